@@ -0,0 +1,200 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * Compare the speed of the scalar and vectorized (SIMD) row operations used by convolution,
+ * both on their own and as used to convolve a float Image and MaskedImage with a spatially invariant
+ * kernel (by brute force) and with a separable kernel
+ */
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "lsst/afw/geom.h"
+#include "lsst/afw/math/FunctionLibrary.h"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/ConvolveImage.h"
+#include "lsst/afw/math/detail/Simd.h"
+
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
+
+typedef float ImageType;
+
+const double Sigma = 3;
+const unsigned DefNIter = 10;
+const int DefImageSize = 2048;
+const int KernelSizes[] = {5, 11, 19};
+const int NKernelSizes = sizeof(KernelSizes)/sizeof(KernelSizes[0]);
+
+char const *getSimdLevelName(mathDetail::SimdLevel level) {
+    switch (level) {
+      case mathDetail::SIMD_SSE2:
+        return "SSE2";
+      case mathDetail::SIMD_AVX:
+        return "AVX";
+      default:
+        return "scalar";
+    }
+}
+
+/*
+ * Time the row operations themselves, on rows of nPix pixels (which should fit in the L1 cache)
+ */
+void timeRowOperations(unsigned int nIter) {
+    int const nPix = 1024;
+    int const nRep = 2000*nIter;
+    std::vector<float> inF(nPix + 1, 1.0), outF(nPix, 0.0);
+    std::vector<double> inD(nPix + 1, 1.0), outD(nPix, 0.0);
+    std::vector<afwImage::MaskPixel> inM(nPix + 1, 0x1), outM(nPix, 0x0);
+
+    std::cout << std::endl << "Row operations on " << nPix << " pixels (offset by one pixel)" << std::endl;
+    std::cout << "Level\tOperation\t\tMPixPerSec" << std::endl;
+    for (int level = mathDetail::SIMD_NONE; level <= mathDetail::getMaxSimdLevel(); ++level) {
+        mathDetail::setSimdLevel(static_cast<mathDetail::SimdLevel>(level));
+        char const *name = getSimdLevelName(mathDetail::getSimdLevel());
+
+        clock_t startTime = clock();
+        for (int i = 0; i < nRep; ++i) {
+            mathDetail::addScaledRow(&outF[0], &inF[1], 1.0e-6, nPix);
+        }
+        double sec = (clock() - startTime) / static_cast<double>(CLOCKS_PER_SEC);
+        std::cout << name << "\taddScaledRow(float)\t" << nRep*(nPix/1.0e6)/sec << std::endl;
+
+        startTime = clock();
+        for (int i = 0; i < nRep; ++i) {
+            mathDetail::addScaledRow(&outD[0], &inD[1], 1.0e-6, nPix);
+        }
+        sec = (clock() - startTime) / static_cast<double>(CLOCKS_PER_SEC);
+        std::cout << name << "\taddScaledRow(double)\t" << nRep*(nPix/1.0e6)/sec << std::endl;
+
+        startTime = clock();
+        for (int i = 0; i < nRep; ++i) {
+            mathDetail::orRow(&outM[0], &inM[1], nPix);
+        }
+        sec = (clock() - startTime) / static_cast<double>(CLOCKS_PER_SEC);
+        std::cout << name << "\torRow\t\t\t" << nRep*(nPix/1.0e6)/sec << std::endl;
+    }
+    mathDetail::setSimdLevel(mathDetail::getMaxSimdLevel());
+}
+
+/*
+ * Time convolution of image with a kernel at each SIMD level
+ */
+template <class ImageClass>
+void timeConvolution(ImageClass &image, afwMath::Kernel const &kernel, std::string const &kernelName,
+                     unsigned int nIter) {
+    int const imWidth = image.getWidth();
+    int const imHeight = image.getHeight();
+    int const kWidth = kernel.getWidth();
+    int const kHeight = kernel.getHeight();
+
+    ImageClass resImage(image.getDimensions());
+    afwMath::ConvolutionControl convControl;
+    convControl.setMinFftKernelSize(0); // always convolve in real space
+
+    double scalarSec = 0;
+    for (int level = mathDetail::SIMD_NONE; level <= mathDetail::getMaxSimdLevel(); ++level) {
+        mathDetail::setSimdLevel(static_cast<mathDetail::SimdLevel>(level));
+
+        clock_t startTime = clock();
+        for (unsigned int iter = 0; iter < nIter; ++iter) {
+            afwMath::convolve(resImage, image, kernel, convControl);
+        }
+        double secPerIter = (clock() - startTime) / static_cast<double> (nIter * CLOCKS_PER_SEC);
+        if (level == mathDetail::SIMD_NONE) {
+            scalarSec = secPerIter;
+        }
+
+        double mOps = static_cast<double>(
+            (imHeight + 1 - kHeight) * (imWidth + 1 - kWidth) * kWidth * kHeight) / 1.0e6;
+        std::cout << getSimdLevelName(mathDetail::getSimdLevel()) << "\t" << kernelName << "\t"
+            << kWidth << "\t" << kHeight << "\t" << secPerIter << "\t" << mOps / secPerIter
+            << "\t" << scalarSec / secPerIter << std::endl;
+    }
+    mathDetail::setSimdLevel(mathDetail::getMaxSimdLevel());
+}
+
+template <class ImageClass>
+void timeConvolutions(ImageClass &image, unsigned int nIter) {
+    std::cout << "Level\tKernel\t\tKerWid\tKerHt\tCnvSec\tMOpsPerSec\tSpeedup" << std::endl;
+    for (int i = 0; i < NKernelSizes; ++i) {
+        int const kSize = KernelSizes[i];
+        afwMath::GaussianFunction2<double> gaussFunc(Sigma, Sigma, 0);
+        afwMath::AnalyticKernel analyticKernel(kSize, kSize, gaussFunc);
+        timeConvolution(image, analyticKernel, "Analytic", nIter);
+
+        afwMath::GaussianFunction1<double> gaussFunc1(Sigma);
+        afwMath::SeparableKernel separableKernel(kSize, kSize, gaussFunc1, gaussFunc1);
+        timeConvolution(image, separableKernel, "Separable", nIter);
+    }
+}
+
+int main(int argc, char **argv) {
+    int imSize = DefImageSize;
+    unsigned int nIter = DefNIter;
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> imSize;
+    }
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> nIter;
+    }
+    if (argc > 3 || imSize <= KernelSizes[NKernelSizes - 1]) {
+        std::cerr << "Usage: timeConvolveSimd [imageSize [nIter]]" << std::endl;
+        std::cerr << "imageSize (default " << DefImageSize << ") is the width and height of the image;"
+                  << " it must exceed " << KernelSizes[NKernelSizes - 1] << std::endl;
+        std::cerr << "nIter (default " << DefNIter << ") is the number of iterations per kernel" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Timing the scalar and SIMD versions of convolution's inner loops" << std::endl;
+    std::cout << "The best SIMD level supported is "
+              << getSimdLevelName(mathDetail::getMaxSimdLevel()) << std::endl;
+    std::cout << "Columns:" << std::endl;
+    std::cout << "* MOps: the number of operations of a kernel pixel on a pixel / 10e6." << std::endl;
+    std::cout << "* CnvSec: time to perform one convolution (sec)" << std::endl;
+    std::cout << "* Speedup: time for the scalar version / time for this version" << std::endl;
+
+    timeRowOperations(nIter);
+
+    afwImage::MaskedImage<ImageType> mImage(afwGeom::Extent2I(imSize, imSize));
+    for (int y = 0; y != imSize; ++y) {
+        afwImage::MaskedImage<ImageType>::x_iterator ptr = mImage.row_begin(y);
+        for (int x = 0; x != imSize; ++x, ++ptr) {
+            ptr.image() = std::rand()/static_cast<double>(RAND_MAX);
+            ptr.mask() = (std::rand()%100 == 0) ? 0x1 : 0x0;
+            ptr.variance() = 1.0;
+        }
+    }
+
+    std::cout << std::endl << "Image " << imSize << " x " << imSize << std::endl;
+    timeConvolutions(*mImage.getImage(), nIter);
+
+    std::cout << std::endl << "MaskedImage " << imSize << " x " << imSize << std::endl;
+    timeConvolutions(mImage, nIter);
+}
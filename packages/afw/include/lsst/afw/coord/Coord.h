@@ -38,6 +38,7 @@
 
 #include "boost/shared_ptr.hpp"
 
+#include "lsst/ndarray.h"
 #include "lsst/afw/geom/Point.h"
 #include "lsst/afw/coord/Utils.h"     // this contains the enums CoordSystem CoordType and radToDeg
 #include "lsst/afw/coord/Observatory.h"
@@ -347,6 +348,48 @@ Coord::Ptr makeCoord(CoordSystem const system, lsst::afw::geom::Point3D const &p
                      double const defaultLongitude=0.0);
 
 
+/**
+ * @class CoordTransform
+ * @brief Convert many positions at once from one coordinate system (and epoch) to another
+ *
+ * The conversion is the rotation that the Coord classes apply one position at a time (via Fk5, as with
+ * Coord::convert), but it's computed once, as a 3x3 matrix, when the CoordTransform is constructed;
+ * converting a position then just rotates its unit vector.  The epochs of ICRS and Galactic coordinates
+ * are always 2000.0; the epochs given for them are ignored.
+ */
+class CoordTransform {
+public:
+    CoordTransform(CoordSystem const fromSystem, CoordSystem const toSystem,
+                   double const fromEpoch = 2000.0, double const toEpoch = 2000.0);
+
+    void apply(lsst::ndarray::Array<double const,1,1> const &longitude,
+               lsst::ndarray::Array<double const,1,1> const &latitude,
+               lsst::ndarray::Array<double,1,1> const &outLongitude,
+               lsst::ndarray::Array<double,1,1> const &outLatitude,
+               CoordUnit unit = DEGREES) const;
+
+    lsst::afw::geom::Point3D apply(lsst::afw::geom::Point3D const &p3d) const;
+    
+private:
+    double _matrix[3][3];               // rotates unit vectors from fromSystem to toSystem
+};
+
+void transformCoords(CoordSystem const fromSystem, CoordSystem const toSystem,
+                     lsst::ndarray::Array<double const,1,1> const &fromEpoch, double const toEpoch,
+                     lsst::ndarray::Array<double const,1,1> const &longitude,
+                     lsst::ndarray::Array<double const,1,1> const &latitude,
+                     lsst::ndarray::Array<double,1,1> const &outLongitude,
+                     lsst::ndarray::Array<double,1,1> const &outLatitude,
+                     CoordUnit unit = DEGREES);
+
+void angularSeparation(lsst::ndarray::Array<double const,1,1> const &longitude1,
+                       lsst::ndarray::Array<double const,1,1> const &latitude1,
+                       lsst::ndarray::Array<double const,1,1> const &longitude2,
+                       lsst::ndarray::Array<double const,1,1> const &latitude2,
+                       lsst::ndarray::Array<double,1,1> const &separation,
+                       CoordUnit unit = DEGREES);
+
+    
 /*
  * Utility functions
  *
@@ -34,9 +34,11 @@
 #include "lsst/afw/detection/Footprint.h"
 #include "lsst/afw/detection/Peak.h"
 #include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceTable.h"
 #include "lsst/afw/detection/DiaSource.h"
 #include "lsst/afw/detection/LocalPsf.h"
 #include "lsst/afw/detection/Psf.h"
 #include "lsst/afw/detection/SourceMatch.h"
+#include "lsst/afw/detection/SourceIndex.h"
 
 #endif
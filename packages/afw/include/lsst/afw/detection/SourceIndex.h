@@ -0,0 +1,113 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/** @file
+  * @brief A spatial index over a SourceSet, for repeated matching
+  * @ingroup afw
+  */
+#ifndef LSST_AFW_DETECTION_SOURCEINDEX_H
+#define LSST_AFW_DETECTION_SOURCEINDEX_H
+
+#include <vector>
+
+#include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceMatch.h"
+
+namespace lsst { namespace afw { namespace detection {
+
+/**
+ * @brief A k-d tree over the positions of the sources in a SourceSet
+ *
+ * In RA_DEC space the sources are indexed by the unit vectors of their (ra, dec), so there's
+ * no special case at the poles or at ra = 0, and radii are in arcseconds;  in XY space they're
+ * indexed by (xAstrom, yAstrom), and radii are in pixels.  Sources whose position contains a NaN
+ * are not indexed.
+ *
+ * The index is built once, and may then be queried any number of times with different radii;
+ * queries don't modify the index, so the index may be shared between threads.  The matches
+ * returned are SourceMatch instances whose first member is the query source and whose second is
+ * an indexed source;  as with matchRaDec and matchXy, a match requires a distance strictly less
+ * than the radius.
+ */
+class SourceIndex {
+public:
+    /// The coordinates used to index (and match) the sources
+    enum Space {
+        RA_DEC,                         ///< (ra, dec); distances in arcseconds
+        XY                              ///< (xAstrom, yAstrom); distances in pixels
+    };
+
+    explicit SourceIndex(SourceSet const &set, Space space = RA_DEC);
+
+    /// Return the coordinates used by the index
+    Space getSpace() const { return _space; }
+    /// Return the number of indexed sources (i.e. those without a NaN in their position)
+    int size() const { return static_cast<int>(_sources.size()); }
+
+    std::vector<SourceMatch> findWithin(Source::Ptr const &source, double radius) const;
+    std::vector<SourceMatch> findNearest(Source::Ptr const &source, int k, double radius) const;
+
+    std::vector<SourceMatch> findMatches(SourceSet const &set, double radius,
+                                         bool closest = true, int nThread = 1) const;
+    std::vector<SourceMatch> findNearestMatches(SourceSet const &set, int k, double radius,
+                                                int nThread = 1) const;
+    std::vector<SourceMatch> findSelfMatches(double radius, bool symmetric = true, int nThread = 1) const;
+
+private:
+    /// A candidate match:  the position of a source in the tree, and its squared distance from the query
+    struct Hit {
+        int index;
+        double d2;
+
+        Hit(int index_, double d2_) : index(index_), d2(d2_) {}
+        bool operator<(Hit const &other) const { return d2 < other.d2; }
+    };
+
+    class MatchChunk;
+    friend class MatchChunk;
+
+    bool _getPosition(Source const &source, double *p) const;
+    double _getD2Limit(double radius) const;
+    double _getDistance(double d2) const;
+
+    void _findWithin(double const *p, int exclude, double d2Limit,
+                     int begin, int end, std::vector<Hit> &hits) const;
+    void _findNearest(double const *p, int exclude, std::size_t k, double &d2Limit,
+                      int begin, int end, std::vector<Hit> &hits) const;
+    void _query(Source::Ptr const &source, double const *p, int exclude, bool symmetric, int k,
+                double d2Limit, std::vector<Hit> &hits, std::vector<SourceMatch> &matches) const;
+    std::vector<SourceMatch> _match(SourceSet const *set, int k, double radius, bool symmetric,
+                                    int nThread) const;
+
+    Space _space;
+    std::vector<double> _points;        // 3 coordinates per indexed source, in tree order
+    std::vector<unsigned char> _splitDims; // the dimension each node of the tree is split on
+    std::vector<Source::Ptr> _sources;  // the indexed sources, in tree order
+    std::vector<int> _ranks;            // the order of each indexed source in the original set
+    std::vector<int> _order;            // the position in the tree of the i-th indexed source
+};
+
+}}} // namespace lsst::afw::detection
+
+#endif // #ifndef LSST_AFW_DETECTION_SOURCEINDEX_H
@@ -0,0 +1,334 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+//
+//##====----------------                                ----------------====##/
+//
+//! \file
+//! \brief  A column-oriented catalog of Sources.
+//
+//##====----------------                                ----------------====##/
+
+#ifndef LSST_AFW_DETECTION_SOURCE_TABLE_H
+#define LSST_AFW_DETECTION_SOURCE_TABLE_H
+
+#include "boost/cstdint.hpp"
+#include "boost/shared_ptr.hpp"
+
+#include "lsst/ndarray.h"
+#include "lsst/daf/base/Persistable.h"
+#include "lsst/afw/detection/Source.h"
+
+/**
+ * The scalar fields of a Source, in the order in which they're persisted.
+ *
+ * Each entry is COLUMN(type, Name, nullable, dbName, units) where
+ *  - Name is the suffix of the Source get/set methods for the field;
+ *  - nullable is the SourceNullableField/SharedNullableField for the field, or -1;
+ *  - dbName is the name of the corresponding column in the Source table of the database;
+ *  - units is NONE, ANGLE (radians, stored in the database in degrees), or RA (an ANGLE that's
+ *    reduced to [0, 360) degrees before it's stored).
+ */
+#define LSST_AFW_DETECTION_SOURCE_COLUMNS(COLUMN) \
+    COLUMN(boost::int64_t, Id,                 -1,                     "sourceId",              NONE)  \
+    COLUMN(boost::int64_t, AmpExposureId,      AMP_EXPOSURE_ID,        "scienceCcdExposureId",  NONE)  \
+    COLUMN(boost::int8_t,  FilterId,           -1,                     "filterId",              NONE)  \
+    COLUMN(boost::int64_t, ObjectId,           OBJECT_ID,              "objectId",              NONE)  \
+    COLUMN(boost::int64_t, MovingObjectId,     MOVING_OBJECT_ID,       "movingObjectId",        NONE)  \
+    COLUMN(boost::int32_t, ProcHistoryId,      -1,                     "procHistoryId",         NONE)  \
+    COLUMN(double,         Ra,                 -1,                     "ra",                    RA)    \
+    COLUMN(float,          RaErrForDetection,  RA_ERR_FOR_DETECTION,   "raSigmaForDetection",   ANGLE) \
+    COLUMN(float,          RaErrForWcs,        -1,                     "raSigmaForWcs",         ANGLE) \
+    COLUMN(double,         Dec,                -1,                     "decl",                  ANGLE) \
+    COLUMN(float,          DecErrForDetection, DEC_ERR_FOR_DETECTION,  "declSigmaForDetection", ANGLE) \
+    COLUMN(float,          DecErrForWcs,       -1,                     "declSigmaForWcs",       ANGLE) \
+    COLUMN(double,         XFlux,              X_FLUX,                 "xFlux",                 NONE)  \
+    COLUMN(float,          XFluxErr,           X_FLUX_ERR,             "xFluxSigma",            NONE)  \
+    COLUMN(double,         YFlux,              Y_FLUX,                 "yFlux",                 NONE)  \
+    COLUMN(float,          YFluxErr,           Y_FLUX_ERR,             "yFluxSigma",            NONE)  \
+    COLUMN(double,         RaFlux,             RA_FLUX,                "raFlux",                RA)    \
+    COLUMN(float,          RaFluxErr,          RA_FLUX_ERR,            "raFluxSigma",           ANGLE) \
+    COLUMN(double,         DecFlux,            DEC_FLUX,               "declFlux",              ANGLE) \
+    COLUMN(float,          DecFluxErr,         DEC_FLUX_ERR,           "declFluxSigma",         ANGLE) \
+    COLUMN(double,         XPeak,              X_PEAK,                 "xPeak",                 NONE)  \
+    COLUMN(double,         YPeak,              Y_PEAK,                 "yPeak",                 NONE)  \
+    COLUMN(double,         RaPeak,             RA_PEAK,                "raPeak",                RA)    \
+    COLUMN(double,         DecPeak,            DEC_PEAK,               "declPeak",              ANGLE) \
+    COLUMN(double,         XAstrom,            X_ASTROM,               "xAstrom",               NONE)  \
+    COLUMN(float,          XAstromErr,         X_ASTROM_ERR,           "xAstromSigma",          NONE)  \
+    COLUMN(double,         YAstrom,            Y_ASTROM,               "yAstrom",               NONE)  \
+    COLUMN(float,          YAstromErr,         Y_ASTROM_ERR,           "yAstromSigma",          NONE)  \
+    COLUMN(double,         RaAstrom,           RA_ASTROM,              "raAstrom",              RA)    \
+    COLUMN(float,          RaAstromErr,        RA_ASTROM_ERR,          "raAstromSigma",         ANGLE) \
+    COLUMN(double,         DecAstrom,          DEC_ASTROM,             "declAstrom",            ANGLE) \
+    COLUMN(float,          DecAstromErr,       DEC_ASTROM_ERR,         "declAstromSigma",       ANGLE) \
+    COLUMN(double,         RaObject,           RA_OBJECT,              "raObject",              RA)    \
+    COLUMN(double,         DecObject,          DEC_OBJECT,             "declObject",            ANGLE) \
+    COLUMN(double,         TaiMidPoint,        -1,                     "taiMidPoint",           NONE)  \
+    COLUMN(double,         TaiRange,           TAI_RANGE,              "taiRange",              NONE)  \
+    COLUMN(double,         PsfFlux,            -1,                     "psfFlux",               NONE)  \
+    COLUMN(float,          PsfFluxErr,         -1,                     "psfFluxSigma",          NONE)  \
+    COLUMN(double,         ApFlux,             -1,                     "apFlux",                NONE)  \
+    COLUMN(float,          ApFluxErr,          -1,                     "apFluxSigma",           NONE)  \
+    COLUMN(double,         ModelFlux,          -1,                     "modelFlux",             NONE)  \
+    COLUMN(float,          ModelFluxErr,       -1,                     "modelFluxSigma",        NONE)  \
+    COLUMN(double,         PetroFlux,          PETRO_FLUX,             "petroFlux",             NONE)  \
+    COLUMN(float,          PetroFluxErr,       PETRO_FLUX_ERR,         "petroFluxSigma",        NONE)  \
+    COLUMN(double,         InstFlux,           -1,                     "instFlux",              NONE)  \
+    COLUMN(float,          InstFluxErr,        -1,                     "instFluxSigma",         NONE)  \
+    COLUMN(double,         NonGrayCorrFlux,    NON_GRAY_CORR_FLUX,     "nonGrayCorrFlux",       NONE)  \
+    COLUMN(float,          NonGrayCorrFluxErr, NON_GRAY_CORR_FLUX_ERR, "nonGrayCorrFluxSigma",  NONE)  \
+    COLUMN(double,         AtmCorrFlux,        ATM_CORR_FLUX,          "atmCorrFlux",           NONE)  \
+    COLUMN(float,          AtmCorrFluxErr,     ATM_CORR_FLUX_ERR,      "atmCorrFluxSigma",      NONE)  \
+    COLUMN(float,          ApDia,              AP_DIA,                 "apDia",                 NONE)  \
+    COLUMN(float,          Ixx,                IXX,                    "Ixx",                   NONE)  \
+    COLUMN(float,          IxxErr,             IXX_ERR,                "IxxSigma",              NONE)  \
+    COLUMN(float,          Iyy,                IYY,                    "Iyy",                   NONE)  \
+    COLUMN(float,          IyyErr,             IYY_ERR,                "IyySigma",              NONE)  \
+    COLUMN(float,          Ixy,                IXY,                    "Ixy",                   NONE)  \
+    COLUMN(float,          IxyErr,             IXY_ERR,                "IxySigma",              NONE)  \
+    COLUMN(float,          PsfIxx,             PSF_IXX,                "psfIxx",                NONE)  \
+    COLUMN(float,          PsfIxxErr,          PSF_IXX_ERR,            "psfIxxSigma",           NONE)  \
+    COLUMN(float,          PsfIyy,             PSF_IYY,                "psfIyy",                NONE)  \
+    COLUMN(float,          PsfIyyErr,          PSF_IYY_ERR,            "psfIyySigma",           NONE)  \
+    COLUMN(float,          PsfIxy,             PSF_IXY,                "psfIxy",                NONE)  \
+    COLUMN(float,          PsfIxyErr,          PSF_IXY_ERR,            "psfIxySigma",           NONE)  \
+    COLUMN(float,          E1,                 E1,                     "e1_SG",                 NONE)  \
+    COLUMN(float,          E1Err,              E1_ERR,                 "e1_SG_Sigma",           NONE)  \
+    COLUMN(float,          E2,                 E2,                     "e2_SG",                 NONE)  \
+    COLUMN(float,          E2Err,              E2_ERR,                 "e2_SG_Sigma",           NONE)  \
+    COLUMN(float,          Resolution,         RESOLUTION,             "resolution_SG",         NONE)  \
+    COLUMN(float,          Shear1,             SHEAR1,                 "shear1_SG",             NONE)  \
+    COLUMN(float,          Shear1Err,          SHEAR1_ERR,             "shear1_SG_Sigma",       NONE)  \
+    COLUMN(float,          Shear2,             SHEAR2,                 "shear2_SG",             NONE)  \
+    COLUMN(float,          Shear2Err,          SHEAR2_ERR,             "shear2_SG_Sigma",       NONE)  \
+    COLUMN(float,          Sigma,              SIGMA,                  "sourceWidth_SG",        NONE)  \
+    COLUMN(float,          SigmaErr,           SIGMA_ERR,              "sourceWidth_SG_Sigma",  NONE)  \
+    COLUMN(boost::int16_t, ShapeStatus,        SHAPE_STATUS,           "shapeFlag_SG",          NONE)  \
+    COLUMN(float,          Snr,                -1,                     "snr",                   NONE)  \
+    COLUMN(float,          Chi2,               -1,                     "chi2",                  NONE)  \
+    COLUMN(float,          Sky,                SKY,                    "sky",                   NONE)  \
+    COLUMN(float,          SkyErr,             SKY_ERR,                "skySigma",              NONE)  \
+    COLUMN(boost::int16_t, FlagForAssociation, FLAG_FOR_ASSOCIATION,   "flagForAssociation",    NONE)  \
+    COLUMN(boost::int64_t, FlagForDetection,   FLAG_FOR_DETECTION,     "flagForDetection",      NONE)  \
+    COLUMN(boost::int16_t, FlagForWcs,         FLAG_FOR_WCS,           "flagForWcs",            NONE)
+
+namespace lsst {
+namespace afw {
+    namespace formatters {
+        class SourceTableFormatter;
+    }
+
+namespace detection {
+
+class SourceTable;
+
+/**
+ * A read-only view of a single row of a SourceTable, with the same get methods as Source
+ *
+ * A record refers to its row by index, so it remains valid as rows are appended to the table,
+ * but not after the table is destroyed.
+ */
+class ConstSourceRecord {
+public:
+#define LSST_AFW_DETECTION_SOURCE_RECORD_GETTERS(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    TYPE get##NAME() const;
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_RECORD_GETTERS)
+
+#undef LSST_AFW_DETECTION_SOURCE_RECORD_GETTERS
+
+    boost::int64_t getSourceId() const { return getId(); }
+
+    bool isNull(int const field) const;
+
+    /// Return the index of this row in its table
+    int getIndex() const { return _index; }
+
+    /// Return the table this row belongs to
+    SourceTable const & getTable() const { return *_table; }
+
+    /// Return a new Source with the values of this row
+    Source::Ptr makeSource() const;
+
+protected:
+    friend class SourceTable;
+
+    ConstSourceRecord(SourceTable const * table, int index) : _table(table), _index(index) {}
+
+    SourceTable const * _table;
+    int _index;
+};
+
+/**
+ * A view of a single row of a SourceTable, with the same get/set methods as Source
+ */
+class SourceRecord : public ConstSourceRecord {
+public:
+#define LSST_AFW_DETECTION_SOURCE_RECORD_SETTERS(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    void set##NAME(TYPE const value);
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_RECORD_SETTERS)
+
+#undef LSST_AFW_DETECTION_SOURCE_RECORD_SETTERS
+
+    void setSourceId(boost::int64_t const sourceId) { setId(sourceId); }
+
+    void setNull(int const field, bool const null = true);
+    void setNotNull(int const field) { setNull(field, false); }
+    void setNull();
+    void setNotNull();
+
+    /// Return the table this row belongs to
+    SourceTable & getTable() const { return *_mutableTable; }
+
+    /// Set every field of this row from a Source
+    void assign(Source const & source);
+
+private:
+    friend class SourceTable;
+
+    SourceRecord(SourceTable * table, int index) : ConstSourceRecord(table, index), _mutableTable(table) {}
+
+    SourceTable * _mutableTable;
+};
+
+/**
+ * @brief A catalog of Sources stored as one contiguous array per field
+ * @ingroup afw
+ *
+ * Unlike a SourceSet, which holds a separately allocated Source for each row, a SourceTable keeps each
+ * field in its own ndarray::Array, so code that only needs a few fields of every Source (matching,
+ * association, formatting) reads them without touching the rest.  Rows are accessed through SourceRecord
+ * views (ConstSourceRecord for a const table); whole columns are returned by the get<Field>Column()
+ * methods, which share memory with the table (and so are only valid until the table next grows).
+ *
+ * Footprints and Measurements aren't stored; use a SourceSet for Sources that carry them.
+ */
+class SourceTable : public lsst::daf::base::Persistable {
+public:
+    typedef boost::shared_ptr<SourceTable> Ptr;
+    typedef boost::shared_ptr<SourceTable const> ConstPtr;
+
+    explicit SourceTable(int capacity = 0);
+    explicit SourceTable(SourceSet const & sources);
+    SourceTable(SourceTable const & other);
+    virtual ~SourceTable() {}
+
+    SourceTable & operator=(SourceTable const & other);
+
+    /// Return the number of rows in the table
+    int size() const { return _size; }
+    /// Return true if the table has no rows
+    bool empty() const { return _size == 0; }
+    /// Return the number of rows the table can hold without reallocating its columns
+    int getCapacity() const { return _capacity; }
+
+    void reserve(int capacity);
+    void clear() { _size = 0; }
+
+    SourceRecord append();
+    SourceRecord append(Source const & source);
+
+    /// Return a view of row n
+    SourceRecord operator[](int n) { return SourceRecord(this, n); }
+    /// Return a read-only view of row n
+    ConstSourceRecord operator[](int n) const { return ConstSourceRecord(this, n); }
+
+    SourceSet makeSourceSet() const;
+
+#define LSST_AFW_DETECTION_SOURCE_TABLE_COLUMN(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    lsst::ndarray::Array<TYPE,1,1> get##NAME##Column() {                \
+        return _column##NAME[lsst::ndarray::view(0, _size)];            \
+    }                                                                   \
+    lsst::ndarray::Array<TYPE const,1,1> get##NAME##Column() const {    \
+        return _column##NAME[lsst::ndarray::view(0, _size)];            \
+    }
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_TABLE_COLUMN)
+
+#undef LSST_AFW_DETECTION_SOURCE_TABLE_COLUMN
+
+    /// Return the null flags of a nullable field (a SourceNullableField) for every row
+    lsst::ndarray::Array<bool,1,1> getNullColumn(int const field) {
+        return _nulls[field][lsst::ndarray::view(0, _size)];
+    }
+    lsst::ndarray::Array<bool const,1,1> getNullColumn(int const field) const {
+        return _nulls[field][lsst::ndarray::view(0, _size)];
+    }
+
+private:
+    friend class ConstSourceRecord;
+    friend class SourceRecord;
+
+    void _reallocate(int capacity);
+
+    int _size;
+    int _capacity;
+
+#define LSST_AFW_DETECTION_SOURCE_TABLE_MEMBER(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    lsst::ndarray::Array<TYPE,1,1> _column##NAME;
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_TABLE_MEMBER)
+
+#undef LSST_AFW_DETECTION_SOURCE_TABLE_MEMBER
+
+    lsst::ndarray::Array<bool,2,2> _nulls; ///< [field][row] null flags for the nullable fields
+
+    LSST_PERSIST_FORMATTER(lsst::afw::formatters::SourceTableFormatter)
+};
+
+#ifndef SWIG
+#define LSST_AFW_DETECTION_SOURCE_RECORD_ACCESSORS(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    inline TYPE ConstSourceRecord::get##NAME() const {                  \
+        return _table->_column##NAME[_index];                           \
+    }                                                                   \
+    inline void SourceRecord::set##NAME(TYPE const value) {             \
+        _mutableTable->_column##NAME[_index] = value;                   \
+        setNotNull(NULLABLE);                                           \
+    }
+
+LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_RECORD_ACCESSORS)
+
+#undef LSST_AFW_DETECTION_SOURCE_RECORD_ACCESSORS
+
+/// Test if a field is null; fields that aren't nullable never are
+inline bool ConstSourceRecord::isNull(int const field) const {
+    if (field >= 0 && field < NUM_SOURCE_NULLABLE_FIELDS) {
+        return _table->_nulls[field][_index];
+    }
+    return false;
+}
+
+/// Set whether a nullable field is null; fields that aren't nullable are ignored
+inline void SourceRecord::setNull(int const field, bool const null) {
+    if (field >= 0 && field < NUM_SOURCE_NULLABLE_FIELDS) {
+        _mutableTable->_nulls[field][_index] = null;
+    }
+}
+#endif
+
+}}}  // namespace lsst::afw::detection
+
+#endif // LSST_AFW_DETECTION_SOURCE_TABLE_H
@@ -40,6 +40,7 @@
 #include "lsst/daf/base.h"
 #include "lsst/daf/persistence.h"
 #include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceTable.h"
 
 namespace lsst {
 namespace afw {
@@ -102,6 +103,64 @@ private:
 };
 
 
+/*!
+    Formatter that supports persistence and retrieval with
+
+    - lsst::daf::persistence::DbStorage
+    - lsst::daf::persistence::DbTsvStorage
+    - lsst::daf::persistence::BoostStorage
+
+    for SourceTable instances.  The database tables are the same as for SourceVectorFormatter;
+    BoostStorage archives hold whole columns, and so can't be read by SourceVectorFormatter.
+ */
+class SourceTableFormatter : public lsst::daf::persistence::Formatter {
+public:
+
+    virtual ~SourceTableFormatter();
+
+    virtual void write(
+        lsst::daf::base::Persistable const *,
+        lsst::daf::persistence::Storage::Ptr,
+        lsst::daf::base::PropertySet::Ptr
+    );
+    virtual lsst::daf::base::Persistable* read(
+        lsst::daf::persistence::Storage::Ptr,
+        lsst::daf::base::PropertySet::Ptr
+    );
+    virtual void update(
+        lsst::daf::base::Persistable*,
+        lsst::daf::persistence::Storage::Ptr,
+        lsst::daf::base::PropertySet::Ptr
+    );
+
+
+    template <class Archive>
+    static void delegateSerialize(
+        Archive &,
+        unsigned int const,
+        lsst::daf::base::Persistable *
+    );
+
+
+private:
+
+    lsst::pex::policy::Policy::Ptr _policy;
+
+    explicit SourceTableFormatter(lsst::pex::policy::Policy::Ptr const & policy);
+
+    static lsst::daf::persistence::Formatter::Ptr createInstance(
+        lsst::pex::policy::Policy::Ptr
+    );
+    static lsst::daf::persistence::FormatterRegistration registration;
+
+    template <typename T>
+    static void insertRows(
+        T &,
+        lsst::afw::detection::SourceTable const &
+    );
+};
+
+
 }}} // namespace lsst::afw::formatters
 
 #endif // LSST_AFW_FORMATTERS_SOURCE_FORMATTERS_H
@@ -240,8 +240,14 @@ public:
     bool hasWcs() const { return *_wcs ? true : false; }
     
     // FITS
-    void writeFits(std::string const &expOutFile) const;
-    void writeFits(char **ramFile, size_t *ramFileLen) const;
+    void writeFits(std::string const &expOutFile,
+                   FitsCompression const& imageCompression=FitsCompression(),
+                   FitsCompression const& maskCompression=FitsCompression(),
+                   FitsCompression const& varianceCompression=FitsCompression()) const;
+    void writeFits(char **ramFile, size_t *ramFileLen,
+                   FitsCompression const& imageCompression=FitsCompression(),
+                   FitsCompression const& maskCompression=FitsCompression(),
+                   FitsCompression const& varianceCompression=FitsCompression()) const;
     
 private:
     LSST_PERSIST_FORMATTER(lsst::afw::formatters::ExposureFormatter<ImageT, MaskT, VarianceT>)
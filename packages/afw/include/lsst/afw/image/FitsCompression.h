@@ -0,0 +1,105 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * \file
+ * \brief Control how images are compressed when written to FITS files
+ */
+#ifndef LSST_AFW_IMAGE_FITSCOMPRESSION_H
+#define LSST_AFW_IMAGE_FITSCOMPRESSION_H
+
+#include <cassert>
+
+namespace lsst {
+namespace afw {
+namespace image {
+
+/// The algorithms that may be used to compress a FITS image
+enum CompressionAlgorithm {
+    COMPRESS_NONE,                      ///< Write a plain (uncompressed) image
+    COMPRESS_GZIP,                      ///< gzip each tile
+    COMPRESS_RICE,                      ///< Rice compression
+    COMPRESS_HCOMPRESS,                 ///< H-compress (tiles must be at least 4x4)
+    COMPRESS_PLIO                       ///< IRAF's PLIO; only for non-negative integers < 2^24 (e.g. masks)
+};
+
+/**
+ * @brief Describe how an image should be compressed when it's written to a FITS file
+ * @ingroup afw
+ *
+ * The image is written as a tile-compressed image:  it's divided into tiles of getTileWidth() x
+ * getTileHeight() pixels (0 meaning the full width or height of the image), each of which is compressed
+ * separately.  Reading part of the image only decompresses the tiles that it overlaps, so tiles a few rows
+ * high are a good choice for images that are read a band at a time.
+ *
+ * Integer images are always compressed losslessly.  Floating point images are quantized before they're
+ * compressed, with getQuantizeLevel() levels per standard deviation of the noise in each tile (which is
+ * lossy); a level of 0 disables the quantization, and is only supported by COMPRESS_GZIP.
+ */
+class FitsCompression {
+public:
+    explicit FitsCompression(
+        CompressionAlgorithm algorithm = COMPRESS_NONE, ///< Desired compression algorithm
+        int tileWidth = 0,              ///< Width of a tile; 0 means the width of the image
+        int tileHeight = 1,             ///< Height of a tile; 0 means the height of the image
+        float quantizeLevel = 16.0      ///< Quantization levels per sigma for floating point images
+                            ) :
+        _algorithm(algorithm),
+        _tileWidth(tileWidth),
+        _tileHeight(tileHeight),
+        _quantizeLevel(quantizeLevel) {
+
+        assert(_tileWidth >= 0 && _tileHeight >= 0 && _quantizeLevel >= 0.0);
+    }
+
+    /// Return a FitsCompression suitable for a Mask (lossless, and efficient for sparse bits)
+    static FitsCompression makeMaskCompression(int tileHeight = 1) {
+        return FitsCompression(COMPRESS_RICE, 0, tileHeight);
+    }
+
+    CompressionAlgorithm getAlgorithm() const { return _algorithm; }
+    int getTileWidth() const { return _tileWidth; }
+    int getTileHeight() const { return _tileHeight; }
+    float getQuantizeLevel() const { return _quantizeLevel; }
+    /// Will images be compressed?
+    bool isCompressed() const { return _algorithm != COMPRESS_NONE; }
+
+    void setAlgorithm(CompressionAlgorithm algorithm) { _algorithm = algorithm; }
+    void setTileWidth(int tileWidth) { assert(tileWidth >= 0); _tileWidth = tileWidth; }
+    void setTileHeight(int tileHeight) { assert(tileHeight >= 0); _tileHeight = tileHeight; }
+    void setQuantizeLevel(float quantizeLevel) {
+        assert(quantizeLevel >= 0.0);
+        _quantizeLevel = quantizeLevel;
+    }
+
+private:
+    CompressionAlgorithm _algorithm;    // compression algorithm
+    int _tileWidth;                     // width of a tile; 0 => width of image
+    int _tileHeight;                    // height of a tile; 0 => height of image
+    float _quantizeLevel;               // quantization levels per sigma for floating point data
+};
+
+}}}  // lsst::afw::image
+
+#endif
@@ -42,6 +42,7 @@
 #include "boost/shared_array.hpp"
 #include "lsst/afw/geom.h"
 #include "lsst/afw/image/lsstGil.h"
+#include "lsst/afw/image/FitsCompression.h"
 #include "lsst/afw/image/Utils.h"
 #include "lsst/afw/image/ImageUtils.h"
 #include "lsst/afw/math/Function.h"
@@ -443,11 +444,13 @@ namespace image {
         void writeFits(
             std::string const& fileName,
             boost::shared_ptr<lsst::daf::base::PropertySet const> metadata = lsst::daf::base::PropertySet::Ptr(),
-            std::string const& mode="w"
+            std::string const& mode="w",
+            FitsCompression const& compression=FitsCompression()
         ) const;
         void writeFits(char **ramFile, size_t *ramFileLen,
             boost::shared_ptr<lsst::daf::base::PropertySet const> metadata = lsst::daf::base::PropertySet::Ptr(),
-            std::string const& mode="w"
+            std::string const& mode="w",
+            FitsCompression const& compression=FitsCompression()
         ) const;
 
         void swap(Image &rhs);
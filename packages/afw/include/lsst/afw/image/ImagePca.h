@@ -68,8 +68,18 @@ namespace image {
         /// Return Eigen images
         ImageList const& getEigenImages() const { return _eigenImages; }
 
+        /// Return the number of eigen images that analyze() computes
+        int getNumComponents() const { return _nComponent; }
+        void setNumComponents(int nComponent);
+
+        /// Return the number of threads that analyze() uses; <= 0 means one per core
+        int getNumThreads() const { return _nThread; }
+        /// Set the number of threads that analyze() uses; <= 0 means one per core
+        void setNumThreads(int nThread) { _nThread = nThread; }
+
     private:
         double getFlux(int i) const { return _fluxList[i]; }
+        void updateGramMatrix();
 
         ImageList _imageList;           // image to analyze
         std::vector<double> _fluxList;  // fluxes of images
@@ -77,7 +87,13 @@ namespace image {
 
         //int _border;                  // how many pixels to ignore around regions
         bool _constantWeight;           // should all stars have the same weight?
-        
+        int _nComponent;                // number of eigen images to compute
+        int _nThread;                   // number of threads to use in analyze()
+
+        std::vector<double> _pixels;    // the images' (weighted) pixels, packed one image after another
+        std::vector<double> _gram;      // the images' inner products, as an nImage x nImage matrix
+        int _nGram;                     // number of images included in _pixels and _gram
+
         std::vector<double> _eigenValues; // Eigen values
         ImageList _eigenImages;           // Eigen images
     };
@@ -165,12 +165,14 @@ public:
     void writeFits(
         std::string const& fileName,
         boost::shared_ptr<const lsst::daf::base::PropertySet> metadata=lsst::daf::base::PropertySet::Ptr(),
-        std::string const& mode="w"
+        std::string const& mode="w",
+        FitsCompression const& compression=FitsCompression()
     ) const;
     void writeFits(
         char **ramFile, size_t *ramFileLen,
         boost::shared_ptr<const lsst::daf::base::PropertySet> metadata=lsst::daf::base::PropertySet::Ptr(),
-        std::string const& mode="w"
+        std::string const& mode="w",
+        FitsCompression const& compression=FitsCompression()
     ) const;
     
     // Mask Plane ops
@@ -729,13 +729,19 @@ public:
         std::string const& baseName,
         boost::shared_ptr<const lsst::daf::base::PropertySet> metadata = lsst::daf::base::PropertySet::Ptr(),
         std::string const& mode="w",
-        bool const writeMef=false
+        bool const writeMef=false,
+        FitsCompression const& imageCompression=FitsCompression(),
+        FitsCompression const& maskCompression=FitsCompression(),
+        FitsCompression const& varianceCompression=FitsCompression()
     ) const;
     void writeFits(
         char **ramFile, size_t *ramFileLen,
         boost::shared_ptr<const lsst::daf::base::PropertySet> metadata = lsst::daf::base::PropertySet::Ptr(),
         std::string const& mode="w",
-        bool const writeMef=true    //writeMef==false is not supported, it will throw an exception
+        bool const writeMef=true,   //writeMef==false is not supported, it will throw an exception
+        FitsCompression const& imageCompression=FitsCompression(),
+        FitsCompression const& maskCompression=FitsCompression(),
+        FitsCompression const& varianceCompression=FitsCompression()
     ) const;
 
     // Getters
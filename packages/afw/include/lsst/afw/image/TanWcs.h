@@ -122,6 +122,14 @@ namespace image {
 
         virtual void pixelToSkyImpl(double pixel1, double pixel2, double skyTmp[2]) const;
         virtual lsst::afw::geom::Point2D skyToPixelImpl(double sky1, double sky2) const;
+        virtual void pixelToSkyImpl(int n, double const *pixel1, double const *pixel2,
+                                    double *sky1, double *sky2) const;
+        virtual void skyToPixelImpl(int n, double const *sky1, double const *sky2,
+                                    double *pixel1, double *pixel2) const;
+
+        // Apply the SIP distortion (or un-distortion) to n pixel positions in place
+        void distortPixels(int n, double *pixel1, double *pixel2) const;
+        void undistortPixels(int n, double *pixel1, double *pixel2) const;
 
         //Allow the formatter to access private goo
         LSST_PERSIST_FORMATTER(lsst::afw::formatters::TanWcsFormatter)
@@ -36,6 +36,7 @@
 #include "lsst/afw/geom/AffineTransform.h"
 #include "lsst/afw/geom/Point.h"
 #include "lsst/afw/geom/Extent.h"
+#include "lsst/ndarray.h"
 
 struct wcsprm;                          // defined in wcs.h
 
@@ -143,6 +144,16 @@ public:
     lsst::afw::geom::Point2D skyToPixel(double sky1, double sky2) const;
     lsst::afw::geom::Point2D skyToPixel(lsst::afw::coord::Coord::ConstPtr coord) const;
     lsst::afw::geom::Point2D skyToIntermediateWorldCoord(lsst::afw::coord::Coord::ConstPtr coord) const;
+
+    //Convert many positions at once, without creating a Coord for each
+    void pixelToSky(lsst::ndarray::Array<double const,1,1> const & pix1,
+                    lsst::ndarray::Array<double const,1,1> const & pix2,
+                    lsst::ndarray::Array<double,1,1> const & sky1,
+                    lsst::ndarray::Array<double,1,1> const & sky2) const;
+    void skyToPixel(lsst::ndarray::Array<double const,1,1> const & sky1,
+                    lsst::ndarray::Array<double const,1,1> const & sky2,
+                    lsst::ndarray::Array<double,1,1> const & pix1,
+                    lsst::ndarray::Array<double,1,1> const & pix2) const;
     
     virtual bool hasDistortion() const {    return false;};
     
@@ -186,6 +197,10 @@ private:
 
     virtual void pixelToSkyImpl(double pixel1, double pixel2, double skyTmp[2]) const;
         virtual lsst::afw::geom::Point2D skyToPixelImpl(double sky1, double sky2) const;
+    virtual void pixelToSkyImpl(int n, double const *pixel1, double const *pixel2,
+                                double *sky1, double *sky2) const;
+    virtual void skyToPixelImpl(int n, double const *sky1, double const *sky2,
+                                double *pixel1, double *pixel2) const;
 
 protected:
 
@@ -198,6 +213,10 @@ protected:
     
     lsst::afw::coord::Coord::Ptr makeCorrectCoord(double sky0, double sky1) const;
     lsst::afw::geom::Point2D convertCoordToSky(lsst::afw::coord::Coord::ConstPtr coord) const;
+
+    // Call wcslib for n positions at once;  pixel coordinates follow the FITS convention
+    void fitsPixelToSky(int n, double const *pixel1, double const *pixel2, double *sky1, double *sky2) const;
+    void skyToFitsPixel(int n, double const *sky1, double const *sky2, double *pixel1, double *pixel2) const;
     
     virtual lsst::afw::geom::AffineTransform linearizePixelToSkyInternal(
                                                  lsst::afw::geom::Point2D const & pix,
@@ -32,7 +32,9 @@
 #if !defined(LSST_FITS_IO_PRIVATE_H)
 #define LSST_FITS_IO_PRIVATE_H
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 #include <unistd.h>
 #include "boost/static_assert.hpp"
 #include "boost/format.hpp"
@@ -41,6 +43,7 @@
 #include "boost/gil/extension/io/io_error.hpp"
 #include "lsst/afw/geom.h"
 #include "lsst/afw/image/lsstGil.h"
+#include "lsst/afw/image/FitsCompression.h"
 #include "lsst/afw/image/Utils.h"
 #include "lsst/afw/image/Wcs.h"
 
@@ -89,6 +92,9 @@ namespace cfitsio {
     void getKey(fitsfile* fd, int n, std::string & keyWord, std::string & keyValue, std::string & keyComment);
 
     void getMetadata(fitsfile* fd, lsst::daf::base::PropertySet::Ptr  metadata, bool strip=true);
+
+    void setCompression(fitsfile* fd, lsst::afw::image::FitsCompression const& compression,
+                        int width, int height);
 }
 
 namespace detail {
@@ -503,6 +509,19 @@ class fits_writer : public fits_file_mgr {
     void init() {
         ;
     }
+    //
+    // cfitsio remembers the requested compression in the fitsfile, so we have to turn it off again
+    // when we've finished writing an HDU (even if we failed)
+    //
+    struct reset_compression {
+        reset_compression(cfitsio::fitsfile *fd) : _fd(fd) {}
+        ~reset_compression() {
+            int status = 0;
+            (void)cfitsio::fits_set_compression_type(_fd, 0, &status);
+        }
+    private:
+        cfitsio::fitsfile *_fd;
+    };
 public:
     fits_writer(cfitsio::fitsfile *file) :     fits_file_mgr(file)           { init(); }
     fits_writer(std::string const& filename, std::string const&mode) : fits_file_mgr(filename, mode) { init(); }
@@ -513,22 +532,27 @@ public:
     template <typename ImageT>
     void apply(
         ImageT const & image,
-        boost::shared_ptr<const lsst::daf::base::PropertySet> metadata
+        boost::shared_ptr<const lsst::daf::base::PropertySet> metadata,
+        FitsCompression const& compression = FitsCompression()
     ) {
+        typedef typename ImageT::Pixel Pixel;
+
         const int nAxis = 2;
         long nAxes[nAxis];
         nAxes[0] = image.getWidth();
         nAxes[1] = image.getHeight();
         long imageSize = nAxes[0]*nAxes[1];
 
-        const int BITPIX = detail::fits_read_support_private<typename ImageT::Pixel>::BITPIX;
+        const int BITPIX = detail::fits_read_support_private<Pixel>::BITPIX;
 
+        reset_compression const resetCompression(_fd.get());
         int status = 0;
         if (_flags == "pdu") {
             if (fits_create_img(_fd.get(), 8, 0, nAxes, &status) != 0) {
                 throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
             }
         } else {
+            cfitsio::setCompression(_fd.get(), compression, nAxes[0], nAxes[1]);
             if (fits_create_img(_fd.get(), BITPIX, nAxis, nAxes, &status) != 0) {
                 throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
             }
@@ -569,12 +593,41 @@ public:
         int const ttype = cfitsio::ttypeFromBitpix(BITPIX);
         status = 0;                     // cfitsio function return status
 
-        ndarray::Array<const typename ImageT::Pixel, 2, 2> array = ndarray::dynamic_dimension_cast<2>(image.getArray());
-        if(array.empty())
-            array = ndarray::copy(image.getArray());
-        typename ImageT::Pixel * data = const_cast<typename ImageT::Pixel *>(array.getData());
-        if (fits_write_img(_fd.get(), ttype, 1, imageSize, data, &status) != 0) {
-            throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
+        ndarray::Array<const Pixel, 2, 2> array = ndarray::dynamic_dimension_cast<2>(image.getArray());
+        if (!array.empty()) {
+            Pixel * data = const_cast<Pixel *>(array.getData());
+            if (fits_write_img(_fd.get(), ttype, 1, imageSize, data, &status) != 0) {
+                throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
+            }
+            return;
+        }
+        /*
+         * The pixels aren't contiguous (e.g. image is a subimage), so write the rows directly from the
+         * image rather than copying it.  Compressed images are written a whole band of tiles at a time,
+         * as cfitsio would otherwise have to re-read and re-compress partially written tiles
+         */
+        int const width = nAxes[0];
+        int const height = nAxes[1];
+        int const bandHeight = !compression.isCompressed() ? 1 :
+            ((compression.getTileHeight() == 0) ? height : std::min(compression.getTileHeight(), height));
+        ndarray::Array<const Pixel, 2, 1> const rows = image.getArray();
+        std::vector<Pixel> band((bandHeight > 1) ? bandHeight*width : 0);
+
+        for (int y0 = 0; y0 < height; y0 += bandHeight) {
+            int const nRow = std::min(bandHeight, height - y0);
+            Pixel * data = NULL;
+            if (bandHeight == 1) {
+                data = const_cast<Pixel *>(rows[y0].getData());
+            } else {
+                for (int y = y0; y != y0 + nRow; ++y) {
+                    std::copy(rows[y].getData(), rows[y].getData() + width, band.begin() + (y - y0)*width);
+                }
+                data = &band[0];
+            }
+            if (fits_write_img(_fd.get(), ttype, static_cast<long>(y0)*width + 1, nRow*width, data,
+                               &status) != 0) {
+                throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
+            }
         }
     }
 };
@@ -40,6 +40,7 @@
 #include "lsst/afw/math/SpatialCell.h"
 #include "lsst/afw/math/offsetImage.h"
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/StatisticsAccumulator.h"
 #include "lsst/afw/math/Integrate.h"
 #include "lsst/afw/math/Interpolate.h"
 #include "lsst/afw/math/Random.h"
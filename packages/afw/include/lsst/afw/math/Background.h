@@ -31,6 +31,7 @@
  * @author Steve Bickerton
  */
 
+#include <vector>
 #include "boost/shared_ptr.hpp"
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/math/Statistics.h"
@@ -72,7 +73,9 @@ public:
           _nxSample(nxSample), _nySample(nySample),
           _undersampleStyle(undersampleStyle),
           _sctrl(new StatisticsControl(sctrl)),
-          _prop(prop) {
+          _prop(prop),
+          _minGoodFraction(0.0),
+          _nThread(1) {
         assert(nxSample > 0);
         assert(nySample > 0);
     }
@@ -90,7 +93,9 @@ public:
           _nxSample(nxSample), _nySample(nySample),
           _undersampleStyle(math::stringToUndersampleStyle(undersampleStyle)),
           _sctrl(new StatisticsControl(sctrl)),
-          _prop(stringToStatisticsProperty(prop)) {
+          _prop(stringToStatisticsProperty(prop)),
+          _minGoodFraction(0.0),
+          _nThread(1) {
         assert(nxSample > 0);
         assert(nySample > 0);
     }
@@ -121,6 +126,23 @@ public:
     Property getStatisticsProperty() { return _prop; }
     void setStatisticsProperty(Property prop) { _prop = prop; }
     void setStatisticsProperty(std::string prop) { _prop = stringToStatisticsProperty(prop); }
+
+    /// Return the minimum fraction of a sub-image's pixels that must be good for it to be used
+    double getMinGoodFraction() const { return _minGoodFraction; }
+    /**
+     * Set the minimum fraction of a sub-image's pixels that must be good (i.e. not NaN, nor masked by
+     * the StatisticsControl's andMask) for it to be used; sub-images with too few good pixels
+     * (or none) are replaced by interpolating between their neighbours
+     */
+    void setMinGoodFraction(double minGoodFraction) {
+        assert(minGoodFraction >= 0.0 && minGoodFraction <= 1.0);
+        _minGoodFraction = minGoodFraction;
+    }
+
+    /// Return the number of threads used to measure the sub-images; <= 0 means one per core
+    int getNumThreads() const { return _nThread; }
+    /// Set the number of threads used to measure the sub-images; <= 0 means one per core
+    void setNumThreads(int nThread) { _nThread = nThread; }
     
 private:
     Interpolate::Style _style;                       // style of interpolation to use
@@ -129,6 +151,8 @@ private:
     UndersampleStyle _undersampleStyle; // what to do when nx,ny are too small for the requested interp style
     StatisticsControl::Ptr _sctrl;           // statistics control object
     Property _prop;                          // statistics Property
+    double _minGoodFraction;            // minimum fraction of good pixels in a usable sub-image
+    int _nThread;                       // number of threads to use; <= 0 means one per core
 };
     
 /**
@@ -136,10 +160,14 @@ private:
  * @brief A class to evaluate %image background levels
  *
  * Break an image up into nx*ny sub-images and use 3-sigma clipped means to
- * estimate the background levels in each square.  Then use a bicubic spline or
+ * estimate the background levels in each square (the squares may be processed by several threads;
+ * see BackgroundControl::setNumThreads).  Squares with too few good pixels are replaced by
+ * interpolating between their neighbours.  Then use a bicubic spline or
  * bilinear interpolation (not currently implemented) algorithm to estimate background
  * at a given pixel coordinate.
- * Methods are available return background at a point (inefficiently), or an entire background image.
+ * Methods are available return background at a point (inefficiently), at a list of points,
+ * in a sub-region of the image, or an entire background image, or to subtract the background from
+ * an image in place (without making a background image).
  * BackgroundControl contains public StatisticsControl and InterpolateControl members to allow
  * user control of how the backgrounds are computed.
  * @code
@@ -150,6 +178,7 @@ private:
        math::Background backobj = math::makeBackground(img, bctrl);
        double somepoint = backobj.getPixel(i_x,i_y); // get the background at a pixel at i_x,i_y
        ImageT back = backobj.getImage();             // get a whole background image
+       backobj.subtractFrom(img);                    // subtract the background from img
  * @endcode
  *
  */
@@ -163,9 +192,20 @@ public:
     virtual ~Background() {}
     
     double getPixel(int const x, int const y) const;
+    std::vector<double> getPixels(std::vector<int> const& x, std::vector<int> const& y) const;
 
     template<typename PixelT>
     typename lsst::afw::image::Image<PixelT>::Ptr getImage() const;
+    template<typename PixelT>
+    typename lsst::afw::image::Image<PixelT>::Ptr getImage(lsst::afw::geom::Box2I const& bbox) const;
+
+    template<typename PixelT>
+    void subtractFrom(lsst::afw::image::Image<PixelT> &img) const;
+    /// Subtract the background from a MaskedImage's image plane
+    template<typename PixelT>
+    void subtractFrom(lsst::afw::image::MaskedImage<PixelT> &img) const {
+        subtractFrom(*img.getImage());
+    }
     
     BackgroundControl getBackgroundControl() const { return _bctrl; }
     
@@ -188,6 +228,7 @@ private:
     BackgroundControl _bctrl;           // control info set by user.
 
     void _checkSampling();
+    void _getRow(int const y, std::vector<double> const& xpix, std::vector<double> &values) const;
 };
 
 /**
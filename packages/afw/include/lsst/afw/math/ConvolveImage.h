@@ -60,22 +60,31 @@ namespace math {
                 bool doNormalize = true,    ///< normalize the kernel to sum=1?
                 bool doCopyEdge = false,    ///< copy edge pixels from source image
                     ///< instead of setting them to the standard edge pixel?
-                int maxInterpolationDistance = 10)  ///< maximum width or height of a region
+                int maxInterpolationDistance = 10,  ///< maximum width or height of a region
                     ///< over which to use linear interpolation interpolate
+                int minFftKernelSize = 15,  ///< minimum width and height of a spatially invariant kernel
+                    ///< to convolve using FFTs; <= 0 to never use FFTs
+                int nThread = 1)    ///< number of threads to use; <= 0 means one per core
         :
             _doNormalize(doNormalize),
             _doCopyEdge(doCopyEdge),
-            _maxInterpolationDistance(maxInterpolationDistance)
+            _maxInterpolationDistance(maxInterpolationDistance),
+            _minFftKernelSize(minFftKernelSize),
+            _nThread(nThread)
         { }
     
         bool getDoNormalize() const { return _doNormalize; }
         bool getDoCopyEdge() const { return _doCopyEdge; }
         int getMaxInterpolationDistance() const { return _maxInterpolationDistance; };
+        int getMinFftKernelSize() const { return _minFftKernelSize; }
+        int getNumThreads() const { return _nThread; }
         
         void setDoNormalize(bool doNormalize) {_doNormalize = doNormalize; }
         void setDoCopyEdge(bool doCopyEdge) { _doCopyEdge = doCopyEdge; }
         void setMaxInterpolationDistance(int maxInterpolationDistance) {
             _maxInterpolationDistance = maxInterpolationDistance; }
+        void setMinFftKernelSize(int minFftKernelSize) { _minFftKernelSize = minFftKernelSize; }
+        void setNumThreads(int nThread) { _nThread = nThread; }
     
     private:
         bool _doNormalize;  ///< normalize the kernel to sum=1?
@@ -83,6 +92,9 @@ namespace math {
                     ///< instead of setting them to the standard edge pixel?
         int _maxInterpolationDistance;  ///< maximum width or height of a region
                     ///< over which to attempt interpolation
+        int _minFftKernelSize;  ///< minimum width and height of a spatially invariant kernel
+                    ///< to convolve using FFTs; <= 0 to never use FFTs
+        int _nThread;       ///< number of threads to use; <= 0 means one per core
     };
 
     template <typename OutImageT, typename InImageT>
@@ -29,14 +29,95 @@
  * @brief Functions to stack images
  * @ingroup stack
  */ 
+#include <cassert>
+#include <string>
 #include <vector>
+#include "boost/shared_ptr.hpp"
+#include "lsst/afw/geom.h"
 #include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/Statistics.h"
 
 namespace lsst {
 namespace afw {
 namespace math {    
 
+/**
+ * @brief Pass parameters controlling how statisticsStack divides up its work
+ * @ingroup afw
+ *
+ * The stack is computed in bands of getBandHeight() rows, and the rows of each band are shared between
+ * getNumThreads() threads.  When the images are provided by a StackInput only one band of each image is
+ * read at a time, so the memory needed depends on the band height rather than on the size of the images.
+ */
+class StackControl {
+public:
+    explicit StackControl(
+        int nThread = 1,                ///< Number of threads to use; <= 0 means one per core
+        int bandHeight = 64             ///< Number of rows of the output to process together
+                         ) :
+        _nThread(nThread),
+        _bandHeight(bandHeight) {
+
+        assert(_bandHeight > 0);
+    }
+
+    int getNumThreads() const { return _nThread; }
+    int getBandHeight() const { return _bandHeight; }
+
+    void setNumThreads(int nThread) { _nThread = nThread; }
+    void setBandHeight(int bandHeight) { assert(bandHeight > 0); _bandHeight = bandHeight; }
+
+private:
+    int _nThread;                       // Number of threads to use
+    int _bandHeight;                    // Number of rows to process together
+};
+
+/**
+ * @brief The MaskedImages to be stacked, to be read a band at a time
+ * @ingroup afw
+ *
+ * Subclasses return the part of each image that lies within a bounding box, e.g. by reading it from disk,
+ * so that statisticsStack never needs the entire stack of images in memory at once.
+ */
+template <typename PixelT>
+class StackInput {
+public:
+    typedef boost::shared_ptr<StackInput> Ptr;
+    typedef boost::shared_ptr<StackInput const> ConstPtr;
+
+    virtual ~StackInput() {}
+
+    /// Return the number of images in the stack
+    virtual int getSize() const = 0;
+    /// Return the dimensions of each of the images in the stack
+    virtual geom::Extent2I getDimensions() const = 0;
+    /// Return the pixels of the i-th image that lie within bbox (in the image's LOCAL coordinates)
+    virtual typename lsst::afw::image::MaskedImage<PixelT>::Ptr read(int i, geom::Box2I const &bbox) const = 0;
+};
+
+/**
+ * @brief A StackInput that reads the images from a list of FITS files
+ * @ingroup afw
+ */
+template <typename PixelT>
+class FitsStackInput : public StackInput<PixelT> {
+public:
+    FitsStackInput(std::vector<std::string> const &fileNames,
+                   geom::Extent2I const &dimensions,
+                   int hdu=0
+                  );
+
+    virtual int getSize() const { return _fileNames.size(); }
+    virtual geom::Extent2I getDimensions() const { return _dimensions; }
+    virtual typename lsst::afw::image::MaskedImage<PixelT>::Ptr read(int i, geom::Box2I const &bbox) const;
+
+private:
+    std::vector<std::string> _fileNames;
+    geom::Extent2I _dimensions;
+    int _hdu;
+};
+
 /********************************************************************
  *
  * z stacks
@@ -51,7 +132,8 @@ typename lsst::afw::image::Image<PixelT>::Ptr statisticsStack(
         std::vector<typename lsst::afw::image::Image<PixelT>::Ptr > &images,      ///< Images to process
         Property flags, ///< statistics requested
         StatisticsControl const& sctrl=StatisticsControl(),   ///< Control structure
-        std::vector<PixelT> const& wvector=std::vector<PixelT>(0) ///< vector containing weights
+        std::vector<PixelT> const& wvector=std::vector<PixelT>(0), ///< vector containing weights
+        StackControl const& stctrl=StackControl() ///< How to divide up the work
                                                              );
 
 /**
@@ -62,7 +144,20 @@ typename lsst::afw::image::MaskedImage<PixelT>::Ptr statisticsStack(
         std::vector<typename lsst::afw::image::MaskedImage<PixelT>::Ptr > &images,///< MaskedImages to process
         Property flags, ///< statistics requested
         StatisticsControl const& sctrl=StatisticsControl(), ///< control structure
-        std::vector<PixelT> const& wvector=std::vector<PixelT>(0) ///< vector containing weights
+        std::vector<PixelT> const& wvector=std::vector<PixelT>(0), ///< vector containing weights
+        StackControl const& stctrl=StackControl() ///< How to divide up the work
+                                                                   );
+
+/**
+ * @brief A function to compute some statistics of a stack of MaskedImages, read a band at a time
+ */
+template<typename PixelT>
+typename lsst::afw::image::MaskedImage<PixelT>::Ptr statisticsStack(
+        StackInput<PixelT> const &input, ///< MaskedImages to process
+        Property flags, ///< statistics requested
+        StatisticsControl const& sctrl=StatisticsControl(), ///< control structure
+        std::vector<PixelT> const& wvector=std::vector<PixelT>(0), ///< vector containing weights
+        StackControl const& stctrl=StackControl() ///< How to divide up the work
                                                                    );
 
 
@@ -74,6 +74,8 @@ enum Property {
 };
 Property stringToStatisticsProperty(std::string const property);
 
+class StatisticsAccumulator;
+
     
 /**
  * @brief Pass parameters to a Statistics object
@@ -200,15 +202,17 @@ public:
     }
     
 private:
+    friend class StatisticsAccumulator;
+
+    explicit Statistics(int const flags, StatisticsControl const& sctrl);
 
     // return type for _getStandard
     typedef boost::tuple<double, double, double, double, double, lsst::afw::image::MaskPixel> StandardReturn; 
-    typedef boost::tuple<int, double, double, double, double, double, lsst::afw::image::MaskPixel> SumReturn; 
     typedef boost::tuple<double, double, double> MedianQuartileReturn;
     
     long _flags;                        // The desired calculation
 
-    int _n;                             // number of pixels in the image
+    long long _n;                       // number of pixels in the image
     double _mean;                       // the image's mean
     double _variance;                   // the image's variance
     double _min;                        // the image's minimum
@@ -222,27 +226,14 @@ private:
 
     StatisticsControl _sctrl;           // the control structure
 
-    template<typename IsFinite, typename ImageT, typename MaskT, typename VarianceT>
-    boost::shared_ptr<std::vector<typename ImageT::Pixel> >  _makeVectorCopy(ImageT const &img,
-                                                                             MaskT const &msk,
-                                                                             VarianceT const &var,
-                                                                             int const flags);
-        
-    template<typename IsFinite,
-             typename HasValueLtMin,
-             typename HasValueGtMax,
-             typename InClipRange,
-             bool MultiplyWeight,
-             typename ImageT, typename MaskT, typename VarianceT>
-    SumReturn _sumImage(ImageT const &img, MaskT const &msk, VarianceT const &var, int const flags,
-                        int const nCrude, int const stride = 1, double const meanCrude = 0,
-                        double const cliplimit = std::numeric_limits<double>::quiet_NaN());
-    
-    template<typename ImageT, typename MaskT, typename VarianceT>
-    StandardReturn _getStandard(ImageT const &img, MaskT const &msk, VarianceT const &var, int const flags);
     template<typename ImageT, typename MaskT, typename VarianceT>
-    StandardReturn _getStandard(ImageT const &img, MaskT const &msk, VarianceT const &var,
-                                int const flags, std::pair<double, double> clipinfo);
+    StandardReturn _getStandard(ImageT const &img, MaskT const &msk, VarianceT const &var, int const flags,
+                                std::vector<typename ImageT::Pixel> *values,
+                                std::vector<double> *variances);
+    template<typename Pixel>
+    std::pair<double, double> _getClipped(std::vector<Pixel> const &values,
+                                          std::vector<double> const &variances,
+                                          std::pair<double, double> clipinfo);
 
     template<typename Pixel>
     double _percentile(std::vector<Pixel> &img, double const percentile);   
@@ -250,7 +241,7 @@ private:
     template<typename Pixel>
     MedianQuartileReturn _medianAndQuartiles(std::vector<Pixel> &img);
     
-    inline double _varianceError(double const variance, int const n) const {
+    inline double _varianceError(double const variance, long long const n) const {
         return 2*(n - 1)*variance*variance/(static_cast<double>(n)*n); // assumes a Gaussian
     }
 
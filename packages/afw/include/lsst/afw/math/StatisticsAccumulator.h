@@ -0,0 +1,155 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#if !defined(LSST_AFW_MATH_STATISTICSACCUMULATOR_H)
+#define LSST_AFW_MATH_STATISTICSACCUMULATOR_H
+/**
+ * @file StatisticsAccumulator.h
+ * @brief Accumulate image statistics incrementally
+ * @ingroup afw
+ */
+
+#include <vector>
+#include "boost/shared_ptr.hpp"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/Statistics.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+
+/**
+ * @ingroup afw
+ *
+ * @brief Accumulate the statistics of a set of pixels that are provided a piece at a time
+ *
+ * Pixels may be added one at a time or as (Masked)Images, and the accumulators for different
+ * pieces (e.g. the amplifiers of a CCD, or the CCDs of a focal plane, processed in different threads)
+ * may be merged.  When all the pixels have been added, finalize() returns a Statistics object
+ * that provides the requested properties.
+ *
+ * The pixel values are kept, and the results are exactly those that makeStatistics() would return,
+ * until more than maxValues values have been added.  After that the values are replaced by a histogram of
+ * at most maxValues bins (of width a power of 2, so that histograms may be merged without resampling),
+ * and MEDIAN, IQRANGE, and the clipped statistics are approximations whose precision is set by the bin
+ * width.  The histogram keeps the moments of the values in each bin, so the clipped mean and variance
+ * are only affected by the bins straddling the clipping limits.  The memory used is thus bounded by
+ * maxValues, however many pixels are added;  if maxValues is 0 all the values are kept.
+ *
+ * The unclipped properties (NPOINT, MEAN, STDEV, VARIANCE, MIN, MAX, SUM, MEANSQUARE, ORMASK)
+ * are always exact.
+ *
+ * @code
+        lsst::afw::math::StatisticsAccumulator total(afwMath::MEDIAN | afwMath::MEANCLIP, sctrl, 4096);
+        for (int i = 0; i != nAmp; ++i) {
+            lsst::afw::math::StatisticsAccumulator amp(afwMath::MEDIAN | afwMath::MEANCLIP, sctrl, 4096);
+            amp.add(*amps[i]);
+            total.merge(amp);
+        }
+        double const median = total.finalize().getValue(afwMath::MEDIAN);
+ * @endcode
+ */
+class StatisticsAccumulator {
+public:
+    typedef boost::shared_ptr<StatisticsAccumulator> Ptr;
+    typedef boost::shared_ptr<StatisticsAccumulator const> ConstPtr;
+
+    explicit StatisticsAccumulator(int const flags,
+                                   StatisticsControl const& sctrl = StatisticsControl(),
+                                   int const maxValues = 0
+                                  );
+
+    void add(double const value,
+             lsst::afw::image::MaskPixel const mask = 0x0,
+             lsst::afw::image::VariancePixel const variance = 1.0
+            );
+    template<typename PixelT>
+    void add(lsst::afw::image::Image<PixelT> const& img);
+    template<typename PixelT>
+    void add(lsst::afw::image::MaskedImage<PixelT> const& mimg);
+
+    void merge(StatisticsAccumulator const& other);
+
+    Statistics finalize() const;
+
+    /// Return the number of values that have been accepted
+    long long getNpoint() const { return _all.n; }
+    /// Return true if the values have been replaced by a histogram, so the quantiles are approximate
+    bool isApproximate() const { return !_bins.empty(); }
+
+private:
+    /*
+     * The (weighted) moments of a set of values, relative to some shift
+     */
+    struct Moments {
+        Moments() : n(0), wsum(0.0), sum(0.0), sumx2(0.0) {}
+
+        void add(double const delta, double const weight) {
+            ++n;
+            wsum += weight;
+            sum += weight*delta;
+            sumx2 += weight*delta*delta;
+        }
+        void merge(Moments const& other, double const shift);
+
+        long long n;                    // number of values
+        double wsum;                    // sum of the weights
+        double sum;                     // sum of the weighted values
+        double sumx2;                   // sum of the weighted squared values
+    };
+
+    int _flags;                         // The desired calculation
+    StatisticsControl _sctrl;           // the control structure
+    int _maxValues;                     // the maximum number of values (or bins) to keep; 0 => no limit
+
+    double _shift;                      // the value subtracted from all values (for numerical stability)
+    Moments _all;                       // the moments of all the accepted values
+    double _min;                        // the minimum value
+    double _max;                        // the maximum value
+    lsst::afw::image::MaskPixel _orMask; // the 'or' of all the accepted pixels' masks
+
+    std::vector<double> _values;        // the values, until there are more than _maxValues of them
+    std::vector<double> _weights;       // the corresponding weights (if weighted)
+
+    int _binExp;                        // the width of each bin is 2^_binExp
+    long _binOffset;                    // the index of _bins[0]
+    std::vector<Moments> _bins;         // the histogram (if there were too many values to keep)
+
+    void _addValue(double const value, double const weight);
+    void _keepValue(double const value, double const weight);
+    void _makeHistogram();
+    void _binValue(double const value, double const weight);
+    void _includeBins(long const lo, long const hi);
+    void _coarsen();
+    void _mergeBins(StatisticsAccumulator const& other);
+
+    double _percentile(std::vector<double> &values, double const fraction) const;
+    double _histogramPercentile(double const fraction) const;
+    Moments _clip(double const center, double const hwidth) const;
+};
+
+}}}
+
+#endif
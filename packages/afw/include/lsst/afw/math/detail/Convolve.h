@@ -83,7 +83,22 @@ namespace detail {
             OutImageT &convolvedImage,
             InImageT const& inImage,
             lsst::afw::math::Kernel const& kernel,
-            bool doNormalize);
+            bool doNormalize,
+            int nThread = 1);
+
+    bool isFftConvolutionPreferred(
+            lsst::afw::math::Kernel const& kernel,
+            lsst::afw::math::ConvolutionControl const& convolutionControl);
+
+    template <typename OutImageT, typename InImageT>
+    void convolveWithFft(
+            OutImageT &convolvedImage,
+            InImageT const& inImage,
+            lsst::afw::math::Kernel const& kernel,
+            bool doNormalize,
+            int nThread = 1);
+
+    void clearFftCache();
 
     // I would prefer this to be nested in KernelImagesForRegion but SWIG doesn't support that
     class RowOfKernelImagesForRegion;
@@ -0,0 +1,117 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_AFW_MATH_DETAIL_IMAGEPLANES_H
+#define LSST_AFW_MATH_DETAIL_IMAGEPLANES_H
+/**
+ * @file
+ *
+ * @brief Views of the planes of an Image or MaskedImage, for code that processes them a plane at a time
+ *
+ * ndarray's reference counts aren't thread safe, so code that shares an image between threads
+ * should make these views in the calling thread; the threads may then use the views' data,
+ * but mustn't copy the views (or index them with [], which makes new views).
+ *
+ * @ingroup afw
+ */
+#include "lsst/ndarray.h"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/Mask.h"
+#include "lsst/afw/image/MaskedImage.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+    /**
+     * @brief Writable view of the pixels of an Image
+     */
+    template <typename ImageT>
+    struct OutputPlanes {
+        typedef typename ImageT::Pixel PixelT;
+
+        explicit OutputPlanes(ImageT &im) : image(im.getArray()) {}
+
+        lsst::ndarray::Array<PixelT, 2, 1> const image;
+    };
+
+    /**
+     * @brief Writable views of the image, mask and variance planes of a MaskedImage
+     */
+    template <typename PixelT>
+    struct OutputPlanes<lsst::afw::image::MaskedImage<PixelT, lsst::afw::image::MaskPixel,
+                                                      lsst::afw::image::VariancePixel> > {
+        explicit OutputPlanes(
+            lsst::afw::image::MaskedImage<PixelT, lsst::afw::image::MaskPixel,
+                                          lsst::afw::image::VariancePixel> &maskedImage
+        ) :
+            image(maskedImage.getImage()->getArray()),
+            mask(maskedImage.getMask()->getArray()),
+            variance(maskedImage.getVariance()->getArray())
+        {}
+
+        lsst::ndarray::Array<PixelT, 2, 1> const image;
+        lsst::ndarray::Array<lsst::afw::image::MaskPixel, 2, 1> const mask;
+        lsst::ndarray::Array<lsst::afw::image::VariancePixel, 2, 1> const variance;
+    };
+
+    /**
+     * @brief Read-only view of the pixels of an Image
+     */
+    template <typename ImageT>
+    struct InputPlanes {
+        typedef typename ImageT::Pixel PixelT;
+
+        explicit InputPlanes(ImageT const &im) : image(im.getArray()) {}
+
+        lsst::ndarray::Array<PixelT const, 2, 1> const image;
+    };
+
+    /**
+     * @brief Read-only views of the image, mask and variance planes of a MaskedImage
+     */
+    template <typename PixelT>
+    struct InputPlanes<lsst::afw::image::MaskedImage<PixelT, lsst::afw::image::MaskPixel,
+                                                     lsst::afw::image::VariancePixel> > {
+        explicit InputPlanes(
+            lsst::afw::image::MaskedImage<PixelT, lsst::afw::image::MaskPixel,
+                                          lsst::afw::image::VariancePixel> const &maskedImage
+        ) :
+            image(static_cast<lsst::afw::image::Image<PixelT> const &>(
+                      *maskedImage.getImage()).getArray()),
+            mask(static_cast<lsst::afw::image::Mask<lsst::afw::image::MaskPixel> const &>(
+                     *maskedImage.getMask()).getArray()),
+            variance(static_cast<lsst::afw::image::Image<lsst::afw::image::VariancePixel> const &>(
+                         *maskedImage.getVariance()).getArray())
+        {}
+
+        lsst::ndarray::Array<PixelT const, 2, 1> const image;
+        lsst::ndarray::Array<lsst::afw::image::MaskPixel const, 2, 1> const mask;
+        lsst::ndarray::Array<lsst::afw::image::VariancePixel const, 2, 1> const variance;
+    };
+
+}}}} // lsst::afw::math::detail
+
+#endif // !defined(LSST_AFW_MATH_DETAIL_IMAGEPLANES_H)
@@ -0,0 +1,146 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_AFW_MATH_DETAIL_PARALLEL_H
+#define LSST_AFW_MATH_DETAIL_PARALLEL_H
+/**
+ * @file
+ *
+ * @brief Support for sharing independent pieces of work between threads
+ *
+ * @ingroup afw
+ */
+#include <algorithm>
+#include <exception>
+#include <string>
+
+#include "boost/shared_ptr.hpp"
+#include "boost/thread.hpp"
+
+#include "lsst/pex/exceptions.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+    int getNumThreads(int nThread);
+
+    /**
+     * @brief The state shared by the threads running a parallelFor
+     *
+     * Hands out the indices to be processed, and remembers the first exception thrown by any thread
+     */
+    class ParallelForState {
+    public:
+        ParallelForState(int begin, int end) : _next(begin), _end(end), _error(), _isFailed(false) {}
+
+        bool next(int &i);
+        void setError(lsst::pex::exceptions::Exception const &e);
+        void setError(std::string const &what);
+        void rethrow() const;
+
+    private:
+        boost::mutex _mutex;
+        int _next;                      // the next index to hand out
+        int const _end;                 // one past the last index
+        boost::shared_ptr<lsst::pex::exceptions::Exception> _error; // the first exception thrown
+        bool _isFailed;                 // has a call failed?
+    };
+
+    /**
+     * @brief The function run by each thread of a parallelFor
+     */
+    template <typename FunctionT>
+    class ParallelForTask {
+    public:
+        ParallelForTask(FunctionT const &func, ParallelForState &state) : _func(func), _state(state) {}
+
+        void operator()() const {
+            int i;
+            while (_state.next(i)) {
+                try {
+                    _func(i);
+                } catch (lsst::pex::exceptions::Exception &e) {
+                    _state.setError(e);
+                } catch (std::exception &e) {
+                    _state.setError(e.what());
+                } catch (...) {
+                    _state.setError("Unknown exception");
+                }
+            }
+        }
+
+    private:
+        FunctionT const &_func;
+        ParallelForState &_state;
+    };
+
+    /**
+     * @brief Call func(i) for each i in [begin, end), sharing the calls between nThread threads
+     *
+     * The indices are handed out one at a time, so the calls may take very different amounts of time.
+     * The calling thread does its share of the work;  if nThread is 1 (or there's only one index) no threads
+     * are started and the calls are made in order.
+     *
+     * If a call throws, no further calls are started and the first exception is rethrown in the calling
+     * thread once all the threads have finished.  LSST exceptions keep their type; other exceptions thrown
+     * in other threads are rethrown as a RuntimeErrorException
+     *
+     * func may construct and destroy lsst::daf::base::Citizen objects (e.g. Images), as their bookkeeping
+     * is thread safe, but it's cheaper to allocate any large temporaries once per chunk.
+     */
+    template <typename FunctionT>
+    void parallelFor(int const begin,         ///< first index to process
+                     int const end,           ///< one past the last index to process
+                     FunctionT const &func,   ///< function to call with each index
+                     int const nThread        ///< number of threads to use; <= 0 means one per core
+                    ) {
+        int const nWorker = std::min(getNumThreads(nThread), end - begin);
+        if (nWorker <= 1) {
+            for (int i = begin; i < end; ++i) {
+                func(i);
+            }
+            return;
+        }
+
+        ParallelForState state(begin, end);
+        ParallelForTask<FunctionT> const task(func, state);
+        boost::thread_group threads;
+        try {
+            for (int t = 1; t < nWorker; ++t) {
+                threads.create_thread(task);
+            }
+        } catch (boost::thread_resource_error &) { // run with the threads that we have
+            ;
+        }
+        task();
+        threads.join_all();
+
+        state.rethrow();
+    }
+
+}}}}
+
+#endif // !defined(LSST_AFW_MATH_DETAIL_PARALLEL_H)
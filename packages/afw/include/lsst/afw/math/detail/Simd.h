@@ -0,0 +1,81 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_AFW_MATH_DETAIL_SIMD_H
+#define LSST_AFW_MATH_DETAIL_SIMD_H
+/**
+ * @file
+ *
+ * @brief Vectorized operations on rows of pixels, used by the convolution code
+ *
+ * The float and double versions use the best SIMD instructions that both the compiler and the CPU
+ * support (chosen at run time), and give the same results as the scalar versions.
+ *
+ * @ingroup afw
+ */
+#include "lsst/afw/image/LsstImageTypes.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+    /**
+     * @brief Instruction sets that the row operations may use, in order of preference
+     */
+    enum SimdLevel {
+        SIMD_NONE = 0,                  ///< scalar code only
+        SIMD_SSE2,                      ///< SSE2; 128-bit registers
+        SIMD_AVX                        ///< AVX; 256-bit registers
+    };
+
+    SimdLevel getMaxSimdLevel();
+    SimdLevel getSimdLevel();
+    void setSimdLevel(SimdLevel level);
+
+    void addScaledRow(double *out, double const *in, double scale, int n);
+    void addScaledRow(double *out, float const *in, double scale, int n);
+    void addScaledRow(float *out, float const *in, double scale, int n);
+    void orRow(lsst::afw::image::MaskPixel *out, lsst::afw::image::MaskPixel const *in, int n);
+
+    /**
+     * @brief Set out[i] += in[i]*scale for i in [0, n)
+     *
+     * The generic (scalar) version, for pixel types without a vectorized overload.
+     * Each product is computed in double precision, and converted to OutPixelT before it's added.
+     */
+    template <typename OutPixelT, typename InPixelT>
+    inline void addScaledRow(OutPixelT *out,    ///< row to add to
+                             InPixelT const *in, ///< row to add
+                             double scale,      ///< multiply in by this before adding it to out
+                             int n)             ///< number of pixels in the rows
+    {
+        for (int i = 0; i != n; ++i) {
+            out[i] += static_cast<OutPixelT>(in[i]*scale);
+        }
+    }
+
+}}}} // lsst::afw::math::detail
+
+#endif // !defined(LSST_AFW_MATH_DETAIL_SIMD_H)
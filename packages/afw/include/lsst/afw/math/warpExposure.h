@@ -36,9 +36,12 @@
 #define LSST_AFW_MATH_WARPEXPOSURE_H
 
 #include <string>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 
+#include "lsst/afw/geom/Box.h"
+#include "lsst/afw/geom/Point.h"
 #include "lsst/afw/image/Exposure.h"
 #include "lsst/afw/math/ConvolveImage.h"
 #include "lsst/afw/math/Function.h"
@@ -180,11 +183,61 @@ namespace math {
     
     boost::shared_ptr<SeparableKernel> makeWarpingKernel(std::string name);
 
+    /**
+    * \brief An approximation to the position on a source %image of each pixel of a destination %image.
+    *
+    * The position on the source of a destination pixel, srcWcs.skyToPixel(destWcs.pixelToSky(destPos)),
+    * is computed exactly on a regular grid of nodes and bilinearly interpolated between them.
+    * The grid covers the destination bounding box plus one extra column on the left and one extra row
+    * on the bottom (used by warpImage to compute the relative area of each pixel).
+    *
+    * The grid spacing starts at maxSpacing (less for a small bounding box) and is halved until the grid
+    * at a given spacing predicts the positions at the nodes of the grid at half that spacing to within
+    * maxError pixels;
+    * the finer of the two grids is then used, so the actual error is usually well within maxError.
+    * At worst the spacing is one pixel, and every position is computed exactly.
+    *
+    * Once built, a grid may be used to warp any number of images with the same pair of Wcs
+    * and destination bounding box, which saves recomputing the Wcs transforms for each %image.
+    */
+    class SrcPositionGrid {
+    public:
+        typedef boost::shared_ptr<SrcPositionGrid> Ptr;
+        typedef boost::shared_ptr<SrcPositionGrid const> ConstPtr;
+
+        explicit SrcPositionGrid(
+            lsst::afw::image::Wcs const &destWcs,
+            lsst::afw::image::Wcs const &srcWcs,
+            lsst::afw::geom::Box2I const &destBBox,
+            double maxError = 0.01,
+            int maxSpacing = 256);
+
+        lsst::afw::geom::Point2D getSrcPosition(int x, int y) const;
+        void getSrcPositions(int x0, int y, int n, lsst::afw::geom::Point2D *srcPosXY) const;
+
+        /// Return the destination bounding box (parent pixels; excludes the extra row and column)
+        lsst::afw::geom::Box2I getDestBBox() const { return _destBBox; }
+        /// Return the maximum error requested, in source pixels
+        double getMaxError() const { return _maxError; }
+        /// Return the spacing of the grid nodes, in destination pixels
+        int getSpacing() const { return _spacing; }
+
+    private:
+        lsst::afw::geom::Box2I _destBBox;
+        double _maxError;
+        int _x0;                        ///< x index of the first column of nodes
+        int _y0;                        ///< y index of the first row of nodes
+        int _spacing;
+        int _nCellX;                    ///< number of grid cells in x; there are _nCellX + 1 nodes per row
+        int _nCellY;                    ///< number of grid cells in y
+        std::vector<lsst::afw::geom::Point2D> _nodes;   ///< source position of each node; x varies fastest
+    };
+
     template<typename DestExposureT, typename SrcExposureT>
     int warpExposure(
         DestExposureT &destExposure,
         SrcExposureT const &srcExposure,
-        SeparableKernel &warpingKernel, int const interpLength=0);
+        SeparableKernel &warpingKernel, int const interpLength=0, int const nThread=1);
 
     template<typename DestImageT, typename SrcImageT>
     int warpImage(
@@ -192,7 +245,14 @@ namespace math {
         lsst::afw::image::Wcs const &destWcs,
         SrcImageT const &srcImage,
         lsst::afw::image::Wcs const &srcWcs,
-        SeparableKernel &warpingKernel, int const interpLength=0);
+        SeparableKernel &warpingKernel, int const interpLength=0, int const nThread=1);
+
+    template<typename DestImageT, typename SrcImageT>
+    int warpImage(
+        DestImageT &destImage,
+        SrcImageT const &srcImage,
+        SrcPositionGrid const &srcPositionGrid,
+        SeparableKernel &warpingKernel, int const nThread=1);
 
     namespace details {
         template <typename A, typename B>
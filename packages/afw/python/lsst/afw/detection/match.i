@@ -25,6 +25,7 @@
 %{
 #include "lsst/afw/detection/Source.h"
 #include "lsst/afw/detection/SourceMatch.h"
+#include "lsst/afw/detection/SourceIndex.h"
 %}
 
 SWIG_SHARED_PTR(PersistableSourceMatchVector,
@@ -34,6 +35,8 @@ SWIG_SHARED_PTR(PersistableSourceMatchVector,
 
 %template(SourceMatchVector) std::vector<lsst::afw::detection::SourceMatch>;
 
+%include "lsst/afw/detection/SourceIndex.h"
+
 SWIG_SHARED_PTR_DERIVED(PersistableSourceMatchVector,
                         lsst::daf::base::Persistable,
                         lsst::afw::detection::PersistableSourceMatchVector);
@@ -29,6 +29,7 @@
 #include "lsst/afw/detection/BaseSourceAttributes.h"
 #include "lsst/afw/detection/Source.h"
 #include "lsst/afw/detection/DiaSource.h"
+#include "lsst/afw/detection/SourceTable.h"
 #include "lsst/afw/detection/Astrometry.h"
 #include "lsst/afw/detection/Photometry.h"
 #include "lsst/afw/detection/Shape.h"
@@ -58,6 +59,9 @@ SWIG_SHARED_PTR_DERIVED(PersistableSourceVector,
 SWIG_SHARED_PTR_DERIVED(PersistableDiaSourceVector,
     lsst::daf::base::Persistable,
     lsst::afw::detection::PersistableDiaSourceVector);
+SWIG_SHARED_PTR_DERIVED(SourceTable,
+    lsst::daf::base::Persistable,
+    lsst::afw::detection::SourceTable);
 
 %include "lsst/afw/formatters/Utils.h"
 %include "lsst/afw/detection/BaseSourceAttributes.h"    
@@ -182,3 +186,33 @@ DiaSource.__str__ = DiaSource.toString
 %boost_picklable(lsst::afw::detection::PersistableDiaSourceVector);
 
 %template(PersistableSourceVectorVector) std::vector<lsst::afw::detection::PersistableSourceVector::Ptr>;
+
+/************************************************************************************************************/
+// Column-oriented catalogs; the get<Field>Column() methods return numpy arrays that share the table's memory
+
+%declareNumPyConverters(lsst::ndarray::Array<double,1,1>);
+%declareNumPyConverters(lsst::ndarray::Array<float,1,1>);
+%declareNumPyConverters(lsst::ndarray::Array<boost::int64_t,1,1>);
+%declareNumPyConverters(lsst::ndarray::Array<boost::int32_t,1,1>);
+%declareNumPyConverters(lsst::ndarray::Array<boost::int16_t,1,1>);
+%declareNumPyConverters(lsst::ndarray::Array<boost::int8_t,1,1>);
+%declareNumPyConverters(lsst::ndarray::Array<bool,1,1>);
+
+%extend lsst::afw::detection::SourceTable {
+    int __len__() const { return $self->size(); }
+    lsst::afw::detection::SourceRecord _getRecord(int n) { return (*$self)[n]; }
+
+    %pythoncode {
+    def __getitem__(self, n):
+        """Return a view of row n; it's only valid while the table exists"""
+        if n < 0:
+            n += len(self)
+        if n < 0 or n >= len(self):
+            raise IndexError(n)
+        return self._getRecord(n)
+    }
+}
+
+%include "lsst/afw/detection/SourceTable.h"
+
+%lsst_persistable(lsst::afw::detection::SourceTable);
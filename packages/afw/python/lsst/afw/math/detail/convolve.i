@@ -24,6 +24,7 @@
  
 %{
 #include "lsst/afw/math/detail/Convolve.h"
+#include "lsst/afw/math/detail/Simd.h"
 %}
 
 SWIG_SHARED_PTR_DERIVED(KernelImagesForRegion,
@@ -31,6 +32,11 @@ SWIG_SHARED_PTR_DERIVED(KernelImagesForRegion,
 
 %include "lsst/afw/math/detail/Convolve.h"
 
+// Only the choice of instruction set is of interest to Python (for testing)
+%ignore lsst::afw::math::detail::addScaledRow;
+%ignore lsst::afw::math::detail::orRow;
+%include "lsst/afw/math/detail/Simd.h"
+
 // Functions to convolve a MaskedImage or Image with a Kernel.
 // There are a lot of these, so write a set of macros to do the instantiations
 //
@@ -50,6 +56,8 @@ lsst::afw::image::MaskedImage<PIXTYPE, lsst::afw::image::MaskPixel, lsst::afw::i
     %template(basicConvolve) lsst::afw::math::detail::basicConvolve<IMAGE(PIXTYPE1), IMAGE(PIXTYPE2)>;
     %template(convolveWithBruteForce)
         lsst::afw::math::detail::convolveWithBruteForce<IMAGE(PIXTYPE1), IMAGE(PIXTYPE2)>;
+    %template(convolveWithFft)
+        lsst::afw::math::detail::convolveWithFft<IMAGE(PIXTYPE1), IMAGE(PIXTYPE2)>;
     %template(convolveWithInterpolation)
         lsst::afw::math::detail::convolveWithInterpolation<IMAGE(PIXTYPE1), IMAGE(PIXTYPE2)>;
     %template(convolveRegionWithInterpolation)
@@ -24,16 +24,24 @@
  
 %{
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/StatisticsAccumulator.h"
 %}
 
 SWIG_SHARED_PTR(StatisticsControlPtr, lsst::afw::math::StatisticsControl);
 
 %include "lsst/afw/math/Statistics.h"
 
+SWIG_SHARED_PTR(StatisticsAccumulatorPtr, lsst::afw::math::StatisticsAccumulator);
+
+%include "lsst/afw/math/StatisticsAccumulator.h"
+
 
 %define %declareStats(PIXTYPE, SUFFIX)
 %template(makeStatistics) lsst::afw::math::makeStatistics<PIXTYPE>;
 %template(Statistics ## SUFFIX) lsst::afw::math::Statistics::Statistics<lsst::afw::image::Image<PIXTYPE>, lsst::afw::image::Mask<lsst::afw::image::MaskPixel>, lsst::afw::image::Image<lsst::afw::image::VariancePixel> >;
+%extend lsst::afw::math::StatisticsAccumulator {
+    %template(add) add<PIXTYPE>;
+}
 %enddef
 
 %declareStats(unsigned short, U)
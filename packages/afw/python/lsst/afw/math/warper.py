@@ -50,17 +50,19 @@ def computeWarpedBBox(destWcs, srcBBox, srcWcs):
 class Warper(object):
     """Warp images
     """
-    def __init__(self, warpingKernelName, interpLength=10, cacheSize=0):
+    def __init__(self, warpingKernelName, interpLength=10, cacheSize=0, nThread=1):
         """Create a Warper
         
         Inputs:
         - warpingKernelName: argument to lsst.afw.math.makeWarpingKernel
         - interpLength: interpLength argument to lsst.afw.warpExposure
         - cacheSize: size of computeCache
+        - nThread: nThread argument to lsst.afw.math.warpImage; <= 0 for one thread per core
         """
         self._warpingKernel = _afw_math.makeWarpingKernel(warpingKernelName)
         self._warpingKernel.computeCache(cacheSize)
         self._interpLength = int(interpLength)
+        self._nThread = int(nThread)
 
     @classmethod
     def fromPolicy(cls, policy):
@@ -72,6 +74,7 @@ class Warper(object):
             warpingKernelName = policy.getString("warpingKernelName"),
             interpLength = policy.getInt("interpLength"),
             cacheSize = policy.getInt("cacheSize"),
+            nThread = policy.getInt("nThread"),
         )
     
     def getWarpingKernel(self):
@@ -134,6 +137,7 @@ class Warper(object):
             if maxBBox:
                 destBBox.clip(maxBBox)
         warpedImage = srcImage.Factory(destBBox)
-        _afw_math.warpImage(warpedImage, destWcs, srcImage, srcWcs, self._warpingKernel, self._interpLength)
+        _afw_math.warpImage(warpedImage, destWcs, srcImage, srcWcs, self._warpingKernel, self._interpLength,
+            self._nThread)
         return warpedImage
 
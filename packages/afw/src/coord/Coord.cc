@@ -31,9 +31,11 @@
  * Most (nearly all) algorithms adapted from Astronomical Algorithms, 2nd ed. (J. Meeus)
  *
  */
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <cstdio>
+#include <map>
 
 #include "Eigen/Core.h"
 #include "Eigen/LU"
@@ -197,6 +199,34 @@ double pointToLatitude(lsst::afw::geom::Point3D const &p3d) {
     return lat;
 }
 
+/*
+ * Compute the angles (in radians) of the rotations that precess Fk5 coordinates between two epochs
+ */
+void computePrecessionAngles(
+                             double const epochFrom, ///< epoch to precess from
+                             double const epochTo,   ///< epoch to precess to
+                             double &xi,             ///< rotation about the pole at epochFrom
+                             double &z,              ///< rotation about the pole at epochTo
+                             double &theta           ///< inclination between the two poles
+                            ) {
+    dafBase::DateTime const dateFrom(epochFrom, dafBase::DateTime::EPOCH, dafBase::DateTime::TAI);
+    dafBase::DateTime const dateTo(epochTo, dafBase::DateTime::EPOCH, dafBase::DateTime::TAI);
+    double const jd0 = dateFrom.get(dafBase::DateTime::JD);
+    double const jd  = dateTo.get(dafBase::DateTime::JD);
+
+    double const T   = (jd0 - JD2000)/36525.0;
+    double const t   = (jd - jd0)/36525.0;
+    double const tt  = t*t;
+    double const ttt = tt*t;
+
+    xi    = arcsecToRad*((2306.2181 + 1.39656*T - 0.000139*T*T)*t +
+                         (0.30188 - 0.000344*T)*tt + 0.017998*ttt);
+    z     = arcsecToRad*((2306.2181 + 1.39656*T - 0.000139*T*T)*t +
+                         (1.09468 + 0.000066*T)*tt + 0.018203*ttt);
+    theta = arcsecToRad*((2004.3109 - 0.85330*T - 0.000217*T*T)*t -
+                         (0.42665 + 0.000217*T)*tt - 0.041833*ttt);
+}
+
 
     
 } // end anonymous namespace
@@ -908,22 +938,8 @@ afwCoord::Fk5Coord afwCoord::Fk5Coord::precess(
         return Fk5Coord(getLongitude(DEGREES), getLatitude(DEGREES), getEpoch());
     }
     
-    dafBase::DateTime const dateFrom(getEpoch(), dafBase::DateTime::EPOCH, dafBase::DateTime::TAI);
-    dafBase::DateTime const dateTo(epochTo, dafBase::DateTime::EPOCH, dafBase::DateTime::TAI);
-    double const jd0 = dateFrom.get(dafBase::DateTime::JD);
-    double const jd  = dateTo.get(dafBase::DateTime::JD);
-
-    double const T   = (jd0 - JD2000)/36525.0;
-    double const t   = (jd - jd0)/36525.0;
-    double const tt  = t*t;
-    double const ttt = tt*t;
-
-    double const xi    = arcsecToRad*((2306.2181 + 1.39656*T - 0.000139*T*T)*t +
-                                      (0.30188 - 0.000344*T)*tt + 0.017998*ttt);
-    double const z     = arcsecToRad*((2306.2181 + 1.39656*T - 0.000139*T*T)*t +
-                                      (1.09468 + 0.000066*T)*tt + 0.018203*ttt);
-    double const theta = arcsecToRad*((2004.3109 - 0.85330*T - 0.000217*T*T)*t -
-                                      (0.42665 + 0.000217*T)*tt - 0.041833*ttt);
+    double xi, z, theta;
+    computePrecessionAngles(getEpoch(), epochTo, xi, z, theta);
 
     Fk5Coord fk5 = this->toFk5();
     double const alpha0 = fk5.getRa(RADIANS);
@@ -1133,6 +1149,338 @@ afwCoord::TopocentricCoord afwCoord::TopocentricCoord::toTopocentric() const {
 
 
 
+/* ============================================================
+ *
+ * Bulk conversions
+ *
+ * ============================================================*/
+
+namespace {
+
+int const coordBlockSize = 256;  ///< number of positions converted together by CoordTransform::apply
+
+/*
+ * Return the matrix that rotates a unit vector about the z axis by phi radians
+ */
+Eigen::Matrix3d rotationAboutZ(double const phi) {
+    Eigen::Matrix3d m;
+    m << cos(phi), -sin(phi), 0.0,
+         sin(phi),  cos(phi), 0.0,
+         0.0,       0.0,      1.0;
+    return m;
+}
+
+/*
+ * Return the matrix that applies Coord::transform(poleTo, poleFrom) to a unit vector
+ */
+Eigen::Matrix3d transformMatrix(
+                                afwCoord::Coord const &poleTo,   ///< Pole of the destination system
+                                afwCoord::Coord const &poleFrom  ///< Pole of the current system
+                               ) {
+    double const alphaGP  = poleFrom[0];
+    double const deltaGP  = poleFrom[1];
+    double const lCP      = poleTo[0];
+
+    // measure longitudes from alphaGP, and tip the destination pole to the z axis ...
+    Eigen::Matrix3d tip;
+    tip << -sin(deltaGP), 0.0, cos(deltaGP),
+           0.0,           1.0, 0.0,
+           cos(deltaGP),  0.0, sin(deltaGP);
+    // ... then measure longitudes backwards from lCP
+    Eigen::Matrix3d flip;
+    flip << cos(lCP),  sin(lCP), 0.0,
+            sin(lCP), -cos(lCP), 0.0,
+            0.0,       0.0,      1.0;
+    return flip*tip*rotationAboutZ(-alphaGP);
+}
+
+/*
+ * Return the matrix that applies Fk5Coord::precess to a unit vector
+ */
+Eigen::Matrix3d precessionMatrix(double const epochFrom, double const epochTo) {
+    if (fabs(epochFrom - epochTo) < epochTolerance) {
+        return Eigen::Matrix3d::Identity();
+    }
+    double xi, z, theta;
+    computePrecessionAngles(epochFrom, epochTo, xi, z, theta);
+
+    Eigen::Matrix3d tilt;
+    tilt << cos(theta), 0.0, -sin(theta),
+            0.0,        1.0,  0.0,
+            sin(theta), 0.0,  cos(theta);
+    return rotationAboutZ(z)*tilt*rotationAboutZ(xi);
+}
+
+/*
+ * Return the matrix that converts a unit vector in a given system to Fk5, and set fk5Epoch to the epoch
+ * of the Fk5 coordinates
+ */
+Eigen::Matrix3d toFk5Matrix(afwCoord::CoordSystem const system, double const epoch, double &fk5Epoch) {
+    switch (system) {
+      case afwCoord::FK5:
+        fk5Epoch = epoch;
+        return Eigen::Matrix3d::Identity();
+      case afwCoord::ICRS:
+        fk5Epoch = 2000.0;
+        return Eigen::Matrix3d::Identity();
+      case afwCoord::GALACTIC:
+        fk5Epoch = 2000.0;
+        return transformMatrix(GalacticPoleInFk5, Fk5PoleInGalactic);
+      case afwCoord::ECLIPTIC:
+        {
+            double const eclPoleIncl = afwCoord::eclipticPoleInclination(epoch);
+            afwCoord::Coord const eclipticPoleInFk5(270.0, 90.0 - eclPoleIncl, epoch);
+            afwCoord::Coord const fk5PoleInEcliptic(90.0, 90.0 - eclPoleIncl, epoch);
+            fk5Epoch = epoch;
+            return transformMatrix(eclipticPoleInFk5, fk5PoleInEcliptic);
+        }
+      default:
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          "Undefined CoordSystem: only FK5, ICRS, GALACTIC, ECLIPTIC allowed.");
+    }
+}
+
+/*
+ * Return the matrix that converts a unit vector in Fk5 to a given system, and set fk5Epoch to the epoch
+ * of the Fk5 coordinates
+ */
+Eigen::Matrix3d fromFk5Matrix(afwCoord::CoordSystem const system, double const epoch, double &fk5Epoch) {
+    switch (system) {
+      case afwCoord::FK5:
+        fk5Epoch = epoch;
+        return Eigen::Matrix3d::Identity();
+      case afwCoord::ICRS:
+        fk5Epoch = 2000.0;
+        return Eigen::Matrix3d::Identity();
+      case afwCoord::GALACTIC:
+        fk5Epoch = 2000.0;
+        return transformMatrix(Fk5PoleInGalactic, GalacticPoleInFk5);
+      case afwCoord::ECLIPTIC:
+        {
+            double const eclPoleIncl = afwCoord::eclipticPoleInclination(epoch);
+            afwCoord::Coord const eclPoleInEquatorial(270.0, 90.0 - eclPoleIncl, epoch);
+            afwCoord::Coord const equPoleInEcliptic(90.0, 90.0 - eclPoleIncl, epoch);
+            fk5Epoch = epoch;
+            return transformMatrix(equPoleInEcliptic, eclPoleInEquatorial);
+        }
+      default:
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          "Undefined CoordSystem: only FK5, ICRS, GALACTIC, ECLIPTIC allowed.");
+    }
+}
+
+/*
+ * Return the factor that converts angles in the given units to radians
+ */
+double getRadiansPerUnit(afwCoord::CoordUnit const unit) {
+    switch (unit) {
+      case afwCoord::DEGREES:
+        return afwCoord::degToRad;
+      case afwCoord::RADIANS:
+        return 1.0;
+      default:
+        throw LSST_EXCEPT(ex::InvalidParameterException, "Units must be DEGREES or RADIANS.");
+    }
+}
+
+/*
+ * Check that a set of arrays all have the same length n
+ */
+void checkLengths(int const n, int const n1, int const n2, int const n3) {
+    if (n1 != n || n2 != n || n3 != n) {
+        throw LSST_EXCEPT(ex::LengthErrorException,
+                          (boost::format("Arrays have different lengths: %d, %d, %d, %d") %
+                           n % n1 % n2 % n3).str());
+    }
+}
+
+} // end anonymous namespace
+
+/**
+ * @brief Construct the conversion between two coordinate systems
+ *
+ * The result for Fk5 (or Ecliptic) coordinates is the same as converting them to Fk5, precessing
+ * them from fromEpoch to toEpoch, and converting them to toSystem.
+ *
+ * @throw lsst::pex::exceptions::InvalidParameterException if either system is TOPOCENTRIC
+ */
+afwCoord::CoordTransform::CoordTransform(
+    CoordSystem const fromSystem, ///< the system of the positions to convert
+    CoordSystem const toSystem,   ///< the system to convert them to
+    double const fromEpoch,       ///< the epoch of the positions to convert
+    double const toEpoch          ///< the epoch to convert them to
+                                        ) {
+    double fk5EpochFrom, fk5EpochTo;
+    Eigen::Matrix3d const toFk5 = toFk5Matrix(fromSystem, fromEpoch, fk5EpochFrom);
+    Eigen::Matrix3d const fromFk5 = fromFk5Matrix(toSystem, toEpoch, fk5EpochTo);
+    Eigen::Matrix3d const m = fromFk5*precessionMatrix(fk5EpochFrom, fk5EpochTo)*toFk5;
+    for (int i = 0; i != 3; ++i) {
+        for (int j = 0; j != 3; ++j) {
+            _matrix[i][j] = m(i, j);
+        }
+    }
+}
+
+/**
+ * @brief Convert arrays of positions
+ *
+ * Longitudes are returned in the range [0, 360) degrees.  The output arrays may be the input arrays.
+ *
+ * @throw lsst::pex::exceptions::LengthErrorException if the arrays don't all have the same length
+ * @throw lsst::pex::exceptions::InvalidParameterException if unit is HOURS
+ */
+void afwCoord::CoordTransform::apply(
+    lsst::ndarray::Array<double const,1,1> const &longitude, ///< longitudes to convert
+    lsst::ndarray::Array<double const,1,1> const &latitude,  ///< latitudes to convert
+    lsst::ndarray::Array<double,1,1> const &outLongitude,    ///< converted longitudes
+    lsst::ndarray::Array<double,1,1> const &outLatitude,     ///< converted latitudes
+    CoordUnit unit                                           ///< units of all the angles
+                                    ) const {
+    int const n = longitude.getSize<0>();
+    checkLengths(n, latitude.getSize<0>(), outLongitude.getSize<0>(), outLatitude.getSize<0>());
+    double const toRadians = getRadiansPerUnit(unit);
+    double const fromRadians = 1.0/toRadians;
+
+    double const *lon = longitude.getData();
+    double const *lat = latitude.getData();
+    double *outLon = outLongitude.getData();
+    double *outLat = outLatitude.getData();
+    //
+    // Convert the positions a block at a time, one step at a time, so that each step's loop can be
+    // vectorised:  to unit vectors, rotated unit vectors, and back to angles
+    //
+    double x[coordBlockSize], y[coordBlockSize], z[coordBlockSize];
+    for (int i0 = 0; i0 < n; i0 += coordBlockSize) {
+        int const nBlock = std::min(coordBlockSize, n - i0);
+
+        for (int i = 0; i < nBlock; ++i) {
+            double const alpha = toRadians*lon[i0 + i];
+            double const delta = toRadians*lat[i0 + i];
+            double const cosDelta = cos(delta);
+            x[i] = cos(alpha)*cosDelta;
+            y[i] = sin(alpha)*cosDelta;
+            z[i] = sin(delta);
+        }
+        for (int i = 0; i < nBlock; ++i) {
+            double const xi = x[i], yi = y[i], zi = z[i];
+            x[i] = _matrix[0][0]*xi + _matrix[0][1]*yi + _matrix[0][2]*zi;
+            y[i] = _matrix[1][0]*xi + _matrix[1][1]*yi + _matrix[1][2]*zi;
+            z[i] = _matrix[2][0]*xi + _matrix[2][1]*yi + _matrix[2][2]*zi;
+        }
+        for (int i = 0; i < nBlock; ++i) {
+            double alpha = atan2(y[i], x[i]);
+            if (alpha < 0.0) {
+                alpha += 2.0*M_PI;
+            }
+            outLon[i0 + i] = fromRadians*alpha;
+            // rounding may leave z (just) outside [-1, 1]
+            outLat[i0 + i] = fromRadians*asin(std::max(-1.0, std::min(1.0, z[i])));
+        }
+    }
+}
+
+/**
+ * @brief Convert a position vector
+ */
+afwGeom::Point3D afwCoord::CoordTransform::apply(lsst::afw::geom::Point3D const &p3d) const {
+    afwGeom::Point3D result;
+    for (int i = 0; i != 3; ++i) {
+        result[i] = _matrix[i][0]*p3d[0] + _matrix[i][1]*p3d[1] + _matrix[i][2]*p3d[2];
+    }
+    return result;
+}
+
+/**
+ * @brief Convert arrays of positions, each with its own epoch, to a single system and epoch
+ *
+ * A CoordTransform is computed for each distinct epoch, and applied to each run of consecutive
+ * positions with that epoch;  catalogues whose positions are grouped by epoch are converted fastest.
+ *
+ * @throw lsst::pex::exceptions::LengthErrorException if the arrays don't all have the same length
+ */
+void afwCoord::transformCoords(
+    CoordSystem const fromSystem,                             ///< the system of the positions to convert
+    CoordSystem const toSystem,                               ///< the system to convert them to
+    lsst::ndarray::Array<double const,1,1> const &fromEpoch,  ///< the epoch of each position
+    double const toEpoch,                                     ///< the epoch to convert them to
+    lsst::ndarray::Array<double const,1,1> const &longitude,  ///< longitudes to convert
+    lsst::ndarray::Array<double const,1,1> const &latitude,   ///< latitudes to convert
+    lsst::ndarray::Array<double,1,1> const &outLongitude,     ///< converted longitudes
+    lsst::ndarray::Array<double,1,1> const &outLatitude,      ///< converted latitudes
+    CoordUnit unit                                            ///< units of all the angles
+                              ) {
+    int const n = longitude.getSize<0>();
+    checkLengths(n, latitude.getSize<0>(), outLongitude.getSize<0>(), outLatitude.getSize<0>());
+    if (fromEpoch.getSize<0>() != n) {
+        throw LSST_EXCEPT(ex::LengthErrorException,
+                          (boost::format("%d epochs given for %d positions") %
+                           fromEpoch.getSize<0>() % n).str());
+    }
+
+    typedef std::map<double, CoordTransform> TransformMap;
+    TransformMap transforms;
+    for (int begin = 0; begin < n; ) {
+        double const epoch = fromEpoch[begin];
+        int end = begin + 1;
+        while (end < n && fromEpoch[end] == epoch) {
+            ++end;
+        }
+
+        TransformMap::iterator transform = transforms.find(epoch);
+        if (transform == transforms.end()) {
+            transform = transforms.insert(
+                std::make_pair(epoch, CoordTransform(fromSystem, toSystem, epoch, toEpoch))).first;
+        }
+        transform->second.apply(longitude[lsst::ndarray::view(begin, end)],
+                                latitude[lsst::ndarray::view(begin, end)],
+                                outLongitude[lsst::ndarray::view(begin, end)],
+                                outLatitude[lsst::ndarray::view(begin, end)], unit);
+
+        begin = end;
+    }
+}
+
+/**
+ * @brief Compute the angular separations between two arrays of positions
+ *
+ * The positions must be in the same coordinate system and epoch; the separations use the same haversine
+ * formula as Coord::angularSeparation.  The separation array may be one of the input arrays.
+ *
+ * @throw lsst::pex::exceptions::LengthErrorException if the arrays don't all have the same length
+ * @throw lsst::pex::exceptions::InvalidParameterException if unit is HOURS
+ */
+void afwCoord::angularSeparation(
+    lsst::ndarray::Array<double const,1,1> const &longitude1, ///< longitudes of the first positions
+    lsst::ndarray::Array<double const,1,1> const &latitude1,  ///< latitudes of the first positions
+    lsst::ndarray::Array<double const,1,1> const &longitude2, ///< longitudes of the second positions
+    lsst::ndarray::Array<double const,1,1> const &latitude2,  ///< latitudes of the second positions
+    lsst::ndarray::Array<double,1,1> const &separation,       ///< separation of each pair of positions
+    CoordUnit unit                                            ///< units of all the angles
+                                ) {
+    int const n = longitude1.getSize<0>();
+    checkLengths(n, latitude1.getSize<0>(), longitude2.getSize<0>(), latitude2.getSize<0>());
+    if (separation.getSize<0>() != n) {
+        throw LSST_EXCEPT(ex::LengthErrorException,
+                          (boost::format("Separation array has length %d, not %d") %
+                           separation.getSize<0>() % n).str());
+    }
+    double const toRadians = getRadiansPerUnit(unit);
+
+    double const *alpha1 = longitude1.getData();
+    double const *delta1 = latitude1.getData();
+    double const *alpha2 = longitude2.getData();
+    double const *delta2 = latitude2.getData();
+    double *dist = separation.getData();
+    for (int i = 0; i < n; ++i) {
+        double const sinDDeltaHalf = sin(0.5*toRadians*(delta1[i] - delta2[i]));
+        double const sinDAlphaHalf = sin(0.5*toRadians*(alpha1[i] - alpha2[i]));
+        double const havD = sinDDeltaHalf*sinDDeltaHalf +
+            cos(toRadians*delta1[i])*cos(toRadians*delta2[i])*sinDAlphaHalf*sinDAlphaHalf;
+        dist[i] = 2.0*asin(std::sqrt(havD))/toRadians;
+    }
+}
+
+
 /* ===============================================================================
  *
  * Factory function definitions:
@@ -44,8 +44,11 @@
  */
 #include <algorithm>
 #include <cassert>
+#include <set>
 #include <string>
 #include <typeinfo>
+#include <utility>
+#include <vector>
 #include "boost/format.hpp"
 #include "lsst/pex/exceptions.h"
 #include "lsst/pex/logging/Trace.h"
@@ -451,427 +454,345 @@ detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
     }
 }
 
-/************************************************************************************************************/
-/**
- * Return a FootprintSet consisting a Footprint containing the point (x, y) (if above threshold)
- *
- * \todo Implement this.  There's RHL Pan-STARRS code to do it, but it isn't yet converted to LSST C++
- */
-template<typename ImagePixelT, typename MaskPixelT>
-detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
-    const image::MaskedImage<ImagePixelT, MaskPixelT> & img, //!< Image to search for objects
-    Threshold const &,                                   //!< threshold to find objects
-    int,                                                 //!< Footprint should include this pixel (column)
-    int,                                                 //!< Footprint should include this pixel (row) 
-    std::vector<Peak> const *       //!< Footprint should include at most one of these peaks
-) : lsst::daf::data::LsstBase(typeid(this)),
-    _footprints(new FootprintList()),
-    _region(geom::Point2I(img.getX0(), img.getY0()),
-            geom::Extent2I(img.getWidth(), img.getHeight())) 
-{}
-
-
 /************************************************************************************************************/
 namespace {
     /// Don't let doxygen see this block  \cond
     /*
-     * A data structure to hold the starting point for a search for pixels above threshold,
-     * used by pmFindFootprintAtPoint
-     *
-     * We don't want to find this span again --- it's already part of the footprint ---
-     * so we set appropriate mask bits
+     * Disjoint sets of the integers 0..n-1 (with path compression and union by rank),
+     * used to join the Spans that make up a Footprint
      */
-    //
-    // An enum for what we should do with a Startspan
-    //
-    enum DIRECTION {DOWN = 0,   // scan down from this span
-                    UP,         // scan up from this span
-                    RESTART,     // restart scanning from this span
-                    DONE                // this span is processed
-    };
-    //
-    // A Class that remembers how to [re-]start scanning the image for pixels
-    //
-    template<typename MaskPixelT>
-    class Startspan {
+    class DisjointSets {
     public:
-        typedef std::vector<boost::shared_ptr<Startspan> > Ptr;
-        
-        Startspan(detection::Span const *span, image::Mask<MaskPixelT> *mask, DIRECTION const dir);
-        ~Startspan() { delete _span; }
-
-        bool getSpan() { return _span; }
-        bool Stop() { return _stop; }
-        DIRECTION getDirection() { return _direction; }
-
-        static int detectedPlane;       // The MaskPlane to use for detected pixels
-        static int stopPlane;           // The MaskPlane to use for pixels that signal us to stop searching
-    private:
-        detection::Span::Ptr const _span; // The initial Span
-        DIRECTION _direction;           // How to continue searching for further pixels
-        bool _stop;                     // should we stop searching?
-    };
-
-    template<typename MaskPixelT>
-    Startspan<MaskPixelT>::Startspan(detection::Span const *span, // The span in question
-                         image::Mask<MaskPixelT> *mask, // Pixels that we've already detected
-                         DIRECTION const dir // Should we continue searching towards the top of the image?
-                        ) :
-        _span(span),
-        _direction(dir),
-        _stop(false) {
-
-        if (mask != NULL) {                     // remember that we've detected these pixels
-            mask->setMaskPlaneValues(detectedPlane, span->getX0(), span->getX1(), span->getY());
-
-            int const y = span->getY() - mask->getY0();
-            for (int x = span->getX0() - mask->getX0(); x <= span->getX1() - mask->getX0(); x++) {
-                if (mask(x, y, stopPlane)) {
-                    _stop = true;
-                    break;
-                }
+        explicit DisjointSets(int n) : _parent(n), _rank(n, 0) {
+            for (int i = 0; i != n; ++i) {
+                _parent[i] = i;
+            }
+        }
+        /*
+         * Return the representative of the set containing i
+         */
+        int find(int i) {
+            int root = i;
+            while (_parent[root] != root) {
+                root = _parent[root];
+            }
+            while (_parent[i] != root) {
+                int const next = _parent[i];
+                _parent[i] = root;
+                i = next;
+            }
+            return root;
+        }
+        /*
+         * Merge the sets containing i and j
+         */
+        void join(int i, int j) {
+            i = find(i);
+            j = find(j);
+            if (i == j) {
+                return;
+            }
+            if (_rank[i] < _rank[j]) {
+                std::swap(i, j);
+            }
+            _parent[j] = i;
+            if (_rank[i] == _rank[j]) {
+                ++_rank[i];
             }
         }
-    }
-
-    template<typename ImagePixelT, typename MaskPixelT>
-    class StartspanSet {
-    public:
-        StartspanSet(image::MaskedImage<ImagePixelT, MaskPixelT>& image) :
-            _image(image->getImage()),
-            _mask(image->getMask()) {}
-        ~StartspanSet() {}
-
-        bool add(detection::Span *span, DIRECTION const dir, bool addToMask = true);
-        bool process(detection::Footprint *fp,          // the footprint that we're building
-                     detection::Threshold const &threshold, // Threshold
-                     double const param = -1);           // parameter that Threshold may need
     private:
-        image::Image<ImagePixelT> const *_image; // the Image we're searching
-        image::Mask<MaskPixelT> *_mask;          // the mask that tells us where we've got to
-        std::vector<typename Startspan<MaskPixelT>::Ptr> _spans; // list of Startspans
+        std::vector<int> _parent;
+        std::vector<int> _rank;
     };
-
-    //
-    // Add a new Startspan to a StartspansSet.  Iff we see a stop bit, return true
-    //
-    template<typename ImagePixelT, typename MaskPixelT>
-    bool StartspanSet<ImagePixelT, MaskPixelT>::add(detection::Span *span, // the span in question
-                                                    DIRECTION const dir, // the desired direction to search
-                                                    bool addToMask) { // should I add the Span to the mask?
-        if (dir == RESTART) {
-            if (add(span,  UP) || add(span, DOWN, false)) {
-                return true;
-            }
-        } else {
-            typename Startspan<MaskPixelT>::Ptr sspan(new Startspan<MaskPixelT>(span, dir));
-            if (sspan->stop()) {        // we detected a stop bit
+/*
+ * comparison functor; sort by row then starting column
+ */
+    struct IdSpanComparYX : public std::binary_function<IdSpan const &, IdSpan const &, bool> {
+        bool operator()(IdSpan const &a, IdSpan const &b) const {
+            if (a.y < b.y) {
                 return true;
+            } else if (a.y > b.y) {
+                return false;
             } else {
-                _spans.push_back(sspan);
+                return (a.x0 < b.x0) ? true : false;
             }
         }
+    };
+    /// \endcond
+}
 
-        return false;
-    }
-    
-    /************************************************************************************************/
-    /*
-     * Search the image for pixels above threshold, starting at a single Startspan.
-     * We search the array looking for one to process; it'd be better to move the
-     * ones that we're done with to the end, but it probably isn't worth it for
-     * the anticipated uses of this routine.
-     *
-     * This is the guts of pmFindFootprintAtPoint
-     */
-    template<typename ImagePixelT, typename MaskPixelT>
-    bool StartspanSet<ImagePixelT, MaskPixelT>::process(
-                detection::Footprint *fp,              // the footprint that we're building
-                detection::Threshold const &threshold, // Threshold
-                double const param                     // parameter that Threshold may need
-                                                             ) {
-        int const row0 = _image->getY0();
-        int const col0 = _image->getOffsetCols();
-        int const height = _image->getHeight();
-        int const width = _image->getWidth();
-        
-        /**********************************************************************************************/
-        
-        typedef typename std::vector<typename Startspan<MaskPixelT>::Ptr> StartspanListT;
-        typedef typename std::vector<typename Startspan<MaskPixelT>::Ptr>::iterator StartspanListIterT;
-
-        Startspan<MaskPixelT> *sspan = NULL;
-        for (StartspanListIterT iter = _spans.begin(); iter != _spans.end(); iter++) {
-            *sspan = *iter;
-            if (sspan->getDirection() != DONE) {
-                break;
-            }
-            if (sspan->Stop()) {
-                break;
+/*
+ * Merge a set of Footprints into the (8-connected) sets of pixels that they cover, appending the
+ * results to _footprints in order of their first pixel
+ *
+ * This is equivalent to setting the Footprints' pixels in an image and running findFootprints,
+ * but it works with the Spans directly (sorting them, and joining overlapping ones with union-find)
+ * so it costs O(nSpan log nSpan) rather than O(nPixel) and there's no limit on the number of Footprints
+ */
+static void mergeFootprints(
+        std::vector<detection::Footprint::Ptr> *_footprints, // the merged Footprints
+        geom::Box2I const& _region,            // clip the Footprints to this region
+        std::vector<detection::Footprint::Ptr> const& inputs, // the Footprints to merge
+        bool const includePeaks                // copy the input Footprints' Peaks to the outputs?
+) {
+    typedef std::vector<detection::Footprint::Ptr> FootprintList;
+/*
+ * Gather up all the Spans, clipped to _region
+ */
+    std::vector<IdSpan> spans;
+    for (FootprintList::const_iterator fiter = inputs.begin(); fiter != inputs.end(); ++fiter) {
+        detection::Footprint::SpanList const& fspans = (*fiter)->getSpans();
+        for (detection::Footprint::SpanList::const_iterator siter = fspans.begin();
+             siter != fspans.end(); ++siter) {
+            int const y = (*siter)->getY();
+            int const x0 = std::max((*siter)->getX0(), _region.getMinX());
+            int const x1 = std::min((*siter)->getX1(), _region.getMaxX());
+            if (y >= _region.getMinY() && y <= _region.getMaxY() && x0 <= x1) {
+                spans.push_back(IdSpan(0, y, x0, x1));
             }
         }
-        if (sspan == NULL || sspan->getDirection() == DONE) { // no more Startspans to process
-            return false;
+    }
+    if (spans.empty()) {
+        return;
+    }
+    std::sort(spans.begin(), spans.end(), IdSpanComparYX());
+/*
+ * Merge overlapping or touching Spans in each row, so each pixel appears in just one Span,
+ * and the Spans in a row are disjoint and sorted
+ */
+    std::vector<IdSpan> runs;
+    runs.reserve(spans.size());
+    for (std::vector<IdSpan>::const_iterator sp = spans.begin(); sp != spans.end(); ++sp) {
+        if (!runs.empty() && runs.back().y == sp->y && sp->x0 <= runs.back().x1 + 1) {
+            runs.back().x1 = std::max(runs.back().x1, sp->x1);
+        } else {
+            runs.push_back(*sp);
         }
-        if (sspan->Stop()) {                    // they don't want any more spans processed
-            return false;
+    }
+    spans.clear();
+/*
+ * Join each Span to the Spans in the previous row that it touches (including diagonally)
+ */
+    int const nrun = runs.size();
+    DisjointSets sets(nrun);
+    int prev0 = 0, prev1 = 0;           // the previous row's Spans are runs[prev0..prev1)
+    for (int i0 = 0; i0 != nrun; ) {
+        int const y = runs[i0].y;
+        int i1 = i0;
+        while (i1 != nrun && runs[i1].y == y) {
+            ++i1;
         }
-        /*
-         * Work
-         */
-        DIRECTION const dir = sspan->getDirection();
-        /*
-         * Set initial span to the startspan
-         */
-        int x0 = sspan->getSpan()->getX0() - col0, x1 = sspan->getSpan()->getX1() - col0;
-        /*
-         * Go through image identifying objects
-         */
-        int nx0, nx1 = -1;                      // new values of x0, x1
-        int const di = (dir == UP) ? 1 : -1; // how much i changes to get to the next row
-        bool stop = false;                      // should I stop searching for spans?
 
-        typedef typename image::Image<ImagePixelT>::pixel_accessor pixAccessT;
-        double const thresholdVal = threshold.getValue(param);
-        bool const polarity = threshold.getPolarity();
-        
-        for (int i = sspan->span->y -row0 + di; i < height && i >= 0; i += di) {
-            pixAccessT imgRow = _image->origin().advance(0, i); // row pointer
-            //maskPixAccessT maskRow = _mask->origin.advance(0, i);  //  masks's row pointer
-            //
-            // Search left from the pixel diagonally to the left of (i - di, x0). If there's
-            // a connected span there it may need to grow up and/or down, so push it onto
-            // the stack for later consideration
-            //
-            nx0 = -1;
-            for (int j = x0 - 1; j >= -1; j--) {
-                ImagePixelT pixVal = (j < 0) ? thresholdVal - 100 : (polarity ? imgRow[j] : -imgRow[j]);
-                if (_mask(j, i, Startspan<MaskPixelT>::detectedPlane) || pixVal < threshold) {
-                    if (j < x0 - 1) {   // we found some pixels above threshold
-                        nx0 = j + 1;
-                    }
-                    break;
+        if (prev1 > prev0 && runs[prev0].y == y - 1) {
+            int j = prev0;
+            for (int i = i0; i != i1; ++i) {
+                while (j != prev1 && runs[j].x1 < runs[i].x0 - 1) {
+                    ++j;
+                }
+                for (int k = j; k != prev1 && runs[k].x0 <= runs[i].x1 + 1; ++k) {
+                    sets.join(i, k);
                 }
             }
-#if 0
-            if (nx0 < 0) {                      // no span to the left
-                nx1 = x0 - 1;           // we're going to resume searching at nx1 + 1
-            } else {
-                //
-                // Search right in leftmost span
-                //
-                //nx1 = 0;                      // make gcc happy
-                for (int j = nx0 + 1; j <= width; j++) {
-                    ImagePixelT pixVal = (j >= width) ? threshold - 100 : 
-                        (polarity ? (F32 ? imgRowF32[j] : imgRowS32[j]) :
-                         (F32 ? -imgRowF32[j] : -imgRowS32[j]));
-                    if ((maskRow[j] & DETECTED) || pixVal < threshold) {
-                        nx1 = j - 1;
+        }
+
+        prev0 = i0;
+        prev1 = i1;
+        i0 = i1;
+    }
+/*
+ * Build Footprints from the sets of Spans
+ */
+    int const nOld = _footprints->size();
+    std::vector<int> index(nrun, -1);   // index into _footprints of each set's Footprint
+    for (int i = 0; i != nrun; ++i) {
+        int const id = sets.find(i);
+        if (index[id] < 0) {
+            index[id] = _footprints->size();
+            _footprints->push_back(detection::Footprint::Ptr(new detection::Footprint(0, _region)));
+        }
+        runs[i].id = index[id];
+        (*_footprints)[index[id]]->addSpan(runs[i].y, runs[i].x0, runs[i].x1);
+    }
+    for (FootprintList::iterator fiter = _footprints->begin() + nOld; fiter != _footprints->end(); ++fiter) {
+        (*fiter)->normalize();
+    }
+/*
+ * Give each Peak to the Footprint containing it;  Peaks outside _region are dropped
+ */
+    if (!includePeaks) {
+        return;
+    }
+    for (FootprintList::const_iterator fiter = inputs.begin(); fiter != inputs.end(); ++fiter) {
+        detection::Footprint::PeakList const& peaks = (*fiter)->getPeaks();
+        for (detection::Footprint::PeakList::const_iterator piter = peaks.begin();
+             piter != peaks.end(); ++piter) {
+            int const x = (*piter)->getIx();
+            int const y = (*piter)->getIy();
+            std::vector<IdSpan>::const_iterator sp =
+                std::upper_bound(runs.begin(), runs.end(), IdSpan(0, y, x, x), IdSpanComparYX());
+            if (sp != runs.begin() && (--sp)->y == y && sp->x1 >= x) {
+                (*_footprints)[sp->id]->getPeaks().push_back(*piter);
+            }
+        }
+    }
+}
+
+/*
+ * Is a pixel good and above threshold?
+ */
+template<typename ImagePixelT>
+static inline bool isDetected(ImagePixelT pixVal, bool polarity, double thresholdVal) {
+    return !isBadPixel(pixVal) && inFootprint(pixVal, polarity, thresholdVal, ThresholdLevel_traits());
+}
+
+/*
+ * Here's the working routine for the point-seeded FootprintSet constructor; a scanline flood fill
+ * from (x, y), adding the (8-connected) pixels above threshold to fp
+ *
+ * Each row's runs of pixels above threshold are found once, and remembered so we don't search them
+ * again.  We stop as soon as we find a run containing one of the stopPixels (a run containing the
+ * starting pixel doesn't count).  All positions are relative to img's origin
+ */
+template<typename ImagePixelT>
+static void findFootprintAtPoint(
+        detection::Footprint *fp,                 // the Footprint to fill
+        image::Image<ImagePixelT> const &img,     // Image to search
+        double const thresholdVal,                // threshold value defining Footprints
+        bool const polarity,                      // if false, search _below_ thresholdVal
+        int const x,                              // starting column
+        int const y,                              // starting row
+        std::set<std::pair<int, int> > const &stopPixels // (y, x) of pixels where we should stop
+) {
+    typedef typename image::Image<ImagePixelT>::x_iterator x_iterator;
+
+    int const row0 = img.getY0();
+    int const col0 = img.getX0();
+    int const height = img.getHeight();
+    int const width = img.getWidth();
+
+    x_iterator pixPtr = img.row_begin(y);
+    if (!isDetected<ImagePixelT>(pixPtr[x], polarity, thresholdVal)) {
+        return;
+    }
+
+    std::vector<std::vector<std::pair<int, int> > > found(height); // the runs found in each row
+    std::vector<IdSpan> spans;          // all the runs found
+    std::vector<IdSpan> stack;          // runs whose neighbouring rows are still to be searched
+    bool stop = false;                  // have we reached a stop pixel?
+
+    int x0 = x, x1 = x;
+    while (x0 > 0 && isDetected<ImagePixelT>(pixPtr[x0 - 1], polarity, thresholdVal)) {
+        --x0;
+    }
+    while (x1 < width - 1 && isDetected<ImagePixelT>(pixPtr[x1 + 1], polarity, thresholdVal)) {
+        ++x1;
+    }
+    found[y].push_back(std::make_pair(x0, x1));
+    spans.push_back(IdSpan(0, y, x0, x1));
+    stack.push_back(spans.back());
+
+    while (!stack.empty() && !stop) {
+        IdSpan const sp = stack.back();
+        stack.pop_back();
+
+        for (int yy = sp.y - 1; yy <= sp.y + 1 && !stop; yy += 2) {
+            if (yy < 0 || yy >= height) {
+                continue;
+            }
+            pixPtr = img.row_begin(yy);
+            std::vector<std::pair<int, int> > &rowRuns = found[yy];
+
+            int const xEnd = std::min(sp.x1 + 1, width - 1);
+            for (int xx = std::max(sp.x0 - 1, 0); xx <= xEnd; ++xx) {
+                if (!isDetected<ImagePixelT>(pixPtr[xx], polarity, thresholdVal)) {
+                    continue;
+                }
+                // Have we already found this run?
+                bool seen = false;
+                for (std::vector<std::pair<int, int> >::const_iterator rptr = rowRuns.begin();
+                     rptr != rowRuns.end(); ++rptr) {
+                    if (rptr->first <= xx && xx <= rptr->second) {
+                        xx = rptr->second;
+                        seen = true;
                         break;
                     }
                 }
-            
-                pmSpan const *sp = pmFootprintAddSpan(fp, i + row0, nx0 + col0, nx1 + col0);
-            
-                if (add_startspan(startspans, sp, mask, RESTART)) {
+                if (seen) {
+                    continue;
+                }
+                // A new run;  extend it to its full length
+                x0 = x1 = xx;
+                while (x0 > 0 && isDetected<ImagePixelT>(pixPtr[x0 - 1], polarity, thresholdVal)) {
+                    --x0;
+                }
+                while (x1 < width - 1 && isDetected<ImagePixelT>(pixPtr[x1 + 1], polarity, thresholdVal)) {
+                    ++x1;
+                }
+                rowRuns.push_back(std::make_pair(x0, x1));
+                spans.push_back(IdSpan(0, yy, x0, x1));
+                stack.push_back(spans.back());
+                xx = x1;
+
+                std::set<std::pair<int, int> >::const_iterator sptr =
+                    stopPixels.lower_bound(std::make_pair(yy, x0));
+                if (sptr != stopPixels.end() && sptr->first == yy && sptr->second <= x1) {
                     stop = true;
                     break;
                 }
             }
-            //
-            // Now look for spans connected to the old span.  The first of these we'll
-            // simply process, but others will have to be deferred for later consideration.
-            //
-            // In fact, if the span overhangs to the right we'll have to defer the overhang
-            // until later too, as it too can grow in both directions
-            //
-            // Note that column width exists virtually, and always ends the last span; this
-            // is why we claim below that sx1 is always set
-            //
-            bool first = false;         // is this the first new span detected?
-            for (int j = nx1 + 1; j <= x1 + 1; j++) {
-                ImagePixelT pixVal = (j >= width) ? threshold - 100 : 
-                    (polarity ? (F32 ? imgRowF32[j] : imgRowS32[j]) : (F32 ? -imgRowF32[j] : -imgRowS32[j]));
-                if (!(maskRow[j] & DETECTED) && pixVal >= threshold) {
-                    int sx0 = j++;              // span that we're working on is sx0:sx1
-                    int sx1 = -1;               // We know that if we got here, we'll also set sx1
-                    for (; j <= width; j++) {
-                        ImagePixelT pixVal = (j >= width) ? threshold - 100 : 
-                            (polarity ? (F32 ? imgRowF32[j] : imgRowS32[j]) :
-                             (F32 ? -imgRowF32[j] : -imgRowS32[j]));
-                        if ((maskRow[j] & DETECTED) || pixVal < threshold) { // end of span
-                            sx1 = j;
-                            break;
-                        }
-                    }
-                    assert (sx1 >= 0);
-                    
-                    pmSpan const *sp;
-                    if (first) {
-                        if (sx1 <= x1) {
-                            sp = pmFootprintAddSpan(fp, i + row0, sx0 + col0, sx1 + col0 - 1);
-                            if (add_startspan(startspans, sp, mask, DONE)) {
-                                stop = true;
-                                break;
-                            }
-                        } else {                // overhangs to right
-                            sp = pmFootprintAddSpan(fp, i + row0, sx0 + col0, x1 + col0);
-                            if (add_startspan(startspans, sp, mask, DONE)) {
-                                stop = true;
-                                break;
-                            }
-                            sp = pmFootprintAddSpan(fp, i + row0, x1 + 1 + col0, sx1 + col0 - 1);
-                            if (add_startspan(startspans, sp, mask, RESTART)) {
-                                stop = true;
-                                break;
-                            }
-                        }
-                        first = false;
-                    } else {
-                        sp = pmFootprintAddSpan(fp, i + row0, sx0 + col0, sx1 + col0 - 1);
-                        if (add_startspan(startspans, sp, mask, RESTART)) {
-                            stop = true;
-                            break;
-                        }
-                    }
-                }
-            }
-
-            if (stop || first == false) {       // we're done
-                break;
-            }
-            
-            x0 = nx0;
-            x1 = nx1;
-#endif
         }
-        /*
-         * Cleanup
-         */
+    }
 
-        sspan->_direction = DONE;
-        return stop ? false : true;
+    for (std::vector<IdSpan>::const_iterator sp = spans.begin(); sp != spans.end(); ++sp) {
+        fp->addSpan(sp->y + row0, sp->x0 + col0, sp->x1 + col0);
     }
-    /// \endcond
-} 
-#if 0
-    
+    fp->normalize();
+}
 
-/*
- * Go through an image, starting at (row, col) and assembling all the pixels
- * that are connected to that point (in a chess kings-move sort of way) into
- * a pmFootprint.
+/**
+ * Return a FootprintSet consisting of the Footprint containing the point (x, y) (if above threshold)
  *
- * This is much slower than pmFindFootprints if you want to find lots of
- * footprints, but if you only want a small region about a given point it
- * can be much faster
+ * The Footprint is found by a flood fill starting at (x, y), one row of pixels above threshold at a time.
+ * If peaks is provided the fill stops as soon as it adds a row of pixels containing one or more of the
+ * peaks (peaks in the starting pixel's row don't count).  The Footprint is then only part of the
+ * object:  it includes any peaks in the starting row, the peaks in the row that stopped the fill, and
+ * the rows found before that, which depend on the order of the search.
  *
- * N.b. The returned pmFootprint is not in "normal form"; that is the pmSpans
- * are not sorted by increasing y, x0, x1.  If this matters to you, call
- * pmFootprintNormalize()
- */
-pmFootprint *
-pmFindFootprintAtPoint(psImage const *img,      // image to search
-                       Threshold const &threshold, // Threshold
-                       psArray const *peaks, // array of peaks; finding one terminates search for footprint
-                       int row, int col) { // starting position (in img's parent's coordinate system)
-    assert(img != NULL);
-    
-    bool F32 = false;                    // is this an F32 image?
-    if (img->type.type == PS_TYPE_F32) {
-        F32 = true;
-    } else if (img->type.type == PS_TYPE_S32) {
-        F32 = false;
-    } else {                             // N.b. You can't trivially add more cases here; F32 is just a bool
-        psError(PS_ERR_UNKNOWN, true, "Unsupported psImage type: %d", img->type.type);
-        return NULL;
-    }
-    psF32 *imgRowF32 = NULL;             // row pointer if F32
-    psS32 *imgRowS32 = NULL;             //  "   "   "  "  !F32
-    
-    int const row0 = img->row0;
-    int const col0 = img->col0;
-    int const height = img->getHeight();
-    int const width = img->getWidth();
-/*
- * Is point in image, and above threshold?
- */
-    row -= row0;
-    col -= col0;
-    if (row < 0 || row >= height ||
-        col < 0 || col >= width) {
-        psError(PS_ERR_BAD_PARAMETER_VALUE, true,
-                "row/col == (%d, %d) are out of bounds [%d--%d, %d--%d]",
-                row + row0, col + col0, row0, row0 + height - 1, col0, col0 + width - 1);
-        return NULL;
-    }
-    
-    ImagePixelT pixVal = F32 ? img->data.F32[row][col] : img->data.S32[row][col];
-    if (pixVal < threshold) {
-        return pmFootprintAlloc(0, img);
+ * If the pixel (x, y) is below threshold the FootprintSet is empty
+ */
+template<typename ImagePixelT, typename MaskPixelT>
+detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
+    const image::MaskedImage<ImagePixelT, MaskPixelT> & img, //!< Image to search for objects
+    Threshold const &threshold,                          //!< threshold to find objects
+    int x,                                               //!< Footprint should include this pixel (column)
+    int y,                                               //!< Footprint should include this pixel (row) 
+    std::vector<Peak> const *peaks  //!< Stop filling on reaching one of these peaks (may be NULL)
+) : lsst::daf::data::LsstBase(typeid(this)),
+    _footprints(new FootprintList()),
+    _region(geom::Point2I(img.getX0(), img.getY0()),
+            geom::Extent2I(img.getWidth(), img.getHeight())) 
+{
+    if (!_region.contains(geom::Point2I(x, y))) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                          (boost::format("Pixel (%d, %d) is not in the image [%d..%d, %d..%d]") % x % y %
+                           _region.getMinX() % _region.getMaxX() %
+                           _region.getMinY() % _region.getMaxY()).str());
     }
-    
-    pmFootprint *fp = pmFootprintAlloc(1 + img->getHeight()/10, img);
-/*
- * We need a mask for two purposes; to indicate which pixels are already detected,
- * and to store the "stop" pixels --- those that, once reached, should stop us
- * looking for the rest of the pmFootprint.  These are generally set from peaks.
- */
-    psImage *mask = psImageAlloc(width, height, PS_TYPE_MASK);
-    P_PSIMAGE_SET_ROW0(mask, row0);
-    P_PSIMAGE_SET_COL0(mask, col0);
-    psImageInit(mask, INITIAL);
-    //
-    // Set stop bits from peaks list
-    //
-    assert (peaks == NULL || peaks->n == 0 || pmIsPeak(peaks->data[0]));
+
+    std::set<std::pair<int, int> > stopPixels; // the peaks, as (y, x) relative to the image's origin
     if (peaks != NULL) {
-        for (int i = 0; i < peaks->n; i++) {
-            pmPeak *peak = peaks->data[i];
-            mask->data.PS_TYPE_MASK_DATA[peak->y - mask->row0][peak->x - mask->col0] |= STOP;
+        for (std::vector<Peak>::const_iterator ptr = peaks->begin(); ptr != peaks->end(); ++ptr) {
+            stopPixels.insert(std::make_pair(ptr->getIy() - img.getY0(), ptr->getIx() - img.getX0()));
         }
     }
-/*
- * Find starting span passing through (row, col)
- */
-    psArray *startspans = psArrayAllocEmpty(1); // spans where we have to restart the search
-    
-    imgRowF32 = img->data.F32[row];      // only one of
-    imgRowS32 = img->data.S32[row];      //      these is valid!
-    psMaskType *maskRow = mask->data.PS_TYPE_MASK_DATA[row];
-    {
-        int i;
-        for (i = col; i >= 0; i--) {
-            pixVal = F32 ? imgRowF32[i] : imgRowS32[i];
-            if ((maskRow[i] & DETECTED) || pixVal < threshold) {
-                break;
-            }
-        }
-        int i0 = i;
-        for (i = col; i < width; i++) {
-            pixVal = F32 ? imgRowF32[i] : imgRowS32[i];
-            if ((maskRow[i] & DETECTED) || pixVal < threshold) {
-                break;
-            }
-        }
-        int i1 = i;
-        pmSpan const *sp = pmFootprintAddSpan(fp, row + row0, i0 + col0 + 1, i1 + col0 - 1);
-        
-        (void)add_startspan(startspans, sp, mask, RESTART);
+
+    Footprint::Ptr fp(new Footprint(0, _region));
+    findFootprintAtPoint(fp.get(), *img.getImage(), getThresholdValue(threshold, img),
+                         threshold.getPolarity(), x - img.getX0(), y - img.getY0(), stopPixels);
+    if (fp->getNpix() > 0) {
+        _footprints->push_back(fp);
     }
-    /*
-     * Now workout from those Startspans, searching for pixels above threshold
-     */
-    while (do_startspan(fp, img, mask, threshold, startspans)) continue;
-    /*
-     * Cleanup
-     */
-    psFree(mask);
-    psFree(startspans);                  // restores the image pixel
-    
-    return fp;                           // pmFootprint really
 }
-#endif
 
 /************************************************************************************************************/
 /**
@@ -916,7 +837,8 @@ void detection::FootprintSet<ImagePixelT, MaskPixelT>::setRegion(
 /**
  * Grow all the Footprints in the input FootprintSet, returning a new FootprintSet
  *
- * The output FootprintSet may contain fewer Footprints, as some may well have been merged
+ * The output FootprintSet may contain fewer Footprints, as some may well have been merged;
+ * the merged Footprints contain the Peak%s of the Footprints that went into them
  */
 template<typename ImagePixelT, typename MaskPixelT>
 detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
@@ -926,7 +848,8 @@ detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
                                         //!< @note Isotropic grows are significantly slower
                                                               )
     : lsst::daf::data::LsstBase(typeid(this)),
-      _footprints(rhs._footprints), _region(rhs._region) {
+      _footprints(r == 0 ? rhs._footprints : boost::shared_ptr<FootprintList>(new FootprintList())),
+      _region(rhs._region) {
 
     if (r == 0) {
         return;
@@ -935,44 +858,44 @@ detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
                           (boost::format("I cannot grow by negative numbers: %d") % r).str());
     }
 
-    typedef unsigned short ImageT;
-    geom::Box2I region = rhs.getRegion();
-    image::Image<ImageT>::Ptr idImage(
-        new image::Image<ImageT>(region)
-    );
-    idImage->setXY0(region.getMinX(), region.getMinY());
-    *idImage = 0;
-
     CONST_PTR(FootprintList) rhsFootprints = rhs.getFootprints();
+    FootprintList grown;
+    grown.reserve(rhsFootprints->size());
     for (FootprintList::const_iterator ptr = rhsFootprints->begin(), end = rhsFootprints->end();
          ptr != end; ++ptr) {
         Footprint::Ptr gfoot = growFootprint(**ptr, r, isotropic);
-        gfoot->insertIntoImage(*idImage, 10); // The value 10 is random; more than 1 anyway
+        gfoot->getPeaks() = (*ptr)->getPeaks();
+        grown.push_back(gfoot);
     }
 
-    FootprintSet<ImageT> ds(image::MaskedImage<ImageT>(idImage), Threshold(1));
-    swap(ds);
+    mergeFootprints(_footprints.get(), _region, grown, true);
 }
 
 /************************************************************************************************************/
 /**
  * Return the FootprintSet corresponding to the merge of two input FootprintSets
  *
- * \todo Implement this.  There's RHL Pan-STARRS code to do it, but it isn't yet converted to LSST C++
+ * Footprints that overlap or touch (including diagonally) are merged, so the result is the same as
+ * detecting objects in an image whose pixels are set in either input.  The region is the union of
+ * the two inputs' regions
  */
 template<typename ImagePixelT, typename MaskPixelT>
 detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
-        FootprintSet const& fs1,
-        FootprintSet const& fs2,
-        bool const 
+        FootprintSet const& fs1,        //!< the first input FootprintSet
+        FootprintSet const& fs2,        //!< the second input FootprintSet
+        bool const includePeaks         //!< include the input Footprints' Peak%s in the merged Footprints?
                                                               )
     : lsst::daf::data::LsstBase(typeid(this)),
       _footprints(new FootprintList()),
       _region(fs1._region)
 {
     _region.include(fs2._region);
-}
 
+    FootprintList inputs(fs1._footprints->begin(), fs1._footprints->end());
+    inputs.insert(inputs.end(), fs2._footprints->begin(), fs2._footprints->end());
+
+    mergeFootprints(_footprints.get(), _region, inputs, includePeaks);
+}
 /************************************************************************************************************/
 /**
  * Return an Image with pixels set to the Footprint%s in the FootprintSet
@@ -0,0 +1,481 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/** @file
+  * @ingroup afw
+  */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "boost/format.hpp"
+
+#include "lsst/utils/ieee.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/pex/logging/Trace.h"
+#include "lsst/afw/math/detail/Parallel.h"
+#include "lsst/afw/detection/SourceIndex.h"
+
+
+namespace ex = lsst::pex::exceptions;
+namespace det = lsst::afw::detection;
+namespace mathDetail = lsst::afw::math::detail;
+
+namespace {
+
+    double const DEGREES_PER_RADIAN = 57.2957795130823208767981548141;
+    double const RADIANS_PER_DEGREE = 0.0174532925199432957692369076849;
+
+    /// A source while the tree is being built
+    struct Entry {
+        double p[3];
+        det::Source::Ptr const *src;
+        int rank;                       // position in the (NaN-free) input set
+    };
+
+    struct CmpEntry {
+        explicit CmpEntry(int dim) : _dim(dim) {}
+        bool operator()(Entry const &e1, Entry const &e2) const { return e1.p[_dim] < e2.p[_dim]; }
+    private:
+        int _dim;
+    };
+
+    /// Order hits by the position of their sources in the input set
+    struct CmpRank {
+        explicit CmpRank(std::vector<int> const &ranks) : _ranks(ranks) {}
+        template <typename HitT>
+        bool operator()(HitT const &h1, HitT const &h2) const {
+            return _ranks[h1.index] < _ranks[h2.index];
+        }
+    private:
+        std::vector<int> const &_ranks;
+    };
+
+    inline double distanceSquared(double const *p1, double const *p2) {
+        double const dx = p1[0] - p2[0];
+        double const dy = p1[1] - p2[1];
+        double const dz = p1[2] - p2[2];
+        return dx*dx + dy*dy + dz*dz;
+    }
+
+    /**
+      * Arrange entries[begin, end) as an implicit, balanced k-d tree:  the middle entry of each range
+      * is its node, with the entries no greater than it along the dimension of greatest extent before it
+      * and those no less than it after it.
+      */
+    void buildTree(Entry *entries, int begin, int end, int nDim, std::vector<unsigned char> &splitDims) {
+        while (end - begin > 1) {
+            double lo[3], hi[3];
+            for (int d = 0; d < nDim; ++d) {
+                lo[d] = hi[d] = entries[begin].p[d];
+            }
+            for (int i = begin + 1; i < end; ++i) {
+                for (int d = 0; d < nDim; ++d) {
+                    lo[d] = std::min(lo[d], entries[i].p[d]);
+                    hi[d] = std::max(hi[d], entries[i].p[d]);
+                }
+            }
+            int dim = 0;
+            for (int d = 1; d < nDim; ++d) {
+                if (hi[d] - lo[d] > hi[dim] - lo[dim]) {
+                    dim = d;
+                }
+            }
+            int const mid = begin + (end - begin)/2;
+            std::nth_element(entries + begin, entries + mid, entries + end, CmpEntry(dim));
+            splitDims[mid] = static_cast<unsigned char>(dim);
+            buildTree(entries, begin, mid, nDim, splitDims);
+            begin = mid + 1;
+        }
+    }
+
+} // namespace <anonymous>
+
+
+/**
+ * @brief Calls SourceIndex::_query for one chunk of the query sources
+ *
+ * If no set is given, the queries are the indexed sources themselves (a self-match).
+ */
+class det::SourceIndex::MatchChunk {
+public:
+    MatchChunk(SourceIndex const &index, SourceSet const *set, int k, double d2Limit, bool symmetric,
+               std::vector<std::vector<SourceMatch> > &matches) :
+        _index(index), _set(set), _k(k), _d2Limit(d2Limit), _symmetric(symmetric), _matches(matches) {}
+
+    void operator()(int chunk) const {
+        int const n = (_set != 0) ? static_cast<int>(_set->size()) : _index.size();
+        int const nChunk = static_cast<int>(_matches.size());
+        int const chunkSize = (n + nChunk - 1)/nChunk;
+        int const begin = chunk*chunkSize;
+        int const end = std::min(n, begin + chunkSize);
+
+        std::vector<SourceMatch> &matches = _matches[chunk];
+        std::vector<Hit> hits;
+        double p[3];
+        for (int i = begin; i < end; ++i) {
+            if (_set != 0) {
+                Source::Ptr const &source = (*_set)[i];
+                if (_index._getPosition(*source, p)) {
+                    _index._query(source, p, -1, true, _k, _d2Limit, hits, matches);
+                }
+            } else {
+                int const t = _index._order[i];
+                _index._query(_index._sources[t], &_index._points[3*t], t, _symmetric, _k, _d2Limit,
+                              hits, matches);
+            }
+        }
+    }
+
+private:
+    SourceIndex const &_index;
+    SourceSet const *_set;
+    int _k;
+    double _d2Limit;
+    bool _symmetric;
+    std::vector<std::vector<SourceMatch> > &_matches;
+};
+
+
+/**
+ * Index the positions of the sources in @a set; sources whose position contains a NaN are skipped.
+ *
+ * @throw lsst::pex::exceptions::RangeErrorException if an ra or dec is out of range (RA_DEC only)
+ */
+det::SourceIndex::SourceIndex(SourceSet const &set, ///< the sources to index
+                              Space space           ///< the coordinates to index them by
+                             ) : _space(space) {
+    std::vector<Entry> entries;
+    entries.reserve(set.size());
+    for (SourceSet::const_iterator i(set.begin()), e(set.end()); i != e; ++i) {
+        Entry entry;
+        if (!_getPosition(**i, entry.p)) {
+            continue;
+        }
+        entry.src = &(*i);
+        entry.rank = static_cast<int>(entries.size());
+        entries.push_back(entry);
+    }
+    if (entries.size() < set.size()) {
+        lsst::pex::logging::TTrace<1>("afw.detection.SourceIndex",
+                                      "At least one source had a position containing a NaN");
+    }
+
+    int const n = static_cast<int>(entries.size());
+    _splitDims.resize(n);
+    if (n > 0) {
+        buildTree(&entries[0], 0, n, (_space == RA_DEC) ? 3 : 2, _splitDims);
+    }
+
+    _points.resize(3*n);
+    _sources.reserve(n);
+    _ranks.resize(n);
+    _order.resize(n);
+    for (int t = 0; t < n; ++t) {
+        std::copy(entries[t].p, entries[t].p + 3, &_points[3*t]);
+        _sources.push_back(*entries[t].src);
+        _ranks[t] = entries[t].rank;
+        _order[entries[t].rank] = t;
+    }
+}
+
+/**
+ * Return all indexed sources closer than @a radius to @a source, in the order of the set that was indexed
+ */
+std::vector<det::SourceMatch> det::SourceIndex::findWithin(
+        Source::Ptr const &source,      ///< the source to match
+        double radius                   ///< match radius (arcsec for RA_DEC, pixels for XY)
+                                                          ) const {
+    double const d2Limit = _getD2Limit(radius);
+    std::vector<SourceMatch> matches;
+    std::vector<Hit> hits;
+    double p[3];
+    if (_getPosition(*source, p)) {
+        _query(source, p, -1, true, 0, d2Limit, hits, matches);
+    }
+    return matches;
+}
+
+/**
+ * Return the (up to) @a k indexed sources nearest to @a source and closer than @a radius, nearest first
+ *
+ * If @a source is itself indexed, it's its own nearest neighbour.
+ */
+std::vector<det::SourceMatch> det::SourceIndex::findNearest(
+        Source::Ptr const &source,      ///< the source to match
+        int k,                          ///< maximum number of matches
+        double radius                   ///< match radius (arcsec for RA_DEC, pixels for XY)
+                                                           ) const {
+    if (k < 1) {
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          (boost::format("Number of neighbours must be positive, not %d") % k).str());
+    }
+    double const d2Limit = _getD2Limit(radius);
+    std::vector<SourceMatch> matches;
+    std::vector<Hit> hits;
+    double p[3];
+    if (_getPosition(*source, p)) {
+        _query(source, p, -1, true, k, d2Limit, hits, matches);
+    }
+    return matches;
+}
+
+/**
+ * Match each source in @a set to the indexed sources closer than @a radius
+ *
+ * The matches are in the order of @a set (and then, if @a closest is false, in the order of the
+ * indexed set);  sources in @a set whose position contains a NaN have no matches.
+ */
+std::vector<det::SourceMatch> det::SourceIndex::findMatches(
+        SourceSet const &set,           ///< the sources to match
+        double radius,                  ///< match radius (arcsec for RA_DEC, pixels for XY)
+        bool closest,                   ///< if true, just return the closest match for each source
+        int nThread                     ///< number of threads to use; <= 0 means one per core
+                                                           ) const {
+    return _match(&set, closest ? 1 : 0, radius, true, nThread);
+}
+
+/**
+ * Match each source in @a set to the (up to) @a k nearest indexed sources closer than @a radius
+ *
+ * The matches are in the order of @a set, and then nearest first.
+ */
+std::vector<det::SourceMatch> det::SourceIndex::findNearestMatches(
+        SourceSet const &set,           ///< the sources to match
+        int k,                          ///< maximum number of matches for each source
+        double radius,                  ///< match radius (arcsec for RA_DEC, pixels for XY)
+        int nThread                     ///< number of threads to use; <= 0 means one per core
+                                                                  ) const {
+    if (k < 1) {
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          (boost::format("Number of neighbours must be positive, not %d") % k).str());
+    }
+    return _match(&set, k, radius, true, nThread);
+}
+
+/**
+ * Match the indexed sources to each other:  return all (s1, s2, d) where s1 != s2 and d < @a radius
+ *
+ * If @a symmetric is true, then if (s1, s2, d) is reported so is (s2, s1, d);  otherwise only the
+ * match in which s1 comes first in the indexed set is reported.
+ */
+std::vector<det::SourceMatch> det::SourceIndex::findSelfMatches(
+        double radius,                  ///< match radius (arcsec for RA_DEC, pixels for XY)
+        bool symmetric,                 ///< report each pair of sources twice?
+        int nThread                     ///< number of threads to use; <= 0 means one per core
+                                                               ) const {
+    return _match(0, 0, radius, symmetric, nThread);
+}
+
+/*
+ * Compute the position of a source as a point in 3 dimensions, returning false if it contains a NaN
+ */
+bool det::SourceIndex::_getPosition(Source const &source, double *p) const {
+    if (_space == XY) {
+        double const x = source.getXAstrom();
+        double const y = source.getYAstrom();
+        if (lsst::utils::isnan(x) || lsst::utils::isnan(y)) {
+            return false;
+        }
+        p[0] = x;
+        p[1] = y;
+        p[2] = 0.0;
+        return true;
+    }
+    // radians
+    double const ra = source.getRa();
+    double const dec = source.getDec();
+    if (ra < 0.0 || ra >= 2.*M_PI) {
+        throw LSST_EXCEPT(ex::RangeErrorException, "right ascension out of range");
+    }
+    if (dec < -M_PI_2 || dec > M_PI_2) {
+        throw LSST_EXCEPT(ex::RangeErrorException, "declination out of range");
+    }
+    if (lsst::utils::isnan(ra) || lsst::utils::isnan(dec)) {
+        return false;
+    }
+    double const cosDec = std::cos(dec);
+    p[0] = std::cos(ra)*cosDec;
+    p[1] = std::sin(ra)*cosDec;
+    p[2] = std::sin(dec);
+    return true;
+}
+
+/*
+ * Convert a match radius to a limit on the squared (chord, for RA_DEC) distance between points
+ */
+double det::SourceIndex::_getD2Limit(double radius) const {
+    if (!(radius >= 0.0)) {
+        throw LSST_EXCEPT(ex::RangeErrorException, "match radius out of range");
+    }
+    if (_space == XY) {
+        return radius*radius;
+    }
+    double const radiusRad = RADIANS_PER_DEGREE * radius/3600.0;
+    if (radiusRad >= M_PI) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double const shr = std::sin(0.5*radiusRad);
+    return 4.0*shr*shr;
+}
+
+/*
+ * Convert a squared (chord, for RA_DEC) distance between points to arcseconds or pixels
+ */
+double det::SourceIndex::_getDistance(double d2) const {
+    if (_space == XY) {
+        return std::sqrt(d2);
+    }
+    return DEGREES_PER_RADIAN*3600.0*2.0*std::asin(std::min(1.0, 0.5*std::sqrt(d2)));
+}
+
+/*
+ * Append to hits all the sources in the subtree [begin, end) with a squared distance from p
+ * less than d2Limit, other than the one at position exclude
+ */
+void det::SourceIndex::_findWithin(double const *p, int exclude, double d2Limit,
+                                   int begin, int end, std::vector<Hit> &hits) const {
+    while (begin < end) {
+        int const mid = begin + (end - begin)/2;
+        double const *q = &_points[3*mid];
+        double const d2 = distanceSquared(p, q);
+        if (d2 < d2Limit && mid != exclude) {
+            hits.push_back(Hit(mid, d2));
+        }
+        int const dim = _splitDims[mid];
+        double const diff = p[dim] - q[dim];
+        // the points on the far side of the split are at least |diff| away
+        if (diff < 0.0) {
+            if (diff*diff < d2Limit) {
+                _findWithin(p, exclude, d2Limit, mid + 1, end, hits);
+            }
+            end = mid;
+        } else {
+            if (diff*diff < d2Limit) {
+                _findWithin(p, exclude, d2Limit, begin, mid, hits);
+            }
+            begin = mid + 1;
+        }
+    }
+}
+
+/*
+ * Maintain in hits a max-heap of the (up to) k sources in the subtree [begin, end) nearest to p,
+ * other than the one at position exclude;  d2Limit is reduced to the squared distance of the k-th
+ * nearest source once k have been found
+ */
+void det::SourceIndex::_findNearest(double const *p, int exclude, std::size_t k, double &d2Limit,
+                                    int begin, int end, std::vector<Hit> &hits) const {
+    while (begin < end) {
+        int const mid = begin + (end - begin)/2;
+        double const *q = &_points[3*mid];
+        double const d2 = distanceSquared(p, q);
+        if (d2 < d2Limit && mid != exclude) {
+            hits.push_back(Hit(mid, d2));
+            std::push_heap(hits.begin(), hits.end());
+            if (hits.size() > k) {
+                std::pop_heap(hits.begin(), hits.end());
+                hits.pop_back();
+            }
+            if (hits.size() == k) {
+                d2Limit = hits.front().d2;
+            }
+        }
+        int const dim = _splitDims[mid];
+        double const diff = p[dim] - q[dim];
+        // search the near side of the split first, as it's likely to reduce d2Limit
+        if (diff < 0.0) {
+            _findNearest(p, exclude, k, d2Limit, begin, mid, hits);
+            if (diff*diff >= d2Limit) {
+                return;
+            }
+            begin = mid + 1;
+        } else {
+            _findNearest(p, exclude, k, d2Limit, mid + 1, end, hits);
+            if (diff*diff >= d2Limit) {
+                return;
+            }
+            end = mid;
+        }
+    }
+}
+
+/*
+ * Append to matches the indexed sources matching source (at position p):  all those within the
+ * radius in the order of the indexed set if k is 0, otherwise the k nearest, nearest first.  If
+ * symmetric is false, only sources that come after the one at position exclude are reported.
+ */
+void det::SourceIndex::_query(Source::Ptr const &source, double const *p, int exclude, bool symmetric,
+                              int k, double d2Limit,
+                              std::vector<Hit> &hits, std::vector<SourceMatch> &matches) const {
+    hits.clear();
+    if (k <= 0) {
+        _findWithin(p, exclude, d2Limit, 0, size(), hits);
+        std::sort(hits.begin(), hits.end(), CmpRank(_ranks));
+    } else {
+        _findNearest(p, exclude, k, d2Limit, 0, size(), hits);
+        std::sort_heap(hits.begin(), hits.end());
+    }
+    for (std::vector<Hit>::const_iterator i = hits.begin(), e = hits.end(); i != e; ++i) {
+        if (!symmetric && _ranks[i->index] < _ranks[exclude]) {
+            continue;
+        }
+        matches.push_back(SourceMatch(source, _sources[i->index], _getDistance(i->d2)));
+    }
+}
+
+/*
+ * Match the sources in set (or, if it's null, the indexed sources) to the indexed sources, sharing
+ * the queries between nThread threads
+ */
+std::vector<det::SourceMatch> det::SourceIndex::_match(SourceSet const *set, int k, double radius,
+                                                       bool symmetric, int nThread) const {
+    double const d2Limit = _getD2Limit(radius);
+    int const n = (set != 0) ? static_cast<int>(set->size()) : size();
+    std::vector<SourceMatch> matches;
+    if (n == 0 || size() == 0) {
+        return matches;
+    }
+    // The queries take very different times in crowded and sparse regions, so give each thread
+    // several chunks;  parallelFor hands them out as the threads become free
+    int const nThreads = mathDetail::getNumThreads(nThread);
+    int const nChunk = (nThreads == 1) ? 1 : std::min(n, 8*nThreads);
+    std::vector<std::vector<SourceMatch> > chunkMatches(nChunk);
+    mathDetail::parallelFor(0, nChunk, MatchChunk(*this, set, k, d2Limit, symmetric, chunkMatches),
+                            nThreads);
+
+    if (nChunk == 1) {
+        matches.swap(chunkMatches[0]);
+        return matches;
+    }
+    std::size_t nMatch = 0;
+    for (int i = 0; i < nChunk; ++i) {
+        nMatch += chunkMatches[i].size();
+    }
+    matches.reserve(nMatch);
+    for (int i = 0; i < nChunk; ++i) {
+        matches.insert(matches.end(), chunkMatches[i].begin(), chunkMatches[i].end());
+    }
+    return matches;
+}
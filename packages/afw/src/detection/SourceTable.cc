@@ -0,0 +1,229 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+//
+//##====----------------                                ----------------====##/
+//!
+//! \file
+//! \brief Support for column-oriented catalogs of Sources
+//!
+//##====----------------                                ----------------====##/
+
+#include <algorithm>
+
+#include "boost/format.hpp"
+
+#include "lsst/pex/exceptions/Runtime.h"
+#include "lsst/afw/image/Filter.h"
+#include "lsst/afw/detection/SourceTable.h"
+
+namespace det = lsst::afw::detection;
+namespace ndarray = lsst::ndarray;
+
+namespace {
+    /// Replace a column by one of the given capacity, keeping its first size elements
+    template <typename T>
+    void reallocateColumn(ndarray::Array<T,1,1> & column, int const size, int const capacity) {
+        ndarray::Array<T,1,1> newColumn = ndarray::allocate(capacity);
+        if (size > 0) {
+            std::copy(column.getData(), column.getData() + size, newColumn.getData());
+        }
+        column = newColumn;
+    }
+}
+
+/**
+ * Create an empty table with room for capacity rows
+ */
+det::SourceTable::SourceTable(int capacity) : _size(0), _capacity(0) {
+    _reallocate(capacity);
+}
+
+/**
+ * Create a table holding the same values (but not the Footprints or Measurements) as a SourceSet
+ */
+det::SourceTable::SourceTable(SourceSet const & sources) : _size(0), _capacity(0) {
+    _reallocate(sources.size());
+    for (SourceSet::const_iterator i = sources.begin(), end = sources.end(); i != end; ++i) {
+        append(**i);
+    }
+}
+
+/**
+ * Deep copy constructor
+ */
+det::SourceTable::SourceTable(SourceTable const & other) :
+    lsst::daf::base::Persistable(), _size(0), _capacity(0)
+{
+    *this = other;
+}
+
+/**
+ * Deep assignment; the columns of this table no longer share memory with any previously returned column
+ */
+det::SourceTable & det::SourceTable::operator=(SourceTable const & other) {
+    if (&other != this) {
+        _size = 0;
+        _capacity = 0;
+        _reallocate(other._size);
+#define LSST_AFW_DETECTION_SOURCE_TABLE_COPY(TYPE, NAME, NULLABLE, DB_NAME, UNITS)          \
+        std::copy(other._column##NAME.getData(), other._column##NAME.getData() + other._size, \
+                  _column##NAME.getData());
+
+        LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_TABLE_COPY)
+
+#undef LSST_AFW_DETECTION_SOURCE_TABLE_COPY
+
+        for (int field = 0; field != NUM_SOURCE_NULLABLE_FIELDS; ++field) {
+            std::copy(other._nulls[field].getData(), other._nulls[field].getData() + other._size,
+                      _nulls[field].getData());
+        }
+        _size = other._size;
+    }
+    return *this;
+}
+
+/**
+ * Make sure that the table can hold at least capacity rows without reallocating its columns
+ */
+void det::SourceTable::reserve(int capacity) {
+    if (capacity > _capacity) {
+        _reallocate(capacity);
+    }
+}
+
+void det::SourceTable::_reallocate(int capacity) {
+    if (capacity < _size) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                          (boost::format("Capacity %d is smaller than the table size %d") %
+                           capacity % _size).str());
+    }
+#define LSST_AFW_DETECTION_SOURCE_TABLE_REALLOCATE(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    reallocateColumn(_column##NAME, _size, capacity);
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_TABLE_REALLOCATE)
+
+#undef LSST_AFW_DETECTION_SOURCE_TABLE_REALLOCATE
+
+    ndarray::Array<bool,2,2> nulls = ndarray::allocate(NUM_SOURCE_NULLABLE_FIELDS, capacity);
+    if (_size > 0) {
+        for (int field = 0; field != NUM_SOURCE_NULLABLE_FIELDS; ++field) {
+            std::copy(_nulls[field].getData(), _nulls[field].getData() + _size, nulls[field].getData());
+        }
+    }
+    _nulls = nulls;
+    _capacity = capacity;
+}
+
+/**
+ * Append a row with the same values as a default-constructed Source (all nullable fields null),
+ * doubling the capacity of the table if it's full
+ */
+det::SourceRecord det::SourceTable::append() {
+    if (_size == _capacity) {
+        _reallocate(std::max(2*_capacity, 16));
+    }
+    int const n = _size++;
+#define LSST_AFW_DETECTION_SOURCE_TABLE_DEFAULT(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    _column##NAME[n] = TYPE(0);
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_TABLE_DEFAULT)
+
+#undef LSST_AFW_DETECTION_SOURCE_TABLE_DEFAULT
+
+    _columnFilterId[n] = lsst::afw::image::Filter::UNKNOWN;
+    _columnShapeStatus[n] = -1;
+
+    SourceRecord record(this, n);
+    record.setNull();
+    return record;
+}
+
+/**
+ * Append a row with the values of a Source
+ */
+det::SourceRecord det::SourceTable::append(Source const & source) {
+    SourceRecord record = append();
+    record.assign(source);
+    return record;
+}
+
+/**
+ * Return a SourceSet with a new Source for each row of the table
+ */
+det::SourceSet det::SourceTable::makeSourceSet() const {
+    SourceSet sources;
+    sources.reserve(_size);
+    for (int i = 0; i != _size; ++i) {
+        sources.push_back((*this)[i].makeSource());
+    }
+    return sources;
+}
+
+/**
+ * Set all nullable fields to null
+ */
+void det::SourceRecord::setNull() {
+    for (int field = 0; field != NUM_SOURCE_NULLABLE_FIELDS; ++field) {
+        _mutableTable->_nulls[field][_index] = true;
+    }
+}
+
+/**
+ * Set all nullable fields to not null
+ */
+void det::SourceRecord::setNotNull() {
+    for (int field = 0; field != NUM_SOURCE_NULLABLE_FIELDS; ++field) {
+        _mutableTable->_nulls[field][_index] = false;
+    }
+}
+
+void det::SourceRecord::assign(Source const & source) {
+#define LSST_AFW_DETECTION_SOURCE_RECORD_ASSIGN(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    _mutableTable->_column##NAME[_index] = source.get##NAME();
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_RECORD_ASSIGN)
+
+#undef LSST_AFW_DETECTION_SOURCE_RECORD_ASSIGN
+
+    for (int field = 0; field != NUM_SOURCE_NULLABLE_FIELDS; ++field) {
+        _mutableTable->_nulls[field][_index] = source.isNull(field);
+    }
+}
+
+det::Source::Ptr det::ConstSourceRecord::makeSource() const {
+    Source::Ptr source = boost::make_shared<Source>();
+#define LSST_AFW_DETECTION_SOURCE_RECORD_MAKE(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    source->set##NAME(_table->_column##NAME[_index]);
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_DETECTION_SOURCE_RECORD_MAKE)
+
+#undef LSST_AFW_DETECTION_SOURCE_RECORD_MAKE
+
+    // the setters above clear the null flags, so restore them
+    for (int field = 0; field != NUM_SOURCE_NULLABLE_FIELDS; ++field) {
+        source->setNull(field, _table->_nulls[field][_index]);
+    }
+    return source;
+}
@@ -36,8 +36,11 @@
 #include "boost/format.hpp"
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/array.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/type_traits/is_same.hpp>
 
 #include "lsst/daf/base.h"
 #include "lsst/daf/persistence.h"
@@ -63,6 +66,9 @@ using lsst::daf::persistence::Storage;
 using lsst::pex::policy::Policy;
 using lsst::afw::detection::Source;
 using lsst::afw::detection::SourceSet;
+using lsst::afw::detection::ConstSourceRecord;
+using lsst::afw::detection::SourceRecord;
+using lsst::afw::detection::SourceTable;
 using lsst::afw::detection::PersistableSourceVector;
 using lsst::afw::image::Filter;
 
@@ -745,3 +751,394 @@ void form::SourceVectorFormatter::update(Persistable*,
     throw LSST_EXCEPT(ex::RuntimeErrorException, 
             "SourceVectorFormatter: updates not supported");
 }
+
+
+// -- SourceTableFormatter ----------------
+
+namespace lsst { namespace afw { namespace formatters { namespace {
+
+// Convert a whole column to the units used for it in the database
+template <typename FloatT>
+lsst::ndarray::Array<FloatT const,1,1> toDbUnitsNONE(lsst::ndarray::Array<FloatT const,1,1> const & column) {
+    return column;
+}
+
+template <typename FloatT>
+lsst::ndarray::Array<FloatT const,1,1> toDbUnitsANGLE(lsst::ndarray::Array<FloatT const,1,1> const & column) {
+    int const n = column.template getSize<0>();
+    lsst::ndarray::Array<FloatT,1,1> degrees = lsst::ndarray::allocate(n);
+    for (int i = 0; i != n; ++i) {
+        degrees[i] = _degrees(column[i]);
+    }
+    return degrees;
+}
+
+template <typename FloatT>
+lsst::ndarray::Array<FloatT const,1,1> toDbUnitsRA(lsst::ndarray::Array<FloatT const,1,1> const & column) {
+    int const n = column.template getSize<0>();
+    lsst::ndarray::Array<FloatT,1,1> degrees = lsst::ndarray::allocate(n);
+    for (int i = 0; i != n; ++i) {
+        double d = std::fmod(_degrees(column[i]), 360.0);
+        degrees[i] = (d < 0.0) ? d + 360.0 : d;
+    }
+    return degrees;
+}
+
+// Convert a value retrieved from the database to the units used in a SourceTable
+template <typename T> inline T fromDbUnitsNONE(T value) { return value; }
+template <typename FloatT> inline FloatT fromDbUnitsANGLE(FloatT degrees) { return _radians(degrees); }
+template <typename FloatT> inline FloatT fromDbUnitsRA(FloatT degrees) { return _radians(degrees); }
+
+template <typename T>
+inline void bindColumn(DbStorage * db, char const * const col, T * value) {
+    db->outParam(col, value);
+}
+inline void bindColumn(DbStorage * db, char const * const col, boost::int8_t * value) {
+    db->outParam(col, reinterpret_cast<char *>(value));
+}
+
+// Serialize a column; floating point columns in text archives are written element by element so that
+// NaNs and infinities survive the trip
+template <typename Archive>
+struct IsBinaryArchive {
+    static bool const value = boost::is_same<Archive, boost::archive::binary_oarchive>::value ||
+        boost::is_same<Archive, boost::archive::binary_iarchive>::value;
+};
+
+template <typename Archive, typename T>
+void serializeColumn(Archive & ar, T * data, int const size) {
+    ar & boost::serialization::make_array(data, size);
+}
+
+template <typename Archive, typename FloatT>
+void serializeFpColumn(Archive & ar, FloatT * data, int const size) {
+    if (IsBinaryArchive<Archive>::value) {
+        ar & boost::serialization::make_array(data, size);
+        return;
+    }
+    for (int i = 0; i != size; ++i) {
+        int fpClass = 0;
+        if (lsst::utils::isnan(data[i])) {
+            fpClass = 1;
+        } else if (lsst::utils::isinf(data[i])) {
+            fpClass = data[i] > 0.0 ? 2 : 3;
+        }
+        ar & fpClass;
+        switch (fpClass) {
+            case 1:
+                data[i] = std::numeric_limits<FloatT>::quiet_NaN();
+                break;
+            case 2:
+                data[i] = std::numeric_limits<FloatT>::infinity();
+                break;
+            case 3:
+                data[i] = -std::numeric_limits<FloatT>::infinity();
+                break;
+            default:
+                ar & data[i];
+        }
+    }
+}
+
+template <typename Archive>
+void serializeColumn(Archive & ar, float * data, int const size) {
+    serializeFpColumn(ar, data, size);
+}
+template <typename Archive>
+void serializeColumn(Archive & ar, double * data, int const size) {
+    serializeFpColumn(ar, data, size);
+}
+
+}}}} // namespace lsst::afw::formatters::<anonymous>
+
+template <typename T, typename F>
+inline static void insertValue(T & db, F const & val, char const * const col, bool isNull) {
+    if (isNull) {
+        db.setColumnToNull(col);
+    } else {
+        db.template setColumn<F>(col, val);
+    }
+}
+template <typename T>
+inline static void insertValue(T & db, boost::int8_t const & val, char const * const col, bool isNull) {
+    if (isNull) {
+        db.setColumnToNull(col);
+    } else {
+        db.template setColumn<char>(col, static_cast<char>(val));
+    }
+}
+template <typename T>
+inline static void insertValue(T & db, float const & val, char const * const col, bool isNull) {
+    insertFp(db, val, col, isNull);
+}
+template <typename T>
+inline static void insertValue(T & db, double const & val, char const * const col, bool isNull) {
+    insertFp(db, val, col, isNull);
+}
+
+
+form::SourceTableFormatter::SourceTableFormatter(Policy::Ptr const & policy) :
+    lsst::daf::persistence::Formatter(typeid(this)),
+    _policy(policy)
+{}
+
+
+form::SourceTableFormatter::~SourceTableFormatter() {}
+
+
+lsst::daf::persistence::Formatter::Ptr form::SourceTableFormatter::createInstance(Policy::Ptr policy) {
+    return lsst::daf::persistence::Formatter::Ptr(new SourceTableFormatter(policy));
+}
+
+
+lsst::daf::persistence::FormatterRegistration form::SourceTableFormatter::registration(
+    "SourceTable",
+    typeid(SourceTable),
+    createInstance
+);
+
+
+/*!
+    Inserts every row of a SourceTable into a database table using \a db
+    (an instance of lsst::daf::persistence::DbStorage or subclass thereof).
+ */
+template <typename T>
+void form::SourceTableFormatter::insertRows(T & db, SourceTable const & table)
+{
+    // convert angles from radians to degrees a column at a time
+#define LSST_AFW_FORMATTERS_DB_COLUMN(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    lsst::ndarray::Array<TYPE const,1,1> const column##NAME = toDbUnits##UNITS(table.get##NAME##Column());
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_FORMATTERS_DB_COLUMN)
+
+#undef LSST_AFW_FORMATTERS_DB_COLUMN
+
+    for (int i = 0, n = table.size(); i != n; ++i) {
+        ConstSourceRecord const record = table[i];
+#define LSST_AFW_FORMATTERS_DB_INSERT(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+        insertValue(db, column##NAME[i], DB_NAME, record.isNull(NULLABLE));
+
+        LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_FORMATTERS_DB_INSERT)
+
+#undef LSST_AFW_FORMATTERS_DB_INSERT
+        db.insertRow();
+    }
+}
+
+//! \cond
+template void form::SourceTableFormatter::insertRows<DbStorage>   (DbStorage & db,    SourceTable const &t);
+template void form::SourceTableFormatter::insertRows<DbTsvStorage>(DbTsvStorage & db, SourceTable const &t);
+//! \endcond
+
+
+template <class Archive>
+void form::SourceTableFormatter::delegateSerialize(
+    Archive & archive,
+    unsigned int const,
+    Persistable * persistable
+) {
+    SourceTable * p = dynamic_cast<SourceTable *>(persistable);
+
+    archive & boost::serialization::base_object<Persistable>(*p);
+
+    int size = p->size();
+    archive & size;
+    if (Archive::is_loading::value) {
+        p->clear();
+        p->reserve(size);
+        for (int i = 0; i != size; ++i) {
+            p->append();
+        }
+    }
+#define LSST_AFW_FORMATTERS_SERIALIZE_COLUMN(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+    serializeColumn(archive, p->_column##NAME.getData(), size);
+
+    LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_FORMATTERS_SERIALIZE_COLUMN)
+
+#undef LSST_AFW_FORMATTERS_SERIALIZE_COLUMN
+
+    for (int field = 0; field != det::NUM_SOURCE_NULLABLE_FIELDS; ++field) {
+        serializeColumn(archive, p->_nulls[field].getData(), size);
+    }
+}
+
+
+template void form::SourceTableFormatter::delegateSerialize<boost::archive::text_oarchive>(
+    boost::archive::text_oarchive &, unsigned int const, Persistable *
+);
+template void form::SourceTableFormatter::delegateSerialize<boost::archive::text_iarchive>(
+    boost::archive::text_iarchive &, unsigned int const, Persistable *
+);
+template void form::SourceTableFormatter::delegateSerialize<boost::archive::binary_oarchive>(
+    boost::archive::binary_oarchive &, unsigned int const, Persistable *
+);
+template void form::SourceTableFormatter::delegateSerialize<boost::archive::binary_iarchive>(
+    boost::archive::binary_iarchive &, unsigned int const, Persistable *
+);
+
+/**
+ * Persist a SourceTable to BoostStorage, DbStorage or DbTsvStorage
+ *
+ * Unknown filter ids and missing source ids are filled in from additionalData in what's persisted;
+ * the table itself is not modified.
+ */
+void form::SourceTableFormatter::write(
+    Persistable const * persistable,
+    Storage::Ptr storage,
+    lsst::daf::base::PropertySet::Ptr additionalData
+) {
+    if (persistable == 0) {
+        throw LSST_EXCEPT(ex::InvalidParameterException, "No Persistable provided");
+    }
+    if (!storage) {
+        throw LSST_EXCEPT(ex::InvalidParameterException, "No Storage provided");
+    }
+
+    SourceTable const * p = dynamic_cast<SourceTable const *>(persistable);
+    if (p == 0) {
+        throw LSST_EXCEPT(ex::RuntimeErrorException,
+                "Persistable was not of concrete type SourceTable");
+    }
+    int const size = p->size();
+    // the ids are filled in in a copy of the table, made only if one is needed
+    boost::scoped_ptr<SourceTable> copy;
+    // Set filter id for sources with an unknown filter
+    if (additionalData && additionalData->exists("filterId") && !additionalData->isArray("filterId")) {
+        int filterId = additionalData->getAsInt("filterId");
+        lsst::ndarray::Array<boost::int8_t const,1,1> filterIds = p->getFilterIdColumn();
+        for (int i = 0; i != size; ++i) {
+            if (filterIds[i] == Filter::UNKNOWN) {
+                if (!copy) {
+                    copy.reset(new SourceTable(*p));
+                }
+                (*copy)[i].setFilterId(filterId);
+            }
+        }
+    }
+    // Assume all have ids or none do.  If none do, assign them ids.
+    if (size > 0 && p->getIdColumn()[0] == 0 && additionalData && additionalData->exists("ampExposureId") &&
+        (!_policy || !_policy->exists("generateIds") || _policy->getBool("generateIds"))) {
+        boost::int64_t ampExposureId = extractAmpExposureId(additionalData);
+        if (size >= 65536) {
+            throw LSST_EXCEPT(ex::RangeErrorException, "too many Sources per-amp: "
+                "sequence number overflows 16 bits, potentially causing unique-id conflicts");
+        }
+        if (!copy) {
+            copy.reset(new SourceTable(*p));
+        }
+        for (int i = 0; i != size; ++i) {
+            SourceRecord record = (*copy)[i];
+            record.setId(generateSourceId(i + 1, ampExposureId));
+            record.setAmpExposureId(ampExposureId);
+        }
+    }
+    if (copy) {
+        p = copy.get();
+    }
+
+    if (typeid(*storage) == typeid(BoostStorage)) {
+        BoostStorage * bs = dynamic_cast<BoostStorage *>(storage.get());
+        if (bs == 0) {
+            throw LSST_EXCEPT(ex::RuntimeErrorException,
+                    "Didn't get BoostStorage");
+        }
+        bs->getOArchive() & *p;
+    } else if (typeid(*storage) == typeid(DbStorage)
+            || typeid(*storage) == typeid(DbTsvStorage)) {
+
+        std::string itemName(getItemName(additionalData));
+        std::string name(getTableName(_policy, additionalData));
+        std::string model = _policy->getString(itemName + ".templateTableName");
+        if (typeid(*storage) == typeid(DbStorage)) {
+            DbStorage * db = dynamic_cast<DbStorage *>(storage.get());
+            if (db == 0) {
+                throw LSST_EXCEPT(ex::RuntimeErrorException,
+                        "Didn't get DbStorage");
+            }
+            db->createTableFromTemplate(name, model, true);
+            db->setTableForInsert(name);
+            insertRows<DbStorage>(*db, *p);
+        } else {
+            DbTsvStorage * db = dynamic_cast<DbTsvStorage *>(storage.get());
+            if (db == 0) {
+                throw LSST_EXCEPT(ex::RuntimeErrorException,
+                        "Didn't get DbTsvStorage");
+            }
+            db->createTableFromTemplate(name, model, true);
+            db->setTableForInsert(name);
+            insertRows<DbTsvStorage>(*db, *p);
+        }
+    } else {
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                "Storage type is not supported");
+    }
+}
+
+
+/**
+ * Retrieve a SourceTable from BoostStorage, DbStorage or DbTsvStorage
+ */
+Persistable* form::SourceTableFormatter::read(
+    Storage::Ptr storage,
+    lsst::daf::base::PropertySet::Ptr additionalData
+) {
+    std::auto_ptr<SourceTable> p(new SourceTable);
+
+    if (typeid(*storage) == typeid(BoostStorage)) {
+        BoostStorage* bs = dynamic_cast<BoostStorage *>(storage.get());
+        if (bs == 0) {
+            throw LSST_EXCEPT(ex::RuntimeErrorException,
+                    "Didn't get BoostStorage");
+        }
+        bs->getIArchive() & *p;
+    } else if (typeid(*storage) == typeid(DbStorage)
+            || typeid(*storage) == typeid(DbTsvStorage)) {
+        DbStorage * db = dynamic_cast<DbStorage *>(storage.get());
+        if (db == 0) {
+            throw LSST_EXCEPT(ex::RuntimeErrorException,
+                    "Didn't get DbStorage");
+        }
+        std::vector<std::string> tables = getAllSliceTableNames(_policy, additionalData);
+
+        std::vector<std::string>::const_iterator i;
+        std::vector<std::string>::const_iterator const end = tables.end();
+        for (i = tables.begin(); i != end; ++i) {
+            db->setTableForQuery(*i);
+
+#define LSST_AFW_FORMATTERS_DB_BIND(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+            TYPE value##NAME;                                           \
+            bindColumn(db, DB_NAME, &value##NAME);
+
+            LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_FORMATTERS_DB_BIND)
+
+#undef LSST_AFW_FORMATTERS_DB_BIND
+
+            db->query();
+            while (db->next()) {
+                SourceRecord record = p->append();
+                int col = 0;
+                // the setters clear the null flags, so set them afterwards
+#define LSST_AFW_FORMATTERS_DB_FILL(TYPE, NAME, NULLABLE, DB_NAME, UNITS) \
+                record.set##NAME(fromDbUnits##UNITS(value##NAME));      \
+                record.setNull(NULLABLE, db->columnIsNull(col++));
+
+                LSST_AFW_DETECTION_SOURCE_COLUMNS(LSST_AFW_FORMATTERS_DB_FILL)
+
+#undef LSST_AFW_FORMATTERS_DB_FILL
+            }
+            db->finishQuery();
+        }
+    } else {
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                "Storage type is not supported");
+    }
+    return p.release();
+}
+
+
+void form::SourceTableFormatter::update(Persistable*,
+    Storage::Ptr, lsst::daf::base::PropertySet::Ptr
+) {
+    throw LSST_EXCEPT(ex::RuntimeErrorException,
+            "SourceTableFormatter: updates not supported");
+}
@@ -440,10 +440,14 @@ lsst::daf::base::PropertySet::Ptr afwImage::Exposure<ImageT, MaskT, VarianceT>::
   */
 template<typename ImageT, typename MaskT, typename VarianceT> 
 void afwImage::Exposure<ImageT, MaskT, VarianceT>::writeFits(
-    const std::string &expOutFile ///< Exposure's base output file name
+    const std::string &expOutFile, ///< Exposure's base output file name
+    FitsCompression const& imageCompression, ///< How to compress the image plane
+    FitsCompression const& maskCompression, ///< How to compress the mask plane
+    FitsCompression const& varianceCompression ///< How to compress the variance plane
 ) const {
     lsst::daf::base::PropertySet::Ptr outputMetadata = generateOutputMetadata();
-    _maskedImage.writeFits(expOutFile, outputMetadata);
+    _maskedImage.writeFits(expOutFile, outputMetadata, "w", false,
+                           imageCompression, maskCompression, varianceCompression);
 }
 
 /**
@@ -455,10 +459,14 @@ void afwImage::Exposure<ImageT, MaskT, VarianceT>::writeFits(
 template<typename ImageT, typename MaskT, typename VarianceT> 
 void afwImage::Exposure<ImageT, MaskT, VarianceT>::writeFits(
     char **ramFile,        ///< RAM buffer to receive RAM FITS file
-    size_t *ramFileLen    ///< RAM buffer length
+    size_t *ramFileLen,    ///< RAM buffer length
+    FitsCompression const& imageCompression, ///< How to compress the image plane
+    FitsCompression const& maskCompression, ///< How to compress the mask plane
+    FitsCompression const& varianceCompression ///< How to compress the variance plane
 ) const {
     lsst::daf::base::PropertySet::Ptr outputMetadata = generateOutputMetadata();
-    _maskedImage.writeFits(ramFile, ramFileLen, outputMetadata, "a", true);
+    _maskedImage.writeFits(ramFile, ramFileLen, outputMetadata, "a", true,
+                           imageCompression, maskCompression, varianceCompression);
 }
 
 // Explicit instantiations
@@ -50,7 +50,7 @@ typename image::ImageBase<PixelT>::_view_t image::ImageBase<PixelT>::_allocateVi
     Manager::Ptr & manager
 ) {    
     std::pair<Manager::Ptr,PixelT*> r = ndarray::SimpleManager<PixelT>::allocate(
-        dimensions.getX() * dimensions.getY()
+        static_cast<std::size_t>(dimensions.getX()) * dimensions.getY()
     );
     manager = r.first;
     return boost::gil::interleaved_view(
@@ -571,7 +571,8 @@ template<typename PixelT>
 void image::Image<PixelT>::writeFits(
     std::string const& fileName,                ///< File to write
     boost::shared_ptr<const lsst::daf::base::PropertySet> metadata_i, //!< metadata to write to header or NULL
-    std::string const& mode                     //!< "w" to write a new file; "a" to append
+    std::string const& mode,                    //!< "w" to write a new file; "a" to append
+    FitsCompression const& compression          //!< How to compress the image (default: don't)
 ) const {
     using lsst::daf::base::PropertySet;
 
@@ -592,7 +593,7 @@ void image::Image<PixelT>::writeFits(
         metadata = wcsAMetadata;
     }
 
-    image::fits_write_image(fileName, *this, metadata, mode);
+    image::fits_write_image(fileName, *this, metadata, mode, compression);
 }
 
 /**
@@ -602,7 +603,8 @@ template<typename PixelT>
 void image::Image<PixelT>::writeFits(
     char **ramFile, size_t *ramFileLen,
     boost::shared_ptr<const lsst::daf::base::PropertySet> metadata_i, //!< metadata to write to header or NULL
-    std::string const& mode                     //!< "w" to write a new file; "a" to append
+    std::string const& mode,                    //!< "w" to write a new file; "a" to append
+    FitsCompression const& compression          //!< How to compress the image (default: don't)
 ) const {
     using lsst::daf::base::PropertySet;
 
@@ -623,7 +625,7 @@ void image::Image<PixelT>::writeFits(
         metadata = wcsAMetadata;
     }
 
-    image::fits_write_ramImage(ramFile, ramFileLen, *this, metadata, mode);
+    image::fits_write_ramImage(ramFile, ramFileLen, *this, metadata, mode, compression);
 }
 
 /************************************************************************************************************/
@@ -28,8 +28,14 @@
  * @brief Utilities to support PCA analysis of a set of images
  */
 #include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include "boost/cstdint.hpp"
 #include "boost/make_shared.hpp"
 #include "lsst/utils/ieee.h"
+#include "lsst/pex/logging/Trace.h"
 
 #include "Eigen/Core"
 #include "Eigen/QR"
@@ -37,8 +43,10 @@
 
 #include "lsst/afw/image/ImagePca.h"
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace afwMath = lsst::afw::math;
+namespace pexLog = lsst::pex::logging;
 
 namespace lsst {
 namespace afw {
@@ -52,6 +60,11 @@ ImagePca<ImageT>::ImagePca(bool constantWeight ///< Should all stars be weighted
     _fluxList(),
     _dimensions(0,0),
     _constantWeight(constantWeight),
+    _nComponent(100),
+    _nThread(1),
+    _pixels(),
+    _gram(),
+    _nGram(0),
     _eigenValues(std::vector<double>()),
     _eigenImages(ImageList()) {
 }
@@ -122,6 +135,12 @@ typename ImageT::Ptr ImagePca<ImageT>::getMean() const {
  * The notation is that in chapter 7 of Gyula Szokoly's thesis at JHU
  */
 namespace {
+    int const GramBlockSize = 32;       // number of images in a block of the Gram matrix
+    int const GramPixelBlockSize = 512; // number of pixels processed at a time within a block
+    int const SubspaceOversample = 10;  // extra vectors carried by the subspace iteration
+    int const SubspaceMaxIter = 300;    // maximum number of subspace iterations
+    double const SubspaceTolerance = 1e-10; // desired eigenvector residual, relative to max(eigenvalue)
+
     template<typename T>
     struct SortEvalueDecreasing : public std::binary_function<std::pair<T, int> const&,
                                                               std::pair<T, int> const&, bool> {
@@ -164,8 +183,510 @@ namespace {
     template<typename ImageT>
     struct GetImage : public GetImage_<ImageT, typename ImageT::image_category> {
     };
+/*
+ * Calculate the inner products of the packed images with indices in [i0, i1) and [j0, j1), for i >= j.
+ * Each call processes one block of the (symmetric) Gram matrix, a chunk of pixels at a time so that
+ * the images being multiplied stay in the cache
+ */
+    class GramBlocks {
+    public:
+        GramBlocks(std::vector<double> const& pixels,     // the packed images
+                   int nPix,                              // number of pixels per image
+                   std::vector<double>& gram,             // the Gram matrix
+                   int nImage,                            // number of images
+                   int nOld,                              // number of images whose products are known
+                   std::vector<std::pair<int, int> > const& blocks // (i, j) indices of blocks to process
+                  ) : _pixels(pixels), _nPix(nPix), _gram(gram), _nImage(nImage), _nOld(nOld),
+                      _blocks(blocks) {}
+
+        void operator()(int const b) const {
+            int const i0 = std::max(_blocks[b].first*GramBlockSize, _nOld);
+            int const i1 = std::min((_blocks[b].first + 1)*GramBlockSize, _nImage);
+            int const j0 = _blocks[b].second*GramBlockSize;
+            int const j1 = std::min(j0 + GramBlockSize, _nImage);
+
+            std::vector<double> sums((i1 - i0)*GramBlockSize, 0.0);
+            for (int p0 = 0; p0 < _nPix; p0 += GramPixelBlockSize) {
+                int const nPix = std::min(GramPixelBlockSize, _nPix - p0);
+                for (int i = i0; i < i1; ++i) {
+                    double const *iPtr = &_pixels[i*_nPix + p0];
+                    double *sumPtr = &sums[(i - i0)*GramBlockSize];
+                    for (int j = j0, jEnd = std::min(j1, i + 1); j < jEnd; ++j) {
+                        double const *jPtr = &_pixels[j*_nPix + p0];
+                        double sum = 0.0;
+                        for (int p = 0; p < nPix; ++p) {
+                            sum += iPtr[p]*jPtr[p];
+                        }
+                        sumPtr[j - j0] += sum;
+                    }
+                }
+            }
+
+            for (int i = i0; i < i1; ++i) {
+                for (int j = j0, jEnd = std::min(j1, i + 1); j < jEnd; ++j) {
+                    _gram[i*_nImage + j] = _gram[j*_nImage + i] = sums[(i - i0)*GramBlockSize + j - j0];
+                }
+            }
+        }
+
+    private:
+        std::vector<double> const& _pixels;
+        int const _nPix;
+        std::vector<double>& _gram;
+        int const _nImage;
+        int const _nOld;
+        std::vector<std::pair<int, int> > const& _blocks;
+    };
+/*
+ * Set out = mat*in, where mat is n x n and in and out are n x m (all row-major), a chunk of rows at a time
+ */
+    class MultiplyRows {
+    public:
+        MultiplyRows(std::vector<double> const& mat, std::vector<double> const& in, std::vector<double>& out,
+                     int n, int m, int nChunk) :
+            _mat(mat), _in(in), _out(out), _n(n), _m(m), _nChunk(nChunk) {}
+
+        void operator()(int const chunk) const {
+            for (int i = chunk*_n/_nChunk, iEnd = (chunk + 1)*_n/_nChunk; i < iEnd; ++i) {
+                double *outPtr = &_out[i*_m];
+                std::fill(outPtr, outPtr + _m, 0.0);
+                for (int j = 0; j != _n; ++j) {
+                    double const value = _mat[i*_n + j];
+                    double const *inPtr = &_in[j*_m];
+                    for (int k = 0; k != _m; ++k) {
+                        outPtr[k] += value*inPtr[k];
+                    }
+                }
+            }
+        }
+
+    private:
+        std::vector<double> const& _mat;
+        std::vector<double> const& _in;
+        std::vector<double>& _out;
+        int const _n;
+        int const _m;
+        int const _nChunk;
+    };
+
+    /// A uniform deviate in [-0.5, 0.5); we don't need a good generator, but we do want reproducible results
+    double getDeviate(boost::uint32_t& seed) {
+        seed = 1664525u*seed + 1013904223u;
+        return seed/4294967296.0 - 0.5;
+    }
+/*
+ * Orthonormalise the columns of the n x m (row-major) matrix vec using modified Gram-Schmidt (applied
+ * twice, for stability).  Columns that are (numerically) linear combinations of their predecessors are
+ * replaced by random vectors, so the result always spans m dimensions
+ */
+    void orthonormalize(std::vector<double>& vec, int const n, int const m, boost::uint32_t& seed) {
+        for (int k = 0; k != m; ++k) {
+            for (int iter = 0; ; ++iter) {
+                double norm0 = 0.0;
+                for (int i = 0; i != n; ++i) {
+                    norm0 += vec[i*m + k]*vec[i*m + k];
+                }
+                for (int pass = 0; pass != 2; ++pass) {
+                    for (int l = 0; l != k; ++l) {
+                        double dot = 0.0;
+                        for (int i = 0; i != n; ++i) {
+                            dot += vec[i*m + k]*vec[i*m + l];
+                        }
+                        for (int i = 0; i != n; ++i) {
+                            vec[i*m + k] -= dot*vec[i*m + l];
+                        }
+                    }
+                }
+                double norm = 0.0;
+                for (int i = 0; i != n; ++i) {
+                    norm += vec[i*m + k]*vec[i*m + k];
+                }
+                if (norm > 0.0 && norm > 1e-20*norm0) {
+                    norm = std::sqrt(norm);
+                    for (int i = 0; i != n; ++i) {
+                        vec[i*m + k] /= norm;
+                    }
+                    break;
+                }
+                if (iter == 10) {
+                    throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
+                                      (boost::format("Unable to find %d orthogonal vectors of length %d") %
+                                       m % n).str());
+                }
+                for (int i = 0; i != n; ++i) {
+                    vec[i*m + k] = getDeviate(seed);
+                }
+            }
+        }
+    }
+/*
+ * Replace the n x m (row-major) matrix mat by mat*S, with the columns of S taken in the order given by
+ * the indices in sorted
+ */
+    void rotateColumns(std::vector<double>& mat, int const n, int const m, Eigen::MatrixXd const& S,
+                       std::vector<std::pair<double, int> > const& sorted) {
+        std::vector<double> tmp(m);
+        for (int i = 0; i != n; ++i) {
+            double *row = &mat[i*m];
+            for (int k = 0; k != m; ++k) {
+                int const kk = sorted[k].second;
+                double sum = 0.0;
+                for (int l = 0; l != m; ++l) {
+                    sum += row[l]*S(l, kk);
+                }
+                tmp[k] = sum;
+            }
+            std::copy(tmp.begin(), tmp.end(), row);
+        }
+    }
+/*
+ * Find all the eigen values and the first nEigen eigen vectors of the symmetric n x n matrix gram, sorted
+ * by decreasing eigen value, by solving the full eigen problem
+ */
+    void findAllEigenvectors(std::vector<double> const& gram, // the matrix (row-major)
+                             int const n,                     // dimension of gram
+                             int const nEigen,                // number of eigen vectors desired
+                             std::vector<double>* eigenValues,  // the eigen values
+                             std::vector<double>* eigenVectors  // the eigen vectors
+                            ) {
+        Eigen::MatrixXd R(n, n);
+        for (int i = 0; i != n; ++i) {
+            for (int j = 0; j != n; ++j) {
+                R(i, j) = gram[i*n + j];
+            }
+        }
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eVecValues(R);
+        Eigen::MatrixXd const& Q = eVecValues.eigenvectors();
+        Eigen::VectorXd const& lambda = eVecValues.eigenvalues();
+        //
+        // We need to sort the eigenValues, and remember the permutation we applied to the eigenImages
+        // We'll use the vector lambdaAndIndex to achieve this
+        //
+        std::vector<std::pair<double, int> > lambdaAndIndex; // pairs (eValue, index)
+        lambdaAndIndex.reserve(n);
+
+        for (int i = 0; i != n; ++i) {
+            lambdaAndIndex.push_back(std::make_pair(lambda(i), i));
+        }
+        std::sort(lambdaAndIndex.begin(), lambdaAndIndex.end(), SortEvalueDecreasing<double>());
+
+        eigenValues->resize(n);
+        eigenVectors->resize(n*nEigen);
+        for (int k = 0; k != n; ++k) {
+            (*eigenValues)[k] = lambdaAndIndex[k].first;
+        }
+        for (int k = 0; k != nEigen; ++k) {
+            int const kk = lambdaAndIndex[k].second; // the index after sorting (backwards) by eigenvalue
+            for (int j = 0; j != n; ++j) {
+                (*eigenVectors)[j*nEigen + k] = Q(j, kk);
+            }
+        }
+    }
+/*
+ * Find the eigen values and vectors of the symmetric n x n matrix gram, sorted by decreasing eigen value.
+ * Only the first nEigen eigen vectors are returned, as the columns of the row-major matrix eigenVectors
+ *
+ * If nEigen is small compared to n we use subspace iteration with Rayleigh-Ritz projection, and
+ * only calculate the first nEigen eigen values;  otherwise (or if the iteration fails to converge)
+ * we solve the full eigen problem
+ */
+    void findLeadingEigenvectors(std::vector<double> const& gram, // the matrix (row-major)
+                                 int const n,                     // dimension of gram
+                                 int nEigen,                      // number of eigen vectors desired
+                                 int const nThread,               // number of threads to use
+                                 std::vector<double>* eigenValues,  // the eigen values
+                                 std::vector<double>* eigenVectors  // the eigen vectors
+                                ) {
+        nEigen = std::min(nEigen, n);
+        int const nSub = std::min(n, nEigen + SubspaceOversample); // dimension of the subspace
+
+        if (4*nSub > n) {
+            findAllEigenvectors(gram, n, nEigen, eigenValues, eigenVectors);
+            return;
+        }
+        /*
+         * Subspace iteration.  Each iteration multiplies the current basis by gram, and replaces it by the
+         * Ritz vectors of the enlarged space, orthonormalising as we go
+         */
+        int const nChunk = std::min(afwMath::detail::getNumThreads(nThread), n);
+        boost::uint32_t seed = 1;
+        std::vector<double> V(n*nSub);  // orthonormal basis of the subspace
+        std::vector<double> W(n*nSub);  // gram*V
+        for (std::vector<double>::iterator ptr = V.begin(); ptr != V.end(); ++ptr) {
+            *ptr = getDeviate(seed);
+        }
+        orthonormalize(V, n, nSub, seed);
+
+        Eigen::MatrixXd H(nSub, nSub);   // V^T gram V
+        for (int iter = 0; iter != SubspaceMaxIter; ++iter) {
+            afwMath::detail::parallelFor(0, nChunk, MultiplyRows(gram, V, W, n, nSub, nChunk), nThread);
+
+            for (int k = 0; k != nSub; ++k) {
+                for (int l = 0; l <= k; ++l) {
+                    double sum = 0.0;
+                    for (int i = 0; i != n; ++i) {
+                        sum += 0.5*(V[i*nSub + k]*W[i*nSub + l] + V[i*nSub + l]*W[i*nSub + k]);
+                    }
+                    H(k, l) = H(l, k) = sum;
+                }
+            }
+            Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eVecValues(H);
+            Eigen::MatrixXd const& S = eVecValues.eigenvectors();
+            Eigen::VectorXd const& theta = eVecValues.eigenvalues();
+
+            std::vector<std::pair<double, int> > thetaAndIndex; // pairs (eValue, index)
+            thetaAndIndex.reserve(nSub);
+            for (int k = 0; k != nSub; ++k) {
+                thetaAndIndex.push_back(std::make_pair(theta(k), k));
+            }
+            std::sort(thetaAndIndex.begin(), thetaAndIndex.end(), SortEvalueDecreasing<double>());
+            //
+            // Replace V and W by the Ritz vectors, V S, and gram V S
+            //
+            rotateColumns(V, n, nSub, S, thetaAndIndex);
+            rotateColumns(W, n, nSub, S, thetaAndIndex);
+            //
+            // Are the first nEigen Ritz vectors eigenvectors?
+            //
+            double const scale = std::fabs(thetaAndIndex[0].first);
+            double maxResidual = 0.0;
+            for (int k = 0; k != nEigen; ++k) {
+                double const thetaK = thetaAndIndex[k].first;
+                double residual = 0.0;
+                for (int i = 0; i != n; ++i) {
+                    double const r = W[i*nSub + k] - thetaK*V[i*nSub + k];
+                    residual += r*r;
+                }
+                maxResidual = std::max(maxResidual, std::sqrt(residual));
+            }
+
+            if (maxResidual <= SubspaceTolerance*scale) {
+                eigenValues->resize(nEigen);
+                eigenVectors->resize(n*nEigen);
+                for (int k = 0; k != nEigen; ++k) {
+                    (*eigenValues)[k] = thetaAndIndex[k].first;
+                }
+                for (int j = 0; j != n; ++j) {
+                    std::copy(&V[j*nSub], &V[j*nSub] + nEigen, &(*eigenVectors)[j*nEigen]);
+                }
+
+                return;
+            }
+
+            V.swap(W);
+            orthonormalize(V, n, nSub, seed);
+        }
+
+        pexLog::TTrace<1>("lsst.afw.image.ImagePca",
+                          "Subspace iteration failed to converge in %d iterations; solving the full %dx%d "
+                          "eigen problem", SubspaceMaxIter, n, n);
+        findAllEigenvectors(gram, n, nEigen, eigenValues, eigenVectors);
+    }
+/*
+ * Accumulate the variance and mask planes of the eigen images (a no-op unless we're analyzing MaskedImages)
+ *
+ * The variances add in quadrature and the masks are ORd together, just as MaskedImage::scaledPlus would
+ */
+    template<typename ImageT, typename TagT>
+    class EigenImagePlanes {
+    public:
+        EigenImagePlanes(typename ImagePca<ImageT>::ImageList const&, int, geom::Extent2I const&) {}
+
+        void add(int, int, double const*, int, int) {}
+        void copyTo(ImageT&, int) const {}
+    };
+
+    template<typename ImageT>
+    class EigenImagePlanes<ImageT, typename image::detail::MaskedImage_tag> {
+    public:
+        EigenImagePlanes(typename ImagePca<ImageT>::ImageList const& imageList, // the images being analyzed
+                         int nEigen,                                            // number of eigen images
+                         geom::Extent2I const& dimensions                       // size of each image
+                        ) :
+            _width(dimensions.getX()), _nPix(dimensions.getX()*dimensions.getY()),
+            _variances(), _masks(),
+            _variance(nEigen*_nPix, 0.0), _mask(_nPix, 0) {
+            // Extract the planes now, so as not to touch any shared_ptrs in the worker threads
+            for (int j = 0, nImage = imageList.size(); j != nImage; ++j) {
+                _variances.push_back(imageList[j]->getVariance());
+                _masks.push_back(imageList[j]->getMask());
+            }
+        }
+        /// Add image j's planes for rows [y0, y1), with weights[k] the weight of image j in eigen image k
+        void add(int const j, int const nEigen, double const *weights, int const y0, int const y1) {
+            for (int y = y0; y != y1; ++y) {
+                typename ImageT::Mask::Pixel *mPtr = &_mask[y*_width];
+                for (typename ImageT::Mask::const_x_iterator ptr = _masks[j]->row_begin(y),
+                         end = _masks[j]->row_end(y); ptr != end; ++ptr, ++mPtr) {
+                    *mPtr |= *ptr;
+                }
+                for (int k = 0; k != nEigen; ++k) {
+                    double const weight2 = weights[k]*weights[k];
+                    double *vPtr = &_variance[k*_nPix + y*_width];
+                    for (typename ImageT::Variance::const_x_iterator ptr = _variances[j]->row_begin(y),
+                             end = _variances[j]->row_end(y); ptr != end; ++ptr, ++vPtr) {
+                        *vPtr += weight2*(*ptr);
+                    }
+                }
+            }
+        }
+        /// Set the variance and mask planes of eImage, the k'th eigen image
+        void copyTo(ImageT& eImage, int const k) const {
+            int const height = eImage.getHeight();
+            for (int y = 0; y != height; ++y) {
+                std::copy(&_variance[k*_nPix + y*_width], &_variance[k*_nPix + (y + 1)*_width],
+                          eImage.getVariance()->row_begin(y));
+                std::copy(&_mask[y*_width], &_mask[(y + 1)*_width], eImage.getMask()->row_begin(y));
+            }
+        }
+
+    private:
+        int const _width;
+        int const _nPix;
+        std::vector<typename ImageT::Variance::ConstPtr> _variances;
+        std::vector<typename ImageT::Mask::ConstPtr> _masks;
+        std::vector<double> _variance;  // the eigen images' variances, packed one image after another
+        std::vector<typename ImageT::Mask::Pixel> _mask; // the OR of all the images' masks
+    };
+/*
+ * Calculate the pixels of the eigen images as linear combinations of the packed images, a chunk of rows
+ * at a time
+ */
+    template<typename ImageT>
+    class MakeEigenImages {
+    public:
+        typedef EigenImagePlanes<ImageT, typename ImageT::image_category> Planes;
+
+        MakeEigenImages(std::vector<double> const& pixels,      // the packed images
+                        geom::Extent2I const& dimensions,       // size of each image
+                        int nImage,                             // number of images
+                        int nEigen,                             // number of eigen images
+                        std::vector<double> const& pixelWeights,    // weights to apply to packed pixels
+                        std::vector<double> const& varianceWeights, // weights to apply to variances
+                        std::vector<double>& eigenPixels,       // the eigen images' pixels
+                        Planes& planes,                         // the eigen images' other planes
+                        int nChunk                              // number of chunks of rows
+                       ) :
+            _pixels(pixels), _width(dimensions.getX()), _height(dimensions.getY()),
+            _nImage(nImage), _nEigen(nEigen), _pixelWeights(pixelWeights), _varianceWeights(varianceWeights),
+            _eigenPixels(eigenPixels), _planes(planes), _nChunk(nChunk) {}
+
+        void operator()(int const chunk) const {
+            int const y0 = chunk*_height/_nChunk;
+            int const y1 = (chunk + 1)*_height/_nChunk;
+            int const nPix = _width*_height;
+            int const p0 = y0*_width;
+            int const p1 = y1*_width;
+
+            for (int j = 0; j != _nImage; ++j) {
+                double const *in = &_pixels[j*nPix];
+                for (int k = 0; k != _nEigen; ++k) {
+                    double const weight = _pixelWeights[j*_nEigen + k];
+                    double *out = &_eigenPixels[k*nPix];
+                    for (int p = p0; p < p1; ++p) {
+                        out[p] += weight*in[p];
+                    }
+                }
+                _planes.add(j, _nEigen, &_varianceWeights[j*_nEigen], y0, y1);
+            }
+        }
+
+    private:
+        std::vector<double> const& _pixels;
+        int const _width;
+        int const _height;
+        int const _nImage;
+        int const _nEigen;
+        std::vector<double> const& _pixelWeights;
+        std::vector<double> const& _varianceWeights;
+        std::vector<double>& _eigenPixels;
+        Planes& _planes;
+        int const _nChunk;
+    };
+}
+
+/**
+ * Set the number of eigen images to be calculated by analyze()
+ *
+ * If this is small compared to the number of images, only this many eigen values are calculated
+ *
+ * @throw lsst::pex::exceptions::InvalidParameterException if nComponent < 1
+ */
+template <typename ImageT>
+void ImagePca<ImageT>::setNumComponents(int nComponent ///< Desired number of eigen images
+                                       ) {
+    if (nComponent < 1) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                          (boost::format("You must ask for at least one component, not %d") %
+                           nComponent).str());
+    }
+    _nComponent = nComponent;
+}
+
+/*
+ * Pack any images that have been added since the last call into _pixels, and extend the matrix of
+ * their inner products, _gram, to include them
+ */
+template <typename ImageT>
+void ImagePca<ImageT>::updateGramMatrix()
+{
+    int const nImage = _imageList.size();
+    int const nOld = _nGram;
+    if (nOld == nImage) {
+        return;
+    }
+
+    int const width = _dimensions.getX();
+    int const height = _dimensions.getY();
+    int const nPix = width*height;
+
+    _pixels.resize(nImage*nPix);
+    for (int i = nOld; i != nImage; ++i) {
+        typename GetImage<ImageT>::type const& im = *GetImage<ImageT>::getImage(_imageList[i]);
+        double const scale = _constantWeight ? 1.0/getFlux(i) : 1.0;
+        double *ptr = &_pixels[i*nPix];
+        for (int y = 0; y != height; ++y) {
+            for (typename GetImage<ImageT>::type::const_x_iterator iptr = im.row_begin(y),
+                     end = im.row_end(y); iptr != end; ++iptr, ++ptr) {
+                *ptr = scale*(*iptr);
+            }
+        }
+    }
+
+    std::vector<double> gram(nImage*nImage);
+    for (int i = 0; i != nOld; ++i) {
+        std::copy(&_gram[i*nOld], &_gram[(i + 1)*nOld], &gram[i*nImage]);
+    }
+    _gram.swap(gram);
+    //
+    // Only blocks including new images need to be calculated
+    //
+    int const nBlock = (nImage + GramBlockSize - 1)/GramBlockSize;
+    std::vector<std::pair<int, int> > blocks;
+    for (int bi = nOld/GramBlockSize; bi < nBlock; ++bi) {
+        for (int bj = 0; bj <= bi; ++bj) {
+            blocks.push_back(std::make_pair(bi, bj));
+        }
+    }
+    afwMath::detail::parallelFor(0, blocks.size(), GramBlocks(_pixels, nPix, _gram, nImage, nOld, blocks),
+                              _nThread);
+
+    _nGram = nImage;
 }
 
+/**
+ * Calculate the PCA decomposition of the images
+ *
+ * The images are packed into one array, and the matrix of their inner products is accumulated in blocks
+ * (in parallel, if setNumThreads() permits);  images added since the last call to analyze() are packed
+ * and only their inner products calculated, so it's cheap to add a few images and reanalyze.
+ *
+ * Only the first getNumComponents() eigen images are calculated; if this is small compared to the number
+ * of images we only find that many eigen values, using subspace iteration
+ *
+ * N.b. the pixel values are copied the first time that an image is analyzed; changes to the images
+ * made via updateBadPixels() are picked up, but other changes are not
+ */
 template <typename ImageT>
 void ImagePca<ImageT>::analyze()
 {
@@ -190,72 +711,62 @@ void ImagePca<ImageT>::analyze()
     /*
      * Find the eigenvectors/values of the scalar product matrix, R' (Eq. 7.4)
      */
-    Eigen::MatrixXd R(nImage, nImage);  // residuals' inner products
-
-    double flux_bar = 0;              // mean of flux for all regions
-    for (int i = 0; i != nImage; ++i) {
-        typename GetImage<ImageT>::type const& im_i = *GetImage<ImageT>::getImage(_imageList[i]);
-        double const flux_i = getFlux(i);
-        flux_bar += flux_i;
+    updateGramMatrix();
 
-        for (int j = i; j != nImage; ++j) {
-            typename GetImage<ImageT>::type const& im_j = *GetImage<ImageT>::getImage(_imageList[j]);
-            double const flux_j = getFlux(j);
+    double const flux_bar = std::accumulate(_fluxList.begin(), _fluxList.end(), 0.0)/nImage;
 
-            double dot = innerProduct(im_i, im_j);
-            if (_constantWeight) {
-                dot /= flux_i*flux_j;
-            }
-            R(i, j) = R(j, i) = dot/nImage;
-        }
-    }
-    flux_bar /= nImage;
-   
-    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eVecValues(R);
-    Eigen::MatrixXd const& Q = eVecValues.eigenvectors();
-    Eigen::VectorXd const& lambda = eVecValues.eigenvalues();
+    std::vector<double> lambda;
+    std::vector<double> Q;
+    findLeadingEigenvectors(_gram, nImage, _nComponent, _nThread, &lambda, &Q);
+    int const ncomp = Q.size()/nImage;  // number of components to keep
     //
-    // We need to sort the eigenValues, and remember the permutation we applied to the eigenImages
-    // We'll use the vector lambdaAndIndex to achieve this
-    //
-    std::vector<std::pair<double, int> > lambdaAndIndex; // pairs (eValue, index)
-    lambdaAndIndex.reserve(nImage);
-
-    for (int i = 0; i != nImage; ++i) {
-        lambdaAndIndex.push_back(std::make_pair(lambda(i), i));
-    }
-    std::sort(lambdaAndIndex.begin(), lambdaAndIndex.end(), SortEvalueDecreasing<double>());
-    //
-    // Save the (sorted) eigen values
+    // Save the (sorted) eigen values; R' is our Gram matrix divided by nImage
     //
     _eigenValues.clear();
-    _eigenValues.reserve(nImage);
-    for (int i = 0; i != nImage; ++i) {
-        _eigenValues.push_back(lambdaAndIndex[i].first);
-    }    
+    _eigenValues.reserve(lambda.size());
+    for (std::vector<double>::const_iterator ptr = lambda.begin(); ptr != lambda.end(); ++ptr) {
+        _eigenValues.push_back(*ptr/nImage);
+    }
     //
-    // Contruct the first ncomp eigenimages in basis
+    // Contruct the first ncomp eigenimages in basis.  N.b. if _constantWeight the packed pixels have
+    // already been divided by their fluxes
     //
-    int ncomp = 100;                    // number of components to keep
+    std::vector<double> pixelWeights(nImage*ncomp);
+    std::vector<double> varianceWeights(nImage*ncomp);
+    for (int j = 0; j != nImage; ++j) {
+        for (int i = 0; i != ncomp; ++i) {
+            double const weight = Q[j*ncomp + i]*(_constantWeight ? flux_bar : 1);
+            pixelWeights[j*ncomp + i] = weight;
+            varianceWeights[j*ncomp + i] = _constantWeight ? weight/getFlux(j) : weight;
+        }
+    }
+
+    int const height = _dimensions.getY();
+    int const nChunk = std::min(afwMath::detail::getNumThreads(_nThread), height);
+    std::vector<double> eigenPixels(ncomp*_dimensions.getX()*height, 0.0);
+    typename MakeEigenImages<ImageT>::Planes planes(_imageList, ncomp, _dimensions);
+    afwMath::detail::parallelFor(0, nChunk,
+                              MakeEigenImages<ImageT>(_pixels, _dimensions, nImage, ncomp,
+                                                      pixelWeights, varianceWeights, eigenPixels, planes,
+                                                      nChunk),
+                              _nThread);
 
     _eigenImages.clear();
-    _eigenImages.reserve(ncomp < nImage ? ncomp : nImage);
+    _eigenImages.reserve(ncomp);
 
     for(int i = 0; i < ncomp; ++i) {
-        if(i >= nImage) {
-            continue;
-        }
-
-        int const ii = lambdaAndIndex[i].second; // the index after sorting (backwards) by eigenvalue
-
         typename ImageT::Ptr eImage(new ImageT(_dimensions));
-        *eImage = static_cast<typename ImageT::Pixel>(0);
-
-        for (int j = 0; j != nImage; ++j) {
-            int const jj = lambdaAndIndex[j].second; // the index after sorting (backwards) by eigenvalue
-            double const weight = Q(jj, ii)*(_constantWeight ? flux_bar/getFlux(jj) : 1);
-            eImage->scaledPlus(weight, *_imageList[jj]);
+        {
+            typename GetImage<ImageT>::type::Ptr eImageIm = GetImage<ImageT>::getImage(eImage);
+            std::vector<double>::const_iterator ptr = eigenPixels.begin() + i*_dimensions.getX()*height;
+            for (int y = 0; y != height; ++y) {
+                for (typename GetImage<ImageT>::type::x_iterator iptr = eImageIm->row_begin(y),
+                         end = eImageIm->row_end(y); iptr != end; ++iptr, ++ptr) {
+                    *iptr = static_cast<typename ImageT::Pixel>(*ptr);
+                }
+            }
         }
+        planes.copyTo(*eImage, i);
         /*
          * Normalise eigenImages to have a maximum of 1.0.  For n > 0 they
          * (should) have mean == 0, so we can't use that to normalize
@@ -530,8 +1041,15 @@ double ImagePca<ImageT>::updateBadPixels(
         int const ncomp     ///< Number of components to use in estimate
                                       )
 {
-    return do_updateBadPixels<ImageT>(typename ImageT::image_category(),
-                                      _imageList, _fluxList, _eigenImages, mask, ncomp);
+    double const maxChange = do_updateBadPixels<ImageT>(typename ImageT::image_category(),
+                                                         _imageList, _fluxList, _eigenImages, mask, ncomp);
+    if (maxChange > 0.0) {              // our packed copies of the images are out of date
+        _pixels.clear();
+        _gram.clear();
+        _nGram = 0;
+    }
+
+    return maxChange;
 }
     
 /*******************************************************************************************************/    
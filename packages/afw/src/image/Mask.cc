@@ -337,7 +337,8 @@ void afwImage::Mask<MaskPixelT>::writeFits(
     std::string const& fileName, ///< File to write
     boost::shared_ptr<const lsst::daf::base::PropertySet> metadata_i, ///< metadata to write to header,
         ///< or a null pointer if none
-    std::string const& mode    ///< "w" to write a new file; "a" to append
+    std::string const& mode,   ///< "w" to write a new file; "a" to append
+    FitsCompression const& compression ///< How to compress the mask (default: don't)
 ) const {
 
     dafBase::PropertySet::Ptr metadata;
@@ -355,7 +356,7 @@ void afwImage::Mask<MaskPixelT>::writeFits(
     );
     metadata->combine(wcsAMetadata);
 
-    afwImage::fits_write_image(fileName, *this, metadata, mode);
+    afwImage::fits_write_image(fileName, *this, metadata, mode, compression);
 }
 
 /**
@@ -367,7 +368,8 @@ void afwImage::Mask<MaskPixelT>::writeFits(
     size_t *ramFileLen,    ///< RAM buffer length
     boost::shared_ptr<const lsst::daf::base::PropertySet> metadata_i, ///< metadata to write to header,
         ///< or a null pointer if none
-    std::string const& mode    ///< "w" to write a new file; "a" to append
+    std::string const& mode,   ///< "w" to write a new file; "a" to append
+    FitsCompression const& compression ///< How to compress the mask (default: don't)
 ) const {
 
     dafBase::PropertySet::Ptr metadata;
@@ -385,7 +387,7 @@ void afwImage::Mask<MaskPixelT>::writeFits(
     );
     metadata->combine(wcsAMetadata);
 
-    afwImage::fits_write_ramImage(ramFile, ramFileLen, *this, metadata, mode);
+    afwImage::fits_write_ramImage(ramFile, ramFileLen, *this, metadata, mode, compression);
 }
 
 template<typename MaskPixelT>
@@ -644,8 +644,11 @@ void image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::writeFits(
         boost::shared_ptr<const lsst::daf::base::PropertySet> metadata_i, ///< Metadata to write to file
                                                                           ///< or NULL
         std::string const& mode,                    //!< "w" to write a new file; "a" to append
-        bool const writeMef  ///< write an MEF file,
+        bool const writeMef, ///< write an MEF file,
                              ///< even if basename doesn't look like a fully qualified FITS file
+        FitsCompression const& imageCompression, ///< How to compress the image plane
+        FitsCompression const& maskCompression, ///< How to compress the mask plane
+        FitsCompression const& varianceCompression ///< How to compress the variance plane
     ) const {
 
     if (!(mode == "a" || mode == "ab" || mode == "w" || mode == "wb")) {
@@ -683,23 +686,23 @@ void image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::writeFits(
         }
 
         metadata->set("EXTTYPE", "IMAGE");
-        _image->writeFits(baseName, metadata, "a");
+        _image->writeFits(baseName, metadata, "a", imageCompression);
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
         metadata->set("EXTTYPE", "MASK");
-        _mask->writeFits(baseName, metadata, "a");
+        _mask->writeFits(baseName, metadata, "a", maskCompression);
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
         metadata->set("EXTTYPE", "VARIANCE");
-        _variance->writeFits(baseName, metadata, "a");
+        _variance->writeFits(baseName, metadata, "a", varianceCompression);
     } else {
-        _image->writeFits(MaskedImage::imageFileName(baseName), metadata, mode);
+        _image->writeFits(MaskedImage::imageFileName(baseName), metadata, mode, imageCompression);
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
-        _mask->writeFits(MaskedImage::maskFileName(baseName), metadata, mode);
+        _mask->writeFits(MaskedImage::maskFileName(baseName), metadata, mode, maskCompression);
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
-        _variance->writeFits(MaskedImage::varianceFileName(baseName), metadata, mode);
+        _variance->writeFits(MaskedImage::varianceFileName(baseName), metadata, mode, varianceCompression);
     }
 }
 
@@ -716,8 +719,11 @@ void image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::writeFits(
         boost::shared_ptr<const lsst::daf::base::PropertySet> metadata_i, ///< Metadata to write to file
                                                                           ///< or NULL
         std::string const& mode,                    //!< "w" to write a new file; "a" to append
-        bool const writeMef  ///< write an MEF file,
+        bool const writeMef, ///< write an MEF file,
                              ///< even if basename doesn't look like a fully qualified FITS file
+        FitsCompression const& imageCompression, ///< How to compress the image plane
+        FitsCompression const& maskCompression, ///< How to compress the mask plane
+        FitsCompression const& varianceCompression ///< How to compress the variance plane
     ) const {
 
     if (!(mode == "a" || mode == "ab" || mode == "w" || mode == "wb")) {
@@ -748,15 +754,15 @@ void image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::writeFits(
         }
 
         metadata->set("EXTTYPE", "IMAGE");
-        _image->writeFits(ramFile, ramFileLen, metadata, "w");    //First one can't be 'a', must be 'w'
+        _image->writeFits(ramFile, ramFileLen, metadata, "w", imageCompression); //First one must be 'w'
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
         metadata->set("EXTTYPE", "MASK");
-        _mask->writeFits(ramFile, ramFileLen, metadata, "a");
+        _mask->writeFits(ramFile, ramFileLen, metadata, "a", maskCompression);
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
         metadata->set("EXTTYPE", "VARIANCE");
-        _variance->writeFits(ramFile, ramFileLen, metadata, "a");
+        _variance->writeFits(ramFile, ramFileLen, metadata, "a", varianceCompression);
     } else {
         throw LSST_EXCEPT(lsst::pex::exceptions::IoErrorException, "nonMEF files not supported.");
 
@@ -22,8 +22,10 @@
  
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <vector>
 
 #include "boost/format.hpp"
 
@@ -58,6 +60,9 @@ static void decodeSipHeader(lsst::daf::base::PropertySet::Ptr fitsMetadata,
                             std::string const& which,
                             Eigen::MatrixXd *m);
 
+static void evaluateSip(Eigen::MatrixXd const & coeffs, int minOrder, int maxOrder,
+                        int n, double const *u, double const *v, double *result);
+
 
 TanWcs::TanWcs() : 
     Wcs(),
@@ -353,65 +358,121 @@ GeomPoint TanWcs::skyToPixelImpl(double sky1, ///< Longitude coordinate, DEGREES
 }
 
 GeomPoint TanWcs::undistortPixel(const lsst::afw::geom::Point2D pix) const {
-    if (!_hasDistortion) {
-        return GeomPoint(pix);
+    double pix1 = pix[0];
+    double pix2 = pix[1];
+    undistortPixels(1, &pix1, &pix2);
+    return afwGeom::Point2D(pix1, pix2);
+}
+
+GeomPoint TanWcs::distortPixel(const lsst::afw::geom::Point2D pix) const {
+    double pix1 = pix[0];
+    double pix2 = pix[1];
+    distortPixels(1, &pix1, &pix2);
+    return afwGeom::Point2D(pix1, pix2);
+}
+
+/*
+ * Apply the SIP A and B un-distortion to n pixel positions in place
+ */
+void TanWcs::undistortPixels(int n, double *pix1, double *pix2) const {
+    if (!_hasDistortion || n <= 0) {
+        return;
     }
     //If the following assertions aren't true then something has gone seriously wrong.
     assert(_sipB.rows() > 0 );
     assert(_sipA.rows() == _sipA.cols());
     assert(_sipB.rows() == _sipB.cols());
 
-    double u = pix[0] - _wcsInfo->crpix[0];  //Relative pixel coords
-    double v = pix[1] - _wcsInfo->crpix[1];
-        
-    double f = 0;
-    for(int i=0; i< _sipA.rows(); ++i) {
-        for(int j=0; j< _sipA.cols(); ++j) {
-            if (i+j>1 && i+j < _sipA.rows() ) {
-                f += _sipA(i,j)* pow(u, i) * pow(v, j);
-            }
-        }
+    std::vector<double> u(n), v(n), f(n), g(n);
+    for (int i = 0; i < n; ++i) {
+        u[i] = pix1[i] - _wcsInfo->crpix[0];  //Relative pixel coords
+        v[i] = pix2[i] - _wcsInfo->crpix[1];
     }
 
-    double g = 0;
-    for(int i=0; i< _sipB.rows(); ++i) {
-        for(int j=0; j< _sipB.cols(); ++j) {
-            if (i+j>1 && i+j < _sipB.rows() ) {
-                g += _sipB(i,j)* pow(u, i) * pow(v, j);
-            }
-        }
-    }
+    //The A and B polynomials have no constant or linear terms
+    evaluateSip(_sipA, 2, _sipA.rows() - 1, n, &u[0], &v[0], &f[0]);
+    evaluateSip(_sipB, 2, _sipB.rows() - 1, n, &u[0], &v[0], &g[0]);
 
-    return afwGeom::Point2D(pix[0] + f, pix[1] + g);
+    for (int i = 0; i < n; ++i) {
+        pix1[i] += f[i];
+        pix2[i] += g[i];
+    }
 }
 
-GeomPoint TanWcs::distortPixel(const lsst::afw::geom::Point2D pix) const {
-    if (!_hasDistortion) {
-        return GeomPoint(pix);
+/*
+ * Apply the SIP AP and BP distortion to n pixel positions in place
+ */
+void TanWcs::distortPixels(int n, double *pix1, double *pix2) const {
+    if (!_hasDistortion || n <= 0) {
+        return;
     }
     //If the following assertions aren't true then something has gone seriously wrong.
     assert(_sipBp.rows() > 0 );
     assert(_sipAp.rows() == _sipAp.cols());
-    assert(_sipBp.rows() == _sipBp.cols());        
-        
-    double U = pix[0] - _wcsInfo->crpix[0];  //Relative, undistorted pixel coords
-    double V = pix[1] - _wcsInfo->crpix[1];
-    
-    double F = 0;
-    for(int i=0; i< _sipAp.rows(); ++i) {
-        for(int j=0; j< _sipAp.cols(); ++j) {
-            F += _sipAp(i,j)* pow(U, i) * pow(V, j);
-        }
-    }    
+    assert(_sipBp.rows() == _sipBp.cols());
+
+    std::vector<double> U(n), V(n), F(n), G(n);
+    for (int i = 0; i < n; ++i) {
+        U[i] = pix1[i] - _wcsInfo->crpix[0];  //Relative, undistorted pixel coords
+        V[i] = pix2[i] - _wcsInfo->crpix[1];
+    }
 
-    double G = 0;
-    for(int i=0; i< _sipBp.rows(); ++i) {
-        for(int j=0; j< _sipBp.cols(); ++j) {
-            G += _sipBp(i,j)* pow(U, i) * pow(V, j);
+    //All the terms of the AP and BP polynomials are used
+    evaluateSip(_sipAp, 0, _sipAp.rows() + _sipAp.cols() - 2, n, &U[0], &V[0], &F[0]);
+    evaluateSip(_sipBp, 0, _sipBp.rows() + _sipBp.cols() - 2, n, &U[0], &V[0], &G[0]);
+
+    for (int i = 0; i < n; ++i) {
+        pix1[i] += F[i];
+        pix2[i] += G[i];
+    }
+}
+
+/*
+ * Set result[k] to the sum of coeffs(i, j)*u[k]^i*v[k]^j over the terms with minOrder <= i + j <= maxOrder
+ *
+ * The polynomial is evaluated by Horner's rule in u, each of its coefficients being a polynomial in v
+ * that is itself evaluated by Horner's rule.  The positions are processed in blocks, with the loops over
+ * the positions of a block innermost, so that the compiler can vectorise them.
+ */
+static void evaluateSip(Eigen::MatrixXd const & coeffs, ///< SIP coefficients; coeffs(i, j) multiplies u^i v^j
+                        int minOrder,                   ///< lowest order term to include
+                        int maxOrder,                   ///< highest order term to include
+                        int n,                          ///< number of positions
+                        double const *u,                ///< relative column positions
+                        double const *v,                ///< relative row positions
+                        double *result                  ///< the value of the polynomial at each position
+                       ) {
+    int const blockSize = 256;
+    double vSum[blockSize];
+
+    for (int k0 = 0; k0 < n; k0 += blockSize) {
+        int const nk = std::min(blockSize, n - k0);
+        double const *uk = u + k0;
+        double const *vk = v + k0;
+        double *rk = result + k0;
+
+        std::fill(rk, rk + nk, 0.0);
+        for (int i = coeffs.rows() - 1; i >= 0; --i) {
+            int const jMin = std::max(0, minOrder - i);
+            int const jMax = std::min(static_cast<int>(coeffs.cols()) - 1, maxOrder - i);
+
+            std::fill(vSum, vSum + nk, 0.0);
+            for (int j = jMax; j >= jMin; --j) {
+                double const c = coeffs(i, j);
+                for (int k = 0; k < nk; ++k) {
+                    vSum[k] = vSum[k]*vk[k] + c;
+                }
+            }
+            for (int j = 0; j < jMin; ++j) {
+                for (int k = 0; k < nk; ++k) {
+                    vSum[k] *= vk[k];
+                }
+            }
+            for (int k = 0; k < nk; ++k) {
+                rk[k] = rk[k]*uk[k] + vSum[k];
+            }
         }
     }
-    return afwGeom::Point2D(U + F + _wcsInfo->crpix[0],
-                            V + G + _wcsInfo->crpix[1]);
 }
 
 /************************************************************************************************************/
@@ -447,6 +508,52 @@ TanWcs::pixelToSkyImpl(double pixel1, double pixel2, double skyTmp[2]) const
     }
 }
 
+/*
+ * Worker routine for the array version of pixelToSky
+ */
+void TanWcs::pixelToSkyImpl(int n, double const *pixel1, double const *pixel2,
+                            double *sky1, double *sky2) const
+{
+    if(_wcsInfo == NULL) {
+        throw(LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, "Wcs structure not initialised"));
+    }
+
+    // wcslib assumes 1-indexed coordinates
+    double const offset = -lsst::afw::image::PixelZeroPos + lsstToFitsPixels;
+    std::vector<double> pixTmp1(n), pixTmp2(n);
+    for (int i = 0; i < n; ++i) {
+        pixTmp1[i] = pixel1[i] + offset;
+        pixTmp2[i] = pixel2[i] + offset;
+    }
+
+    //Correct pixel positions for distortion if necessary
+    undistortPixels(n, &pixTmp1[0], &pixTmp2[0]);
+
+    fitsPixelToSky(n, &pixTmp1[0], &pixTmp2[0], sky1, sky2);
+}
+
+/*
+ * Worker routine for the array version of skyToPixel
+ */
+void TanWcs::skyToPixelImpl(int n, double const *sky1, double const *sky2,
+                            double *pixel1, double *pixel2) const
+{
+    if(_wcsInfo == NULL) {
+        throw(LSST_EXCEPT(except::RuntimeErrorException, "Wcs structure not initialised"));
+    }
+
+    //Estimate undistorted pixel coordinates, then correct for distortion
+    skyToFitsPixel(n, sky1, sky2, pixel1, pixel2);
+    distortPixels(n, pixel1, pixel2);
+
+    // wcslib assumes 1-indexed coords
+    double const offset = lsst::afw::image::PixelZeroPos + fitsToLsstPixels;
+    for (int i = 0; i < n; ++i) {
+        pixel1[i] += offset;
+        pixel2[i] += offset;
+    }
+}
+
 /************************************************************************************************************/
 
 lsst::daf::base::PropertyList::Ptr TanWcs::getFitsMetadata() const {
@@ -24,8 +24,11 @@
 
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <limits>
+#include <vector>
 
 #include "boost/format.hpp"
 
@@ -61,6 +64,14 @@ const int STRLEN = 72;
 const int lsstToFitsPixels = +1;
 const int fitsToLsstPixels = -1;
 
+//The number of positions converted by each call to wcslib in the array versions of pixelToSky and skyToPixel;
+//this bounds the size of the scratch arrays that wcslib needs
+const int WCS_BATCH_SIZE = 1024;
+
+//wcslib status codes for "One or more of the pixel (world) coordinates were invalid"
+const int WCS_INVALID_PIXEL = 8;
+const int WCS_INVALID_WORLD = 9;
+
 //
 // Constructors
 //
@@ -761,6 +772,165 @@ afwGeom::Point2D Wcs::pixelToSky(double pixel1, double pixel2, bool) const {
     return afwGeom::Point2D(skyTmp[0], skyTmp[1]);
 }
 
+///\brief Convert an array of pixel positions to sky coordinates (e.g ra/dec)
+///
+///The positions are passed to wcslib (and the SIP polynomials of a TanWcs are evaluated) a batch at a
+///time, and no Coord is created, so this is much faster than calling pixelToSky for each position.
+///sky1 and sky2 are set to the longitude and latitude (e.g ra and dec) in degrees, in the coordinate
+///system of the Wcs, even if CTYPE1 is a latitude;  this is the same order as is expected by
+///skyToPixel(double, double).  Positions that can't be converted are set to NaN.
+///
+///\throw lsst::pex::exceptions::LengthErrorException if the arrays don't all have the same length
+void Wcs::pixelToSky(lsst::ndarray::Array<double const,1,1> const & pix1, ///< column positions
+                     lsst::ndarray::Array<double const,1,1> const & pix2, ///< row positions
+                     lsst::ndarray::Array<double,1,1> const & sky1,       ///< longitudes; DEGREES
+                     lsst::ndarray::Array<double,1,1> const & sky2        ///< latitudes; DEGREES
+                    ) const {
+    int const n = pix1.getSize<0>();
+    if (pix2.getSize<0>() != n || sky1.getSize<0>() != n || sky2.getSize<0>() != n) {
+        throw LSST_EXCEPT(except::LengthErrorException,
+                          (boost::format("Arrays have different lengths: %d, %d, %d, %d") %
+                           n % pix2.getSize<0>() % sky1.getSize<0>() % sky2.getSize<0>()).str());
+    }
+    if(! isInitialized()) {
+        throw(LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, "Wcs structure not initialised"));
+    }
+
+    double *lon = sky1.getData();
+    double *lat = sky2.getData();
+    if (_skyCoordsReversed) {
+        std::swap(lon, lat);
+    }
+    for (int i = 0; i < n; i += WCS_BATCH_SIZE) {
+        int const nBatch = std::min(WCS_BATCH_SIZE, n - i);
+        pixelToSkyImpl(nBatch, pix1.getData() + i, pix2.getData() + i, lon + i, lat + i);
+    }
+}
+
+///\brief Convert an array of sky positions (e.g ra/dec) to pixel positions
+///
+///The inverse of the array version of pixelToSky:  sky1 and sky2 are the longitude and latitude in degrees,
+///in the coordinate system of the Wcs.  Positions that can't be converted are set to NaN.
+///
+///\throw lsst::pex::exceptions::LengthErrorException if the arrays don't all have the same length
+void Wcs::skyToPixel(lsst::ndarray::Array<double const,1,1> const & sky1, ///< longitudes; DEGREES
+                     lsst::ndarray::Array<double const,1,1> const & sky2, ///< latitudes; DEGREES
+                     lsst::ndarray::Array<double,1,1> const & pix1,       ///< column positions
+                     lsst::ndarray::Array<double,1,1> const & pix2        ///< row positions
+                    ) const {
+    int const n = sky1.getSize<0>();
+    if (sky2.getSize<0>() != n || pix1.getSize<0>() != n || pix2.getSize<0>() != n) {
+        throw LSST_EXCEPT(except::LengthErrorException,
+                          (boost::format("Arrays have different lengths: %d, %d, %d, %d") %
+                           n % sky2.getSize<0>() % pix1.getSize<0>() % pix2.getSize<0>()).str());
+    }
+    if(! isInitialized()) {
+        throw(LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, "Wcs structure not initialised"));
+    }
+
+    double const *lon = sky1.getData();
+    double const *lat = sky2.getData();
+    if (_skyCoordsReversed) {
+        std::swap(lon, lat);
+    }
+    for (int i = 0; i < n; i += WCS_BATCH_SIZE) {
+        int const nBatch = std::min(WCS_BATCH_SIZE, n - i);
+        skyToPixelImpl(nBatch, lon + i, lat + i, pix1.getData() + i, pix2.getData() + i);
+    }
+}
+
+/*
+ * Worker routine for the array version of pixelToSky; the sky coordinates are in the order of the ctypes
+ */
+void Wcs::pixelToSkyImpl(int n, double const *pixel1, double const *pixel2, double *sky1, double *sky2) const
+{
+    // wcslib assumes 1-indexed coordinates
+    double const offset = -lsst::afw::image::PixelZeroPos + lsstToFitsPixels;
+    std::vector<double> pixTmp1(n), pixTmp2(n);
+    for (int i = 0; i < n; ++i) {
+        pixTmp1[i] = pixel1[i] + offset;
+        pixTmp2[i] = pixel2[i] + offset;
+    }
+    fitsPixelToSky(n, &pixTmp1[0], &pixTmp2[0], sky1, sky2);
+}
+
+/*
+ * Worker routine for the array version of skyToPixel; the sky coordinates are in the order of the ctypes
+ */
+void Wcs::skyToPixelImpl(int n, double const *sky1, double const *sky2, double *pixel1, double *pixel2) const
+{
+    skyToFitsPixel(n, sky1, sky2, pixel1, pixel2);
+
+    // wcslib assumes 1-indexed coords
+    double const offset = lsst::afw::image::PixelZeroPos + fitsToLsstPixels;
+    for (int i = 0; i < n; ++i) {
+        pixel1[i] += offset;
+        pixel2[i] += offset;
+    }
+}
+
+/*
+ * Convert n FITS (1-indexed) pixel positions to sky coordinates with a single call to wcsp2s.
+ * Positions that wcslib reports as invalid are set to NaN.
+ */
+void Wcs::fitsPixelToSky(int n, double const *pixel1, double const *pixel2, double *sky1, double *sky2) const
+{
+    if (n <= 0) {
+        return;
+    }
+    std::vector<double> pixTmp(2*n), imgcrd(2*n), skyTmp(2*n), phi(n), theta(n);
+    std::vector<int> stat(n);
+    for (int i = 0; i < n; ++i) {
+        pixTmp[2*i] = pixel1[i];
+        pixTmp[2*i + 1] = pixel2[i];
+    }
+
+    int const status = wcsp2s(_wcsInfo, n, 2, &pixTmp[0], &imgcrd[0], &phi[0], &theta[0], &skyTmp[0],
+                              &stat[0]);
+    if (status > 0 && status != WCS_INVALID_PIXEL) {
+        throw LSST_EXCEPT(except::RuntimeErrorException,
+                          (boost::format("Error: wcslib returned a status code of %d. %s") %
+                           status % wcs_errmsg[status]).str());
+    }
+
+    double const nan = std::numeric_limits<double>::quiet_NaN();
+    for (int i = 0; i < n; ++i) {
+        sky1[i] = stat[i] ? nan : skyTmp[2*i];
+        sky2[i] = stat[i] ? nan : skyTmp[2*i + 1];
+    }
+}
+
+/*
+ * Convert n sky positions to FITS (1-indexed) pixel coordinates with a single call to wcss2p.
+ * Positions that wcslib reports as invalid are set to NaN.
+ */
+void Wcs::skyToFitsPixel(int n, double const *sky1, double const *sky2, double *pixel1, double *pixel2) const
+{
+    if (n <= 0) {
+        return;
+    }
+    std::vector<double> skyTmp(2*n), imgcrd(2*n), pixTmp(2*n), phi(n), theta(n);
+    std::vector<int> stat(n);
+    for (int i = 0; i < n; ++i) {
+        skyTmp[2*i] = sky1[i];
+        skyTmp[2*i + 1] = sky2[i];
+    }
+
+    int const status = wcss2p(_wcsInfo, n, 2, &skyTmp[0], &phi[0], &theta[0], &imgcrd[0], &pixTmp[0],
+                              &stat[0]);
+    if (status > 0 && status != WCS_INVALID_WORLD) {
+        throw LSST_EXCEPT(except::RuntimeErrorException,
+                          (boost::format("Error: wcslib returned a status code of %d. %s") %
+                           status % wcs_errmsg[status]).str());
+    }
+
+    double const nan = std::numeric_limits<double>::quiet_NaN();
+    for (int i = 0; i < n; ++i) {
+        pixel1[i] = stat[i] ? nan : pixTmp[2*i];
+        pixel2[i] = stat[i] ? nan : pixTmp[2*i + 1];
+    }
+}
+
 ///\brief Given a sky position, use the values stored in ctype and radesys to return the correct
 ///sub-class of Coord
 CoordPtr Wcs::makeCorrectCoord(double sky0, double sky1) const {
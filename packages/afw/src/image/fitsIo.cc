@@ -27,6 +27,7 @@
 /// \author Robert Lupton (rhl@astro.princeton.edu)\n
 ///         Princeton University
 /// \date   September 2008
+#include <algorithm>
 #include <cstring>
 #include "boost/format.hpp"
 #include "boost/regex.hpp"
@@ -380,6 +381,20 @@ void addKV(lsst::daf::base::PropertySet::Ptr metadata, std::string const& key, s
     }
 }
 
+namespace {
+    /*
+     * Is keyName one of the keywords used to describe a tile-compressed image (which is stored as a binary
+     * table, so it has table keywords too)?
+     */
+    bool isCompressionKey(std::string const& keyName) {
+        static boost::regex const compressionKey_RE(
+            "^(Z(IMAGE|SIMPLE|EXTEND|TENSION|BITPIX|NAXIS[0-9]*|TILE[0-9]+|CMPTYPE|NAME[0-9]+|VAL[0-9]+|"
+            "QUANTIZ|DITHER0|BLOCKED|PCOUNT|GCOUNT|HECKSUM|DATASUM|BLANK|SCALE|ZERO|MASKCMP)|"
+            "TFIELDS|T(TYPE|FORM|SCAL|ZERO|NULL|UNIT|DIM)[0-9]+|THEAP)$");
+        return boost::regex_match(keyName, compressionKey_RE);
+    }
+}
+
 // Private function to build a PropertySet that contains all the FITS kw-value pairs
     void getMetadata(fitsfile* fd, lsst::daf::base::PropertySet::Ptr metadata, bool strip) {
     // Get all the kw-value pairs from the FITS file, and add each to DataProperty
@@ -387,6 +402,9 @@ void addKV(lsst::daf::base::PropertySet::Ptr metadata, std::string const& key, s
         return;
     }
 
+    int status = 0;
+    bool const isCompressed = (fits_is_compressed_image(fd, &status) != 0);
+
     for (int i=1; i<=getNumKeys(fd); i++) {
         std::string keyName;
         std::string val;
@@ -396,7 +414,8 @@ void addKV(lsst::daf::base::PropertySet::Ptr metadata, std::string const& key, s
         if (strip && (keyName == "SIMPLE" || keyName == "BITPIX" || keyName == "EXTEND" ||
                       keyName == "NAXIS" || keyName == "NAXIS1" || keyName == "NAXIS2" ||
                       keyName == "GCOUNT" || keyName == "PCOUNT" || keyName == "XTENSION" ||
-                      keyName == "BSCALE" || keyName == "BZERO")) {
+                      keyName == "BSCALE" || keyName == "BZERO" ||
+                      (isCompressed && isCompressionKey(keyName)))) {
             ;
         } else {
             addKV(metadata, keyName, val, comment);
@@ -404,6 +423,65 @@ void addKV(lsst::daf::base::PropertySet::Ptr metadata, std::string const& key, s
     }
 
 }
+
+/************************************************************************************************************/
+/**
+ * Set the compression to be used for the next image HDU created in fd
+ *
+ * The tile dimensions are clipped to the dimensions of the image (width x height); the compression
+ * remains in effect until it's reset by calling setCompression with a COMPRESS_NONE FitsCompression
+ */
+void setCompression(fitsfile* fd,                                 ///< cfitsio file descriptor
+                    lsst::afw::image::FitsCompression const& compression, ///< desired compression
+                    int width,                                    ///< width of image to be written
+                    int height                                    ///< height of image to be written
+                   ) {
+    int type = 0;                       // cfitsio's name for the compression; 0 => none
+    switch (compression.getAlgorithm()) {
+      case COMPRESS_NONE:
+        type = 0;
+        break;
+      case COMPRESS_GZIP:
+        type = GZIP_1;
+        break;
+      case COMPRESS_RICE:
+        type = RICE_1;
+        break;
+      case COMPRESS_HCOMPRESS:
+        type = HCOMPRESS_1;
+        break;
+      case COMPRESS_PLIO:
+        type = PLIO_1;
+        break;
+      default:
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                          (boost::format("Unknown compression algorithm %d") %
+                           compression.getAlgorithm()).str());
+    }
+
+    if (width == 0 || height == 0) {    // cfitsio can't compress an empty image
+        type = 0;
+    }
+
+    int status = 0;
+    if (fits_set_compression_type(fd, type, &status) != 0) {
+        throw LSST_EXCEPT(FitsException, err_msg(fd, status, "Setting compression type"));
+    }
+    if (type == 0) {
+        return;
+    }
+
+    long tileDim[2];
+    tileDim[0] = (compression.getTileWidth() == 0) ? width : std::min(compression.getTileWidth(), width);
+    tileDim[1] = (compression.getTileHeight() == 0) ? height : std::min(compression.getTileHeight(), height);
+    if (fits_set_tile_dim(fd, 2, tileDim, &status) != 0 ||
+        fits_set_quantize_level(fd, compression.getQuantizeLevel(), &status) != 0) {
+        throw LSST_EXCEPT(FitsException,
+                          err_msg(fd, status, boost::format("Setting %dx%d compression tiles") %
+                                  tileDim[0] % tileDim[1]));
+    }
+}
+
 } // namespace cfitsio
 
 /************************************************************************************************************/
@@ -29,14 +29,20 @@
  * @author Steve Bickerton
  * @date Jan 26, 2009
  */
+#include <algorithm>
 #include <iostream>
 #include <limits>
+#include <utility>
 #include <vector>
 #include <cmath>
+#include "boost/format.hpp"
+#include "boost/scoped_ptr.hpp"
+#include "lsst/utils/ieee.h"
 #include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/Interpolate.h"
 #include "lsst/afw/math/Background.h"
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 using namespace std;
 namespace geom = lsst::afw::geom;
@@ -45,11 +51,227 @@ namespace math = lsst::afw::math;
 namespace ex = lsst::pex::exceptions;
 
 
+namespace {
+    /*
+     * The type of the pixels in an Image or MaskedImage's image plane
+     */
+    template<typename ImageT>
+    struct ImagePixel {
+    };
+    template<typename PixelT>
+    struct ImagePixel<image::Image<PixelT> > {
+        typedef PixelT type;
+    };
+    template<typename PixelT>
+    struct ImagePixel<image::MaskedImage<PixelT> > {
+        typedef PixelT type;
+    };
+
+    template<typename PixelT>
+    inline bool isGoodPixel(PixelT val, bool isNanSafe) {
+        return !isNanSafe || !lsst::utils::isnan(static_cast<float>(val));
+    }
+
+    /*
+     * Compute the desired statistic of the good pixels in bbox (i.e. those that aren't NaN);
+     * values and variances are scratch space
+     *
+     * We don't make a sub-image, as this is called from several threads and Images aren't thread safe
+     */
+    template<typename PixelT>
+    double getCellStatistic(image::Image<PixelT> const& img,  // the image
+                            geom::Box2I const& bbox,           // the pixels that make up the cell
+                            math::Property const prop,         // the desired statistic
+                            math::StatisticsControl const& sctrl, // control the statistics
+                            std::vector<PixelT> &values,       // scratch space for the good pixels
+                            std::vector<image::VariancePixel> &, // scratch space for their variances
+                            int *nGood                         // number of good pixels
+                           ) {
+        bool const isNanSafe = sctrl.getNanSafe();
+
+        values.clear();
+        for (int y = bbox.getMinY(); y <= bbox.getMaxY(); ++y) {
+            typename image::Image<PixelT>::x_iterator ptr = img.x_at(bbox.getMinX(), y);
+            for (typename image::Image<PixelT>::x_iterator end = ptr + bbox.getWidth(); ptr != end; ++ptr) {
+                if (isGoodPixel(*ptr, isNanSafe)) {
+                    values.push_back(*ptr);
+                }
+            }
+        }
+
+        *nGood = values.size();
+        if (values.empty()) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return math::makeStatistics(values, prop, sctrl).getValue(prop);
+    }
+
+    /*
+     * Compute the desired statistic of the good pixels in bbox (i.e. those that aren't NaN, and don't
+     * have any of sctrl.getAndMask()'s bits set); values and variances are scratch space
+     */
+    template<typename PixelT>
+    double getCellStatistic(image::MaskedImage<PixelT> const& img, // the image
+                            geom::Box2I const& bbox,           // the pixels that make up the cell
+                            math::Property const prop,         // the desired statistic
+                            math::StatisticsControl const& sctrl, // control the statistics
+                            std::vector<PixelT> &values,       // scratch space for the good pixels
+                            std::vector<image::VariancePixel> &variances, // scratch space for their variances
+                            int *nGood                         // number of good pixels
+                           ) {
+        bool const isNanSafe = sctrl.getNanSafe();
+        bool const isWeighted = sctrl.getWeighted();
+        image::MaskPixel const andMask = sctrl.getAndMask();
+
+        values.clear();
+        variances.clear();
+        for (int y = bbox.getMinY(); y <= bbox.getMaxY(); ++y) {
+            typename image::MaskedImage<PixelT>::x_iterator ptr = img.x_at(bbox.getMinX(), y);
+            for (int x = 0; x != bbox.getWidth(); ++x, ++ptr) {
+                if (!(ptr.mask() & andMask) && isGoodPixel(ptr.image(), isNanSafe)) {
+                    values.push_back(ptr.image());
+                    if (isWeighted) {
+                        variances.push_back(ptr.variance());
+                    }
+                }
+            }
+        }
+
+        *nGood = values.size();
+        if (values.empty()) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        if (isWeighted) {
+            math::ImageImposter<PixelT> const vimg(values);
+            math::MaskImposter<image::MaskPixel> const vmsk;
+            math::ImageImposter<image::VariancePixel> const vvar(variances);
+            return math::Statistics(vimg, vmsk, vvar, prop, sctrl).getValue(prop);
+        } else {
+            return math::makeStatistics(values, prop, sctrl).getValue(prop);
+        }
+    }
+
+    /*
+     * Measure the statistic in each of a grid of cells, sharing the cells between threads.  Each chunk
+     * of cells reuses the same scratch space for its pixels
+     */
+    template<typename ImageT>
+    class MeasureCells {
+    public:
+        MeasureCells(ImageT const& img,                  // the image
+                     std::vector<int> const& xorig,      // column origins of the cells
+                     std::vector<int> const& yorig,      // row origins of the cells
+                     int const width,                    // width of a cell
+                     int const height,                   // height of a cell
+                     math::Property const prop,          // the desired statistic
+                     math::StatisticsControl const& sctrl, // control the statistics
+                     std::vector<std::vector<double> > &grid,  // the statistic for each cell
+                     std::vector<std::vector<int> > &nGood,    // the number of good pixels in each cell
+                     int const nChunk                    // number of chunks to divide the cells into
+                    ) : _img(img), _xorig(xorig), _yorig(yorig), _width(width), _height(height),
+                        _prop(prop), _sctrl(sctrl), _grid(grid), _nGood(nGood), _nChunk(nChunk) {}
+
+        void operator()(int const chunk) const {
+            int const nx = _xorig.size();
+            int const nCell = nx*_yorig.size();
+            int const i0 = (chunk*nCell)/_nChunk;
+            int const i1 = ((chunk + 1)*nCell)/_nChunk;
+
+            std::vector<typename ImagePixel<ImageT>::type> values;
+            std::vector<image::VariancePixel> variances;
+            values.reserve(_width*_height);
+
+            for (int i = i0; i != i1; ++i) {
+                int const iX = i%nx;
+                int const iY = i/nx;
+                geom::Box2I const bbox(geom::Point2I(_xorig[iX], _yorig[iY]), geom::Extent2I(_width, _height));
+
+                _grid[iX][iY] = getCellStatistic(_img, bbox, _prop, _sctrl, values, variances, &_nGood[iX][iY]);
+            }
+        }
+
+    private:
+        ImageT const& _img;
+        std::vector<int> const& _xorig;
+        std::vector<int> const& _yorig;
+        int const _width;
+        int const _height;
+        math::Property const _prop;
+        math::StatisticsControl const& _sctrl;
+        std::vector<std::vector<double> > &_grid;
+        std::vector<std::vector<int> > &_nGood;
+        int const _nChunk;
+    };
+
+    /*
+     * Replace the bad values in a line of grid points by interpolating between the good ones;  beyond
+     * the first and last good points (or if style is CONSTANT) use the nearest good value.
+     * The filled points are marked as good
+     *
+     * Returns false if there are no good points to interpolate between
+     */
+    bool interpolateOverBadCells(std::vector<double> const& pos, // positions of the grid points
+                                 std::vector<double> &values,    // values at the grid points
+                                 std::vector<bool> &isGood,      // is each value good?
+                                 math::Interpolate::Style style  // desired style of interpolation
+                                ) {
+        std::vector<double> goodPos, goodValues;
+        for (unsigned int i = 0; i != pos.size(); ++i) {
+            if (isGood[i]) {
+                goodPos.push_back(pos[i]);
+                goodValues.push_back(values[i]);
+            }
+        }
+
+        int const nGood = goodPos.size();
+        if (nGood == 0) {
+            return false;
+        } else if (nGood == static_cast<int>(pos.size())) {
+            return true;
+        }
+
+        if (nGood < math::lookupMinInterpPoints(style)) {
+            style = math::lookupMaxInterpStyle(nGood);
+        }
+        boost::scoped_ptr<math::Interpolate> interp;
+        if (style != math::Interpolate::CONSTANT) {
+            interp.reset(new math::Interpolate(goodPos, goodValues, style));
+        }
+
+        for (unsigned int i = 0; i != pos.size(); ++i) {
+            if (isGood[i]) {
+                continue;
+            }
+
+            if (pos[i] <= goodPos.front()) {
+                values[i] = goodValues.front();
+            } else if (pos[i] >= goodPos.back()) {
+                values[i] = goodValues.back();
+            } else if (interp) {
+                values[i] = interp->interpolate(pos[i]);
+            } else {
+                int const j = std::upper_bound(goodPos.begin(), goodPos.end(), pos[i]) - goodPos.begin();
+                values[i] = (pos[i] - goodPos[j - 1] <= goodPos[j] - pos[i]) ?
+                    goodValues[j - 1] : goodValues[j];
+            }
+            isGood[i] = true;
+        }
+
+        return true;
+    }
+}
+
 /**
  * @brief Constructor for Background
  *
  * Various things are pre-computed by the constructor to make the interpolation faster.
  *
+ * The sub-images' statistics are computed using bgCtrl.getNumThreads() threads.  Sub-images with fewer
+ * than bgCtrl.getMinGoodFraction() of their pixels good (or with no good pixels at all; NaNs and pixels
+ * with any of the StatisticsControl's andMask bits set are bad) are replaced by interpolating over them.
+ *
+ * @throw lsst::pex::exceptions::RuntimeErrorException if there are no good sub-images at all
+ *
  * @note This is hard-coded to use bicubic spline for interpolation, attempt to use linear interpolate
  *       will cause an assertion failure.
  * @todo Implement user-settable intepolation style
@@ -105,28 +327,57 @@ math::Background::Background(ImageT const& img, ///< ImageT (or MaskedImage) who
     vector<int> ypix(_imgHeight);
     for (int iY = 0; iY < _imgHeight; ++iY) { ypix[iY] = iY; }
 
-
-    // go to each sub-image and get it's stats.
-    // -- do columns in the inner-loop and spline them as they complete
+    // go to each sub-image and get its stats, sharing the sub-images between threads
+    vector<vector<int> > nGood(_nxSample);
     for (int iX = 0; iX < _nxSample; ++iX) {
-        
         _grid[iX].resize(_nySample);
+        nGood[iX].resize(_nySample);
+    }
+    {
+        int const nThread = math::detail::getNumThreads(_bctrl.getNumThreads());
+        int const nChunk = std::min(nThread, _nxSample*_nySample);
+        math::detail::parallelFor(0, nChunk,
+                                  MeasureCells<ImageT>(img, _xorig, _yorig, _subimgWidth, _subimgHeight,
+                                                       _bctrl.getStatisticsProperty(),
+                                                       *_bctrl.getStatisticsControl(),
+                                                       _grid, nGood, nChunk),
+                                  nThread);
+    }
+
+    // replace the sub-images with too few good pixels by interpolating over them;  first up and down
+    // the columns, then (for columns with no good sub-images) along the rows
+    int const minGood = std::max(1, static_cast<int>(std::ceil(_bctrl.getMinGoodFraction()*
+                                                               _subimgWidth*_subimgHeight)));
+    vector<bool> isGoodColumn(_nxSample);
+    for (int iX = 0; iX < _nxSample; ++iX) {
+        vector<bool> isGood(_nySample);
         for (int iY = 0; iY < _nySample; ++iY) {
-            
-            ImageT subimg = ImageT(img, geom::Box2I(
-                    geom::Point2I(_xorig[iX], _yorig[iY]),
-                    geom::Extent2I(_subimgWidth, _subimgHeight)
-                ),
-                image::LOCAL
-            );
-            
-            math::Statistics stats =
-                math::makeStatistics(subimg, _bctrl.getStatisticsProperty(),
-                                     *(_bctrl.getStatisticsControl()));
-            
-            _grid[iX][iY] = stats.getValue(_bctrl.getStatisticsProperty());
+            isGood[iY] = (nGood[iX][iY] >= minGood && !lsst::utils::isnan(_grid[iX][iY]));
+        }
+        isGoodColumn[iX] = interpolateOverBadCells(_ycen, _grid[iX], isGood, _bctrl.getInterpStyle());
+    }
+    if (std::find(isGoodColumn.begin(), isGoodColumn.end(), true) == isGoodColumn.end()) {
+        throw LSST_EXCEPT(ex::RuntimeErrorException,
+                          (boost::format("None of the %dx%d sub-images has at least %d good pixels") %
+                           _nxSample % _nySample % minGood).str());
+    }
+    if (std::find(isGoodColumn.begin(), isGoodColumn.end(), false) != isGoodColumn.end()) {
+        vector<double> row(_nxSample);
+        for (int iY = 0; iY < _nySample; ++iY) {
+            vector<bool> isGood(isGoodColumn);
+            for (int iX = 0; iX < _nxSample; ++iX) {
+                row[iX] = _grid[iX][iY];
+            }
+            if (interpolateOverBadCells(_xcen, row, isGood, _bctrl.getInterpStyle())) {
+                for (int iX = 0; iX < _nxSample; ++iX) {
+                    _grid[iX][iY] = row[iX];
+                }
+            }
         }
+    }
 
+    // spline the columns
+    for (int iX = 0; iX < _nxSample; ++iX) {
         _gridcolumns[iX].resize(_imgHeight);
 
         // there isn't actually any way to interpolate as a constant ... do that manually here
@@ -141,7 +392,7 @@ math::Background::Background(ImageT const& img, ///< ImageT (or MaskedImage) who
             // it should only be used sanely when nx,nySample are both 1,
             //  but this should still work for other grid sizes.
             for (int iY = 0; iY < _imgHeight; ++iY) {
-                int const iGridY = (iY/_subimgHeight < _nySample) ? iY/_subimgHeight : _nySample;
+                int const iGridY = (iY/_subimgHeight < _nySample) ? iY/_subimgHeight : _nySample - 1;
                 _gridcolumns[iX][iY] = _grid[iX][iGridY];
             }
         }
@@ -151,6 +402,37 @@ math::Background::Background(ImageT const& img, ///< ImageT (or MaskedImage) who
 }
 
 
+/**
+ * @brief Interpolate the background along row y, setting values[i] to the background at (xpix[i], y)
+ *
+ * The columns were interpolated in y by the constructor, so we only need to build one interpolation
+ * object in x for the entire row
+ */
+void math::Background::_getRow(int const y,                      ///< the row
+                               std::vector<double> const& xpix,  ///< the columns
+                               std::vector<double> &values       ///< the background at (xpix, y)
+                              ) const {
+    assert(values.size() == xpix.size());
+
+    if (_bctrl.getInterpStyle() != Interpolate::CONSTANT) {
+        vector<double> bg_x(_nxSample);
+        for (int iX = 0; iX < _nxSample; iX++) {
+            bg_x[iX] = _gridcolumns[iX][y];
+        }
+        math::Interpolate intobj(_xcen, bg_x, _bctrl.getInterpStyle());
+
+        for (std::size_t i = 0; i != xpix.size(); ++i) {
+            values[i] = intobj.interpolate(xpix[i]);
+        }
+    } else {
+        for (std::size_t i = 0; i != xpix.size(); ++i) {
+            int const iX = static_cast<int>(xpix[i]);
+            int const iGridX = (iX/_subimgWidth < _nxSample) ? iX/_subimgWidth : _nxSample - 1;
+            values[i] = _gridcolumns[iGridX][y];
+        }
+    }
+}
+
 /**
  * @brief Method to retrieve the background level at a pixel coord.
  *
@@ -158,28 +440,69 @@ math::Background::Background(ImageT const& img, ///< ImageT (or MaskedImage) who
  * @param y y-pixel coordinate (row)
  *
  * @warning This can be a very costly function to get a single pixel
- *          If you want an image, use the getImage() method.
+ *          If you want many pixels, use the getPixels() method;  if you want an image,
+ *          use the getImage() method.
  *
  * @return an estimated background at x,y (double)
  */
 double math::Background::getPixel(int const x, int const y) const {
+    vector<double> xpix(1, static_cast<double>(x));
+    vector<double> values(1);
+    _getRow(y, xpix, values);
 
-    // build an interpobj along the row y and get the x'th value
-    vector<double> bg_x(_nxSample);
-    for (int iX = 0; iX < _nxSample; iX++) {
-        bg_x[iX] = _gridcolumns[iX][y];
+    return values[0];
+}
+
+/**
+ * @brief Method to retrieve the background level at a list of pixel coords
+ *
+ * The points are processed a row at a time, so this is much faster than calling getPixel() for
+ * each point when many of them share rows
+ *
+ * @return the estimated background at each (x[i], y[i])
+ */
+std::vector<double> math::Background::getPixels(std::vector<int> const& x, ///< x-pixel coordinates (columns)
+                                                std::vector<int> const& y  ///< y-pixel coordinates (rows)
+                                               ) const {
+    if (x.size() != y.size()) {
+        throw LSST_EXCEPT(ex::LengthErrorException,
+                          (boost::format("Number of x (%d) and y (%d) coordinates differ") %
+                           x.size() % y.size()).str());
     }
+    //
+    // Sort the points by row
+    //
+    int const npoint = x.size();
+    vector<std::pair<int, int> > rows(npoint); // (y, index into x and y)
+    for (int i = 0; i != npoint; ++i) {
+        if (x[i] < 0 || x[i] >= _imgWidth || y[i] < 0 || y[i] >= _imgHeight) {
+            throw LSST_EXCEPT(ex::LengthErrorException,
+                              (boost::format("Point (%d, %d) is not in the %dx%d image") %
+                               x[i] % y[i] % _imgWidth % _imgHeight).str());
+        }
+        rows[i] = std::make_pair(y[i], i);
+    }
+    std::sort(rows.begin(), rows.end());
+
+    vector<double> result(npoint);
+    vector<double> xpix, values;
+    for (int i0 = 0; i0 != npoint; ) {
+        int const iY = rows[i0].first;
+        int i1 = i0;
+        for (xpix.clear(); i1 != npoint && rows[i1].first == iY; ++i1) {
+            xpix.push_back(x[rows[i1].second]);
+        }
+        values.resize(xpix.size());
+        _getRow(iY, xpix, values);
 
-    if (_bctrl.getInterpStyle() != Interpolate::CONSTANT) {
-        math::Interpolate intobj(_xcen, bg_x, _bctrl.getInterpStyle());
-        return static_cast<double>(intobj.interpolate(x));
-    } else {
-        int const iGridX = (x/_subimgWidth < _nxSample) ? x/_subimgHeight : _nxSample;
-        return static_cast<double>(_gridcolumns[iGridX][y]);
+        for (int i = i0; i != i1; ++i) {
+            result[rows[i].second] = values[i - i0];
+        }
+        i0 = i1;
     }
-    
-}
 
+    return result;
+}
 
 /**
  * @brief Method to compute the background for entire image and return a background image
@@ -188,52 +511,84 @@ double math::Background::getPixel(int const x, int const y) const {
  */
 template<typename PixelT>
 typename image::Image<PixelT>::Ptr math::Background::getImage() const {
+    return getImage<PixelT>(geom::Box2I(geom::Point2I(0, 0), geom::Extent2I(_imgWidth, _imgHeight)));
+}
+
+/**
+ * @brief Method to compute the background for part of the image and return a background image
+ *
+ * @return A boost shared-pointer to an image containing the estimated background, with its origin
+ * set to bbox's lower left corner
+ */
+template<typename PixelT>
+typename image::Image<PixelT>::Ptr math::Background::getImage(
+        geom::Box2I const& bbox         ///< the pixels (in the image used to create the Background) wanted
+                                                              ) const {
+    if (bbox.getMinX() < 0 || bbox.getMinY() < 0 ||
+        bbox.getMaxX() >= _imgWidth || bbox.getMaxY() >= _imgHeight) {
+        throw LSST_EXCEPT(ex::LengthErrorException,
+                          (boost::format("BBox (%d,%d) -- (%d,%d) is not in the %dx%d image") %
+                           bbox.getMinX() % bbox.getMinY() % bbox.getMaxX() % bbox.getMaxY() %
+                           _imgWidth % _imgHeight).str());
+    }
 
     // create a shared_ptr to put the background image in and return to caller
     typename image::Image<PixelT>::Ptr bg = typename image::Image<PixelT>::Ptr(
-        new typename image::Image<PixelT>(
-            geom::Extent2I(_imgWidth, _imgHeight)
-        )
+        new typename image::Image<PixelT>(bbox)
     );
 
     // need a vector of all x pixel coords to spline over
-    vector<int> xpix(bg->getWidth());
-    for (int iX = 0; iX < bg->getWidth(); ++iX) { xpix[iX] = iX; }
+    vector<double> xpix(bbox.getWidth());
+    for (int iX = 0; iX < bbox.getWidth(); ++iX) { xpix[iX] = bbox.getMinX() + iX; }
+    vector<double> values(bbox.getWidth());
     
     // go through row by row
     // - spline on the gridcolumns that were pre-computed by the constructor
     // - copy the values to an ImageT to return to the caller.
     for (int iY = 0; iY < bg->getHeight(); ++iY) {
+        _getRow(bbox.getMinY() + iY, xpix, values);
 
-        // build an interp object for this row
-        vector<double> bg_x(_nxSample);
-        for (int iX = 0; iX < _nxSample; iX++) {
-            bg_x[iX] = static_cast<double>(_gridcolumns[iX][iY]);
-        }
-        
-        if (_bctrl.getInterpStyle() != Interpolate::CONSTANT) {
-            math::Interpolate intobj(_xcen, bg_x, _bctrl.getInterpStyle());
-            // fill the image with interpolated objects.
-            int iX = 0;
-            for (typename image::Image<PixelT>::x_iterator ptr = bg->row_begin(iY),
-                     end = ptr + bg->getWidth(); ptr != end; ++ptr, ++iX) {
-                *ptr = static_cast<PixelT>(intobj.interpolate(xpix[iX]));
-            }
-        } else {
-            // fill the image with interpolated objects.
-            int iX = 0;
-            for (typename image::Image<PixelT>::x_iterator ptr = bg->row_begin(iY),
-                     end = ptr + bg->getWidth(); ptr != end; ++ptr, ++iX) {
-                int const iGridX = (iX/_subimgWidth < _nxSample) ? iX/_subimgWidth : _nxSample - 1;
-                *ptr = static_cast<PixelT>(_gridcolumns[iGridX][iY]);
-            }
+        vector<double>::const_iterator vptr = values.begin();
+        for (typename image::Image<PixelT>::x_iterator ptr = bg->row_begin(iY),
+                 end = ptr + bg->getWidth(); ptr != end; ++ptr, ++vptr) {
+            *ptr = static_cast<PixelT>(*vptr);
         }
-
     }
     
     return bg;
 }
 
+/**
+ * @brief Subtract the background from an image in place
+ *
+ * This gives the same result as subtracting getImage<PixelT>() from img, but without
+ * making a full-size background image
+ */
+template<typename PixelT>
+void math::Background::subtractFrom(
+        image::Image<PixelT> &img       ///< the image (the same size as that used to create the Background)
+                                   ) const {
+    if (img.getWidth() != _imgWidth || img.getHeight() != _imgHeight) {
+        throw LSST_EXCEPT(ex::LengthErrorException,
+                          (boost::format("Image's size %dx%d doesn't match the Background's %dx%d") %
+                           img.getWidth() % img.getHeight() % _imgWidth % _imgHeight).str());
+    }
+
+    vector<double> xpix(_imgWidth);
+    for (int iX = 0; iX < _imgWidth; ++iX) { xpix[iX] = iX; }
+    vector<double> values(_imgWidth);
+
+    for (int iY = 0; iY < _imgHeight; ++iY) {
+        _getRow(iY, xpix, values);
+
+        vector<double>::const_iterator vptr = values.begin();
+        for (typename image::Image<PixelT>::x_iterator ptr = img.row_begin(iY),
+                 end = ptr + _imgWidth; ptr != end; ++ptr, ++vptr) {
+            *ptr -= static_cast<PixelT>(*vptr);
+        }
+    }
+}
+
 /************************************************************************************************************/
 /**
  * @brief Conversion function to switch a string to an UndersampleStyle
@@ -307,7 +662,9 @@ void math::Background::_checkSampling() {
                                           math::BackgroundControl const& bgCtrl); \
     template math::Background::Background(image::MaskedImage<TYPE> const& img, \
                                           math::BackgroundControl const& bgCtrl); \
-    template image::Image<TYPE>::Ptr math::Background::getImage<TYPE>() const;
+    template image::Image<TYPE>::Ptr math::Background::getImage<TYPE>() const; \
+    template image::Image<TYPE>::Ptr math::Background::getImage<TYPE>(geom::Box2I const&) const; \
+    template void math::Background::subtractFrom(image::Image<TYPE> &img) const;
 
 INSTANTIATE_BACKGROUND(double)
 INSTANTIATE_BACKGROUND(float)
@@ -264,9 +264,17 @@ void afwMath::scaledPlus(
  * to the lower left corner of the sub-image, but it will almost certainly change to be
  * the lower left corner of the parent image.
  * 
- * All convolution is performed in real space. This allows convolution to handle masked pixels
- * and spatially varying kernels. Although convolution of an Image with a spatially invariant kernel could,
- * in fact, be performed in Fourier space, the code does not do this.
+ * Most convolution is performed in real space. This allows convolution to handle masked pixels
+ * and spatially varying kernels. Spatially invariant kernels that are at least
+ * convolutionControl.getMinFftKernelSize() pixels wide and high (other than SeparableKernels and
+ * DeltaFunctionKernels, which have faster special cases) are convolved in Fourier space, as the cost
+ * of direct convolution grows as the area of the kernel. The results agree to within rounding error;
+ * the mask is still smeared in real space, and NaNs in the input %image only affect the output pixels
+ * they contribute to.
+ * 
+ * The work may be divided between several threads by setting convolutionControl.setNumThreads()
+ * (<= 0 means one thread per core). The output is divided into bands of rows (tiles, for FFTs),
+ * each of which reads the input pixels it needs, so the results are the same for any number of threads.
  * 
  * Note that mask bits are smeared by convolution; all nonzero pixels in the kernel smear the mask, even
  * pixels that have very small values. Larger kernels smear the mask more and are also slower to convolve.
@@ -293,7 +301,10 @@ void afwMath::scaledPlus(
  *   convolution with a kernel of size nCols x 1, followed by convolution with a kernel of size 1 x nRows.
  * - Convolution with spatially invariant versions of the other kernels is performed by computing
  *   the kernel %image once and convolving with that. The code has been optimized for cache performance
- *   and so should be fairly efficient.
+ *   and so should be fairly efficient; floating point images are convolved a plane at a time, adding
+ *   each kernel pixel's contribution to whole rows using SIMD instructions (see detail/Simd.h),
+ *   as are the two passes of SeparableKernel convolution.  Large kernels are convolved a tile at a time using FFTs
+ *   (see convolveWithFft); the FFTW plans are cached for reuse by later convolutions of the same size.
  * - Convolution with a spatially varying LinearCombinationKernel is performed by convolving the %image
  *   by each basis kernel and combining the result by solving the spatial model. This will be efficient
  *   provided the kernel does not contain too many or very large basis kernels.
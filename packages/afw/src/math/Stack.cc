@@ -30,11 +30,15 @@
  *
  */
 #include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
 #include "boost/shared_ptr.hpp"
+#include "boost/format.hpp"
 
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/math/Stack.h"
-#include "lsst/afw/math/MaskedVector.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace afwGeom = lsst::afw::geom;
 namespace afwImage = lsst::afw::image;
@@ -43,19 +47,9 @@ namespace ex    = lsst::pex::exceptions;
 
 
 namespace {
-    
-/*
- * A function to load values from the weight vector into the variance plane of the pixelSet.
- */
-template <typename PixelT>    
-void loadVariance(std::vector<PixelT> const &wvector, afwMath::MaskedVector<PixelT> &pixelSet) {
-    unsigned int j = 0;
-    for (typename std::vector<PixelT>::const_iterator pVec = wvector.begin();
-         pVec != wvector.end(); ++pVec) {
-        (*pixelSet.getVariance())(j, 0) = static_cast<afwImage::VariancePixel>(*pVec);
-        ++j;
-    }
-}
+
+double const NaN = std::numeric_limits<double>::quiet_NaN();
+double const IQ_TO_STDEV = 0.741301109252802;   // 1 sigma in units of iqrange (assume Gaussian)
 
 /*
  * A bit counter (to make sure that only one type of statistics has been requested)
@@ -78,214 +72,657 @@ void checkOnlyOneFlag(unsigned int flags) {
     if (bitcount(flags & ~afwMath::ERRORS) != 1) {
         throw LSST_EXCEPT(ex::InvalidParameterException,
                           "Requested more than one type of statistic to make the image stack.");
-                          
+
     }
-    
+
 }
-    
-} // end anonymous namespace
 
+/*
+ * Check that all the inputs to be stacked have the same dimensions as the first one
+ */
+template <typename ImageT>
+void checkDimensions(std::vector<typename ImageT::Ptr> const &images) {
+    for (unsigned int i = 1; i < images.size(); ++i) {
+        if (images[i]->getDimensions() != images[0]->getDimensions()) {
+            throw LSST_EXCEPT(ex::LengthErrorException,
+                              "All images to be stacked must have the same dimensions.");
+        }
+    }
+}
 
+/************************************************************************************************************/
+/*
+ * Interpolated percentiles of a set of values, as computed by Statistics (which uses the same scheme)
+ */
+template <typename PixelT>    
+double percentile(typename std::vector<PixelT>::iterator begin,
+                  typename std::vector<PixelT>::iterator end,
+                  double const fraction) {
+    int const n = end - begin;
+
+    if (n == 0) {
+        return NaN;
+    } else if (n == 1) {
+        return *begin;
+    }
 
+    double const idx = fraction*(n - 1);
+    int const q1 = static_cast<int>(idx);
+    int const q2 = q1 + 1;
 
+    typename std::vector<PixelT>::iterator mid1 = begin + q1;
+    typename std::vector<PixelT>::iterator mid2 = begin + q2;
+    std::nth_element(begin, mid1, end);
+    std::nth_element(mid1, mid2, end);  // [mid1, end) are all >= *mid1, so this is a short partition
 
+    return (q2 - idx)*static_cast<double>(*mid1) + (idx - q1)*static_cast<double>(*mid2);
+}
 
-/****************************************************************************
+/**
+ * @brief A column-batched engine to compute the statistics of a stack of pixels
  *
- * stack MaskedImages
+ * Calling makeStatistics for each output pixel repeats all of Statistics' setup (copying the control
+ * object, packing a MaskedVector, choosing the right templated loop) for every pixel in the output.
+ * Instead, we copy a run of pixels (e.g. a row) from each of the nImage inputs into a contiguous
+ * structure-of-arrays buffer, and accumulate the statistics of all the columns at the same time.
+ * The inner loops run along the contiguous columns with no data-dependent branches so that the compiler
+ * is free to vectorise them;  only the quantiles (MEDIAN/IQRANGE, and the first clip of MEANCLIP etc.)
+ * need a per-column partial sort.
  *
- ****************************************************************************/
-
-namespace {
-    
-/*
- * A function to handle MaskedImage stacking
+ * The values returned are those that makeStatistics(pixelSet, flags | NPOINT | ERRORS, sctrl) would return
+ * for a MaskedVector pixelSet containing a column of the stack.
  */
-    
-template<typename PixelT, bool UseVariance>
-typename afwImage::MaskedImage<PixelT>::Ptr computeMaskedImageStack(
-                             std::vector<typename afwImage::MaskedImage<PixelT>::Ptr > const &images,
-                             afwMath::Property flags,               
-                             afwMath::StatisticsControl const& sctrl,
-                             std::vector<PixelT> const &wvector
-                                                          ) {
+template <typename PixelT>    
+class StackEngine {
+public:
+    StackEngine(int const nImage,                         ///< Number of images in the stack
+                int const width,                          ///< Number of pixels processed together
+                int const flags,                          ///< Desired statistic (only one!)
+                afwMath::StatisticsControl const &sctrl,  ///< Fine control over processing
+                std::vector<PixelT> const &wvector,       ///< constant weights for each input (may be empty)
+                bool const useMask                        ///< Are the inputs masked?
+               );
+
+    /// Return the buffer into which values from the i-th input should be copied
+    PixelT *getImageRow(int const i) { return &_image[i*_width]; }
+    /// Return the buffer into which mask bits from the i-th input should be copied, or NULL if unused
+    afwImage::MaskPixel *getMaskRow(int const i) { return _useMask ? &_mask[i*_width] : NULL; }
+    /// Return the buffer into which variances from the i-th input should be copied, or NULL if unused
+    afwImage::VariancePixel *getVarianceRow(int const i) {
+        return _useVarianceWeights ? &_weight[i*_width] : NULL;
+    }
 
-    // create the image to be returned
-    typedef afwImage::MaskedImage<PixelT> Image;
-    typename Image::Ptr imgStack(new Image(images[0]->getDimensions()));
+    void compute();
 
-    // get a list of row_begin iterators
-    typedef typename afwImage::MaskedImage<PixelT>::x_iterator x_iterator;
-    std::vector<x_iterator> rows;
-    rows.reserve(images.size());
+    /// Return the desired statistic for the x-th column
+    double getValue(int const x) const { return _value[x]; }
+    /// Return the variance (i.e. the square of the error) in the desired statistic for the x-th column
+    double getVariance(int const x) const { return _error[x]*_error[x]; }
+    /// Return the mask for the x-th column:  the OR of all good pixels, or NoGoodPixelsMask if there are none
+    afwImage::MaskPixel getMask(int const x) const {
+        return (_npoint[x] == 0) ? _sctrl.getNoGoodPixelsMask() : _orMask[x];
+    }
 
-    // get a list to contain a pixel from x,y for each image
-    afwMath::MaskedVector<PixelT> pixelSet(images.size());
-    afwMath::StatisticsControl sctrlTmp(sctrl);
+private:
+    void _computeQuantiles();
+    void _clip();
+
+    int const _nImage;
+    int const _width;
+    afwMath::Property _prop;            // the statistic that we want
+    afwMath::StatisticsControl _sctrl;
+    bool _useMask;                      // do we have mask planes?
+    bool _isWeighted;                   // are we computing weighted statistics?
+    bool _useVarianceWeights;           // are the weights derived from the variance planes?
+    bool _isMultiplyingWeights;         // Treat variance plane as weights and multiply instead of dividing
+    // The input buffers, nImage rows of width values
+    std::vector<PixelT> _image;
+    std::vector<afwImage::MaskPixel> _mask;
+    std::vector<afwImage::VariancePixel> _weight;
+    // Per-column accumulators and results
+    std::vector<int> _n;                // number of good pixels
+    std::vector<double> _sum, _sumx2, _wsum, _shift;
+    std::vector<double> _mean, _variance, _min, _max, _total;
+    std::vector<double> _median, _iqrange, _meanclip, _varianceclip;
+    std::vector<afwImage::MaskPixel> _orMask;
+    std::vector<int> _npoint;           // number of good pixels (n.b. as modified by clipping)
+    std::vector<double> _value, _error;
+    std::vector<PixelT> _scratch;       // storage for the partial sorts
+};
 
-    // if we're forcing the user variances ...
-    if (UseVariance) {
-        sctrlTmp.setWeighted(true);
-        sctrlTmp.setMultiplyWeights(true);
-        loadVariance(wvector, pixelSet); // put them in the variance vector
+template <typename PixelT>    
+StackEngine<PixelT>::StackEngine(int const nImage,
+                                 int const width,
+                                 int const flags,
+                                 afwMath::StatisticsControl const &sctrl,
+                                 std::vector<PixelT> const &wvector,
+                                 bool const useMask
+                                ) :
+    _nImage(nImage), _width(width),
+    _prop(static_cast<afwMath::Property>(flags & ~afwMath::ERRORS)),
+    _sctrl(sctrl),
+    _useMask(useMask),
+    _isWeighted(!wvector.empty() || sctrl.getWeighted()),
+    _useVarianceWeights(wvector.empty() && sctrl.getWeighted()),
+    _isMultiplyingWeights(!wvector.empty() || sctrl.getMultiplyWeights()),
+    _image(nImage*width),
+    _mask(useMask ? nImage*width : 0),
+    _weight(_isWeighted ? nImage*width : 0),
+    _n(width), _sum(width), _sumx2(width), _wsum(width), _shift(width),
+    _mean(width), _variance(width), _min(width), _max(width), _total(width),
+    _median(width), _iqrange(width), _meanclip(width), _varianceclip(width),
+    _orMask(width), _npoint(width), _value(width), _error(width),
+    _scratch(nImage)
+{
+    if (!wvector.empty()) {             // constant weights for each input; set them once and for all
+        for (int i = 0; i != nImage; ++i) {
+            std::fill(_weight.begin() + i*width, _weight.begin() + (i + 1)*width,
+                      static_cast<afwImage::VariancePixel>(wvector[i]));
+        }
     }
+}
 
-    // loop over x,y ... the loop over the stack to fill pixelSet
-    // - get the stats on pixelSet and put the value in the output image at x,y
-    for (int y = 0; y != imgStack->getHeight(); ++y) {
-
-        for (unsigned int i = 0; i < images.size(); ++i) {
-            x_iterator ptr = images[i]->row_begin(y);
-            if (y == 0) {
-                rows.push_back(ptr);
-            } else {
-                rows[i] = ptr;
+/**
+ * @brief Calculate the statistics of all the columns in the buffers
+ */
+template <typename PixelT>    
+void StackEngine<PixelT>::compute() {
+    int const nImage = _nImage;
+    int const width = _width;
+    afwImage::MaskPixel const andMask = _sctrl.getAndMask();
+    bool const nanSafe = _sctrl.getNanSafe();
+    // n.b. Statistics always rejects NaNs when asked for MIN or MAX
+    bool const checkFinite = nanSafe || (_prop & (afwMath::MIN | afwMath::MAX));
+    bool const isWeighted = _isWeighted;
+
+    if (_useVarianceWeights && !_isMultiplyingWeights) { // convert variances into weights
+        for (typename std::vector<afwImage::VariancePixel>::iterator ptr = _weight.begin(),
+                 end = _weight.end(); ptr != end; ++ptr) {
+            *ptr = (*ptr > 0) ? 1.0/(*ptr) : 0.0;
+        }
+    }
+    //
+    // A crude estimate of the mean, used for numerical stability of the variance
+    //
+    std::fill(_n.begin(), _n.end(), 0);
+    std::fill(_sum.begin(), _sum.end(), 0.0);
+    for (int i = 0; i != nImage; ++i) {
+        PixelT const *im = &_image[i*width];
+        afwImage::MaskPixel const *msk = _useMask ? &_mask[i*width] : NULL;
+        int *n = &_n[0];
+        double *sum = &_sum[0];
+        for (int x = 0; x != width; ++x) {
+            bool const good = (!nanSafe || im[x] == im[x]) && !(msk && (msk[x] & andMask));
+            n[x] += good;
+            sum[x] += good ? im[x] : 0.0;
+        }
+    }
+    for (int x = 0; x != width; ++x) {
+        _shift[x] = (_n[x] > 0) ? _sum[x]/_n[x] : 0.0;
+    }
+    //
+    // Now the full-precision values
+    //
+    std::fill(_n.begin(), _n.end(), 0);
+    std::fill(_sum.begin(), _sum.end(), 0.0);
+    std::fill(_sumx2.begin(), _sumx2.end(), 0.0);
+    std::fill(_wsum.begin(), _wsum.end(), 0.0);
+    std::fill(_min.begin(), _min.end(), std::numeric_limits<double>::max());
+    std::fill(_max.begin(), _max.end(), -std::numeric_limits<double>::max());
+    std::fill(_orMask.begin(), _orMask.end(), 0x0);
+
+    for (int i = 0; i != nImage; ++i) {
+        PixelT const *im = &_image[i*width];
+        afwImage::MaskPixel const *msk = _useMask ? &_mask[i*width] : NULL;
+        afwImage::VariancePixel const *wt = isWeighted ? &_weight[i*width] : NULL;
+        double const *shift = &_shift[0];
+        int *n = &_n[0];
+        double *sum = &_sum[0], *sumx2 = &_sumx2[0], *wsum = &_wsum[0], *min = &_min[0], *max = &_max[0];
+        afwImage::MaskPixel *orMask = &_orMask[0];
+
+        for (int x = 0; x != width; ++x) {
+            bool const good = (!checkFinite || im[x] == im[x]) && !(msk && (msk[x] & andMask));
+            double const w = good ? (isWeighted ? wt[x] : 1.0) : 0.0;
+            double const delta = good ? im[x] - shift[x] : 0.0;
+
+            n[x] += good;
+            sum[x] += w*delta;
+            sumx2[x] += w*delta*delta;
+            wsum[x] += w;
+            min[x] = (good && im[x] < min[x]) ? im[x] : min[x];
+            max[x] = (good && im[x] > max[x]) ? im[x] : max[x];
+            if (msk) {
+                orMask[x] |= good ? msk[x] : 0x0;
             }
         }
+    }
 
-        for (x_iterator ptr = imgStack->row_begin(y), end = imgStack->row_end(y); ptr != end; ++ptr) {
-            typename afwMath::MaskedVector<PixelT>::iterator psPtr = pixelSet.begin();
-            afwImage::MaskPixel msk(0x0);
-            for (unsigned int i = 0; i < images.size(); ++i, ++psPtr) {
-                afwImage::MaskPixel mskTmp = rows[i].mask();
-                psPtr.value() = rows[i].image();
-                psPtr.mask()  = mskTmp;
+    for (int x = 0; x != width; ++x) {
+        int const n = _n[x];
+        double const sum = _sum[x];
+        double const sumx2 = _sumx2[x];
+        double const wsum = isWeighted ? _wsum[x] : n;
+
+        _mean[x] = (wsum > 0) ? _shift[x] + sum/wsum : NaN;
+        _variance[x] = (n > 1) ? sumx2/(wsum - wsum/n) - sum*sum/((wsum - wsum/n)*wsum) : NaN;
+        _total[x] = sum + wsum*_shift[x];
+        if (n == 0) {
+            _min[x] = _max[x] = NaN;
+        }
+        _npoint[x] = n;
+    }
+    //
+    // Now only calculate things if they're specifically requested - these all cost more!
+    //
+    if (_prop & (afwMath::MEDIAN | afwMath::IQRANGE |
+                 afwMath::MEANCLIP | afwMath::STDEVCLIP | afwMath::VARIANCECLIP)) {
+        _computeQuantiles();
+    }
+    if (_prop & (afwMath::MEANCLIP | afwMath::STDEVCLIP | afwMath::VARIANCECLIP)) {
+        _clip();
+    }
+    //
+    // And finally the requested quantity and its error
+    //
+    for (int x = 0; x != width; ++x) {
+        int const n = _npoint[x];
+        double value = NaN;
+        double error = NaN;
+
+        switch (_prop) {
+          case afwMath::NPOINT:
+            value = n;
+            error = 0;
+            break;
+          case afwMath::SUM:
+            value = _total[x];
+            error = 0;
+            break;
+          case afwMath::MEAN:
+            value = _mean[x];
+            error = std::sqrt(_variance[x]/n);
+            break;
+          case afwMath::MEANCLIP:
+            value = _meanclip[x];
+            error = std::sqrt(_varianceclip[x]/n);
+            break;
+          case afwMath::VARIANCE:
+            value = _variance[x];
+            error = 2*(n - 1)*value*value/(static_cast<double>(n)*n);
+            break;
+          case afwMath::STDEV:
+            value = std::sqrt(_variance[x]);
+            error = 0.5*2*(n - 1)*_variance[x]*_variance[x]/(static_cast<double>(n)*n)/value;
+            break;
+          case afwMath::VARIANCECLIP:
+            value = _varianceclip[x];
+            error = 2*(n - 1)*value*value/(static_cast<double>(n)*n);
+            break;
+          case afwMath::STDEVCLIP:
+            value = std::sqrt(_varianceclip[x]);
+            error = 0.5*2*(n - 1)*_varianceclip[x]*_varianceclip[x]/(static_cast<double>(n)*n)/value;
+            break;
+          case afwMath::MEANSQUARE:
+            value = (n - 1)/static_cast<double>(n)*_variance[x] + _mean[x]*_mean[x];
+            error = std::sqrt(2*value*value/(static_cast<double>(n)*n));
+            break;
+          case afwMath::MIN:
+            value = _min[x];
+            error = 0;
+            break;
+          case afwMath::MAX:
+            value = _max[x];
+            error = 0;
+            break;
+          case afwMath::MEDIAN:
+            value = _median[x];
+            error = std::sqrt(M_PI/2*_variance[x]/n);
+            break;
+          case afwMath::IQRANGE:
+            value = _iqrange[x];
+            error = 0;
+            break;
+          case afwMath::ORMASK:
+            value = _orMask[x];
+            error = 0;
+            break;
+          default:
+            throw LSST_EXCEPT(ex::InvalidParameterException,
+                              (boost::format("Unable to stack images using statistic %d") % _prop).str());
+        }
 
-                // if we're not using the wvector weights, use the variance plane.
-                if (! UseVariance) {
-                    psPtr.variance() = rows[i].variance();
-                }
+        _value[x] = value;
+        _error[x] = error;
+    }
+}
 
-                ++rows[i];
-            }
-            afwMath::Statistics stat =
-                afwMath::makeStatistics(pixelSet, flags | afwMath::NPOINT | afwMath::ERRORS, sctrlTmp);
-            
-            PixelT variance = ::pow(stat.getError(flags), 2);
-            msk = stat.getOrMask();
-            if (stat.getValue(afwMath::NPOINT) == 0) {
-                msk = sctrlTmp.getNoGoodPixelsMask();
+/*
+ * Calculate the median and interquartile range of each column
+ */
+template <typename PixelT>    
+void StackEngine<PixelT>::_computeQuantiles() {
+    afwImage::MaskPixel const andMask = _sctrl.getAndMask();
+    bool const nanSafe = _sctrl.getNanSafe();
+    bool const onlyMedian = (_prop == afwMath::MEDIAN);
+
+    for (int x = 0; x != _width; ++x) {
+        typename std::vector<PixelT>::iterator end = _scratch.begin();
+        for (int i = 0; i != _nImage; ++i) {
+            PixelT const val = _image[i*_width + x];
+            if ((!nanSafe || val == val) && !(_useMask && (_mask[i*_width + x] & andMask))) {
+                *end++ = val;
             }
-            *ptr = typename afwImage::MaskedImage<PixelT>::Pixel(stat.getValue(flags), msk, variance);
+        }
+
+        _median[x] = percentile<PixelT>(_scratch.begin(), end, 0.5);
+        if (onlyMedian) {
+            _iqrange[x] = NaN;
+        } else {
+            _iqrange[x] = percentile<PixelT>(_scratch.begin(), end, 0.75) -
+                percentile<PixelT>(_scratch.begin(), end, 0.25);
         }
     }
+}
 
-    return imgStack;
+/*
+ * Iteratively N-sigma clip each column, starting at median +- numSigmaClip*IQ_TO_STDEV*IQR;
+ * all subsequent iterations clip at mean +- numSigmaClip*stdev
+ */
+template <typename PixelT>    
+void StackEngine<PixelT>::_clip() {
+    int const nImage = _nImage;
+    int const width = _width;
+    afwImage::MaskPixel const andMask = _sctrl.getAndMask();
+    bool const isWeighted = _isWeighted;
+    double const numSigmaClip = _sctrl.getNumSigmaClip();
+
+    std::vector<double> hwidth(width);
+    std::vector<int> nClip(width);
+
+    std::fill(_meanclip.begin(), _meanclip.end(), NaN);
+    std::fill(_varianceclip.begin(), _varianceclip.end(), NaN);
+
+    for (int iter = 0; iter < _sctrl.getNumIter(); ++iter) {
+        for (int x = 0; x != width; ++x) {
+            _shift[x] = (iter > 0) ? _meanclip[x] : _median[x];
+            hwidth[x] = (iter > 0 && _npoint[x] > 1) ?
+                numSigmaClip*std::sqrt(_varianceclip[x]) : numSigmaClip*IQ_TO_STDEV*_iqrange[x];
+        }
+
+        std::fill(nClip.begin(), nClip.end(), 0);
+        std::fill(_sum.begin(), _sum.end(), 0.0);
+        std::fill(_sumx2.begin(), _sumx2.end(), 0.0);
+        std::fill(_wsum.begin(), _wsum.end(), 0.0);
+
+        for (int i = 0; i != nImage; ++i) {
+            PixelT const *im = &_image[i*width];
+            afwImage::MaskPixel const *msk = _useMask ? &_mask[i*width] : NULL;
+            afwImage::VariancePixel const *wt = isWeighted ? &_weight[i*width] : NULL;
+            double const *center = &_shift[0], *hw = &hwidth[0];
+            int *n = &nClip[0];
+            double *sum = &_sum[0], *sumx2 = &_sumx2[0], *wsum = &_wsum[0];
+
+            for (int x = 0; x != width; ++x) {
+                double const delta = im[x] - center[x];
+                // n.b. NaNs (in the data or the clipping limits) fail the comparison
+                bool const good = std::fabs(delta) <= hw[x] && !(msk && (msk[x] & andMask));
+                double const w = good ? (isWeighted ? wt[x] : 1.0) : 0.0;
+                double const d = good ? delta : 0.0;
+
+                n[x] += good;
+                sum[x] += w*d;
+                sumx2[x] += w*d*d;
+                wsum[x] += w;
+            }
+        }
+
+        for (int x = 0; x != width; ++x) {
+            if (_shift[x] != _shift[x] || hwidth[x] != hwidth[x]) {
+                _meanclip[x] = _varianceclip[x] = NaN;
+                continue;
+            }
+            int const n = nClip[x];
+            double const sum = _sum[x];
+            double const wsum = isWeighted ? _wsum[x] : n;
 
+            _meanclip[x] = (wsum > 0) ? _shift[x] + sum/wsum : NaN;
+            _varianceclip[x] = (n > 1) ? _sumx2[x]/(wsum - wsum/n) - sum*sum/((wsum - wsum/n)*wsum) : NaN;
+            _npoint[x] = n;
+        }
+    }
 }
-    
+
 } // end anonymous namespace
 
 
-/**
- * @brief A function to compute some statistics of a stack of Masked Images
- * @relates Statistics
+
+/****************************************************************************
  *
- * If none of the input images are valid for some pixel,
- * the afwMath::StatisticsControl::getNoGoodPixelsMask() bit(s) are set.
+ * stack Images and MaskedImages, a band of rows at a time
  *
- * All the work is done in the function comuteMaskedImageStack.
- * A boolean template variable has been used to allow the compiler to generate the different instantiations
- *   to handle cases when we are, or are not, dealing with the variance plane.
+ ****************************************************************************/
+
+namespace {
+
+/*
+ * Copy row y of image i into the engine's buffers
  */
 template<typename PixelT>
-typename afwImage::MaskedImage<PixelT>::Ptr afwMath::statisticsStack(
-        std::vector<typename afwImage::MaskedImage<PixelT>::Ptr > &images, //!< images to process
-        afwMath::Property flags,                                           //!< Desired statistic (only one!)
-        afwMath::StatisticsControl const& sctrl,                           //!< Fine control over processing
-        std::vector<PixelT> const &wvector                                 //!< optional weights vector
-                                                              ) {
-    if (images.size() == 0) {
-        throw LSST_EXCEPT(lsst::pex::exceptions::LengthErrorException, "Please specify at least one image");
-    }
-
-    checkOnlyOneFlag(flags);
+void loadRow(StackEngine<PixelT> &engine, int const i, afwImage::Image<PixelT> const &image, int const y) {
+    std::copy(image.row_begin(y), image.row_end(y), engine.getImageRow(i));
+}
 
-    // if we're going to use constant weights 
-    if ( wvector.size() == images.size() ) {
-        return computeMaskedImageStack<PixelT, true>(images, flags, sctrl, wvector);
-        
-    // if we're weighting by the pixel variance        
-    } else if ( wvector.size() == 0 ) {
-        return computeMaskedImageStack<PixelT, false>(images, flags, sctrl, wvector);
-        
-    // Fail if the number weights isn't the same as the number of images to be weighted.
-    } else {
-        throw LSST_EXCEPT(ex::InvalidParameterException,
-                          "Weight vector must have same length as number of MaskedImages to be stacked.");
+template<typename PixelT>
+void loadRow(StackEngine<PixelT> &engine, int const i, afwImage::MaskedImage<PixelT> const &image, int const y) {
+    std::copy(image.getImage()->row_begin(y), image.getImage()->row_end(y), engine.getImageRow(i));
+    std::copy(image.getMask()->row_begin(y), image.getMask()->row_end(y), engine.getMaskRow(i));
+    // if we're not using the wvector weights, we may need the variance plane.
+    if (afwImage::VariancePixel *var = engine.getVarianceRow(i)) {
+        std::copy(image.getVariance()->row_begin(y), image.getVariance()->row_end(y), var);
     }
 }
 
+/*
+ * Set row y of the output image from the engine's results
+ */
+template<typename PixelT>
+void storeRow(StackEngine<PixelT> const &engine, afwImage::Image<PixelT> &image, int const y) {
+    typename afwImage::Image<PixelT>::x_iterator ptr = image.row_begin(y);
+    for (int x = 0; x != image.getWidth(); ++x, ++ptr) {
+        *ptr = engine.getValue(x);
+    }
+}
 
+template<typename PixelT>
+void storeRow(StackEngine<PixelT> const &engine, afwImage::MaskedImage<PixelT> &image, int const y) {
+    typedef afwImage::MaskedImage<PixelT> Image;
+    typename Image::x_iterator ptr = image.row_begin(y);
+    for (int x = 0; x != image.getWidth(); ++x, ++ptr) {
+        *ptr = typename Image::Pixel(engine.getValue(x), engine.getMask(x), engine.getVariance(x));
+    }
+}
 
+/*
+ * Stack one chunk of the rows of a band;  called (possibly in parallel) for each chunk of the band.
+ *
+ * Each call has its own StackEngine, and only touches the pixels of images created by the calling thread
+ */
+template<typename PixelT, typename ImageT>
+class StackRows {
+public:
+    StackRows(std::vector<typename ImageT::Ptr> const &band, ///< the band of each input image
+              ImageT &out,                                  ///< the corresponding band of the output
+              int const nChunk,                             ///< number of chunks the band is divided into
+              afwMath::Property const flags,
+              afwMath::StatisticsControl const &sctrl,
+              std::vector<PixelT> const &wvector,
+              bool const useMask
+             ) : _band(band), _out(out), _nChunk(nChunk),
+                 _flags(flags), _sctrl(sctrl), _wvector(wvector), _useMask(useMask) {}
+
+    void operator()(int const chunk) const {
+        int const nRow = _out.getHeight();
+        int const y0 = (chunk*nRow)/_nChunk;
+        int const y1 = ((chunk + 1)*nRow)/_nChunk;
+
+        StackEngine<PixelT> engine(_band.size(), _out.getWidth(), _flags, _sctrl, _wvector, _useMask);
+        for (int y = y0; y != y1; ++y) {
+            for (unsigned int i = 0; i != _band.size(); ++i) {
+                loadRow(engine, i, *_band[i], y);
+            }
+            engine.compute();
+            storeRow(engine, _out, y);
+        }
+    }
 
+private:
+    std::vector<typename ImageT::Ptr> const &_band;
+    ImageT &_out;
+    int const _nChunk;
+    afwMath::Property const _flags;
+    afwMath::StatisticsControl const &_sctrl;
+    std::vector<PixelT> const &_wvector;
+    bool const _useMask;
+};
 
-/****************************************************************************
- *
- * stack Images
- *
- * All the work is done in the function comuteImageStack.
- * A boolean template variable has been used to allow the compiler to generate the different instantiations
- *   to handle cases when we are, or are not, dealing with the variance plane.
- *
- ****************************************************************************/
+/*
+ * Provide the bands of a vector of images that are already in memory
+ */
+template<typename ImageT>
+class InMemoryReader {
+public:
+    explicit InMemoryReader(std::vector<typename ImageT::Ptr> const &images) : _images(images) {}
+
+    int getSize() const { return _images.size(); }
+    afwGeom::Extent2I getDimensions() const { return _images[0]->getDimensions(); }
+    typename ImageT::Ptr read(int const i, afwGeom::Box2I const &bbox) const {
+        return typename ImageT::Ptr(new ImageT(*_images[i], bbox, afwImage::LOCAL));
+    }
 
+private:
+    std::vector<typename ImageT::Ptr> const &_images;
+};
 
-namespace {
-/***********************************************************************************/
 /*
- * A function to compute some statistics of a stack of regular images
+ * Compute the stack of the images provided by reader, a band of rows at a time.
+ *
+ * The bands are read (and all Images created) in the calling thread;  the rows of each band are then
+ * shared between the threads
  */
-template<typename PixelT, bool UseVariance>
-typename afwImage::Image<PixelT>::Ptr computeImageStack(
-        std::vector<typename afwImage::Image<PixelT>::Ptr > &images,  
-        afwMath::Property flags,               
+template<typename PixelT, typename ImageT, typename ReaderT>
+typename ImageT::Ptr computeStack(
+        ReaderT const &reader,
+        afwMath::Property flags,
         afwMath::StatisticsControl const& sctrl,
-        std::vector<PixelT> const &wvector
-                                                        ) {
-
+        std::vector<PixelT> const &wvector,
+        afwMath::StackControl const &stctrl,
+        bool const useMask
+                                 ) {
     // create the image to be returned
-    typedef afwImage::Image<PixelT> Image;
-    typename Image::Ptr imgStack(new Image(images[0]->getDimensions(), 0.0));
-
-    afwMath::StatisticsControl sctrlTmp(sctrl);
-    afwMath::MaskedVector<typename Image::Pixel> pixelSet(images.size());
-
-    // set the mask to be an infinite iterator
-    afwMath::MaskImposter<afwImage::MaskPixel> msk;
-
-    // if we're going to use contant weights
-    if ( UseVariance ) {
-        sctrlTmp.setWeighted(true);
-        sctrlTmp.setMultiplyWeights(true);
-        // copy the weights in to the variance vector
-        loadVariance(wvector, pixelSet);
-    }
-        
-    // get the desired statistic
-    for (int y = 0; y != imgStack->getHeight(); ++y) {
-        for (int x = 0; x != imgStack->getWidth(); ++x) {
-            for (unsigned int i = 0; i != images.size(); ++i) {
-                (*pixelSet.getImage())(i, 0) = (*images[i])(x, y);
-            }
-            if (UseVariance) {
-                afwMath::Statistics stat =
-                    afwMath::makeStatistics(*pixelSet.getImage(), msk, *pixelSet.getVariance(),
-                                         flags, sctrlTmp);
-                (*imgStack)(x, y) = stat.getValue();
-            } else {
-                afwMath::Statistics stat = afwMath::makeStatistics(pixelSet, flags, sctrlTmp);
-                (*imgStack)(x, y) = stat.getValue();
+    afwGeom::Extent2I const dims = reader.getDimensions();
+    typename ImageT::Ptr imgStack(new ImageT(dims));
+
+    int const nImage = reader.getSize();
+    int const height = dims.getY();
+    int const nThread = afwMath::detail::getNumThreads(stctrl.getNumThreads());
+
+    for (int y0 = 0; y0 < height; y0 += stctrl.getBandHeight()) {
+        afwGeom::Box2I const bbox(afwGeom::Point2I(0, y0),
+                                  afwGeom::Extent2I(dims.getX(), std::min(stctrl.getBandHeight(), height - y0)));
+
+        std::vector<typename ImageT::Ptr> band(nImage);
+        for (int i = 0; i != nImage; ++i) {
+            band[i] = reader.read(i, bbox);
+            if (band[i]->getDimensions() != bbox.getDimensions()) {
+                throw LSST_EXCEPT(ex::LengthErrorException,
+                                  (boost::format("Image %d: read %dx%d pixels; expected %dx%d") % i %
+                                   band[i]->getWidth() % band[i]->getHeight() %
+                                   bbox.getWidth() % bbox.getHeight()).str());
             }
         }
+        ImageT outBand(*imgStack, bbox, afwImage::LOCAL);
+
+        int const nChunk = std::min(nThread, bbox.getHeight());
+        afwMath::detail::parallelFor(0, nChunk,
+                                     StackRows<PixelT, ImageT>(band, outBand, nChunk,
+                                                               flags, sctrl, wvector, useMask),
+                                     nThread);
     }
 
     return imgStack;
 }
 
+/*
+ * Check the arguments common to all the ways of stacking images
+ */
+template<typename PixelT>
+void checkStackArguments(int const nImage,
+                         afwMath::Property const flags,
+                         std::vector<PixelT> const &wvector,
+                         char const *what
+                        ) {
+    if (nImage == 0) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::LengthErrorException, "Please specify at least one image");
+    }
+
+    checkOnlyOneFlag(flags);
+
+    // Fail if the number weights isn't the same as the number of images to be weighted.
+    if (wvector.size() != 0 && static_cast<int>(wvector.size()) != nImage) {
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          (boost::format("Weight vector must have same length as number of %s to be stacked.") %
+                           what).str());
+    }
+}
+
 } // end anonymous namespace
 
 
+/**
+ * @brief A function to compute some statistics of a stack of Masked Images
+ * @relates Statistics
+ *
+ * If none of the input images are valid for some pixel,
+ * the afwMath::StatisticsControl::getNoGoodPixelsMask() bit(s) are set.
+ *
+ * All the work is done in the function computeStack, which processes the output a band of rows at a time.
+ */
+template<typename PixelT>
+typename afwImage::MaskedImage<PixelT>::Ptr afwMath::statisticsStack(
+        std::vector<typename afwImage::MaskedImage<PixelT>::Ptr > &images, //!< images to process
+        afwMath::Property flags,                                           //!< Desired statistic (only one!)
+        afwMath::StatisticsControl const& sctrl,                           //!< Fine control over processing
+        std::vector<PixelT> const &wvector,                                //!< optional weights vector
+        afwMath::StackControl const& stctrl                                //!< How to divide up the work
+                                                              ) {
+    typedef afwImage::MaskedImage<PixelT> Image;
+
+    checkStackArguments(images.size(), flags, wvector, "MaskedImages");
+    checkDimensions<Image>(images);
+
+    // if wvector is empty, we're weighting by the pixel variance (if at all)
+    return computeStack<PixelT, Image>(InMemoryReader<Image>(images), flags, sctrl, wvector, stctrl, true);
+}
+
+/**
+ * @brief A function to compute some statistics of a stack of Masked Images, reading them a band at a time
+ * @relates Statistics
+ *
+ * Only one band of each of the input images (of height stctrl.getBandHeight()) is in memory at a time.
+ */
+template<typename PixelT>
+typename afwImage::MaskedImage<PixelT>::Ptr afwMath::statisticsStack(
+        afwMath::StackInput<PixelT> const &input,       //!< images to process
+        afwMath::Property flags,                        //!< Desired statistic (only one!)
+        afwMath::StatisticsControl const& sctrl,        //!< Fine control over processing
+        std::vector<PixelT> const &wvector,             //!< optional weights vector
+        afwMath::StackControl const& stctrl             //!< How to divide up the work
+                                                              ) {
+    checkStackArguments(input.getSize(), flags, wvector, "MaskedImages");
+
+    return computeStack<PixelT, afwImage::MaskedImage<PixelT> >(input, flags, sctrl, wvector, stctrl, true);
+}
+
 /**
  * @brief A function to compute some statistics of a stack of regular images
  * @relates Statistics
@@ -295,24 +732,44 @@ typename afwImage::Image<PixelT>::Ptr afwMath::statisticsStack(
         std::vector<typename afwImage::Image<PixelT>::Ptr > &images,  
         afwMath::Property flags,               
         afwMath::StatisticsControl const& sctrl,
-        std::vector<PixelT> const &wvector
+        std::vector<PixelT> const &wvector,
+        afwMath::StackControl const& stctrl
                                                         ) {
+    typedef afwImage::Image<PixelT> Image;
 
-    checkOnlyOneFlag(flags);
+    checkStackArguments(images.size(), flags, wvector, "Images");
+    checkDimensions<Image>(images);
 
-    // if we're going to use contant weights
-    if ( wvector.size() == images.size() ) {
-        return computeImageStack<PixelT, true>(images, flags, sctrl, wvector);
-        
-    } else if ( wvector.size() == 0 ) {
-        return computeImageStack<PixelT, false>(images, flags, sctrl, wvector);
+    // An Image has no variance plane, so we only weight with the wvector
+    afwMath::StatisticsControl sctrlTmp(sctrl);
+    sctrlTmp.setWeighted(false);
 
-    // Fail if the number weights isn't the same as the number of images to be weighted.
-    } else {
-        throw LSST_EXCEPT(ex::InvalidParameterException,
-                          "Weight vector must have same length as number of Images to be stacked.");
-    }
+    return computeStack<PixelT, Image>(InMemoryReader<Image>(images), flags, sctrlTmp, wvector, stctrl, false);
+}
 
+/************************************************************************************************************/
+/**
+ * @brief Read the MaskedImages to be stacked from a set of FITS files
+ */
+template<typename PixelT>
+afwMath::FitsStackInput<PixelT>::FitsStackInput(
+        std::vector<std::string> const &fileNames, ///< names of the files to read
+        afwGeom::Extent2I const &dimensions,       ///< dimensions of each of the images
+        int hdu                                    ///< HDU to read
+                                               ) :
+    _fileNames(fileNames), _dimensions(dimensions), _hdu(hdu) {}
+
+/**
+ * @brief Read the part of the i-th image within bbox
+ */
+template<typename PixelT>
+typename afwImage::MaskedImage<PixelT>::Ptr afwMath::FitsStackInput<PixelT>::read(
+        int i,                                  ///< index of the image to read
+        afwGeom::Box2I const &bbox              ///< the pixels to read
+                                                                                 ) const {
+    return typename afwImage::MaskedImage<PixelT>::Ptr(
+        new afwImage::MaskedImage<PixelT>(_fileNames.at(i), _hdu, lsst::daf::base::PropertySet::Ptr(),
+                                          bbox, afwImage::LOCAL));
 }
 
 
@@ -331,7 +788,7 @@ namespace {
 /*
  * A function to compute some statistics of a stack of vectors
  */
-template<typename PixelT, bool UseVariance>
+template<typename PixelT>
 typename boost::shared_ptr<std::vector<PixelT> > computeVectorStack(
         std::vector<boost::shared_ptr<std::vector<PixelT> > > &vectors,  
         afwMath::Property flags,               
@@ -341,37 +798,22 @@ typename boost::shared_ptr<std::vector<PixelT> > computeVectorStack(
 
     // create the image to be returned
     typedef std::vector<PixelT> Vect;
-    typename boost::shared_ptr<Vect> vecStack(new Vect(vectors[0]->size(), 0.0));
-
-    afwMath::MaskedVector<PixelT> pixelSet(vectors.size()); // values from a given pixel of each image
+    int const width = vectors[0]->size();
+    typename boost::shared_ptr<Vect> vecStack(new Vect(width, 0.0));
 
     afwMath::StatisticsControl sctrlTmp(sctrl);
-    // set the mask to be an infinite iterator
-    afwMath::MaskImposter<afwImage::MaskPixel> msk;
-    
-    // Use constant weights for each layer
-    if ( UseVariance ) {
-        sctrlTmp.setWeighted(true);
-        sctrlTmp.setMultiplyWeights(true);
-        // copy the weights in to the variance vector
-        loadVariance(wvector, pixelSet);
-    }
-    
-    // collect elements from the stack into the MaskedVector to do stats
-    for (unsigned int x = 0; x < vectors[0]->size(); ++x) {
-        typename afwMath::MaskedVector<PixelT>::iterator psPtr = pixelSet.begin();
-        for (unsigned int i = 0; i < vectors.size(); ++i, ++psPtr) {
-            psPtr.value() = (*vectors[i])[x];
-        }
-        if (UseVariance) {
-            afwMath::Statistics stat = afwMath::makeStatistics(*pixelSet.getImage(), msk,
-                                                               *pixelSet.getVariance(),
-                                                               flags, sctrlTmp);
-            (*vecStack)[x] = stat.getValue(flags);
-        } else {
-            afwMath::Statistics stat = afwMath::makeStatistics(pixelSet, flags, sctrlTmp);
-            (*vecStack)[x] = stat.getValue(flags);
-        }
+    sctrlTmp.setWeighted(false);
+    StackEngine<PixelT> engine(vectors.size(), width, flags, sctrlTmp, wvector, false);
+
+    // collect elements from the stack into the engine to do stats
+    for (unsigned int i = 0; i < vectors.size(); ++i) {
+        std::copy(vectors[i]->begin(), vectors[i]->end(), engine.getImageRow(i));
+    }
+
+    engine.compute();
+
+    for (int x = 0; x != width; ++x) {
+        (*vecStack)[x] = engine.getValue(x);
     }
 
     return vecStack;
@@ -384,9 +826,7 @@ typename boost::shared_ptr<std::vector<PixelT> > computeVectorStack(
  * @brief A function to handle stacking a vector of vectors
  * @relates Statistics
  *
- * All the work is done in the function comuteVectorStack.
- * A boolean template variable has been used to allow the compiler to generate the different instantiations
- *   to handle cases when we are, or are not, dealing with the variance plane.
+ * All the work is done in the function computeVectorStack.
  */
 template<typename PixelT>
 typename boost::shared_ptr<std::vector<PixelT> > afwMath::statisticsStack(
@@ -395,20 +835,25 @@ typename boost::shared_ptr<std::vector<PixelT> > afwMath::statisticsStack(
         afwMath::StatisticsControl const& sctrl,
         std::vector<PixelT> const &wvector
                                                                       ) {
+    if (vectors.size() == 0) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::LengthErrorException, "Please specify at least one vector");
+    }
 
     checkOnlyOneFlag(flags);
+    for (unsigned int i = 1; i < vectors.size(); ++i) {
+        if (vectors[i]->size() != vectors[0]->size()) {
+            throw LSST_EXCEPT(ex::LengthErrorException,
+                              "All vectors to be stacked must have the same length.");
+        }
+    }
 
-    // Use constant weights for each layer
-    if ( wvector.size() == vectors.size() ) {
-        return computeVectorStack<PixelT, true>(vectors, flags, sctrl, wvector);
-    // Use no weights.
-    } else if ( wvector.size() == 0 ) {
-        return computeVectorStack<PixelT, false>(vectors, flags, sctrl, wvector);
     // Fail if the number weights isn't the same as the number of vectors to be weighted.
-    } else {
+    if (wvector.size() != 0 && wvector.size() != vectors.size()) {
         throw LSST_EXCEPT(ex::InvalidParameterException,
                           "Weight vector must have same length as number of vectors to be stacked.");
     }
+
+    return computeVectorStack<PixelT>(vectors, flags, sctrl, wvector);
 }
 
 
@@ -551,12 +996,21 @@ typename afwImage::MaskedImage<PixelT>::Ptr afwMath::statisticsStack(
             std::vector<afwImage::Image<TYPE>::Ptr > &images, \
             afwMath::Property flags, \
             afwMath::StatisticsControl const& sctrl,    \
-            std::vector<TYPE> const &wvector);                          \
+            std::vector<TYPE> const &wvector,                           \
+            afwMath::StackControl const& stctrl);                       \
     template afwImage::MaskedImage<TYPE>::Ptr afwMath::statisticsStack<TYPE>( \
             std::vector<afwImage::MaskedImage<TYPE>::Ptr > &images, \
             afwMath::Property flags, \
             afwMath::StatisticsControl const& sctrl,    \
-            std::vector<TYPE> const &wvector);                          \
+            std::vector<TYPE> const &wvector,                           \
+            afwMath::StackControl const& stctrl);                       \
+    template afwImage::MaskedImage<TYPE>::Ptr afwMath::statisticsStack<TYPE>( \
+            afwMath::StackInput<TYPE> const &input, \
+            afwMath::Property flags, \
+            afwMath::StatisticsControl const& sctrl,    \
+            std::vector<TYPE> const &wvector,                           \
+            afwMath::StackControl const& stctrl);                       \
+    template class afwMath::FitsStackInput<TYPE>;                       \
     template boost::shared_ptr<std::vector<TYPE> > afwMath::statisticsStack<TYPE>( \
             std::vector<boost::shared_ptr<std::vector<TYPE> > > &vectors, \
             afwMath::Property flags, \
@@ -172,38 +172,6 @@ afwMath::Property afwMath::stringToStatisticsProperty(std::string const property
     return statisticsProperty[property];
 }
 
-/**
- * @brief A private function to copy an image into a vector
- *
- * This is used for percentile and iq_range as these must reorder the values.
- * Because it loops over the pixels, it's been templated over the NaN test to avoid
- * code repetition of the loops.
- */
-template<typename IsFinite, typename ImageT, typename MaskT, typename VarianceT>
-boost::shared_ptr<std::vector<typename ImageT::Pixel> > afwMath::Statistics::_makeVectorCopy(
-        ImageT const &img,
-        MaskT const &msk,
-        VarianceT const &,
-        int const
-                                                                                         )
-{
-
-    // Note to self: I'm not going to keep track of allPixelOrMask here ... sumImage() does that
-    // and it always gets called
-    boost::shared_ptr<std::vector<typename ImageT::Pixel> > imgcp(new std::vector<typename ImageT::Pixel>(0));
-    for (int i_y = 0; i_y < img.getHeight(); ++i_y) {
-        typename MaskT::x_iterator mptr = msk.row_begin(i_y);
-        for (typename ImageT::x_iterator ptr = img.row_begin(i_y), end = img.row_end(i_y); ptr != end; ++ptr) {
-            if ( IsFinite()(*ptr) && !(*mptr & _sctrl.getAndMask()) ) {
-                imgcp->push_back(*ptr);
-            }
-            ++mptr;
-        }
-    }
-    return imgcp;
-}
-
-
 /**
  * @brief Constructor for Statistics object
  *
@@ -232,8 +200,17 @@ afwMath::Statistics::Statistics(
     // Check that an int's large enough to hold the number of pixels
     assert(img.getWidth()*static_cast<double>(img.getHeight()) < std::numeric_limits<int>::max());
 
+    // the median, quartiles, and clipped statistics are calculated from a copy of the good pixels
+    // (and their variances, if we're weighting), made while we get the standard statistics
+    bool const needValues = (flags & (MEDIAN | IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP));
+    bool const needClip = (flags & (MEANCLIP | STDEVCLIP | VARIANCECLIP));
+    std::vector<typename ImageT::Pixel> values;
+    std::vector<double> variances;
+
     // get the standard statistics
-    StandardReturn standard = _getStandard(img, msk, var, flags);
+    StandardReturn standard = _getStandard(img, msk, var, flags,
+                                           needValues ? &values : NULL,
+                                           (needValues && _sctrl.getWeighted()) ? &variances : NULL);
 
     _mean = standard.get<0>();
     _variance = standard.get<1>();
@@ -245,28 +222,26 @@ afwMath::Statistics::Statistics(
     // ==========================================================
     // now only calculate it if it's specifically requested - these all cost more!
 
-    // copy the image for any routines that will use median or quantiles
-    if (flags & (MEDIAN | IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP)) {
-
-        // make a vector copy of the image to get the median and quartiles (will move values)
-        boost::shared_ptr<std::vector<typename ImageT::Pixel> > imgcp;
-        if (_sctrl.getNanSafe()) {
-            imgcp = _makeVectorCopy<ChkFin>(img, msk, var, flags);
-        } else {
-            imgcp = _makeVectorCopy<AlwaysT>(img, msk, var, flags);
+    if (needValues) {
+        // The quantiles are found by reordering the values;  if we're going to clip, reorder a copy so that
+        // the clipping sums the values (and their variances) in the same order as _getStandard
+        std::vector<typename ImageT::Pixel> reordered;
+        if (needClip) {
+            reordered = values;
         }
+        std::vector<typename ImageT::Pixel> &quantileValues = needClip ? reordered : values;
 
         // if we *only* want the median, just use _percentile(), otherwise use _medianAndQuartiles()
         if ( (flags & (MEDIAN)) && !(flags & (IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP)) ) {
-            _median = _percentile(*imgcp, 0.5);
+            _median = _percentile(quantileValues, 0.5);
         } else {
-            MedianQuartileReturn mq = _medianAndQuartiles(*imgcp);
+            MedianQuartileReturn mq = _medianAndQuartiles(quantileValues);
             _median = mq.get<0>();
             _iqrange = mq.get<2>() - mq.get<1>();
         }
         
         
-        if (flags & (MEANCLIP | STDEVCLIP | VARIANCECLIP)) {            
+        if (needClip) {
             for (int i_i = 0; i_i < _sctrl.getNumIter(); ++i_i) {
                 
                 double const center = (i_i > 0) ? _meanclip : _median;
@@ -275,17 +250,58 @@ afwMath::Statistics::Statistics(
                     _sctrl.getNumSigmaClip()*IQ_TO_STDEV*_iqrange;
                 std::pair<double, double> const clipinfo(center, hwidth);
                 
-                // returns a tuple but we'll ignore clipped min, max, and sum;
-                StandardReturn clipped = _getStandard(img, msk, var, flags, clipinfo);
+                std::pair<double, double> const clipped = _getClipped(values, variances, clipinfo);
                 
-                _meanclip = clipped.get<0>();
-                _varianceclip = clipped.get<1>();
+                _meanclip = clipped.first;
+                _varianceclip = clipped.second;
             }
         }
     }
 }
 
 
+/**
+ * @brief Constructor for a Statistics object whose values are set by a StatisticsAccumulator
+ */
+afwMath::Statistics::Statistics(
+    int const flags,               ///< Describe what we want to calculate
+    StatisticsControl const& sctrl ///< Control how things are calculated
+                               ) :
+    _flags(flags),
+    _n(0),
+    _mean(NaN), _variance(NaN), _min(NaN), _max(NaN), _sum(NaN),
+    _meanclip(NaN), _varianceclip(NaN), _median(NaN), _iqrange(NaN),
+    _allPixelOrMask(0x0),
+    _sctrl(sctrl) {
+}
+
+
+namespace {
+
+typedef boost::tuple<int, double, double, double, double, double, afwImage::MaskPixel> SumReturn; 
+
+/*
+ * The arguments to sumImage() that don't select which version of the loop is used
+ */
+template<typename ImageT, typename MaskT, typename VarianceT>
+struct SumImageArgs {
+    SumImageArgs(ImageT const &img_, MaskT const &msk_, VarianceT const &var_, int const andMask_,
+                 int const nCrude_, int const stride_, double const meanCrude_,
+                 std::vector<typename ImageT::Pixel> *values_, std::vector<double> *variances_) :
+        img(img_), msk(msk_), var(var_), andMask(andMask_),
+        nCrude(nCrude_), stride(stride_), meanCrude(meanCrude_), values(values_), variances(variances_) {}
+
+    ImageT const &img;
+    MaskT const &msk;
+    VarianceT const &var;
+    int const andMask;                  // ignore pixels with any of these bits set
+    int const nCrude;                   // number of pixels used to estimate meanCrude
+    int const stride;                   // only process every stride-th row
+    double const meanCrude;             // a crude estimate of the mean, subtracted from each pixel
+    std::vector<typename ImageT::Pixel> *values;  // if non-NULL, save the good pixels here
+    std::vector<double> *variances;     // if non-NULL, save the good pixels' variances here
+};
+
 /**
  * @brief This function handles the inner summation loop, with tests templated
  *
@@ -294,29 +310,43 @@ afwMath::Statistics::Statistics(
  * user requests a test (eg check for NaNs), the function is instantiated with the appropriate functor.
  * Otherwise, an 'AlwaysTrue' or 'AlwaysFalse' object is passed in.  The compiler then compiles-out
  * a test which is always false, or removes the conditional for a test which is always true.
+ *
+ * The choice of weighting and whether the good pixels are copied (for the quantiles and clipping) are
+ * also made at compile time, so everything that's wanted is calculated in a single pass over the pixels.
+ *
+ * The NaN test for the copy is separate from that for the sums:  finding the min and max always skips
+ * NaNs in the sums, but NaNs are only dropped from the copy if the StatisticsControl asks us to be NaN-safe.
  */
-
 template<typename IsFinite,
+         typename IsFiniteCopy,
          typename HasValueLtMin,
          typename HasValueGtMax,
-         typename InClipRange,
          bool IsWeighted,
+         bool IsMultiplyingWeights,
+         bool IsCopying,
          typename ImageT, typename MaskT, typename VarianceT>
-afwMath::Statistics::SumReturn afwMath::Statistics::_sumImage(ImageT const &img,
-                                                              MaskT const &msk,
-                                                              VarianceT const &var,
-                                                              int const,
-                                                              int const nCrude,
-                                                              int const stride,
-                                                              double const meanCrude,
-                                                              double const cliplimit) {
+SumReturn sumImage(SumImageArgs<ImageT, MaskT, VarianceT> const &args) {
     int n = 0;
     double wsum = 0.0;
     double sum = 0, sumx2 = 0;
-    double min = (nCrude) ? meanCrude : MAX_DOUBLE;
-    double max = (nCrude) ? meanCrude : -MAX_DOUBLE;
+    double min = (args.nCrude) ? args.meanCrude : MAX_DOUBLE;
+    double max = (args.nCrude) ? args.meanCrude : -MAX_DOUBLE;
+    ImageT const &img = args.img;
+    MaskT const &msk = args.msk;
+    VarianceT const &var = args.var;
+    int const stride = args.stride;
+    double const meanCrude = args.meanCrude;
+    int const andMask = args.andMask;
 
     afwImage::MaskPixel allPixelOrMask = 0x0;
+
+    if (IsCopying) {
+        int const nPixel = img.getWidth()*((img.getHeight() + stride - 1)/stride);
+        args.values->reserve(nPixel);
+        if (IsWeighted) {
+            args.variances->reserve(nPixel);
+        }
+    }
     
     for (int iY = 0; iY < img.getHeight(); iY += stride) {
         
@@ -326,14 +356,23 @@ afwMath::Statistics::SumReturn afwMath::Statistics::_sumImage(ImageT const &img,
         for (typename ImageT::x_iterator ptr = img.row_begin(iY), end = ptr + img.getWidth();
              ptr != end; ++ptr, ++mptr, ++vptr) {
             
-            if (IsFinite()(*ptr) &&
-                !(*mptr & _sctrl.getAndMask()) &&
-                InClipRange()(*ptr, meanCrude, cliplimit) ) { // clip
+            if (*mptr & andMask) {
+                continue;
+            }
+
+            if (IsCopying && IsFiniteCopy()(*ptr)) {
+                args.values->push_back(*ptr);
+                if (IsWeighted) {
+                    args.variances->push_back(*vptr);
+                }
+            }
+
+            if (IsFinite()(*ptr)) {
                 
                 double const delta = (*ptr - meanCrude);
 
                 if (IsWeighted) {
-                    if ( _sctrl.getMultiplyWeights()) {
+                    if (IsMultiplyingWeights) {
                         sum   += (*vptr)*delta;
                         sumx2 += (*vptr)*delta*delta;
                         wsum  += (*vptr);
@@ -364,7 +403,97 @@ afwMath::Statistics::SumReturn afwMath::Statistics::_sumImage(ImageT const &img,
         max = NaN;
     }
 
-    return afwMath::Statistics::SumReturn(n, sum, sumx2, min, max, wsum, allPixelOrMask);
+    return SumReturn(n, sum, sumx2, min, max, wsum, allPixelOrMask);
+}
+
+/*
+ * Convert the runtime choices of sumImage's behaviour into template arguments, one at a time
+ */
+template<typename IsFinite, typename IsFiniteCopy, typename HasValueLtMin, typename HasValueGtMax,
+         bool IsWeighted, bool IsMultiplyingWeights, typename ImageT, typename MaskT, typename VarianceT>
+SumReturn sumImage(SumImageArgs<ImageT, MaskT, VarianceT> const &args) {
+    if (args.values) {
+        return sumImage<IsFinite, IsFiniteCopy, HasValueLtMin, HasValueGtMax,
+                        IsWeighted, IsMultiplyingWeights, true>(args);
+    } else {
+        return sumImage<IsFinite, IsFiniteCopy, HasValueLtMin, HasValueGtMax,
+                        IsWeighted, IsMultiplyingWeights, false>(args);
+    }
+}
+
+template<typename IsFinite, typename IsFiniteCopy, typename HasValueLtMin, typename HasValueGtMax,
+         typename ImageT, typename MaskT, typename VarianceT>
+SumReturn sumImage(SumImageArgs<ImageT, MaskT, VarianceT> const &args,
+                   afwMath::StatisticsControl const &sctrl) {
+    if (!sctrl.getWeighted()) {
+        return sumImage<IsFinite, IsFiniteCopy, HasValueLtMin, HasValueGtMax, false, false>(args);
+    } else if (sctrl.getMultiplyWeights()) {
+        return sumImage<IsFinite, IsFiniteCopy, HasValueLtMin, HasValueGtMax, true, true>(args);
+    } else {
+        return sumImage<IsFinite, IsFiniteCopy, HasValueLtMin, HasValueGtMax, true, false>(args);
+    }
+}
+
+template<typename ImageT, typename MaskT, typename VarianceT>
+SumReturn sumImage(SumImageArgs<ImageT, MaskT, VarianceT> const &args,
+                   afwMath::StatisticsControl const &sctrl,
+                   bool const isFindingMinMax ///< Find the min and max? (implies checking for NaNs)
+                  ) {
+    if (isFindingMinMax) {
+        if (sctrl.getNanSafe()) {
+            return sumImage<ChkFin, ChkFin, ChkMin, ChkMax>(args, sctrl);
+        } else {
+            return sumImage<ChkFin, AlwaysT, ChkMin, ChkMax>(args, sctrl);
+        }
+    } else if (sctrl.getNanSafe()) {
+        return sumImage<ChkFin, ChkFin, AlwaysF, AlwaysF>(args, sctrl);
+    } else {
+        return sumImage<AlwaysT, AlwaysT, AlwaysF, AlwaysF>(args, sctrl);
+    }
+}
+
+/**
+ * @brief The summation loop for the clipped statistics, over the values saved by sumImage()
+ *
+ * The values have already passed the mask and NaN tests
+ */
+template<bool IsWeighted, bool IsMultiplyingWeights, typename Pixel>
+SumReturn sumClipped(std::vector<Pixel> const &values,
+                     std::vector<double> const &variances,
+                     double const center,
+                     double const cliplimit) {
+    int n = 0;
+    double wsum = 0.0;
+    double sum = 0, sumx2 = 0;
+
+    for (unsigned int i = 0; i != values.size(); ++i) {
+        if (ChkClip()(values[i], center, cliplimit)) {
+            double const delta = (values[i] - center);
+
+            if (IsWeighted) {
+                double const var = variances[i];
+                if (IsMultiplyingWeights) {
+                    sum   += var*delta;
+                    sumx2 += var*delta*delta;
+                    wsum  += var;
+                } else {
+                    if (var > 0) {
+                        sum   += delta/var;
+                        sumx2 += delta*delta/var;
+                        wsum  += 1.0/var;
+                    }
+                }
+            } else {
+                sum += delta;
+                sumx2 += delta*delta;
+            }
+            n++;
+        }
+    }
+
+    return SumReturn(n, sum, sumx2, NaN, NaN, wsum, 0x0);
+}
+
 }
 
 /* =========================================================================
@@ -373,15 +502,19 @@ afwMath::Statistics::SumReturn afwMath::Statistics::_sumImage(ImageT const &img,
  *
  * @param img    an afw::Image to compute the stats over
  * @param flags  an integer (bit field indicating which statistics are to be computed
- *
- * @note An overloaded version below is used to get clipped versions
+ * @param values if non-NULL, the good pixels are copied into *values
+ * @param variances if non-NULL, the good pixels' variances are copied into *variances
  */
 template<typename ImageT, typename MaskT, typename VarianceT>
-afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(ImageT const &img,
-                                                                      MaskT const &msk,
-                                                                      VarianceT const &var,
-                                                                      int const flags) {
-
+afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(
+    ImageT const &img,
+    MaskT const &msk,
+    VarianceT const &var,
+    int const flags,
+    std::vector<typename ImageT::Pixel> *values,
+    std::vector<double> *variances
+                                                                     ) {
+    typedef SumImageArgs<ImageT, MaskT, VarianceT> Args;
 
     // =====================================================
     // a crude estimate of the mean, used for numerical stability of variance
@@ -398,23 +531,8 @@ afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(ImageT con
     } else {
         strideCrude = 10;
     }
-    if (_sctrl.getNanSafe()) {
-        if (_sctrl.getWeighted()){
-            loopValues = _sumImage<ChkFin, AlwaysF, AlwaysF, AlwaysT, true>(img, msk, var, flags,
-                                                                            nCrude, strideCrude, meanCrude);
-        } else {
-            loopValues = _sumImage<ChkFin, AlwaysF, AlwaysF, AlwaysT, false>(img, msk, var, flags,
-                                                                             nCrude, strideCrude, meanCrude);
-        }
-    } else {
-        if (_sctrl.getWeighted()) {
-            loopValues = _sumImage<AlwaysT, AlwaysF, AlwaysF, AlwaysT, true>(img, msk, var, flags,
-                                                                             nCrude, strideCrude, meanCrude);
-        } else {
-            loopValues = _sumImage<AlwaysT, AlwaysF, AlwaysF, AlwaysT, false>(img, msk, var, flags,
-                                                                              nCrude, strideCrude, meanCrude);
-        }
-    }
+    loopValues = sumImage(Args(img, msk, var, _sctrl.getAndMask(), nCrude, strideCrude, meanCrude, NULL, NULL),
+                          _sctrl, false);
     nCrude = loopValues.get<0>();
 
     double sumCrude = loopValues.get<1>();
@@ -425,39 +543,10 @@ afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(ImageT con
 
     // =======================================================
     // Estimate the full precision variance using that crude mean
-    // - get the min and max as well
-    
-    // If we want max or min (you get both)
-    if (flags & (MIN | MAX)){
-        
-        if (_sctrl.getWeighted()) {
-            loopValues = _sumImage<ChkFin, ChkMin, ChkMax, AlwaysT,true>(img, msk, var,
-                                                                         flags, nCrude, 1, meanCrude);
-            // fast loop ... just the mean & variance
-        } else {
-            loopValues = _sumImage<ChkFin, ChkMin, ChkMax, AlwaysT,false>(img, msk, var,
-                                                                          flags, nCrude, 1, meanCrude);
-        }
-    } else {
-        
-        if (_sctrl.getNanSafe()) {
-            if ( _sctrl.getWeighted()) {
-                loopValues = _sumImage<ChkFin, AlwaysF, AlwaysF, AlwaysT,true>(img, msk, var,
-                                                                               flags, nCrude, 1, meanCrude);
-            } else {
-                loopValues = _sumImage<ChkFin, AlwaysF, AlwaysF, AlwaysT,false>(img, msk, var,
-                                                                                flags, nCrude, 1, meanCrude);
-            }
-        } else {
-            if ( _sctrl.getWeighted()) {
-                loopValues = _sumImage<AlwaysT, AlwaysF, AlwaysF, AlwaysT,true>(img, msk, var, flags,
-                                                                                nCrude, 1, meanCrude);
-            } else {
-                loopValues = _sumImage<AlwaysT, AlwaysF, AlwaysF, AlwaysT,false>(img, msk, var, flags,
-                                                                                 nCrude, 1, meanCrude);
-            }
-        }
-    }
+    // - get the min and max as well if we want either of them (you get both),
+    //   and copy the values if we'll need them for quantiles or clipping
+    loopValues = sumImage(Args(img, msk, var, _sctrl.getAndMask(), nCrude, 1, meanCrude, values, variances),
+                          _sctrl, (flags & (MIN | MAX)));
 
     int n        = loopValues.get<0>();
     double sum   = loopValues.get<1>();
@@ -485,102 +574,56 @@ afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(ImageT con
 
 
 /* ==========================================================
- * *overload _getStandard(img, flags, clipinfo)
+ * _getClipped(values, variances, clipinfo)
  *
- * @param img      an afw::Image to compute stats for
- * @param flags    an int (bit field indicating which stats to compute
- * @param clipinfo the center and cliplimit for the first clip iteration
+ * @param values    the good pixels (as copied by _getStandard)
+ * @param variances the good pixels' variances (only used if weighting)
+ * @param clipinfo  the center and cliplimit for the clip iteration
  *
- * @brief A routine to get standard stats: mean, variance, min, max with
- *   clipping on std::pair<double,double> = center, cliplimit
+ * @brief A routine to get the clipped mean and variance, clipping on std::pair<double,double> = center, cliplimit
  */
-template<typename ImageT, typename MaskT, typename VarianceT>
-afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(
-    ImageT const &img,
-    MaskT const &msk,
-    VarianceT const &var,
-    int const flags,
+template<typename Pixel>
+std::pair<double, double> afwMath::Statistics::_getClipped(
+    std::vector<Pixel> const &values,
+    std::vector<double> const &variances,
     std::pair<double, double> const clipinfo
-                                                                     ) {
+                                                          ) {
     
     double const center = clipinfo.first;
     double const cliplimit = clipinfo.second;
 
     if (lsst::utils::isnan(center) || lsst::utils::isnan(cliplimit)) {
-        //return afwMath::Statistics::StandardReturn(mean, variance, min, max, sum + center*n);
-        return afwMath::Statistics::StandardReturn(NaN, NaN, NaN, NaN, NaN, ~0x0);
+        return std::make_pair(NaN, NaN);
     }
     
-    // =======================================================
-    // Estimate the full precision variance using that crude mean
     SumReturn loopValues;
-
-    int const stride = 1;
-    int nCrude = 0;
-    
-    // If we want max or min (you get both)
-    if (flags & (MIN | MAX)){
-        if ( _sctrl.getWeighted()) {
-            loopValues = _sumImage<ChkFin, ChkMin, ChkMax, ChkClip, true>(img, msk, var,
-                                                                          flags, nCrude, stride,
-                                                                          center, cliplimit);
-        } else {
-            loopValues = _sumImage<ChkFin, ChkMin, ChkMax, ChkClip, false>(img, msk, var,
-                                                                           flags, nCrude, stride,
-                                                                           center, cliplimit);
-        }
-    // fast loop ... just the mean & variance
+    if (!_sctrl.getWeighted()) {
+        loopValues = sumClipped<false, false>(values, variances, center, cliplimit);
+    } else if (_sctrl.getMultiplyWeights()) {
+        loopValues = sumClipped<true, true>(values, variances, center, cliplimit);
     } else {
-        if ( _sctrl.getWeighted()) {
-            
-            if (_sctrl.getNanSafe()) {
-                loopValues = _sumImage<ChkFin, AlwaysF, AlwaysF, ChkClip, true>(img, msk, var,
-                                                                                flags, nCrude, stride,
-                                                                                center, cliplimit);
-            } else {
-                loopValues = _sumImage<AlwaysT, AlwaysF, AlwaysF, ChkClip, true>(img, msk, var,
-                                                                                 flags, nCrude, stride,
-                                                                                 center, cliplimit);
-            }
-        } else {
-            
-            if (_sctrl.getNanSafe()) {
-                loopValues = _sumImage<ChkFin, AlwaysF, AlwaysF, ChkClip, false>(img, msk, var,
-                                                                                 flags, nCrude, stride,
-                                                                                 center, cliplimit);
-            } else {
-                loopValues = _sumImage<AlwaysT, AlwaysF, AlwaysF, ChkClip, false>(img, msk, var,
-                                                                                  flags, nCrude, stride,
-                                                                                  center, cliplimit);
-            }
-        }
+        loopValues = sumClipped<true, false>(values, variances, center, cliplimit);
     }
     
     int n        = loopValues.get<0>();
     double sum   = loopValues.get<1>();
     double sumx2 = loopValues.get<2>();
-    double min   = loopValues.get<3>();
-    double max   = loopValues.get<4>();
     double wsum  = loopValues.get<5>();
-    afwImage::MaskPixel allPixelOrMask = loopValues.get<6>();
     
     // estimate of population variance
     double mean, variance;
     if (_sctrl.getWeighted()) {
         mean = (wsum > 0) ? center + sum/wsum : NaN;
-        variance = (n > 1) ? sumx2/(wsum - wsum/n) - sum*sum/(static_cast<double>(wsum - wsum/n)*n) : NaN;
-        sum += center*wsum;
+        variance = (n > 1) ? sumx2/(wsum - wsum/n) - sum*sum/(static_cast<double>(wsum - wsum/n)*wsum) : NaN;
     } else {
         mean = (n) ? center + sum/n : NaN;
         variance = (n > 1) ? sumx2/(n - 1) - sum*sum/(static_cast<double>(n - 1)*n) : NaN;
-        sum += n*center;
     }
     _n = n;
     
-    return afwMath::Statistics::StandardReturn(mean, variance, min, max, sum, allPixelOrMask);
+    return std::make_pair(mean, variance);
 }
 
-
 /* _percentile()
  *
  * @brief A wrapper using the nth_element() built-in to compute percentiles for an image
@@ -801,7 +844,7 @@ std::pair<double, double> afwMath::Statistics::getResult(
       case MEANSQUARE:
         ret.first = (_n - 1)/static_cast<double>(_n)*_variance + _mean*_mean;
         if (_flags & ERRORS) {
-            ret.second = ::sqrt(2*ret.first*ret.first/(_n*_n)); // assumes Gaussian
+            ret.second = ::sqrt(2*ret.first*ret.first/(static_cast<double>(_n)*_n)); // assumes Gaussian
         }
         break;
         
@@ -941,45 +984,21 @@ typedef afwImage::VariancePixel VPixel;
     template STAT::Statistics(afwImage::Image<TYPE> const &img,            \
                               afwImage::Mask<afwImage::MaskPixel> const &msk, \
                               afwImage::Image<VPixel> const &var,               \
-                              int const flags, StatisticsControl const& sctrl); \
-    template STAT::StandardReturn STAT::_getStandard(afwImage::Image<TYPE> const &img, \
-                                                     afwImage::Mask<afwImage::MaskPixel> const &msk, \
-                                                     afwImage::Image<VPixel> const &var, \
-                                                     int const flags);  \
-    template STAT::StandardReturn STAT::_getStandard(afwImage::Image<TYPE> const &img, \
-                                                     afwImage::Mask<afwImage::MaskPixel> const &msk, \
-                                                     afwImage::Image<VPixel> const &var, \
-                                                     int const flags, std::pair<double, double> clipinfo);
+                              int const flags, StatisticsControl const& sctrl)
 
 
 #define INSTANTIATE_MASKEDIMAGE_STATISTICS_NO_MASK(TYPE)                       \
     template STAT::Statistics(afwImage::Image<TYPE> const &img,            \
                               afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
                               afwImage::Image<VPixel> const &var,               \
-                              int const flags, StatisticsControl const& sctrl); \
-    template STAT::StandardReturn STAT::_getStandard(afwImage::Image<TYPE> const &img, \
-                                                     afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
-                                                     afwImage::Image<VPixel> const &var, \
-                                                     int const flags);  \
-    template STAT::StandardReturn STAT::_getStandard(afwImage::Image<TYPE> const &img, \
-                                                     afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
-                                                     afwImage::Image<VPixel> const &var, \
-                                                     int const flags, std::pair<double, double> clipinfo)
+                              int const flags, StatisticsControl const& sctrl)
 
 
 #define INSTANTIATE_MASKEDIMAGE_STATISTICS_NO_VAR(TYPE)                       \
     template STAT::Statistics(afwImage::Image<TYPE> const &img,            \
                               afwImage::Mask<afwImage::MaskPixel> const &msk, \
                               afwMath::MaskImposter<VPixel> const &var,          \
-                              int const flags, StatisticsControl const& sctrl); \
-    template STAT::StandardReturn STAT::_getStandard(afwImage::Image<TYPE> const &img, \
-                                                     afwImage::Mask<afwImage::MaskPixel> const &msk, \
-                                                     afwMath::MaskImposter<VPixel> const &var, \
-                                                     int const flags);  \
-    template STAT::StandardReturn STAT::_getStandard(afwImage::Image<TYPE> const &img, \
-                                                     afwImage::Mask<afwImage::MaskPixel> const &msk, \
-                                                     afwMath::MaskImposter<VPixel> const &var, \
-                                                     int const flags, std::pair<double, double> clipinfo)
+                              int const flags, StatisticsControl const& sctrl)
 
 
 //
@@ -987,30 +1006,21 @@ typedef afwImage::VariancePixel VPixel;
     template STAT::Statistics(afwImage::Image<TYPE> const &img,            \
                               afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
                               afwMath::MaskImposter<VPixel> const &var, \
-                              int const flags, StatisticsControl const& sctrl); \
-    template STAT::StandardReturn STAT::_getStandard(afwImage::Image<TYPE> const &img, \
-                                                     afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
-                                                     afwMath::MaskImposter<VPixel> const &var, \
-                                                     int const flags);  \
-    template STAT::StandardReturn STAT::_getStandard(afwImage::Image<TYPE> const &img, \
-                                                     afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
-                                                     afwMath::MaskImposter<VPixel> const &var, \
-                                                     int const flags, std::pair<double, double> clipinfo)
+                              int const flags, StatisticsControl const& sctrl)
 
 //
 #define INSTANTIATE_VECTOR_STATISTICS(TYPE)                         \
     template STAT::Statistics(afwMath::ImageImposter<TYPE> const &img,     \
                               afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
                               afwMath::MaskImposter<VPixel> const &var,      \
-                              int const flags, StatisticsControl const& sctrl); \
-    template STAT::StandardReturn STAT::_getStandard(afwMath::ImageImposter<TYPE> const &img, \
-                                                     afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
-                                                     afwMath::MaskImposter<VPixel> const &var, \
-                                                     int const flags);  \
-    template STAT::StandardReturn STAT::_getStandard(afwMath::ImageImposter<TYPE> const &img, \
-                                                     afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
-                                                     afwMath::MaskImposter<VPixel> const &var, \
-                                                     int const flags, std::pair<double, double> clipinfo)
+                              int const flags, StatisticsControl const& sctrl)
+
+//
+#define INSTANTIATE_WEIGHTED_VECTOR_STATISTICS(TYPE)                \
+    template STAT::Statistics(afwMath::ImageImposter<TYPE> const &img,     \
+                              afwMath::MaskImposter<afwImage::MaskPixel> const &msk, \
+                              afwMath::ImageImposter<VPixel> const &var,      \
+                              int const flags, StatisticsControl const& sctrl)
 
 
 #define INSTANTIATE_IMAGE_STATISTICS(T) \
@@ -1018,7 +1028,8 @@ typedef afwImage::VariancePixel VPixel;
     INSTANTIATE_MASKEDIMAGE_STATISTICS_NO_VAR(T); \
     INSTANTIATE_MASKEDIMAGE_STATISTICS_NO_MASK(T); \
     INSTANTIATE_REGULARIMAGE_STATISTICS(T); \
-    INSTANTIATE_VECTOR_STATISTICS(T)
+    INSTANTIATE_VECTOR_STATISTICS(T); \
+    INSTANTIATE_WEIGHTED_VECTOR_STATISTICS(T)
 
 
 INSTANTIATE_IMAGE_STATISTICS(double);
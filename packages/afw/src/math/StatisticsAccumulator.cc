@@ -0,0 +1,576 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file
+ *
+ * @brief Accumulate image statistics incrementally
+ *
+ * @ingroup afw
+ */
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include "boost/cstdint.hpp"
+#include "boost/format.hpp"
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/math/StatisticsAccumulator.h"
+#include "lsst/utils/ieee.h"
+
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+namespace ex = lsst::pex::exceptions;
+
+namespace {
+
+double const NaN = std::numeric_limits<double>::quiet_NaN();
+double const IQ_TO_STDEV = 0.741301109252802;   // 1 sigma in units of iqrange (assume Gaussian)
+
+/*
+ * Return floor(i/2), rounding towards -infinity for negative i
+ */
+inline long floorHalf(long const i) {
+    return (i >= 0) ? i/2 : -((1 - i)/2);
+}
+
+}
+
+/**
+ * @brief Create an empty accumulator
+ */
+afwMath::StatisticsAccumulator::StatisticsAccumulator(
+        int const flags,                ///< Describe what we want to calculate
+        StatisticsControl const& sctrl, ///< Control how things are calculated
+        int const maxValues             ///< Maximum number of values (or histogram bins) to keep; 0 => all
+                                                     ) :
+    _flags(flags), _sctrl(sctrl), _maxValues(maxValues),
+    _shift(0.0), _all(), _min(NaN), _max(NaN), _orMask(0x0),
+    _values(), _weights(),
+    _binExp(0), _binOffset(0), _bins() {
+
+    if (maxValues < 0) {
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          (boost::format("maxValues must be >= 0 (saw %d)") % maxValues).str());
+    }
+}
+
+/**
+ * @brief Add a single pixel
+ *
+ * The pixel is ignored if its mask has any of the StatisticsControl's andMask bits set,
+ * or if it's a NaN and the StatisticsControl is NaN-safe.  As in makeStatistics(), a NaN that isn't
+ * ignored is left out of the unclipped statistics (and NPOINT) if MIN or MAX was requested, but is still
+ * used for the quantiles
+ */
+void afwMath::StatisticsAccumulator::add(
+        double const value,                             ///< the pixel's value
+        afwImage::MaskPixel const mask,                 ///< the pixel's mask
+        afwImage::VariancePixel const variance          ///< the pixel's variance (only used if weighted)
+                                        ) {
+    bool const isNan = lsst::utils::isnan(value);
+    if ((mask & _sctrl.getAndMask()) || (_sctrl.getNanSafe() && isNan)) {
+        return;
+    }
+
+    double weight = 1.0;
+    if (_sctrl.getWeighted()) {
+        if (_sctrl.getMultiplyWeights()) {
+            weight = variance;
+        } else {
+            weight = (variance > 0) ? 1.0/variance : 0.0;
+        }
+    }
+
+    if (isNan && (_flags & (MIN | MAX))) {
+        _keepValue(value, weight);
+        return;
+    }
+
+    _orMask |= mask;
+    _addValue(value, weight);
+}
+
+/**
+ * @brief Add all the pixels of an Image (all with unit weight)
+ */
+template<typename PixelT>
+void afwMath::StatisticsAccumulator::add(afwImage::Image<PixelT> const& img) {
+    for (int y = 0; y != img.getHeight(); ++y) {
+        for (typename afwImage::Image<PixelT>::x_iterator ptr = img.row_begin(y), end = img.row_end(y);
+             ptr != end; ++ptr) {
+            add(*ptr);
+        }
+    }
+}
+
+/**
+ * @brief Add all the pixels of a MaskedImage
+ */
+template<typename PixelT>
+void afwMath::StatisticsAccumulator::add(afwImage::MaskedImage<PixelT> const& mimg) {
+    for (int y = 0; y != mimg.getHeight(); ++y) {
+        for (typename afwImage::MaskedImage<PixelT>::x_iterator ptr = mimg.row_begin(y),
+                 end = mimg.row_end(y); ptr != end; ++ptr) {
+            add(ptr.image(), ptr.mask(), ptr.variance());
+        }
+    }
+}
+
+/**
+ * @brief Add a value that's passed the mask and NaN checks
+ */
+void afwMath::StatisticsAccumulator::_addValue(double const value, double const weight) {
+    bool const isFinite = lsst::utils::isfinite(value);
+
+    if (_all.n == 0 && isFinite) {
+        _shift = value;
+    }
+    _all.add(value - _shift, weight);
+
+    if (isFinite) {
+        if (!(value >= _min)) {         // true if _min is NaN
+            _min = value;
+        }
+        if (!(value <= _max)) {
+            _max = value;
+        }
+    }
+
+    _keepValue(value, weight);
+}
+
+/**
+ * @brief Keep a value for the quantiles and clipped statistics
+ */
+void afwMath::StatisticsAccumulator::_keepValue(double const value, double const weight) {
+    if (!_bins.empty()) {
+        if (lsst::utils::isfinite(value)) {
+            _binValue(value, weight);
+        }
+    } else {
+        _values.push_back(value);
+        if (_sctrl.getWeighted()) {
+            _weights.push_back(weight);
+        }
+        if (_maxValues > 0 && static_cast<int>(_values.size()) > _maxValues) {
+            _makeHistogram();
+        }
+    }
+}
+
+/**
+ * @brief Merge the pixels accumulated by another StatisticsAccumulator into this one
+ *
+ * The other accumulator should have been created with the same StatisticsControl.  If either accumulator
+ * has replaced its values by a histogram, so will the merged accumulator.
+ */
+void afwMath::StatisticsAccumulator::merge(StatisticsAccumulator const& other) {
+    if (&other == this) {               // we're about to modify other
+        StatisticsAccumulator const copy(other);
+        merge(copy);
+        return;
+    }
+    if (other._all.n == 0 && other._values.empty()) {
+        return;
+    }
+    if (_all.n == 0) {
+        _shift = other._shift;
+    }
+    if (_maxValues == 0) {
+        _maxValues = other._maxValues;
+    }
+
+    _all.merge(other._all, other._shift - _shift);
+    if (!lsst::utils::isnan(other._min) && !(other._min >= _min)) {
+        _min = other._min;
+    }
+    if (!lsst::utils::isnan(other._max) && !(other._max <= _max)) {
+        _max = other._max;
+    }
+    _orMask |= other._orMask;
+
+    if (other._bins.empty()) {
+        if (_bins.empty()) {
+            _values.insert(_values.end(), other._values.begin(), other._values.end());
+            _weights.insert(_weights.end(), other._weights.begin(), other._weights.end());
+            if (_maxValues > 0 && static_cast<int>(_values.size()) > _maxValues) {
+                _makeHistogram();
+            }
+        } else {
+            for (unsigned int i = 0; i != other._values.size(); ++i) {
+                double const value = other._values[i];
+                if (lsst::utils::isfinite(value)) {
+                    _binValue(value, other._weights.empty() ? 1.0 : other._weights[i]);
+                }
+            }
+        }
+    } else {
+        std::vector<double> values, weights;
+        values.swap(_values);
+        weights.swap(_weights);
+
+        _mergeBins(other);
+
+        for (unsigned int i = 0; i != values.size(); ++i) {
+            double const value = values[i];
+            if (lsst::utils::isfinite(value)) {
+                _binValue(value, weights.empty() ? 1.0 : weights[i]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Add the moments of another set of values, measured relative to a point shift greater than ours
+ */
+void afwMath::StatisticsAccumulator::Moments::merge(Moments const& other, double const shift) {
+    n += other.n;
+    wsum += other.wsum;
+    sum += other.sum + shift*other.wsum;
+    sumx2 += other.sumx2 + 2*shift*other.sum + shift*shift*other.wsum;
+}
+
+/************************************************************************************************************/
+/*
+ * The histogram
+ *
+ * Bin i contains the values in [i*2^_binExp, (i + 1)*2^_binExp), so two histograms' bins line up once
+ * the one with the finer bins has been coarsened (by combining pairs of bins) to the other's resolution.
+ * Only the range of bins [_binOffset, _binOffset + _bins.size()) is stored.
+ */
+
+/**
+ * @brief Replace the list of values by a histogram
+ */
+void afwMath::StatisticsAccumulator::_makeHistogram() {
+    std::vector<double> values, weights;
+    values.swap(_values);
+    weights.swap(_weights);
+    // Choose the bin width so that the values seen so far span half the available bins
+    double const range = _max - _min;
+    if (range > 0) {
+        _binExp = static_cast<int>(std::ceil(std::log(range/(0.5*_maxValues))/std::log(2.0)));
+    } else if (_max != 0) {
+        int exp;
+        std::frexp(_max, &exp);
+        _binExp = exp - 20;
+    } else {
+        _binExp = 0;
+    }
+    _bins.clear();
+    _binOffset = 0;
+
+    for (unsigned int i = 0; i != values.size(); ++i) {
+        double const value = values[i];
+        if (lsst::utils::isfinite(value)) {
+            _binValue(value, weights.empty() ? 1.0 : weights[i]);
+        }
+    }
+}
+
+/**
+ * @brief Add a finite value to the histogram, coarsening the bins if needed to keep it in range
+ */
+void afwMath::StatisticsAccumulator::_binValue(double const value, double const weight) {
+    // Values many decades from those already seen can overflow a bin index; coarsen the bins until they
+    // can't (they'd have to be that coarse anyway to span both)
+    double const maxIndex = std::ldexp(1.0, std::numeric_limits<long>::digits - 2);
+    while (!(std::fabs(std::ldexp(value, -_binExp)) < maxIndex)) {
+        _coarsen();
+    }
+    long i = static_cast<long>(std::floor(std::ldexp(value, -_binExp)));
+    for (;;) {
+        long const lo = _bins.empty() ? i : std::min(i, _binOffset);
+        long const hi = _bins.empty() ? i + 1 : std::max(i + 1, _binOffset + static_cast<long>(_bins.size()));
+        if (hi - lo <= _maxValues) {
+            _includeBins(lo, hi);
+            break;
+        }
+        _coarsen();
+        i = floorHalf(i);
+    }
+
+    _bins[i - _binOffset].add(value - _shift, weight);
+}
+
+/**
+ * @brief Extend the histogram to include bins [lo, hi)
+ */
+void afwMath::StatisticsAccumulator::_includeBins(long const lo, long const hi) {
+    if (_bins.empty()) {
+        _binOffset = lo;
+    }
+    if (lo < _binOffset) {
+        _bins.insert(_bins.begin(), _binOffset - lo, Moments());
+        _binOffset = lo;
+    }
+    if (hi > _binOffset + static_cast<long>(_bins.size())) {
+        _bins.resize(hi - _binOffset);
+    }
+}
+
+/**
+ * @brief Double the width of the histogram's bins
+ */
+void afwMath::StatisticsAccumulator::_coarsen() {
+    ++_binExp;
+    if (_bins.empty()) {
+        return;
+    }
+
+    long const offset = floorHalf(_binOffset);
+    std::vector<Moments> bins(floorHalf(_binOffset + static_cast<long>(_bins.size()) - 1) - offset + 1);
+    for (unsigned int j = 0; j != _bins.size(); ++j) {
+        bins[floorHalf(_binOffset + j) - offset].merge(_bins[j], 0.0);
+    }
+    _bins.swap(bins);
+    _binOffset = offset;
+}
+
+/**
+ * @brief Merge another accumulator's histogram into ours (which may be empty)
+ */
+void afwMath::StatisticsAccumulator::_mergeBins(StatisticsAccumulator const& other) {
+    StatisticsAccumulator tmp(other);
+    if (_bins.empty()) {
+        _binExp = tmp._binExp;
+    }
+    while (_binExp < tmp._binExp) {
+        _coarsen();
+    }
+    while (tmp._binExp < _binExp) {
+        tmp._coarsen();
+    }
+    for (;;) {
+        long const tmpEnd = tmp._binOffset + tmp._bins.size();
+        long const lo = _bins.empty() ? tmp._binOffset : std::min(_binOffset, tmp._binOffset);
+        long const hi = _bins.empty() ? tmpEnd : std::max(_binOffset + static_cast<long>(_bins.size()), tmpEnd);
+        if (hi - lo <= _maxValues) {
+            _includeBins(lo, hi);
+            break;
+        }
+        _coarsen();
+        tmp._coarsen();
+    }
+
+    double const shift = tmp._shift - _shift;
+    for (unsigned int j = 0; j != tmp._bins.size(); ++j) {
+        _bins[tmp._binOffset + j - _binOffset].merge(tmp._bins[j], shift);
+    }
+}
+
+/************************************************************************************************************/
+/*
+ * Quantiles and clipping
+ */
+
+/**
+ * @brief Return the desired percentile of a set of values, interpolating linearly between the values
+ *
+ * The values are reordered
+ */
+double afwMath::StatisticsAccumulator::_percentile(std::vector<double> &values, double const fraction) const {
+    int const n = values.size();
+    if (n == 0) {
+        return NaN;
+    } else if (n == 1) {
+        return values[0];
+    }
+
+    double const idx = fraction*(n - 1);
+    int const q1 = static_cast<int>(idx);
+    int const q2 = q1 + 1;
+    std::vector<double>::iterator mid1 = values.begin() + q1;
+    std::vector<double>::iterator mid2 = values.begin() + q2;
+    std::nth_element(values.begin(), mid1, values.end());
+    std::nth_element(mid1, mid2, values.end());
+
+    return (q2 - idx)*(*mid1) + (idx - q1)*(*mid2);
+}
+
+/**
+ * @brief Return the desired percentile of the histogrammed values
+ *
+ * The values in a bin are assumed to be uniformly distributed over the part of the bin
+ * within sqrt(3) standard deviations of their mean (i.e. a uniform distribution with the
+ * same first two moments), so a narrow peak is resolved even if it falls within a single bin
+ */
+double afwMath::StatisticsAccumulator::_histogramPercentile(double const fraction) const {
+    long long n = 0;
+    for (unsigned int j = 0; j != _bins.size(); ++j) {
+        n += _bins[j].n;
+    }
+    if (n == 0) {
+        return NaN;
+    }
+
+    double const width = std::ldexp(1.0, _binExp);
+    double const idx = fraction*(n - 1);
+    long long before = 0;               // number of values in the bins before the j-th
+    for (unsigned int j = 0; j != _bins.size(); ++j) {
+        Moments const& bin = _bins[j];
+        if (before + bin.n > idx) {
+            double lo = (_binOffset + static_cast<long>(j))*width;
+            double hi = lo + width;
+            if (bin.wsum > 0) {
+                double const mean = bin.sum/bin.wsum;
+                double const variance = bin.sumx2/bin.wsum - mean*mean;
+                double const hwidth = (variance > 0) ? std::sqrt(3*variance) : 0.0;
+                lo = std::max(lo, _shift + mean - hwidth);
+                hi = std::min(hi, _shift + mean + hwidth);
+            }
+            double const value = (lo <= hi) ? lo + (hi - lo)*(idx - before + 0.5)/bin.n : 0.5*(lo + hi);
+            return std::max(_min, std::min(_max, value));
+        }
+        before += bin.n;
+    }
+    return _max;
+}
+
+/**
+ * @brief Return the moments of the values within hwidth of center
+ *
+ * The moments are measured relative to _shift.  Histogram bins straddling the clipping limits are
+ * included if the mean of their values lies within the limits
+ */
+afwMath::StatisticsAccumulator::Moments afwMath::StatisticsAccumulator::_clip(
+        double const center,
+        double const hwidth
+                                                                             ) const {
+    Moments moments;
+
+    if (_bins.empty()) {
+        for (unsigned int i = 0; i != _values.size(); ++i) {
+            double const value = _values[i];
+            if (std::fabs(value - center) <= hwidth) {
+                moments.add(value - _shift, _weights.empty() ? 1.0 : _weights[i]);
+            }
+        }
+    } else {
+        double const width = std::ldexp(1.0, _binExp);
+        for (unsigned int j = 0; j != _bins.size(); ++j) {
+            Moments const& bin = _bins[j];
+            if (bin.n == 0) {
+                continue;
+            }
+            double const lo = (_binOffset + static_cast<long>(j))*width;
+            double const hi = lo + width;
+            bool use;
+            if (lo >= center - hwidth && hi <= center + hwidth) {
+                use = true;
+            } else if (hi < center - hwidth || lo > center + hwidth) {
+                use = false;
+            } else {
+                double const mean = (bin.wsum > 0) ? _shift + bin.sum/bin.wsum : lo + 0.5*width;
+                use = (std::fabs(mean - center) <= hwidth);
+            }
+            if (use) {
+                moments.merge(bin, 0.0);
+            }
+        }
+    }
+
+    return moments;
+}
+
+/**
+ * @brief Return the statistics of all the pixels added so far
+ *
+ * The results are those that makeStatistics() would have returned for the same pixels, except that
+ * MEDIAN, IQRANGE, and the clipped statistics are approximate if isApproximate() is true.
+ * Unlike makeStatistics(), it is not an error if no pixels were added;  all the values except NPOINT
+ * will be NaN.
+ */
+afwMath::Statistics afwMath::StatisticsAccumulator::finalize() const {
+    Statistics stats(_flags, _sctrl);
+
+    long long const n = _all.n;
+    double const wsum = _all.wsum;
+    stats._n = n;
+    stats._allPixelOrMask = _orMask;
+    stats._min = _min;
+    stats._max = _max;
+    stats._sum = _all.sum + _shift*wsum;
+    stats._mean = (wsum > 0) ? _shift + _all.sum/wsum : NaN;
+    stats._variance = (n > 1) ?
+        _all.sumx2/(wsum - wsum/n) - _all.sum*_all.sum/((wsum - wsum/n)*wsum) : NaN;
+
+    if (!(_flags & (MEDIAN | IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP))) {
+        return stats;
+    }
+
+    double q1, q3;
+    if (_bins.empty()) {
+        std::vector<double> values(_values);
+        stats._median = _percentile(values, 0.5);
+        q1 = _percentile(values, 0.25);
+        q3 = _percentile(values, 0.75);
+    } else {
+        stats._median = _histogramPercentile(0.5);
+        q1 = _histogramPercentile(0.25);
+        q3 = _histogramPercentile(0.75);
+    }
+    stats._iqrange = q3 - q1;
+
+    if (_flags & (MEANCLIP | STDEVCLIP | VARIANCECLIP)) {
+        for (int iter = 0; iter < _sctrl.getNumIter(); ++iter) {
+            double const center = (iter > 0) ? stats._meanclip : stats._median;
+            double const hwidth = (iter > 0 && stats._n > 1) ?
+                _sctrl.getNumSigmaClip()*std::sqrt(stats._varianceclip) :
+                _sctrl.getNumSigmaClip()*IQ_TO_STDEV*stats._iqrange;
+
+            if (lsst::utils::isnan(center) || lsst::utils::isnan(hwidth)) {
+                stats._meanclip = NaN;
+                stats._varianceclip = NaN;
+                continue;
+            }
+
+            Moments const clipped = _clip(center, hwidth);
+            long long const nClip = clipped.n;
+            double const wsumClip = clipped.wsum;
+            stats._meanclip = (wsumClip > 0) ? _shift + clipped.sum/wsumClip : NaN;
+            stats._varianceclip = (nClip > 1) ?
+                clipped.sumx2/(wsumClip - wsumClip/nClip) -
+                clipped.sum*clipped.sum/((wsumClip - wsumClip/nClip)*wsumClip) : NaN;
+            stats._n = nClip;           // as set by Statistics
+        }
+    }
+
+    return stats;
+}
+
+/************************************************************************************************************/
+/*
+ * Explicit instantiations
+ */
+/// \cond
+#define INSTANTIATE_ACCUMULATOR(TYPE) \
+    template void afwMath::StatisticsAccumulator::add(afwImage::Image<TYPE> const& img); \
+    template void afwMath::StatisticsAccumulator::add(afwImage::MaskedImage<TYPE> const& mimg)
+
+INSTANTIATE_ACCUMULATOR(double);
+INSTANTIATE_ACCUMULATOR(float);
+INSTANTIATE_ACCUMULATOR(int);
+INSTANTIATE_ACCUMULATOR(boost::uint16_t);
+/// \endcond
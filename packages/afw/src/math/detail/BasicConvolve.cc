@@ -37,13 +37,20 @@
 #include <vector>
 
 #include "boost/cstdint.hpp" 
+#include "boost/shared_ptr.hpp"
+#include "boost/type_traits/integral_constant.hpp"
+#include "boost/type_traits/is_floating_point.hpp"
 
+#include "lsst/ndarray.h"
 #include "lsst/pex/exceptions.h"
 #include "lsst/pex/logging/Trace.h"
 #include "lsst/afw/image.h"
 #include "lsst/afw/math.h"
 #include "lsst/afw/geom.h"
 #include "lsst/afw/math/detail/Convolve.h"
+#include "lsst/afw/math/detail/ImagePlanes.h"
+#include "lsst/afw/math/detail/Parallel.h"
+#include "lsst/afw/math/detail/Simd.h"
 
 namespace pexExcept = lsst::pex::exceptions;
 namespace pexLog = lsst::pex::logging;
@@ -51,6 +58,7 @@ namespace afwGeom = lsst::afw::geom;
 namespace afwImage = lsst::afw::image;
 namespace afwMath = lsst::afw::math;
 namespace mathDetail = lsst::afw::math::detail;
+namespace nd = lsst::ndarray;
 
 namespace {
 
@@ -130,6 +138,630 @@ include/lsst/afw/image/Pixel.h:212: error: no type named ‘VariancePixelT’ in
         }
     }
     
+    typedef afwImage::Image<afwMath::Kernel::Pixel> KernelImage;
+    typedef nd::Array<afwMath::Kernel::Pixel const, 2, 1> KernelArray;
+
+    /*
+     * Return the kernel to be used by each of nChunk chunks of a convolution
+     *
+     * Computing the image of a spatially varying kernel modifies its parameters, so each chunk after
+     * the first gets its own copy.  The copies are made here, rather than in the threads, as Kernels
+     * are Citizens.
+     */
+    template <typename KernelT>
+    std::vector<KernelT const*> copyKernelForChunks(
+            KernelT const &kernel,  ///< kernel to copy
+            int nChunk,             ///< number of chunks
+            std::vector<afwMath::Kernel::Ptr> &kernelCopies)    ///< the copies; must outlive the result
+    {
+        std::vector<KernelT const*> kernelList(nChunk, &kernel);
+        for (int i = 1; i < nChunk; ++i) {
+            kernelCopies.push_back(kernel.clone());
+            kernelList[i] = dynamic_cast<KernelT const*>(kernelCopies.back().get());
+        }
+        return kernelList;
+    }
+
+    /*
+     * Are OutImageT and InImageT Images or MaskedImages with floating point pixels, and so convolved
+     * a plane at a time using the vectorized row operations in detail/Simd.h?
+     *
+     * Integer images keep the pixel-by-pixel code, whose arithmetic (e.g. the truncation of each product)
+     * the row operations don't reproduce.
+     */
+    template <typename ImageT>
+    struct HasFloatingPointPixels : public boost::false_type {};
+    template <typename PixelT>
+    struct HasFloatingPointPixels<afwImage::Image<PixelT> > : public boost::is_floating_point<PixelT> {};
+    template <typename PixelT>
+    struct HasFloatingPointPixels<afwImage::MaskedImage<PixelT, afwImage::MaskPixel, afwImage::VariancePixel> >
+        : public boost::is_floating_point<PixelT> {};
+
+    template <typename OutImageT, typename InImageT>
+    struct UseRowOperations {
+        static bool const value =
+            HasFloatingPointPixels<OutImageT>::value && HasFloatingPointPixels<InImageT>::value;
+    };
+
+    /*
+     * Correlate rows [yBegin, yEnd) of the good region of an image plane with a kernel image
+     *
+     * The kernel is applied one pixel at a time, so the inner loop runs along a row of the image,
+     * and is vectorized.  Kernel pixels that are 0 are skipped (as in kernelDotProduct), so non-finite
+     * image pixels only affect the output pixels that they contribute to.
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolvePlaneRows(nd::Array<OutPixelT, 2, 1> const &out,    // output plane; same size as in
+                           nd::Array<InPixelT const, 2, 1> const &in, // input plane
+                           KernelArray const &kernel,                // kernel image
+                           bool const isSquared,                     // use the square of the kernel?
+                           int ctrX, int ctrY,                       // kernel centre
+                           int yBegin, int yEnd                      // rows of the good region to set
+                          ) {
+        int const kWidth = kernel.getSize<1>();
+        int const kHeight = kernel.getSize<0>();
+        int const kStride = kernel.getStride<0>();
+        int const cnvWidth = in.template getSize<1>() + 1 - kWidth;
+        int const inStride = in.template getStride<0>();
+        int const outStride = out.template getStride<0>();
+
+        for (int y = yBegin; y != yEnd; ++y) {
+            OutPixelT *outPtr = out.getData() + (ctrY + y)*outStride + ctrX;
+            std::fill(outPtr, outPtr + cnvWidth, 0);
+            for (int ky = 0; ky != kHeight; ++ky) {
+                InPixelT const *inPtr = in.getData() + (y + ky)*inStride;
+                afwMath::Kernel::Pixel const *kPtr = kernel.getData() + ky*kStride;
+                for (int kx = 0; kx != kWidth; ++kx) {
+                    double const kVal = kPtr[kx];
+                    if (kVal != 0) {
+                        mathDetail::addScaledRow(outPtr, inPtr + kx, isSquared ? kVal*kVal : kVal, cnvWidth);
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+     * Set rows [yBegin, yEnd) of the good region of a mask to the OR of the input mask pixels
+     * under the nonzero kernel pixels
+     */
+    void convolveMaskRows(nd::Array<afwImage::MaskPixel, 2, 1> const &out,    // output mask; same size as in
+                          nd::Array<afwImage::MaskPixel const, 2, 1> const &in, // input mask
+                          KernelArray const &kernel,                           // kernel image
+                          int ctrX, int ctrY,                                  // kernel centre
+                          int yBegin, int yEnd                                 // rows of the good region to set
+                         ) {
+        int const kWidth = kernel.getSize<1>();
+        int const kHeight = kernel.getSize<0>();
+        int const kStride = kernel.getStride<0>();
+        int const cnvWidth = in.getSize<1>() + 1 - kWidth;
+        int const inStride = in.getStride<0>();
+        int const outStride = out.getStride<0>();
+
+        for (int y = yBegin; y != yEnd; ++y) {
+            afwImage::MaskPixel *outPtr = out.getData() + (ctrY + y)*outStride + ctrX;
+            std::fill(outPtr, outPtr + cnvWidth, 0);
+            for (int ky = 0; ky != kHeight; ++ky) {
+                afwImage::MaskPixel const *inPtr = in.getData() + (y + ky)*inStride;
+                afwMath::Kernel::Pixel const *kPtr = kernel.getData() + ky*kStride;
+                for (int kx = 0; kx != kWidth; ++kx) {
+                    if (kPtr[kx] != 0) {
+                        mathDetail::orRow(outPtr, inPtr + kx, cnvWidth);
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+     * Correlate rows [yBegin, yEnd) of the good region of an Image with a kernel image, using row operations
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolveRowsByPlane(
+            mathDetail::OutputPlanes<afwImage::Image<OutPixelT> > const &convolvedPlanes,
+            mathDetail::InputPlanes<afwImage::Image<InPixelT> > const &inPlanes,
+            KernelArray const &kernel,
+            int ctrX, int ctrY,
+            int yBegin, int yEnd
+    ) {
+        convolvePlaneRows(convolvedPlanes.image, inPlanes.image, kernel, false, ctrX, ctrY, yBegin, yEnd);
+    }
+
+    /*
+     * Correlate rows [yBegin, yEnd) of the good region of a MaskedImage with a kernel image, using row
+     * operations; the variance is convolved with the square of the kernel
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolveRowsByPlane(
+            mathDetail::OutputPlanes<afwImage::MaskedImage<OutPixelT> > const &convolvedPlanes,
+            mathDetail::InputPlanes<afwImage::MaskedImage<InPixelT> > const &inPlanes,
+            KernelArray const &kernel,
+            int ctrX, int ctrY,
+            int yBegin, int yEnd
+    ) {
+        convolvePlaneRows(convolvedPlanes.image, inPlanes.image, kernel, false, ctrX, ctrY, yBegin, yEnd);
+        convolvePlaneRows(convolvedPlanes.variance, inPlanes.variance, kernel, true, ctrX, ctrY, yBegin, yEnd);
+        convolveMaskRows(convolvedPlanes.mask, inPlanes.mask, kernel, ctrX, ctrY, yBegin, yEnd);
+    }
+
+    /*
+     * Correlate rows [yBegin, yEnd) of the good region of an image plane with a separable kernel
+     *
+     * Each input row is convolved with the kernel x vector into a circular buffer of kernel height rows;
+     * each output row is then the sum of the buffer's rows weighted by the kernel y vector.  As in
+     * convolvePlaneRows, both passes add one (nonzero) kernel pixel's contribution to a whole row at a time.
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolvePlaneRowsSeparable(
+            nd::Array<OutPixelT, 2, 1> const &out,      // output plane; same size as in
+            nd::Array<InPixelT const, 2, 1> const &in,  // input plane
+            std::vector<afwMath::Kernel::Pixel> const &kernelXVec, // kernel x vector
+            std::vector<afwMath::Kernel::Pixel> const &kernelYVec, // kernel y vector
+            bool const isSquared,                       // use the square of the kernel?
+            int ctrX, int ctrY,                         // kernel centre
+            int yBegin, int yEnd                        // rows of the good region to set
+    ) {
+        int const kWidth = kernelXVec.size();
+        int const kHeight = kernelYVec.size();
+        int const cnvWidth = in.template getSize<1>() + 1 - kWidth;
+        int const inStride = in.template getStride<0>();
+        int const outStride = out.template getStride<0>();
+
+        std::vector<OutPixelT> buffer(kHeight*cnvWidth); // x-convolved rows; input row y is in row y%kHeight
+        for (int y = yBegin; y != yEnd + kHeight - 1; ++y) {
+            OutPixelT *bufPtr = &buffer[(y%kHeight)*cnvWidth];
+            std::fill(bufPtr, bufPtr + cnvWidth, 0);
+            InPixelT const *inPtr = in.getData() + y*inStride;
+            for (int kx = 0; kx != kWidth; ++kx) {
+                double const kVal = kernelXVec[kx];
+                if (kVal != 0) {
+                    mathDetail::addScaledRow(bufPtr, inPtr + kx, isSquared ? kVal*kVal : kVal, cnvWidth);
+                }
+            }
+
+            int const cnvY = y + 1 - kHeight;   // the output row that this input row completes
+            if (cnvY < yBegin) {
+                continue;
+            }
+            OutPixelT *outPtr = out.getData() + (ctrY + cnvY)*outStride + ctrX;
+            std::fill(outPtr, outPtr + cnvWidth, 0);
+            for (int ky = 0; ky != kHeight; ++ky) {
+                double const kVal = kernelYVec[ky];
+                if (kVal != 0) {
+                    mathDetail::addScaledRow(outPtr, &buffer[((cnvY + ky)%kHeight)*cnvWidth],
+                                             isSquared ? kVal*kVal : kVal, cnvWidth);
+                }
+            }
+        }
+    }
+
+    /*
+     * Set rows [yBegin, yEnd) of the good region of a mask to the OR of the input mask pixels
+     * under the nonzero pixels of a separable kernel
+     */
+    void convolveMaskRowsSeparable(
+            nd::Array<afwImage::MaskPixel, 2, 1> const &out,        // output mask; same size as in
+            nd::Array<afwImage::MaskPixel const, 2, 1> const &in,   // input mask
+            std::vector<afwMath::Kernel::Pixel> const &kernelXVec,  // kernel x vector
+            std::vector<afwMath::Kernel::Pixel> const &kernelYVec,  // kernel y vector
+            int ctrX, int ctrY,                                     // kernel centre
+            int yBegin, int yEnd                                    // rows of the good region to set
+    ) {
+        int const kWidth = kernelXVec.size();
+        int const kHeight = kernelYVec.size();
+        int const cnvWidth = in.getSize<1>() + 1 - kWidth;
+        int const inStride = in.getStride<0>();
+        int const outStride = out.getStride<0>();
+
+        std::vector<afwImage::MaskPixel> buffer(kHeight*cnvWidth);
+        for (int y = yBegin; y != yEnd + kHeight - 1; ++y) {
+            afwImage::MaskPixel *bufPtr = &buffer[(y%kHeight)*cnvWidth];
+            std::fill(bufPtr, bufPtr + cnvWidth, 0);
+            afwImage::MaskPixel const *inPtr = in.getData() + y*inStride;
+            for (int kx = 0; kx != kWidth; ++kx) {
+                if (kernelXVec[kx] != 0) {
+                    mathDetail::orRow(bufPtr, inPtr + kx, cnvWidth);
+                }
+            }
+
+            int const cnvY = y + 1 - kHeight;
+            if (cnvY < yBegin) {
+                continue;
+            }
+            afwImage::MaskPixel *outPtr = out.getData() + (ctrY + cnvY)*outStride + ctrX;
+            std::fill(outPtr, outPtr + cnvWidth, 0);
+            for (int ky = 0; ky != kHeight; ++ky) {
+                if (kernelYVec[ky] != 0) {
+                    mathDetail::orRow(outPtr, &buffer[((cnvY + ky)%kHeight)*cnvWidth], cnvWidth);
+                }
+            }
+        }
+    }
+
+    /*
+     * Convolve rows [yBegin, yEnd) of the good region of an Image with a separable kernel,
+     * using row operations
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolveRowsByPlaneSeparable(
+            mathDetail::OutputPlanes<afwImage::Image<OutPixelT> > const &convolvedPlanes,
+            mathDetail::InputPlanes<afwImage::Image<InPixelT> > const &inPlanes,
+            std::vector<afwMath::Kernel::Pixel> const &kernelXVec,
+            std::vector<afwMath::Kernel::Pixel> const &kernelYVec,
+            int ctrX, int ctrY,
+            int yBegin, int yEnd
+    ) {
+        convolvePlaneRowsSeparable(convolvedPlanes.image, inPlanes.image, kernelXVec, kernelYVec,
+                                   false, ctrX, ctrY, yBegin, yEnd);
+    }
+
+    /*
+     * Convolve rows [yBegin, yEnd) of the good region of a MaskedImage with a separable kernel,
+     * using row operations; the variance is convolved with the square of the kernel
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolveRowsByPlaneSeparable(
+            mathDetail::OutputPlanes<afwImage::MaskedImage<OutPixelT> > const &convolvedPlanes,
+            mathDetail::InputPlanes<afwImage::MaskedImage<InPixelT> > const &inPlanes,
+            std::vector<afwMath::Kernel::Pixel> const &kernelXVec,
+            std::vector<afwMath::Kernel::Pixel> const &kernelYVec,
+            int ctrX, int ctrY,
+            int yBegin, int yEnd
+    ) {
+        convolvePlaneRowsSeparable(convolvedPlanes.image, inPlanes.image, kernelXVec, kernelYVec,
+                                   false, ctrX, ctrY, yBegin, yEnd);
+        convolvePlaneRowsSeparable(convolvedPlanes.variance, inPlanes.variance, kernelXVec, kernelYVec,
+                                   true, ctrX, ctrY, yBegin, yEnd);
+        convolveMaskRowsSeparable(convolvedPlanes.mask, inPlanes.mask, kernelXVec, kernelYVec,
+                                  ctrX, ctrY, yBegin, yEnd);
+    }
+
+    /*
+     * Convolve one chunk of the rows of an image with a spatially invariant kernel using brute force;
+     * called (possibly in parallel) for each chunk of the rows.
+     *
+     * Floating point images are convolved a plane at a time using row operations (see convolveRowsByPlane);
+     * others a pixel at a time using kernelDotProduct.
+     */
+    template <typename OutImageT, typename InImageT>
+    class ConvolveRowsWithFixedKernel {
+    public:
+        ConvolveRowsWithFixedKernel(
+                OutImageT &convolvedImage,      ///< convolved %image
+                InImageT const &inImage,        ///< %image to convolve
+                KernelImage const &kernelImage, ///< image of the kernel
+                int ctrX,                       ///< x index of kernel center
+                int ctrY,                       ///< y index of kernel center
+                int nChunk)                     ///< number of chunks the rows are divided into
+        :
+            _convolvedImage(convolvedImage),
+            _inImage(inImage),
+            _kernelImage(kernelImage),
+            _convolvedPlanes(convolvedImage),
+            _inPlanes(inImage),
+            _kernelArray(kernelImage.getArray()),
+            _ctrX(ctrX),
+            _ctrY(ctrY),
+            _nChunk(nChunk)
+        { }
+
+        void operator()(int chunk) const {
+            typedef afwMath::Kernel::Pixel KernelPixel;
+            typedef KernelImage::const_x_iterator KernelXIterator;
+            typedef typename InImageT::const_x_iterator InXIterator;
+            typedef typename OutImageT::x_iterator OutXIterator;
+            typedef typename OutImageT::SinglePixel OutPixel;
+
+            int const kWidth = _kernelImage.getWidth();
+            int const kHeight = _kernelImage.getHeight();
+            int const cnvWidth = _inImage.getWidth() + 1 - kWidth;
+            int const cnvHeight = _inImage.getHeight() + 1 - kHeight;
+            int const yBegin = (chunk*cnvHeight)/_nChunk;
+            int const yEnd = ((chunk + 1)*cnvHeight)/_nChunk;
+
+            if (UseRowOperations<OutImageT, InImageT>::value) {
+                convolveRowsByPlane(_convolvedPlanes, _inPlanes, _kernelArray, _ctrX, _ctrY, yBegin, yEnd);
+                return;
+            }
+
+            for (int inStartY = yBegin, cnvY = _ctrY + yBegin; inStartY < yEnd; ++inStartY, ++cnvY) {
+                KernelXIterator kernelXIter = _kernelImage.x_at(0, 0);
+                InXIterator inXIter = _inImage.x_at(0, inStartY);
+                OutXIterator cnvXIter = _convolvedImage.x_at(_ctrX, cnvY);
+                for (int x = 0; x < cnvWidth; ++x, ++cnvXIter, ++inXIter) {
+                    *cnvXIter = kernelDotProduct<OutPixel, InXIterator, KernelXIterator, KernelPixel>(
+                        inXIter, kernelXIter, kWidth);
+                }
+                for (int kernelY = 1, inY = inStartY + 1; kernelY < kHeight; ++inY, ++kernelY) {
+                    KernelXIterator kernelXIter = _kernelImage.x_at(0, kernelY);
+                    InXIterator inXIter = _inImage.x_at(0, inY);
+                    OutXIterator cnvXIter = _convolvedImage.x_at(_ctrX, cnvY);
+                    for (int x = 0; x < cnvWidth; ++x, ++cnvXIter, ++inXIter) {
+                        *cnvXIter += kernelDotProduct<OutPixel, InXIterator, KernelXIterator, KernelPixel>(
+                            inXIter, kernelXIter, kWidth);
+                    }
+                }
+            }
+        }
+
+    private:
+        OutImageT &_convolvedImage;
+        InImageT const &_inImage;
+        KernelImage const &_kernelImage;
+        mathDetail::OutputPlanes<OutImageT> const _convolvedPlanes;
+        mathDetail::InputPlanes<InImageT> const _inPlanes;
+        KernelArray const _kernelArray;
+        int const _ctrX;
+        int const _ctrY;
+        int const _nChunk;
+    };
+
+    /*
+     * Convolve one chunk of the rows of an image with a spatially varying kernel using brute force;
+     * called (possibly in parallel) for each chunk of the rows.
+     *
+     * Each chunk has its own kernel and kernel image.
+     */
+    template <typename OutImageT, typename InImageT>
+    class ConvolveRowsWithVaryingKernel {
+    public:
+        ConvolveRowsWithVaryingKernel(
+                OutImageT &convolvedImage,      ///< convolved %image
+                InImageT const &inImage,        ///< %image to convolve
+                std::vector<afwMath::Kernel const*> const &kernelList,  ///< kernel for each chunk
+                std::vector<KernelImage::Ptr> const &kernelImageList,   ///< kernel image for each chunk
+                bool doNormalize,               ///< if true, normalize the kernel, else use "as is"
+                int nChunk)                     ///< number of chunks the rows are divided into
+        :
+            _convolvedImage(convolvedImage),
+            _inImage(inImage),
+            _kernelList(kernelList),
+            _kernelImageList(kernelImageList),
+            _doNormalize(doNormalize),
+            _nChunk(nChunk)
+        { }
+
+        void operator()(int chunk) const {
+            typedef afwMath::Kernel::Pixel KernelPixel;
+            typedef KernelImage::const_xy_locator KernelXYLocator;
+            typedef typename InImageT::const_xy_locator InXYLocator;
+            typedef typename OutImageT::x_iterator OutXIterator;
+
+            afwMath::Kernel const &kernel = *_kernelList[chunk];
+            KernelImage &kernelImage = *_kernelImageList[chunk];
+            int const kWidth = kernel.getWidth();
+            int const kHeight = kernel.getHeight();
+            int const cnvWidth = _inImage.getWidth() + 1 - kWidth;
+            int const cnvHeight = _inImage.getHeight() + 1 - kHeight;
+            int const cnvStartX = kernel.getCtrX();
+            int const cnvStartY = kernel.getCtrY();
+            int const cnvEndX = cnvStartX + cnvWidth;  // end index + 1
+            int const cnvBeginY = cnvStartY + (chunk*cnvHeight)/_nChunk;
+            int const cnvEndY = cnvStartY + ((chunk + 1)*cnvHeight)/_nChunk; // end index + 1
+            KernelXYLocator const kernelLoc = kernelImage.xy_at(0,0);
+
+            for (int cnvY = cnvBeginY; cnvY != cnvEndY; ++cnvY) {
+                double const rowPos = _inImage.indexToPosition(cnvY, afwImage::Y);
+                
+                InXYLocator  inImLoc =  _inImage.xy_at(0, cnvY - cnvStartY);
+                OutXIterator cnvXIter = _convolvedImage.x_at(cnvStartX, cnvY);
+                for (int cnvX = cnvStartX; cnvX != cnvEndX; ++cnvX, ++inImLoc.x(), ++cnvXIter) {
+                    double const colPos = _inImage.indexToPosition(cnvX, afwImage::X);
+
+                    KernelPixel kSum = kernel.computeImage(kernelImage, false, colPos, rowPos);
+                    *cnvXIter = afwMath::convolveAtAPoint<OutImageT, InImageT>(
+                        inImLoc, kernelLoc, kWidth, kHeight);
+                    if (_doNormalize) {
+                        *cnvXIter = *cnvXIter/kSum;
+                    }
+                }
+            }
+        }
+
+    private:
+        OutImageT &_convolvedImage;
+        InImageT const &_inImage;
+        std::vector<afwMath::Kernel const*> const &_kernelList;
+        std::vector<KernelImage::Ptr> const &_kernelImageList;
+        bool const _doNormalize;
+        int const _nChunk;
+    };
+
+    /*
+     * Convolve one chunk of the good rows of an image with a spatially invariant separable kernel;
+     * called (possibly in parallel) for each chunk of the rows.
+     *
+     * The basic sequence:
+     * - For each output row:
+     * - Compute x-convolved data: a kernel height's strip of input image convolved with kernel x vector
+     * - Compute one row of output by dotting each column of x-convolved data with the kernel y vector
+     * The x-convolved data is stored in a kernel-height by good-width buffer (one per chunk).
+     * This is circular buffer along y (to avoid shifting pixels before setting each new row);
+     * so for each new row the kernel y vector is rotated to match the order of the x-convolved data.
+     *
+     * Floating point images are convolved a plane at a time using row operations
+     * (see convolveRowsByPlaneSeparable), which need no buffer image.
+     */
+    template <typename OutImageT, typename InImageT>
+    class ConvolveRowsWithSeparableKernel {
+    public:
+        typedef std::vector<afwMath::Kernel::Pixel> KernelVector;
+        typedef std::vector<boost::shared_ptr<OutImageT> > BufferList;
+
+        ConvolveRowsWithSeparableKernel(
+                OutImageT &convolvedImage,      ///< convolved %image
+                InImageT const &inImage,        ///< %image to convolve
+                afwGeom::Box2I const &goodBBox, ///< region of convolvedImage to set
+                KernelVector const &kernelXVec, ///< kernel x vector
+                KernelVector const &kernelYVec, ///< kernel y vector
+                BufferList const &bufferList,   ///< buffer for x-convolved data for each chunk;
+                                                ///< unused if UseRowOperations<OutImageT, InImageT>
+                int nChunk)                     ///< number of chunks the rows are divided into
+        :
+            _convolvedImage(convolvedImage),
+            _inImage(inImage),
+            _goodBBox(goodBBox),
+            _kernelXVec(kernelXVec),
+            _kernelYVec(kernelYVec),
+            _bufferList(bufferList),
+            _convolvedPlanes(convolvedImage),
+            _inPlanes(inImage),
+            _nChunk(nChunk)
+        { }
+
+        void operator()(int chunk) const {
+            typedef afwMath::Kernel::Pixel KernelPixel;
+            typedef KernelVector::const_iterator KernelIterator;
+            typedef typename InImageT::const_x_iterator InXIterator;
+            typedef typename OutImageT::x_iterator OutXIterator;
+            typedef typename OutImageT::y_iterator OutYIterator;
+            typedef typename OutImageT::SinglePixel OutPixel;
+
+            int const nGoodRow = _goodBBox.getHeight();
+            int const yBegin = (chunk*nGoodRow)/_nChunk;
+            int const yEnd = ((chunk + 1)*nGoodRow)/_nChunk;
+            if (yBegin == yEnd) {
+                return;
+            }
+            if (UseRowOperations<OutImageT, InImageT>::value) {
+                convolveRowsByPlaneSeparable(_convolvedPlanes, _inPlanes, _kernelXVec, _kernelYVec,
+                                             _goodBBox.getMinX(), _goodBBox.getMinY(), yBegin, yEnd);
+                return;
+            }
+
+            int const kWidth = _kernelXVec.size();
+            int const kHeight = _kernelYVec.size();
+            KernelVector kernelYVec(_kernelYVec); // rotated to match the buffer
+            KernelIterator const kernelXVecBegin = _kernelXVec.begin();
+            KernelIterator const kernelYVecBegin = kernelYVec.begin();
+            OutImageT &buffer = *_bufferList[chunk];
+
+            // pre-fill x-convolved data buffer with all but one row of data
+            int yInd = 0; // during initial fill bufY = inImageY - yBegin
+            int const yPrefillEnd = buffer.getHeight() - 1;
+            for (; yInd < yPrefillEnd; ++yInd) {
+                OutXIterator bufXIter = buffer.x_at(0, yInd);
+                OutXIterator const bufXEnd = buffer.x_at(_goodBBox.getWidth(), yInd);
+                InXIterator inXIter = _inImage.x_at(0, yBegin + yInd);
+                for ( ; bufXIter != bufXEnd; ++bufXIter, ++inXIter) {
+                    *bufXIter = kernelDotProduct<OutPixel, InXIterator, KernelIterator, KernelPixel>(
+                        inXIter, kernelXVecBegin, kWidth);
+                }
+            }
+
+            // compute output pixels using the sequence described above
+            int inY = yBegin + yPrefillEnd;
+            int bufY = yPrefillEnd;
+            int cnvY = _goodBBox.getMinY() + yBegin;
+            int const cnvEndY = _goodBBox.getMinY() + yEnd;  // end index + 1
+            while (true) {
+                // fill next buffer row and compute output row
+                InXIterator inXIter = _inImage.x_at(0, inY);
+                OutXIterator bufXIter = buffer.x_at(0, bufY);
+                OutXIterator cnvXIter = _convolvedImage.x_at(_goodBBox.getMinX(), cnvY);
+                for (int bufX = 0; bufX < _goodBBox.getWidth(); ++bufX, ++cnvXIter, ++bufXIter, ++inXIter) {
+                    // note: bufXIter points to the row of the buffer that is being updated,
+                    // whereas bufYIter points to row 0 of the buffer
+                    *bufXIter = kernelDotProduct<OutPixel, InXIterator, KernelIterator, KernelPixel>(
+                        inXIter, kernelXVecBegin, kWidth);
+
+                    OutYIterator bufYIter = buffer.y_at(bufX, 0);
+                    *cnvXIter = kernelDotProduct<OutPixel, OutYIterator, KernelIterator, KernelPixel>(
+                        bufYIter, kernelYVecBegin, kHeight);
+                }
+
+                // test for done now, instead of the start of the loop,
+                // to avoid an unnecessary extra rotation of the kernel Y vector
+                if (cnvY + 1 >= cnvEndY) break;
+
+                // update y indices, including bufY, and rotate the kernel y vector to match
+                ++inY;
+                bufY = (bufY + 1) % kHeight;
+                ++cnvY;
+                std::rotate(kernelYVec.begin(), kernelYVec.end()-1, kernelYVec.end());
+            }
+        }
+
+    private:
+        OutImageT &_convolvedImage;
+        InImageT const &_inImage;
+        afwGeom::Box2I const _goodBBox;
+        KernelVector const &_kernelXVec;
+        KernelVector const &_kernelYVec;
+        BufferList const &_bufferList;
+        mathDetail::OutputPlanes<OutImageT> const _convolvedPlanes;
+        mathDetail::InputPlanes<InImageT> const _inPlanes;
+        int const _nChunk;
+    };
+
+    /*
+     * Convolve one chunk of the good rows of an image with a spatially varying separable kernel;
+     * called (possibly in parallel) for each chunk of the rows.
+     *
+     * Each chunk has its own kernel.
+     */
+    template <typename OutImageT, typename InImageT>
+    class ConvolveRowsWithVaryingSeparableKernel {
+    public:
+        ConvolveRowsWithVaryingSeparableKernel(
+                OutImageT &convolvedImage,      ///< convolved %image
+                InImageT const &inImage,        ///< %image to convolve
+                afwGeom::Box2I const &goodBBox, ///< region of convolvedImage to set
+                std::vector<afwMath::SeparableKernel const*> const &kernelList, ///< kernel for each chunk
+                bool doNormalize,               ///< if true, normalize the kernel, else use "as is"
+                int nChunk)                     ///< number of chunks the rows are divided into
+        :
+            _convolvedImage(convolvedImage),
+            _inImage(inImage),
+            _goodBBox(goodBBox),
+            _kernelList(kernelList),
+            _doNormalize(doNormalize),
+            _nChunk(nChunk)
+        { }
+
+        void operator()(int chunk) const {
+            typedef afwMath::Kernel::Pixel KernelPixel;
+            typedef std::vector<KernelPixel> KernelVector;
+            typedef typename InImageT::const_xy_locator InXYLocator;
+            typedef typename OutImageT::x_iterator OutXIterator;
+
+            afwMath::SeparableKernel const &kernel = *_kernelList[chunk];
+            KernelVector kernelXVec(kernel.getWidth());
+            KernelVector kernelYVec(kernel.getHeight());
+            int const nGoodRow = _goodBBox.getHeight();
+            int const cnvBeginY = _goodBBox.getMinY() + (chunk*nGoodRow)/_nChunk;
+            int const cnvEndY = _goodBBox.getMinY() + ((chunk + 1)*nGoodRow)/_nChunk; // end index + 1
+
+            for (int cnvY = cnvBeginY; cnvY != cnvEndY; ++cnvY) {
+                double const rowPos = _inImage.indexToPosition(cnvY, afwImage::Y);
+                
+                InXYLocator inImLoc = _inImage.xy_at(0, cnvY - _goodBBox.getMinY());
+                OutXIterator cnvXIter = _convolvedImage.row_begin(cnvY) + _goodBBox.getMinX();
+                for (int cnvX = _goodBBox.getMinX(); cnvX <= _goodBBox.getMaxX();
+                    ++cnvX, ++inImLoc.x(), ++cnvXIter) {
+                    double const colPos = _inImage.indexToPosition(cnvX, afwImage::X);
+
+                    KernelPixel kSum = kernel.computeVectors(kernelXVec, kernelYVec,
+                        _doNormalize, colPos, rowPos);
+
+                    // why does this trigger warnings? It did not in the past.
+                    *cnvXIter = afwMath::convolveAtAPoint<OutImageT, InImageT>(inImLoc, kernelXVec, kernelYVec);
+                    if (_doNormalize) {
+                        *cnvXIter = *cnvXIter/kSum;
+                    }
+                }
+            }
+        }
+
+    private:
+        OutImageT &_convolvedImage;
+        InImageT const &_inImage;
+        afwGeom::Box2I const _goodBBox;
+        std::vector<afwMath::SeparableKernel const*> const &_kernelList;
+        bool const _doNormalize;
+        int const _nChunk;
+    };
+    
 }   // anonymous namespace
 
 /**
@@ -186,11 +818,17 @@ void mathDetail::basicConvolve(
         pexLog::TTrace<3>("lsst.afw.math.convolve", "generic basicConvolve: using linear interpolation");
         mathDetail::convolveWithInterpolation(convolvedImage, inImage, kernel, convolutionControl);
 
+    } else if (mathDetail::isFftConvolutionPreferred(kernel, convolutionControl)) {
+        // large spatially invariant kernel; use FFTs
+        pexLog::TTrace<3>("lsst.afw.math.convolve", "generic basicConvolve: using FFTs");
+        mathDetail::convolveWithFft(convolvedImage, inImage, kernel,
+            convolutionControl.getDoNormalize(), convolutionControl.getNumThreads());
+
     } else {
         // use brute force
         pexLog::TTrace<3>("lsst.afw.math.convolve", "generic basicConvolve: using brute force");
         mathDetail::convolveWithBruteForce(convolvedImage, inImage, kernel,
-            convolutionControl.getDoNormalize());
+            convolutionControl.getDoNormalize(), convolutionControl.getNumThreads());
     }
 }
 
@@ -251,12 +889,18 @@ void mathDetail::basicConvolve(
     afwMath::LinearCombinationKernel const& kernel,         ///< convolution kernel
     afwMath::ConvolutionControl const & convolutionControl) ///< convolution control parameters
 {
-    if (!kernel.isSpatiallyVarying()) {
+    if (mathDetail::isFftConvolutionPreferred(kernel, convolutionControl)) {
+        // a large spatially invariant kernel is fastest in Fourier space
+        pexLog::TTrace<3>("lsst.afw.math.convolve",
+            "basicConvolve for LinearCombinationKernel: spatially invariant; using FFTs");
+        return mathDetail::convolveWithFft(convolvedImage, inImage, kernel,
+            convolutionControl.getDoNormalize(), convolutionControl.getNumThreads());
+    } else if (!kernel.isSpatiallyVarying()) {
         // use the standard algorithm for the spatially invariant case
         pexLog::TTrace<3>("lsst.afw.math.convolve",
             "basicConvolve for LinearCombinationKernel: spatially invariant; using brute force");
         return mathDetail::convolveWithBruteForce(convolvedImage, inImage, kernel,
-            convolutionControl.getDoNormalize());
+            convolutionControl.getDoNormalize(), convolutionControl.getNumThreads());
     } else {
         // refactor the kernel if this is reasonable and possible;
         // then use the standard algorithm for the spatially varying case
@@ -279,7 +923,7 @@ void mathDetail::basicConvolve(
             pexLog::TTrace<3>("lsst.afw.math.convolve",
                 "basicConvolve for LinearCombinationKernel: maxInterpolationError < 0; using brute force");
             return mathDetail::convolveWithBruteForce(convolvedImage, inImage, *refKernelPtr,
-                convolutionControl.getDoNormalize());
+                convolutionControl.getDoNormalize(), convolutionControl.getNumThreads());
         }
     }
 }
@@ -287,6 +931,8 @@ void mathDetail::basicConvolve(
 /**
  * @brief A version of basicConvolve that should be used when convolving separable kernels
  *
+ * The rows of the output are divided between convolutionControl.getNumThreads() threads.
+ *
  * @ingroup afw
  */
 template <typename OutImageT, typename InImageT>
@@ -298,107 +944,43 @@ void mathDetail::basicConvolve(
 {
     typedef typename afwMath::Kernel::Pixel KernelPixel;
     typedef typename std::vector<KernelPixel> KernelVector;
-    typedef KernelVector::const_iterator KernelIterator;
-    typedef typename InImageT::const_x_iterator InXIterator;
-    typedef typename InImageT::const_xy_locator InXYLocator;
-    typedef typename OutImageT::x_iterator OutXIterator;
-    typedef typename OutImageT::y_iterator OutYIterator;
-    typedef typename OutImageT::SinglePixel OutPixel;
 
     assertDimensionsOK(convolvedImage, inImage, kernel);
     
     afwGeom::Box2I const fullBBox = inImage.getBBox(image::LOCAL);
     afwGeom::Box2I const goodBBox = kernel.shrinkBBox(fullBBox);
+    int const nChunk = std::min(getNumThreads(convolutionControl.getNumThreads()), goodBBox.getHeight());
 
-    KernelVector kernelXVec(kernel.getWidth());
-    KernelVector kernelYVec(kernel.getHeight());
-    
     if (kernel.isSpatiallyVarying()) {
         pexLog::TTrace<3>("lsst.afw.math.convolve",
             "SeparableKernel basicConvolve: kernel is spatially varying");
 
-        for (int cnvY = goodBBox.getMinY(); cnvY <= goodBBox.getMaxY(); ++cnvY) {
-            double const rowPos = inImage.indexToPosition(cnvY, afwImage::Y);
-            
-            InXYLocator inImLoc = inImage.xy_at(0, cnvY - goodBBox.getMinY());
-            OutXIterator cnvXIter = convolvedImage.row_begin(cnvY) + goodBBox.getMinX();
-            for (int cnvX = goodBBox.getMinX(); cnvX <= goodBBox.getMaxX();
-                ++cnvX, ++inImLoc.x(), ++cnvXIter) {
-                double const colPos = inImage.indexToPosition(cnvX, afwImage::X);
-
-                KernelPixel kSum = kernel.computeVectors(kernelXVec, kernelYVec,
-                    convolutionControl.getDoNormalize(), colPos, rowPos);
-
-                // why does this trigger warnings? It did not in the past.
-                *cnvXIter = afwMath::convolveAtAPoint<OutImageT, InImageT>(inImLoc, kernelXVec, kernelYVec);
-                if (convolutionControl.getDoNormalize()) {
-                    *cnvXIter = *cnvXIter/kSum;
-                }
-            }
-        }
+        std::vector<afwMath::Kernel::Ptr> kernelCopies;
+        std::vector<afwMath::SeparableKernel const*> const kernelList =
+            copyKernelForChunks(kernel, nChunk, kernelCopies);
+        parallelFor(0, nChunk,
+                    ConvolveRowsWithVaryingSeparableKernel<OutImageT, InImageT>(
+                        convolvedImage, inImage, goodBBox, kernelList,
+                        convolutionControl.getDoNormalize(), nChunk),
+                    nChunk);
     } else {
-        // kernel is spatially invariant
-        // The basic sequence:
-        // - For each output row:
-        // - Compute x-convolved data: a kernel height's strip of input image convolved with kernel x vector
-        // - Compute one row of output by dotting each column of x-convolved data with the kernel y vector
-        // The x-convolved data is stored in a kernel-height by good-width buffer.
-        // This is circular buffer along y (to avoid shifting pixels before setting each new row);
-        // so for each new row the kernel y vector is rotated to match the order of the x-convolved data.
-
         pexLog::TTrace<3>("lsst.afw.math.convolve",
             "SeparableKernel basicConvolve: kernel is spatially invariant");
 
+        KernelVector kernelXVec(kernel.getWidth());
+        KernelVector kernelYVec(kernel.getHeight());
         kernel.computeVectors(kernelXVec, kernelYVec, convolutionControl.getDoNormalize());
-        KernelIterator const kernelXVecBegin = kernelXVec.begin();
-        KernelIterator const kernelYVecBegin = kernelYVec.begin();
-
-        // buffer for x-convolved data
-        OutImageT buffer(afwGeom::Extent2I(goodBBox.getWidth(), kernel.getHeight()));
-        
-        // pre-fill x-convolved data buffer with all but one row of data
-        int yInd = 0; // during initial fill bufY = inImageY
-        int const yPrefillEnd = buffer.getHeight() - 1;
-        for (; yInd < yPrefillEnd; ++yInd) {
-            OutXIterator bufXIter = buffer.x_at(0, yInd);
-            OutXIterator const bufXEnd = buffer.x_at(goodBBox.getWidth(), yInd);
-            InXIterator inXIter = inImage.x_at(0, yInd);
-            for ( ; bufXIter != bufXEnd; ++bufXIter, ++inXIter) {
-                *bufXIter = kernelDotProduct<OutPixel, InXIterator, KernelIterator, KernelPixel>(
-                    inXIter, kernelXVecBegin, kernel.getWidth());
-            }
-        }
 
-        // compute output pixels using the sequence described above
-        int inY = yPrefillEnd;
-        int bufY = yPrefillEnd;
-        int cnvY = goodBBox.getMinY();
-        while (true) {
-            // fill next buffer row and compute output row
-            InXIterator inXIter = inImage.x_at(0, inY);
-            OutXIterator bufXIter = buffer.x_at(0, bufY);
-            OutXIterator cnvXIter = convolvedImage.x_at(goodBBox.getMinX(), cnvY);
-            for (int bufX = 0; bufX < goodBBox.getWidth(); ++bufX, ++cnvXIter, ++bufXIter, ++inXIter) {
-                // note: bufXIter points to the row of the buffer that is being updated,
-                // whereas bufYIter points to row 0 of the buffer
-                *bufXIter = kernelDotProduct<OutPixel, InXIterator, KernelIterator, KernelPixel>(
-                    inXIter, kernelXVecBegin, kernel.getWidth());
-
-                OutYIterator bufYIter = buffer.y_at(bufX, 0);
-                *cnvXIter = kernelDotProduct<OutPixel, OutYIterator, KernelIterator, KernelPixel>(
-                    bufYIter, kernelYVecBegin, kernel.getHeight());
-            }
-            
-            // test for done now, instead of the start of the loop,
-            // to avoid an unnecessary extra rotation of the kernel Y vector
-            if (cnvY >= goodBBox.getMaxY()) break;
-            
-            // update y indices, including bufY, and rotate the kernel y vector to match
-            ++inY;
-            bufY = (bufY + 1) % kernel.getHeight();
-            ++cnvY;
-            std::rotate(kernelYVec.begin(), kernelYVec.end()-1, kernelYVec.end());
+        // each chunk needs its own buffer for x-convolved data (unless it's working a plane at a time)
+        std::vector<boost::shared_ptr<OutImageT> > bufferList;
+        for (int i = 0; i != nChunk && !UseRowOperations<OutImageT, InImageT>::value; ++i) {
+            bufferList.push_back(boost::shared_ptr<OutImageT>(
+                new OutImageT(afwGeom::Extent2I(goodBBox.getWidth(), kernel.getHeight()))));
         }
+        parallelFor(0, nChunk,
+                    ConvolveRowsWithSeparableKernel<OutImageT, InImageT>(
+                        convolvedImage, inImage, goodBBox, kernelXVec, kernelYVec, bufferList, nChunk),
+                    nChunk);
     }
 }
 
@@ -415,6 +997,9 @@ void mathDetail::basicConvolve(
  * - kernel.getWidth()  - 1 - kernel.getCtrX() along the right edge
  * - kernel.getHeight() - 1 - kernel.getCtrY() along the top edge
  *
+ * The rows of the output are divided between nThread threads; a spatially varying kernel is copied
+ * for each thread, as computing its image modifies its parameters.
+ *
  * @throw lsst::pex::exceptions::InvalidParameterException if convolvedImage dimensions != inImage dimensions
  * @throw lsst::pex::exceptions::InvalidParameterException if inImage smaller than kernel in width or height
  * @throw lsst::pex::exceptions::InvalidParameterException if kernel width or height < 1
@@ -426,77 +1011,39 @@ void mathDetail::convolveWithBruteForce(
         OutImageT &convolvedImage,      ///< convolved %image
         InImageT const& inImage,        ///< %image to convolve
         afwMath::Kernel const& kernel,  ///< convolution kernel
-        bool doNormalize)               ///< if true, normalize the kernel, else use "as is"
+        bool doNormalize,               ///< if true, normalize the kernel, else use "as is"
+        int nThread)                    ///< number of threads to use; <= 0 means one per core
 {
-    typedef typename afwMath::Kernel::Pixel KernelPixel;
-    typedef afwImage::Image<KernelPixel> KernelImage;
-
-    typedef typename KernelImage::const_x_iterator KernelXIterator;
-    typedef typename KernelImage::const_xy_locator KernelXYLocator;
-    typedef typename InImageT::const_x_iterator InXIterator;
-    typedef typename InImageT::const_xy_locator InXYLocator;
-    typedef typename OutImageT::x_iterator OutXIterator;
-    typedef typename OutImageT::SinglePixel OutPixel;
-
     assertDimensionsOK(convolvedImage, inImage, kernel);
     
-    int const inImageWidth = inImage.getWidth();
-    int const inImageHeight = inImage.getHeight();
-    int const kWidth = kernel.getWidth();
-    int const kHeight = kernel.getHeight();
-    int const cnvWidth = inImageWidth + 1 - kernel.getWidth();
-    int const cnvHeight = inImageHeight + 1 - kernel.getHeight();
-    int const cnvStartX = kernel.getCtrX();
-    int const cnvStartY = kernel.getCtrY();
-    int const cnvEndX = cnvStartX + cnvWidth;  // end index + 1
-    int const cnvEndY = cnvStartY + cnvHeight; // end index + 1
-
-    KernelImage kernelImage(kernel.getDimensions());
-    KernelXYLocator const kernelLoc = kernelImage.xy_at(0,0);
+    int const cnvHeight = inImage.getHeight() + 1 - kernel.getHeight();
+    int const nChunk = std::min(getNumThreads(nThread), cnvHeight);
 
     if (kernel.isSpatiallyVarying()) {
         pexLog::TTrace<5>("lsst.afw.math.convolve",
             "convolveWithBruteForce: kernel is spatially varying");
 
-        for (int cnvY = cnvStartY; cnvY != cnvEndY; ++cnvY) {
-            double const rowPos = inImage.indexToPosition(cnvY, afwImage::Y);
-            
-            InXYLocator  inImLoc =  inImage.xy_at(0, cnvY - cnvStartY);
-            OutXIterator cnvXIter = convolvedImage.x_at(cnvStartX, cnvY);
-            for (int cnvX = cnvStartX; cnvX != cnvEndX; ++cnvX, ++inImLoc.x(), ++cnvXIter) {
-                double const colPos = inImage.indexToPosition(cnvX, afwImage::X);
-
-                KernelPixel kSum = kernel.computeImage(kernelImage, false, colPos, rowPos);
-                *cnvXIter = afwMath::convolveAtAPoint<OutImageT, InImageT>(
-                    inImLoc, kernelLoc, kWidth, kHeight);
-                if (doNormalize) {
-                    *cnvXIter = *cnvXIter/kSum;
-                }
-            }
+        std::vector<afwMath::Kernel::Ptr> kernelCopies;
+        std::vector<afwMath::Kernel const*> const kernelList =
+            copyKernelForChunks(kernel, nChunk, kernelCopies);
+        std::vector<KernelImage::Ptr> kernelImageList;
+        for (int i = 0; i != nChunk; ++i) {
+            kernelImageList.push_back(KernelImage::Ptr(new KernelImage(kernel.getDimensions())));
         }
+        parallelFor(0, nChunk,
+                    ConvolveRowsWithVaryingKernel<OutImageT, InImageT>(
+                        convolvedImage, inImage, kernelList, kernelImageList, doNormalize, nChunk),
+                    nChunk);
     } else {
         pexLog::TTrace<5>("lsst.afw.math.convolve",
             "convolveWithBruteForce: kernel is spatially invariant");
+        KernelImage kernelImage(kernel.getDimensions());
         (void)kernel.computeImage(kernelImage, doNormalize);
-        
-        for (int inStartY = 0, cnvY = cnvStartY; inStartY < cnvHeight; ++inStartY, ++cnvY) {
-            KernelXIterator kernelXIter = kernelImage.x_at(0, 0);
-            InXIterator inXIter = inImage.x_at(0, inStartY);
-            OutXIterator cnvXIter = convolvedImage.x_at(cnvStartX, cnvY);
-            for (int x = 0; x < cnvWidth; ++x, ++cnvXIter, ++inXIter) {
-                *cnvXIter = kernelDotProduct<OutPixel, InXIterator, KernelXIterator, KernelPixel>(
-                    inXIter, kernelXIter, kWidth);
-            }
-            for (int kernelY = 1, inY = inStartY + 1; kernelY < kHeight; ++inY, ++kernelY) {
-                KernelXIterator kernelXIter = kernelImage.x_at(0, kernelY);
-                InXIterator inXIter = inImage.x_at(0, inY);
-                OutXIterator cnvXIter = convolvedImage.x_at(cnvStartX, cnvY);
-                for (int x = 0; x < cnvWidth; ++x, ++cnvXIter, ++inXIter) {
-                    *cnvXIter += kernelDotProduct<OutPixel, InXIterator, KernelXIterator, KernelPixel>(
-                        inXIter, kernelXIter, kWidth);
-                }
-            }
-        }
+
+        parallelFor(0, nChunk,
+                    ConvolveRowsWithFixedKernel<OutImageT, InImageT>(
+                        convolvedImage, inImage, kernelImage, kernel.getCtrX(), kernel.getCtrY(), nChunk),
+                    nChunk);
     }
 }
 
@@ -522,7 +1069,7 @@ void mathDetail::convolveWithBruteForce(
         IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&, afwMath::SeparableKernel const&, \
             afwMath::ConvolutionControl const&); NL \
     template void mathDetail::convolveWithBruteForce( \
-        IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&, afwMath::Kernel const&, bool);
+        IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&, afwMath::Kernel const&, bool, int);
 // Instantiate both Image and MaskedImage versions
 #define INSTANTIATE(OUTPIXTYPE, INPIXTYPE) \
     INSTANTIATE_IM_OR_MI(IMAGE,       OUTPIXTYPE, INPIXTYPE) \
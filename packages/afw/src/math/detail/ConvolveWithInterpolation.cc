@@ -38,6 +38,7 @@
 #include <iostream>
 
 #include "boost/cstdint.hpp" 
+#include "boost/shared_ptr.hpp"
 
 #include "lsst/pex/exceptions.h"
 #include "lsst/pex/logging/Trace.h"
@@ -45,6 +46,7 @@
 #include "lsst/afw/math.h"
 #include "lsst/afw/geom.h"
 #include "lsst/afw/math/detail/Convolve.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace pexExcept = lsst::pex::exceptions;
 namespace pexLog = lsst::pex::logging;
@@ -53,6 +55,53 @@ namespace afwImage = lsst::afw::image;
 namespace afwMath = lsst::afw::math;
 namespace mathDetail = lsst::afw::math::detail;
 
+namespace {
+
+    typedef std::vector<boost::shared_ptr<mathDetail::ConvolveWithInterpolationWorkingImages> >
+        WorkingImagesList;
+
+    /*
+     * Convolve one chunk of a row of regions;  called (possibly in parallel) for each chunk of the row.
+     *
+     * Each chunk has its own working images, and the regions' kernel images must already have been computed
+     */
+    template <typename OutImageT, typename InImageT>
+    class ConvolveRegionsWithInterpolation {
+    public:
+        ConvolveRegionsWithInterpolation(
+                OutImageT &outImage,        ///< convolved image = inImage convolved with kernel
+                InImageT const &inImage,    ///< input image
+                mathDetail::RowOfKernelImagesForRegion const &regionRow,    ///< row of regions to convolve
+                WorkingImagesList const &workingImagesList, ///< working kernel images for each chunk
+                int nChunk)                 ///< number of chunks the row is divided into
+        :
+            _outImage(outImage),
+            _inImage(inImage),
+            _regionRow(regionRow),
+            _workingImagesList(workingImagesList),
+            _nChunk(nChunk)
+        { }
+
+        void operator()(int chunk) const {
+            int const nRegion = _regionRow.getNX();
+            int const begin = (chunk*nRegion)/_nChunk;
+            int const end = ((chunk + 1)*nRegion)/_nChunk;
+            for (int i = begin; i != end; ++i) {
+                mathDetail::convolveRegionWithInterpolation(_outImage, _inImage, *_regionRow.getRegion(i),
+                    *_workingImagesList[chunk]);
+            }
+        }
+
+    private:
+        OutImageT &_outImage;
+        InImageT const &_inImage;
+        mathDetail::RowOfKernelImagesForRegion const &_regionRow;
+        WorkingImagesList const &_workingImagesList;
+        int const _nChunk;
+    };
+
+}   // anonymous namespace
+
 /**
  * @brief Convolve an Image or MaskedImage with a spatially varying Kernel using linear interpolation.
  *
@@ -107,7 +156,13 @@ void mathDetail::convolveWithInterpolation(
     pexLog::TTrace<4>("lsst.afw.math.convolve",
         "convolveWithInterpolation: divide into %d x %d subregions", nx, ny);
 
-    ConvolveWithInterpolationWorkingImages workingImages(kernel.getDimensions());
+    // the regions of each row are shared between the threads, each with its own working images
+    int const nChunk = std::min(getNumThreads(convolutionControl.getNumThreads()), nx);
+    WorkingImagesList workingImagesList;
+    for (int i = 0; i != nChunk; ++i) {
+        workingImagesList.push_back(WorkingImagesList::value_type(
+            new ConvolveWithInterpolationWorkingImages(kernel.getDimensions())));
+    }
     RowOfKernelImagesForRegion regionRow(nx, ny);
     while (goodRegion.computeNextRow(regionRow)) {
         for (RowOfKernelImagesForRegion::ConstIterator rgnIter = regionRow.begin(), rgnEnd = regionRow.end();
@@ -116,8 +171,16 @@ void mathDetail::convolveWithInterpolation(
                 "convolveWithInterpolation: bbox minimum=(%d, %d), extent=(%d, %d)",
                     (*rgnIter)->getBBox().getMinX(), (*rgnIter)->getBBox().getMinY(),
                     (*rgnIter)->getBBox().getWidth(), (*rgnIter)->getBBox().getHeight());
-            convolveRegionWithInterpolation(outImage, inImage, **rgnIter, workingImages);
+            // the kernel images are computed on demand, which must not happen in parallel
+            (*rgnIter)->getImage(KernelImagesForRegion::BOTTOM_LEFT);
+            (*rgnIter)->getImage(KernelImagesForRegion::BOTTOM_RIGHT);
+            (*rgnIter)->getImage(KernelImagesForRegion::TOP_LEFT);
+            (*rgnIter)->getImage(KernelImagesForRegion::TOP_RIGHT);
         }
+        parallelFor(0, nChunk,
+                    ConvolveRegionsWithInterpolation<OutImageT, InImageT>(
+                        outImage, inImage, regionRow, workingImagesList, nChunk),
+                    nChunk);
     }
 }
 
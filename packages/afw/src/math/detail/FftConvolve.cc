@@ -0,0 +1,689 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file
+ *
+ * @brief Definition of convolveWithFft and isFftConvolutionPreferred, declared in detail/Convolve.h
+ *
+ * @ingroup afw
+ */
+#include <algorithm>
+#include <complex>
+#include <limits>
+#include <list>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "boost/cstdint.hpp"
+#include "boost/noncopyable.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "lsst/ndarray.h"
+#include "lsst/ndarray/fft.h"
+#include "lsst/utils/ieee.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/pex/logging/Trace.h"
+#include "lsst/afw/image.h"
+#include "lsst/afw/math.h"
+#include "lsst/afw/geom.h"
+#include "lsst/afw/math/detail/Convolve.h"
+#include "lsst/afw/math/detail/Parallel.h"
+#include "lsst/afw/math/detail/Simd.h"
+
+namespace pexExcept = lsst::pex::exceptions;
+namespace pexLog = lsst::pex::logging;
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
+namespace nd = lsst::ndarray;
+
+namespace {
+
+    typedef nd::FourierTransform<double, 2> FourierTransform;
+    typedef nd::Array<afwMath::Kernel::Pixel const, 2, 1> KernelArray;
+
+    /*
+     * A pair of FFTW plans that transform a real array to Fourier space and back again
+     *
+     * The plans share their arrays, so a workspace may only be used by one thread at a time.
+     */
+    struct FftWorkspace : private boost::noncopyable {
+        typedef boost::shared_ptr<FftWorkspace> Ptr;
+
+        FftWorkspace(int nRows, int nCols) :
+            shape(nd::makeVector(nRows, nCols)),
+            x(),
+            k(),
+            forward(FourierTransform::planForward(shape, x, k)),
+            inverse(FourierTransform::planInverse(shape, k, x))
+        { }
+
+        FourierTransform::Index const shape; // shape of the real-space array
+        FourierTransform::ArrayX x;         // real-space array
+        FourierTransform::ArrayK k;         // Fourier-space array
+        FourierTransform::Ptr forward;      // plan to transform x into k
+        FourierTransform::Ptr inverse;      // plan to transform k into x (unnormalised)
+    };
+
+    /*
+     * A cache of FftWorkspaces, so that the (expensive) FFTW plans may be reused by later convolutions
+     *
+     * Workspaces are checked out while they're in use, so concurrent convolutions never share one;
+     * the FFTW planner isn't thread safe, so all plans are made and destroyed under the cache's mutex.
+     * At most MaxIdle idle workspaces are kept (each holds two image-sized arrays); when there are
+     * more, the least recently released is destroyed.
+     */
+    class FftWorkspaceCache : private boost::noncopyable {
+    public:
+        enum { MaxIdle = 16 };
+
+        FftWorkspace::Ptr acquire(int nRows, int nCols) {
+            boost::mutex::scoped_lock lock(_mutex);
+            for (std::list<FftWorkspace::Ptr>::iterator i = _idle.begin(); i != _idle.end(); ++i) {
+                if ((*i)->shape[0] == nRows && (*i)->shape[1] == nCols) {
+                    FftWorkspace::Ptr ws = *i;
+                    _idle.erase(i);
+                    return ws;
+                }
+            }
+            pexLog::TTrace<5>("lsst.afw.math.convolve",
+                              "convolveWithFft: making FFTW plans for %d x %d", nCols, nRows);
+            return FftWorkspace::Ptr(new FftWorkspace(nRows, nCols));
+        }
+
+        void release(FftWorkspace::Ptr &ws) {
+            boost::mutex::scoped_lock lock(_mutex);
+            _idle.push_front(ws);
+            ws.reset();                 // so that the plans are never destroyed outside the lock
+            while (_idle.size() > MaxIdle) {
+                _idle.pop_back();
+            }
+        }
+
+        void clear() {
+            boost::mutex::scoped_lock lock(_mutex);
+            _idle.clear();
+        }
+
+    private:
+        boost::mutex _mutex;
+        std::list<FftWorkspace::Ptr> _idle; // idle workspaces, most recently released first
+    };
+
+    FftWorkspaceCache fftWorkspaceCache;
+
+    /*
+     * An FftWorkspace checked out of the cache for the lifetime of this object
+     */
+    class CachedFftWorkspace : private boost::noncopyable {
+    public:
+        CachedFftWorkspace(int nRows, int nCols) : _ws(fftWorkspaceCache.acquire(nRows, nCols)) {}
+        ~CachedFftWorkspace() {
+            try {
+                fftWorkspaceCache.release(_ws);
+            } catch (...) {                 // we just lose the chance to reuse the plans
+                ;
+            }
+        }
+
+        FftWorkspace &operator*() const { return *_ws; }
+
+    private:
+        FftWorkspace::Ptr _ws;
+    };
+
+    /*
+     * Return the length of the FFTs used to convolve an image with a kernel (along one axis)
+     *
+     * The image is processed in tiles about 4 times the size of the kernel, but not less than 256 pixels
+     * (or the whole image, if that's smaller); the length is rounded up to a product of small primes,
+     * which FFTW handles efficiently.
+     */
+    int getFftLength(int imageLength,   // length of image
+                     int kernelLength   // length of kernel
+                    ) {
+        int const minFftLength = 256;
+        int n = std::min(imageLength, std::max(4*kernelLength, minFftLength));
+        for (;; ++n) {
+            int m = n;
+            int const nPrime = 4;
+            int const primes[nPrime] = {2, 3, 5, 7};
+            for (int i = 0; i != nPrime; ++i) {
+                while (m%primes[i] == 0) {
+                    m /= primes[i];
+                }
+            }
+            if (m == 1) {
+                return n;
+            }
+        }
+    }
+
+    /*
+     * Return the Fourier transform of a kernel (or of its square, for the variance) at the size of ws,
+     * conjugated so that multiplying by it correlates with the kernel (as convolveWithBruteForce does),
+     * and scaled to normalise the inverse transform.
+     */
+    FourierTransform::ArrayK transformKernel(FftWorkspace &ws,
+                                             KernelArray const &kernel,
+                                             bool const isSquared
+                                            ) {
+        ws.x.deep() = 0.0;
+        for (int y = 0; y != kernel.getSize<0>(); ++y) {
+            for (int x = 0; x != kernel.getSize<1>(); ++x) {
+                double const value = kernel[y][x];
+                ws.x[y][x] = isSquared ? value*value : value;
+            }
+        }
+        ws.forward->execute();
+
+        FourierTransform::ArrayK kernelK = nd::copy(ws.k);
+        double const scale = 1.0/ws.shape.product();
+        for (std::complex<double> *ptr = kernelK.getData(), *end = ptr + kernelK.getNumElements();
+             ptr != end; ++ptr) {
+            *ptr = std::conj(*ptr)*scale;
+        }
+        return kernelK;
+    }
+
+    /*
+     * Copy a tile of an image plane into the real-space array of ws, padding with zeros
+     *
+     * @return false (leaving ws in an undefined state) if the tile contains any NaN or infinite pixels;
+     * their values would propagate to every pixel of the transform.
+     */
+    template <typename InPixelT>
+    bool loadTile(FftWorkspace &ws,
+                  nd::Array<InPixelT const, 2, 1> const &in, // image plane
+                  int x0, int y0,                           // origin of tile in image plane
+                  int width, int height                     // dimensions of tile
+                 ) {
+        int const inStride = in.template getStride<0>();
+        int const xStride = ws.x.getStride<0>();
+        for (int y = 0; y != height; ++y) {
+            InPixelT const *inPtr = in.getData() + (y0 + y)*inStride + x0;
+            double *xPtr = ws.x.getData() + y*xStride;
+            for (int x = 0; x != width; ++x) {
+                double const value = inPtr[x];
+                if (!lsst::utils::isfinite(value)) {
+                    return false;
+                }
+                xPtr[x] = value;
+            }
+            std::fill(xPtr + width, xPtr + ws.shape[1], 0.0);
+        }
+        std::fill(ws.x.getData() + height*xStride, ws.x.getData() + ws.shape[0]*xStride, 0.0);
+        return true;
+    }
+
+    /*
+     * Correlate one tile of an image plane with a kernel in real space
+     *
+     * As in convolveWithBruteForce, kernel pixels that are 0 are skipped, so non-finite image pixels
+     * only affect the output pixels that they contribute to.
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void correlateTile(nd::Array<OutPixelT, 2, 1> const &out,    // output plane
+                       nd::Array<InPixelT const, 2, 1> const &in, // input plane
+                       KernelArray const &kernel,                // kernel
+                       bool const isSquared,                     // use the square of the kernel?
+                       int ctrX, int ctrY,                       // kernel centre
+                       int x0, int y0,                           // origin of the tile in the input plane
+                       int width, int height                     // dimensions of the output tile
+                      ) {
+        int const kWidth = kernel.getSize<1>();
+        int const kHeight = kernel.getSize<0>();
+        int const kStride = kernel.getStride<0>();
+        int const inStride = in.template getStride<0>();
+        int const outStride = out.template getStride<0>();
+        for (int y = 0; y != height; ++y) {
+            OutPixelT *outPtr = out.getData() + (ctrY + y0 + y)*outStride + ctrX + x0;
+            for (int x = 0; x != width; ++x) {
+                double sum = 0.0;
+                for (int ky = 0; ky != kHeight; ++ky) {
+                    InPixelT const *inPtr = in.getData() + (y0 + y + ky)*inStride + x0 + x;
+                    afwMath::Kernel::Pixel const *kPtr = kernel.getData() + ky*kStride;
+                    for (int kx = 0; kx != kWidth; ++kx) {
+                        double const kVal = kPtr[kx];
+                        if (kVal != 0) {
+                            sum += inPtr[kx]*(isSquared ? kVal*kVal : kVal);
+                        }
+                    }
+                }
+                outPtr[x] = static_cast<OutPixelT>(sum);
+            }
+        }
+    }
+
+    /*
+     * Correlate a range of the tiles of an image plane with a kernel (whose transform is kernelK)
+     * using overlap-save; called (possibly in parallel) for each chunk of the tiles.
+     *
+     * The image is processed in tiles of the size of the transforms; each tile yields
+     * (size of transform - size of kernel + 1) output pixels uncontaminated by the wrap-around of the
+     * circular convolution.  Tiles containing non-finite pixels are correlated in real space.
+     * Each chunk checks its own workspace out of the cache, as a workspace's arrays may only
+     * be used by one thread at a time.  The chunks share the views of the planes and kernel (made
+     * by the calling thread), but mustn't copy them or index them with [], which makes new views:
+     * ndarray's reference counts aren't thread safe.
+     */
+    template <typename OutPixelT, typename InPixelT>
+    class ConvolveTiles {
+    public:
+        ConvolveTiles(nd::Array<OutPixelT, 2, 1> const &out,    // output plane; same size as in
+                      nd::Array<InPixelT const, 2, 1> const &in, // input plane
+                      KernelArray const &kernel,                // kernel
+                      bool isSquared,                           // use the square of the kernel?
+                      int ctrX, int ctrY,                       // kernel centre
+                      FourierTransform::Index const &shape,     // shape of the transforms
+                      FourierTransform::ArrayK const &kernelK,  // transformKernel(ws, kernel, isSquared)
+                      int nChunk                                // number of chunks the tiles are divided into
+                     ) :
+            _out(out), _in(in), _kernel(kernel), _isSquared(isSquared), _ctrX(ctrX), _ctrY(ctrY),
+            _shape(shape), _kernelK(kernelK), _nChunk(nChunk)
+        { }
+
+        /// Return the number of tiles needed to cover the image
+        int getNumTiles() const {
+            return _getNumTilesX()*_getNumTilesY();
+        }
+
+        void operator()(int chunk) const {
+            int const kWidth = _kernel.getSize<1>();
+            int const kHeight = _kernel.getSize<0>();
+            int const cnvWidth = _in.template getSize<1>() + 1 - kWidth;
+            int const cnvHeight = _in.template getSize<0>() + 1 - kHeight;
+            int const tileWidth = _shape[1] + 1 - kWidth;
+            int const tileHeight = _shape[0] + 1 - kHeight;
+            int const nTileX = _getNumTilesX();
+            int const nTile = getNumTiles();
+            int const outStride = _out.template getStride<0>();
+
+            CachedFftWorkspace cachedWs(_shape[0], _shape[1]);
+            FftWorkspace &ws = *cachedWs;
+            int const xStride = ws.x.getStride<0>();
+
+            for (int tile = (chunk*nTile)/_nChunk, end = ((chunk + 1)*nTile)/_nChunk; tile != end; ++tile) {
+                int const y0 = (tile/nTileX)*tileHeight;
+                int const x0 = (tile%nTileX)*tileWidth;
+                int const height = std::min(tileHeight, cnvHeight - y0);
+                int const width = std::min(tileWidth, cnvWidth - x0);
+
+                if (!loadTile(ws, _in, x0, y0, width + kWidth - 1, height + kHeight - 1)) {
+                    pexLog::TTrace<6>("lsst.afw.math.convolve",
+                                      "convolveWithFft: tile at (%d, %d) has non-finite pixels", x0, y0);
+                    correlateTile(_out, _in, _kernel, _isSquared, _ctrX, _ctrY, x0, y0, width, height);
+                    continue;
+                }
+
+                ws.forward->execute();
+                std::complex<double> const *kernelPtr = _kernelK.getData();
+                for (std::complex<double> *ptr = ws.k.getData(), *end = ptr + ws.k.getNumElements();
+                     ptr != end; ++ptr, ++kernelPtr) {
+                    *ptr *= *kernelPtr;
+                }
+                ws.inverse->execute();
+
+                for (int y = 0; y != height; ++y) {
+                    double const *xPtr = ws.x.getData() + y*xStride;
+                    OutPixelT *outPtr = _out.getData() + (_ctrY + y0 + y)*outStride + _ctrX + x0;
+                    for (int x = 0; x != width; ++x) {
+                        outPtr[x] = static_cast<OutPixelT>(xPtr[x]);
+                    }
+                }
+            }
+        }
+
+    private:
+        nd::Array<OutPixelT, 2, 1> const _out;
+        nd::Array<InPixelT const, 2, 1> const _in;
+        KernelArray const _kernel;
+        bool const _isSquared;
+        int const _ctrX;
+        int const _ctrY;
+        FourierTransform::Index const _shape;
+        FourierTransform::ArrayK const _kernelK;
+        int const _nChunk;
+
+        int _getNumTilesX() const {
+            int const tileWidth = _shape[1] + 1 - _kernel.getSize<1>();
+            int const cnvWidth = _in.template getSize<1>() + 1 - _kernel.getSize<1>();
+            return (cnvWidth + tileWidth - 1)/tileWidth;
+        }
+        int _getNumTilesY() const {
+            int const tileHeight = _shape[0] + 1 - _kernel.getSize<0>();
+            int const cnvHeight = _in.template getSize<0>() + 1 - _kernel.getSize<0>();
+            return (cnvHeight + tileHeight - 1)/tileHeight;
+        }
+    };
+
+    /*
+     * Correlate an image plane with a kernel in Fourier space, using nThread threads
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolvePlane(nd::Array<OutPixelT, 2, 1> const &out,    // output plane; same size as in
+                       nd::Array<InPixelT const, 2, 1> const &in, // input plane
+                       KernelArray const &kernel,                // kernel
+                       bool const isSquared,                     // use the square of the kernel?
+                       int ctrX, int ctrY,                       // kernel centre
+                       int nThread                               // number of threads; <= 0 for one per core
+                      ) {
+        FourierTransform::Index const shape = nd::makeVector(
+            getFftLength(in.template getSize<0>(), kernel.getSize<0>()),
+            getFftLength(in.template getSize<1>(), kernel.getSize<1>()));
+        FourierTransform::ArrayK kernelK;
+        {
+            CachedFftWorkspace ws(shape[0], shape[1]);
+            kernelK = transformKernel(*ws, kernel, isSquared);
+        }
+
+        ConvolveTiles<OutPixelT, InPixelT> convolveTiles(out, in, kernel, isSquared, ctrX, ctrY,
+                                                         shape, kernelK, 1);
+        int const nChunk = std::min(mathDetail::getNumThreads(nThread), convolveTiles.getNumTiles());
+        mathDetail::parallelFor(0, nChunk,
+                                ConvolveTiles<OutPixelT, InPixelT>(out, in, kernel, isSquared, ctrX, ctrY,
+                                                                   shape, kernelK, nChunk),
+                                nChunk);
+    }
+
+    /*
+     * Set a chunk of the rows of an output mask to the OR of the input mask pixels under the nonzero
+     * kernel pixels, as convolveWithBruteForce does; called (possibly in parallel) for each chunk.
+     * As in ConvolveTiles, the chunks only use the data of the shared views.
+     */
+    template <typename MaskPixelT>
+    class ConvolveMask {
+    public:
+        ConvolveMask(nd::Array<MaskPixelT, 2, 1> const &out,    // output mask; same size as in
+                     nd::Array<MaskPixelT const, 2, 1> const &in, // input mask
+                     KernelArray const &kernel,                  // kernel
+                     int ctrX, int ctrY,                         // kernel centre
+                     int nChunk                                  // number of chunks the rows are divided into
+                    ) :
+            _out(out), _in(in), _kernel(kernel), _ctrX(ctrX), _ctrY(ctrY), _nChunk(nChunk),
+            _isDense(true)
+        {
+            for (int ky = 0; ky != kernel.getSize<0>() && _isDense; ++ky) {
+                for (int kx = 0; kx != kernel.getSize<1>(); ++kx) {
+                    if (kernel[ky][kx] == 0) {
+                        _isDense = false;
+                        break;
+                    }
+                }
+            }
+        }
+
+        void operator()(int chunk) const {
+            int const kWidth = _kernel.getSize<1>();
+            int const kHeight = _kernel.getSize<0>();
+            int const kStride = _kernel.getStride<0>();
+            int const cnvWidth = _in.template getSize<1>() + 1 - kWidth;
+            int const cnvHeight = _in.template getSize<0>() + 1 - kHeight;
+            int const inStride = _in.template getStride<0>();
+            int const outStride = _out.template getStride<0>();
+            int const y0 = (chunk*cnvHeight)/_nChunk;
+            int const y1 = ((chunk + 1)*cnvHeight)/_nChunk;
+            if (y0 == y1) {
+                return;
+            }
+
+            if (_isDense) {
+                // the OR over a rectangle is separable:  OR along the rows, then along the columns
+                int const nRowOr = y1 - y0 + kHeight - 1;
+                std::vector<MaskPixelT> rowOr(nRowOr*cnvWidth);
+                for (int y = 0; y != nRowOr; ++y) {
+                    MaskPixelT const *inPtr = _in.getData() + (y0 + y)*inStride;
+                    MaskPixelT *rowPtr = &rowOr[y*cnvWidth];
+                    std::fill(rowPtr, rowPtr + cnvWidth, 0);
+                    for (int kx = 0; kx != kWidth; ++kx) {
+                        mathDetail::orRow(rowPtr, inPtr + kx, cnvWidth);
+                    }
+                }
+                for (int y = y0; y != y1; ++y) {
+                    MaskPixelT *outPtr = _out.getData() + (_ctrY + y)*outStride + _ctrX;
+                    std::fill(outPtr, outPtr + cnvWidth, 0);
+                    for (int ky = 0; ky != kHeight; ++ky) {
+                        mathDetail::orRow(outPtr, &rowOr[(y - y0 + ky)*cnvWidth], cnvWidth);
+                    }
+                }
+            } else {
+                for (int y = y0; y != y1; ++y) {
+                    MaskPixelT *outPtr = _out.getData() + (_ctrY + y)*outStride + _ctrX;
+                    std::fill(outPtr, outPtr + cnvWidth, 0);
+                    for (int ky = 0; ky != kHeight; ++ky) {
+                        MaskPixelT const *inPtr = _in.getData() + (y + ky)*inStride;
+                        afwMath::Kernel::Pixel const *kPtr = _kernel.getData() + ky*kStride;
+                        for (int kx = 0; kx != kWidth; ++kx) {
+                            if (kPtr[kx] != 0) {
+                                mathDetail::orRow(outPtr, inPtr + kx, cnvWidth);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        nd::Array<MaskPixelT, 2, 1> const _out;
+        nd::Array<MaskPixelT const, 2, 1> const _in;
+        KernelArray const _kernel;
+        int const _ctrX;
+        int const _ctrY;
+        int const _nChunk;
+        bool _isDense;                  // are all the kernel's pixels nonzero?
+    };
+
+    /*
+     * Convolve a mask plane, using nThread threads
+     */
+    template <typename MaskPixelT>
+    void convolveMask(nd::Array<MaskPixelT, 2, 1> const &out,    // output mask; same size as in
+                      nd::Array<MaskPixelT const, 2, 1> const &in, // input mask
+                      KernelArray const &kernel,                  // kernel
+                      int ctrX, int ctrY,                         // kernel centre
+                      int nThread                                 // number of threads; <= 0 for one per core
+                     ) {
+        int const cnvHeight = in.template getSize<0>() + 1 - kernel.getSize<0>();
+        int const nChunk = std::min(mathDetail::getNumThreads(nThread), cnvHeight);
+        mathDetail::parallelFor(0, nChunk, ConvolveMask<MaskPixelT>(out, in, kernel, ctrX, ctrY, nChunk),
+                                nChunk);
+    }
+
+    /*
+     * Convolve an Image
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolveImage(afwImage::Image<OutPixelT> &convolvedImage,
+                       afwImage::Image<InPixelT> const &inImage,
+                       afwMath::Kernel const &kernel,
+                       bool doNormalize,
+                       int nThread
+                      ) {
+        if (std::numeric_limits<OutPixelT>::is_integer) {
+            // convolveWithBruteForce truncates each product, and we can't reproduce that
+            mathDetail::convolveWithBruteForce(convolvedImage, inImage, kernel, doNormalize, nThread);
+            return;
+        }
+
+        afwImage::Image<afwMath::Kernel::Pixel> kernelImage(kernel.getDimensions());
+        (void)kernel.computeImage(kernelImage, doNormalize);
+        KernelArray const kernelArray = kernelImage.getArray();
+
+        convolvePlane(convolvedImage.getArray(), inImage.getArray(), kernelArray, false,
+                      kernel.getCtrX(), kernel.getCtrY(), nThread);
+    }
+
+    /*
+     * Convolve a MaskedImage; the variance is convolved with the square of the kernel
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolveImage(afwImage::MaskedImage<OutPixelT> &convolvedImage,
+                       afwImage::MaskedImage<InPixelT> const &inImage,
+                       afwMath::Kernel const &kernel,
+                       bool doNormalize,
+                       int nThread
+                      ) {
+        if (std::numeric_limits<OutPixelT>::is_integer) {
+            // convolveWithBruteForce truncates each product, and we can't reproduce that
+            mathDetail::convolveWithBruteForce(convolvedImage, inImage, kernel, doNormalize, nThread);
+            return;
+        }
+
+        afwImage::Image<afwMath::Kernel::Pixel> kernelImage(kernel.getDimensions());
+        (void)kernel.computeImage(kernelImage, doNormalize);
+        KernelArray const kernelArray = kernelImage.getArray();
+        int const ctrX = kernel.getCtrX();
+        int const ctrY = kernel.getCtrY();
+
+        convolvePlane(convolvedImage.getImage()->getArray(),
+                      static_cast<afwImage::Image<InPixelT> const &>(*inImage.getImage()).getArray(),
+                      kernelArray, false, ctrX, ctrY, nThread);
+
+        convolvePlane(convolvedImage.getVariance()->getArray(),
+                      static_cast<afwImage::Image<afwImage::VariancePixel> const &>(
+                          *inImage.getVariance()).getArray(),
+                      kernelArray, true, ctrX, ctrY, nThread);
+
+        convolveMask(convolvedImage.getMask()->getArray(),
+                     static_cast<afwImage::Mask<afwImage::MaskPixel> const &>(*inImage.getMask()).getArray(),
+                     kernelArray, ctrX, ctrY, nThread);
+    }
+
+}   // anonymous namespace
+
+/**
+ * @brief Return true if a Kernel should be convolved using convolveWithFft
+ *
+ * That is, if the kernel is spatially invariant, and at least convolutionControl.getMinFftKernelSize()
+ * pixels in both width and height;  for smaller kernels direct convolution is faster.
+ *
+ * @ingroup afw
+ */
+bool mathDetail::isFftConvolutionPreferred(
+        afwMath::Kernel const& kernel,  ///< convolution kernel
+        afwMath::ConvolutionControl const& convolutionControl)  ///< convolution control parameters
+{
+    int const minFftKernelSize = convolutionControl.getMinFftKernelSize();
+    return minFftKernelSize > 0 && !kernel.isSpatiallyVarying() &&
+        kernel.getWidth() >= minFftKernelSize && kernel.getHeight() >= minFftKernelSize;
+}
+
+/**
+ * @brief Convolve an Image or MaskedImage with a spatially invariant Kernel using FFTs
+ *
+ * @warning Low-level convolution function that does not set edge pixels.
+ *
+ * The results are those of convolveWithBruteForce, to within rounding error. The image is divided into
+ * tiles which are convolved in Fourier space (the overlap-save method), at a cost per pixel that
+ * depends only logarithmically on the size of the kernel. The FFTW plans are cached, so repeated
+ * convolutions of images of the same size don't pay for the planning again; see clearFftCache.
+ *
+ * The variance of a MaskedImage is convolved with the square of the kernel, and the mask is convolved
+ * directly (as it's an OR, not a sum). Tiles that contain NaN or infinite pixels are convolved directly,
+ * so that such pixels only affect the output pixels that they would in convolveWithBruteForce.
+ * The tiles are divided between nThread threads, each using its own FFTW workspace.
+ * If the output pixels are integers convolveWithBruteForce is called, as its truncation of each product
+ * can't be reproduced.
+ *
+ * @throw lsst::pex::exceptions::InvalidParameterException if the kernel is spatially varying
+ * @throw lsst::pex::exceptions::InvalidParameterException if convolvedImage dimensions != inImage dimensions
+ * @throw lsst::pex::exceptions::InvalidParameterException if inImage smaller than kernel in width or height
+ *
+ * @ingroup afw
+ */
+template <typename OutImageT, typename InImageT>
+void mathDetail::convolveWithFft(
+        OutImageT &convolvedImage,      ///< convolved %image
+        InImageT const& inImage,        ///< %image to convolve
+        afwMath::Kernel const& kernel,  ///< convolution kernel
+        bool doNormalize,               ///< if true, normalize the kernel, else use "as is"
+        int nThread)                    ///< number of threads to use; <= 0 means one per core
+{
+    if (kernel.isSpatiallyVarying()) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException,
+                          "convolveWithFft only supports spatially invariant kernels");
+    }
+    if (convolvedImage.getDimensions() != inImage.getDimensions()) {
+        std::ostringstream os;
+        os << "convolvedImage dimensions = ( "
+            << convolvedImage.getWidth() << ", " << convolvedImage.getHeight()
+            << ") != (" << inImage.getWidth() << ", " << inImage.getHeight() << ") = inImage dimensions";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, os.str());
+    }
+    if (inImage.getWidth() < kernel.getWidth() || inImage.getHeight() < kernel.getHeight()) {
+        std::ostringstream os;
+        os << "inImage dimensions = ( "
+            << inImage.getWidth() << ", " << inImage.getHeight()
+            << ") smaller than (" << kernel.getWidth() << ", " << kernel.getHeight()
+            << ") = kernel dimensions in width and/or height";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, os.str());
+    }
+
+    pexLog::TTrace<5>("lsst.afw.math.convolve", "convolveWithFft: kernel is %d x %d",
+                      kernel.getWidth(), kernel.getHeight());
+    convolveImage(convolvedImage, inImage, kernel, doNormalize, nThread);
+}
+
+/**
+ * @brief Destroy the FFTW plans (and their arrays) cached by convolveWithFft
+ *
+ * The cache holds at most a few idle workspaces, but they're as large as the images that were
+ * convolved; call this to free them once you've finished convolving.  Workspaces in use by
+ * other threads are unaffected.
+ *
+ * @ingroup afw
+ */
+void mathDetail::clearFftCache() {
+    fftWorkspaceCache.clear();
+}
+
+/*
+ * Explicit instantiation
+ */
+/// \cond
+#define IMAGE(PIXTYPE) afwImage::Image<PIXTYPE>
+#define MASKEDIMAGE(PIXTYPE) afwImage::MaskedImage<PIXTYPE, afwImage::MaskPixel, afwImage::VariancePixel>
+#define NL /* */
+// Instantiate Image or MaskedImage versions
+#define INSTANTIATE_IM_OR_MI(IMGMACRO, OUTPIXTYPE, INPIXTYPE) \
+    template void mathDetail::convolveWithFft( \
+        IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&, afwMath::Kernel const&, bool, int);
+// Instantiate both Image and MaskedImage versions
+#define INSTANTIATE(OUTPIXTYPE, INPIXTYPE) \
+    INSTANTIATE_IM_OR_MI(IMAGE,       OUTPIXTYPE, INPIXTYPE) \
+    INSTANTIATE_IM_OR_MI(MASKEDIMAGE, OUTPIXTYPE, INPIXTYPE)
+
+INSTANTIATE(double, double)
+INSTANTIATE(double, float)
+INSTANTIATE(double, int)
+INSTANTIATE(double, boost::uint16_t)
+INSTANTIATE(float, float)
+INSTANTIATE(float, int)
+INSTANTIATE(float, boost::uint16_t)
+INSTANTIATE(int, int)
+INSTANTIATE(boost::uint16_t, boost::uint16_t)
+/// \endcond
@@ -0,0 +1,94 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file
+ *
+ * @brief Support for sharing independent pieces of work between threads
+ *
+ * @ingroup afw
+ */
+#include "lsst/afw/math/detail/Parallel.h"
+
+namespace pexExcept = lsst::pex::exceptions;
+namespace mathDetail = lsst::afw::math::detail;
+
+/**
+ * @brief Return the number of threads to use, given the number requested
+ *
+ * @return nThread if it's positive, otherwise the number of cores (or 1 if that can't be determined)
+ */
+int mathDetail::getNumThreads(int const nThread ///< number of threads requested; <= 0 means one per core
+                             ) {
+    if (nThread > 0) {
+        return nThread;
+    }
+    int const nCore = boost::thread::hardware_concurrency();
+    return (nCore > 0) ? nCore : 1;
+}
+
+/**
+ * @brief Return the next index to process in i
+ *
+ * @return false if there's no more work to do (either all indices have been handed out, or a call failed)
+ */
+bool mathDetail::ParallelForState::next(int &i) {
+    boost::mutex::scoped_lock lock(_mutex);
+    if (_isFailed || _next >= _end) {
+        return false;
+    }
+    i = _next++;
+    return true;
+}
+
+/**
+ * @brief Remember an exception (unless we already have one), and stop handing out work
+ */
+void mathDetail::ParallelForState::setError(pexExcept::Exception const &e) {
+    boost::mutex::scoped_lock lock(_mutex);
+    if (!_isFailed) {
+        _error.reset(e.clone());
+        _isFailed = true;
+    }
+}
+
+/**
+ * @brief Remember the message from a non-LSST exception (unless we already have one), and stop handing out work
+ */
+void mathDetail::ParallelForState::setError(std::string const &what) {
+    boost::mutex::scoped_lock lock(_mutex);
+    if (!_isFailed) {
+        _error.reset(new pexExcept::RuntimeErrorException(LSST_EXCEPT_HERE, what));
+        _isFailed = true;
+    }
+}
+
+/**
+ * @brief Rethrow the remembered exception, if any, as its original type
+ */
+void mathDetail::ParallelForState::rethrow() const {
+    if (_error) {
+        _error->raise();
+    }
+}
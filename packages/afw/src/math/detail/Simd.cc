@@ -0,0 +1,316 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file
+ *
+ * @brief Vectorized operations on rows of pixels, used by the convolution code
+ *
+ * SSE2 is used if the compiler targets it (as it always does on x86_64). The AVX versions are compiled
+ * whatever the target (gcc >= 4.9 can generate code for a single function), and only used if the CPU
+ * supports them.  The vectorized versions perform the same floating point operations on each pixel
+ * as the scalar versions, so the results don't depend on the instructions used.
+ *
+ * @ingroup afw
+ */
+#include <algorithm>
+
+#include "lsst/afw/math/detail/Simd.h"
+
+#if defined(__SSE2__)
+#   define LSST_AFW_MATH_HAVE_SSE2 1
+#   include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#   define LSST_AFW_MATH_HAVE_AVX 1
+#   include <immintrin.h>
+#endif
+
+namespace afwImage = lsst::afw::image;
+namespace mathDetail = lsst::afw::math::detail;
+
+namespace {
+
+    mathDetail::SimdLevel simdLevel = mathDetail::getMaxSimdLevel(); // level currently in use
+
+    template <typename OutPixelT, typename InPixelT>
+    inline void addScaledRowScalar(OutPixelT *out, InPixelT const *in, double scale, int n) {
+        mathDetail::addScaledRow<OutPixelT, InPixelT>(out, in, scale, n);
+    }
+
+    inline void orRowScalar(afwImage::MaskPixel *out, afwImage::MaskPixel const *in, int n) {
+        for (int i = 0; i != n; ++i) {
+            out[i] |= in[i];
+        }
+    }
+
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+    void addScaledRowSse2(double *out, double const *in, double scale, int n) {
+        __m128d const s = _mm_set1_pd(scale);
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128d const p0 = _mm_mul_pd(_mm_loadu_pd(in + i), s);
+            __m128d const p1 = _mm_mul_pd(_mm_loadu_pd(in + i + 2), s);
+            _mm_storeu_pd(out + i,     _mm_add_pd(_mm_loadu_pd(out + i), p0));
+            _mm_storeu_pd(out + i + 2, _mm_add_pd(_mm_loadu_pd(out + i + 2), p1));
+        }
+        addScaledRowScalar(out + i, in + i, scale, n - i);
+    }
+
+    void addScaledRowSse2(double *out, float const *in, double scale, int n) {
+        __m128d const s = _mm_set1_pd(scale);
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 const f = _mm_loadu_ps(in + i);
+            __m128d const p0 = _mm_mul_pd(_mm_cvtps_pd(f), s);
+            __m128d const p1 = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(f, f)), s);
+            _mm_storeu_pd(out + i,     _mm_add_pd(_mm_loadu_pd(out + i), p0));
+            _mm_storeu_pd(out + i + 2, _mm_add_pd(_mm_loadu_pd(out + i + 2), p1));
+        }
+        addScaledRowScalar(out + i, in + i, scale, n - i);
+    }
+
+    void addScaledRowSse2(float *out, float const *in, double scale, int n) {
+        __m128d const s = _mm_set1_pd(scale);
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            // the products are computed in double precision, and rounded to float before they're added
+            __m128 const f = _mm_loadu_ps(in + i);
+            __m128 const p0 = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(f), s));
+            __m128 const p1 = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(f, f)), s));
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_movelh_ps(p0, p1)));
+        }
+        addScaledRowScalar(out + i, in + i, scale, n - i);
+    }
+
+    void orRowSse2(afwImage::MaskPixel *out, afwImage::MaskPixel const *in, int n) {
+        int const nPerVector = sizeof(__m128i)/sizeof(afwImage::MaskPixel);
+        int i = 0;
+        for (; i + nPerVector <= n; i += nPerVector) {
+            __m128i const *inPtr = reinterpret_cast<__m128i const *>(in + i);
+            __m128i *outPtr = reinterpret_cast<__m128i *>(out + i);
+            _mm_storeu_si128(outPtr, _mm_or_si128(_mm_loadu_si128(outPtr), _mm_loadu_si128(inPtr)));
+        }
+        orRowScalar(out + i, in + i, n - i);
+    }
+#endif
+
+#if defined(LSST_AFW_MATH_HAVE_AVX)
+    __attribute__((target("avx")))
+    void addScaledRowAvx(double *out, double const *in, double scale, int n) {
+        __m256d const s = _mm256_set1_pd(scale);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256d const p0 = _mm256_mul_pd(_mm256_loadu_pd(in + i), s);
+            __m256d const p1 = _mm256_mul_pd(_mm256_loadu_pd(in + i + 4), s);
+            _mm256_storeu_pd(out + i,     _mm256_add_pd(_mm256_loadu_pd(out + i), p0));
+            _mm256_storeu_pd(out + i + 4, _mm256_add_pd(_mm256_loadu_pd(out + i + 4), p1));
+        }
+        addScaledRowScalar(out + i, in + i, scale, n - i);
+    }
+
+    __attribute__((target("avx")))
+    void addScaledRowAvx(double *out, float const *in, double scale, int n) {
+        __m256d const s = _mm256_set1_pd(scale);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256d const p0 = _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(in + i)), s);
+            __m256d const p1 = _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(in + i + 4)), s);
+            _mm256_storeu_pd(out + i,     _mm256_add_pd(_mm256_loadu_pd(out + i), p0));
+            _mm256_storeu_pd(out + i + 4, _mm256_add_pd(_mm256_loadu_pd(out + i + 4), p1));
+        }
+        addScaledRowScalar(out + i, in + i, scale, n - i);
+    }
+
+    __attribute__((target("avx")))
+    void addScaledRowAvx(float *out, float const *in, double scale, int n) {
+        __m256d const s = _mm256_set1_pd(scale);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            // the products are computed in double precision, and rounded to float before they're added
+            __m128 const p0 = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(in + i)), s));
+            __m128 const p1 = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(in + i + 4)), s));
+            __m256 const p = _mm256_insertf128_ps(_mm256_castps128_ps256(p0), p1, 1);
+            _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), p));
+        }
+        addScaledRowScalar(out + i, in + i, scale, n - i);
+    }
+
+    __attribute__((target("avx")))
+    void orRowAvx(afwImage::MaskPixel *out, afwImage::MaskPixel const *in, int n) {
+        // AVX has no 256-bit integer instructions, but a bitwise OR is a bitwise OR
+        int const nPerVector = sizeof(__m256)/sizeof(afwImage::MaskPixel);
+        int i = 0;
+        for (; i + nPerVector <= n; i += nPerVector) {
+            float const *inPtr = reinterpret_cast<float const *>(in + i);
+            float *outPtr = reinterpret_cast<float *>(out + i);
+            _mm256_storeu_ps(outPtr, _mm256_or_ps(_mm256_loadu_ps(outPtr), _mm256_loadu_ps(inPtr)));
+        }
+        orRowScalar(out + i, in + i, n - i);
+    }
+#endif
+
+}   // anonymous namespace
+
+/**
+ * @brief Return the best instruction set supported by both this build and the CPU we're running on
+ */
+mathDetail::SimdLevel mathDetail::getMaxSimdLevel() {
+#if defined(LSST_AFW_MATH_HAVE_AVX)
+    __builtin_cpu_init();           // we may be called by a static initializer
+    if (__builtin_cpu_supports("avx")) {
+        return SIMD_AVX;
+    }
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+    return SIMD_SSE2;
+#else
+    return SIMD_NONE;
+#endif
+}
+
+/**
+ * @brief Return the instruction set currently used by the row operations
+ */
+mathDetail::SimdLevel mathDetail::getSimdLevel() {
+    return simdLevel;
+}
+
+/**
+ * @brief Set the instruction set to be used by the row operations
+ *
+ * Intended for testing and benchmarking; the default is getMaxSimdLevel().
+ * Requests for an unsupported instruction set get the best supported one instead.
+ * This is a global setting, and shouldn't be changed while other threads are convolving.
+ */
+void mathDetail::setSimdLevel(SimdLevel level   ///< desired instruction set
+                             ) {
+    simdLevel = std::max(SIMD_NONE, std::min(level, getMaxSimdLevel()));
+}
+
+/**
+ * @brief Set out[i] += in[i]*scale for i in [0, n)
+ *
+ * Each product is computed in double precision, and converted to the output type before it's added.
+ */
+void mathDetail::addScaledRow(double *out,      ///< row to add to
+                              double const *in, ///< row to add
+                              double scale,     ///< multiply in by this before adding it to out
+                              int n)            ///< number of pixels in the rows
+{
+    switch (simdLevel) {
+#if defined(LSST_AFW_MATH_HAVE_AVX)
+      case SIMD_AVX:
+        addScaledRowAvx(out, in, scale, n);
+        break;
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+      case SIMD_SSE2:
+        addScaledRowSse2(out, in, scale, n);
+        break;
+#endif
+      default:
+        addScaledRowScalar(out, in, scale, n);
+        break;
+    }
+}
+
+/**
+ * @brief Set out[i] += in[i]*scale for i in [0, n)
+ *
+ * Each product is computed in double precision, and converted to the output type before it's added.
+ */
+void mathDetail::addScaledRow(double *out,      ///< row to add to
+                              float const *in,  ///< row to add
+                              double scale,     ///< multiply in by this before adding it to out
+                              int n)            ///< number of pixels in the rows
+{
+    switch (simdLevel) {
+#if defined(LSST_AFW_MATH_HAVE_AVX)
+      case SIMD_AVX:
+        addScaledRowAvx(out, in, scale, n);
+        break;
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+      case SIMD_SSE2:
+        addScaledRowSse2(out, in, scale, n);
+        break;
+#endif
+      default:
+        addScaledRowScalar(out, in, scale, n);
+        break;
+    }
+}
+
+/**
+ * @brief Set out[i] += in[i]*scale for i in [0, n)
+ *
+ * Each product is computed in double precision, and converted to the output type before it's added.
+ */
+void mathDetail::addScaledRow(float *out,       ///< row to add to
+                              float const *in,  ///< row to add
+                              double scale,     ///< multiply in by this before adding it to out
+                              int n)            ///< number of pixels in the rows
+{
+    switch (simdLevel) {
+#if defined(LSST_AFW_MATH_HAVE_AVX)
+      case SIMD_AVX:
+        addScaledRowAvx(out, in, scale, n);
+        break;
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+      case SIMD_SSE2:
+        addScaledRowSse2(out, in, scale, n);
+        break;
+#endif
+      default:
+        addScaledRowScalar(out, in, scale, n);
+        break;
+    }
+}
+
+/**
+ * @brief Set out[i] |= in[i] for i in [0, n)
+ */
+void mathDetail::orRow(afwImage::MaskPixel *out,        ///< row to OR into
+                       afwImage::MaskPixel const *in,   ///< row to OR
+                       int n)                           ///< number of pixels in the rows
+{
+    switch (simdLevel) {
+#if defined(LSST_AFW_MATH_HAVE_AVX)
+      case SIMD_AVX:
+        orRowAvx(out, in, n);
+        break;
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+      case SIMD_SSE2:
+        orRowSse2(out, in, n);
+        break;
+#endif
+      default:
+        orRowScalar(out, in, n);
+        break;
+    }
+}
@@ -32,27 +32,38 @@
  * \author Nicole M. Silvestri and Russell Owen, University of Washington
  */
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <numeric>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <utility>
 
 #include "boost/cstdint.hpp" 
+#include "boost/format.hpp"
 #include "boost/regex.hpp"
+#include "boost/scoped_ptr.hpp"
 
+#include "lsst/ndarray.h"
+#include "lsst/ndarray/MemoryPool.h"
+#include "lsst/utils/ieee.h"
 #include "lsst/pex/logging/Trace.h" 
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/image.h"
 #include "lsst/afw/geom.h"
 #include "lsst/afw/math.h"
+#include "lsst/afw/math/detail/ImagePlanes.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace pexExcept = lsst::pex::exceptions;
 namespace pexLog = lsst::pex::logging;
 namespace afwImage = lsst::afw::image;
 namespace afwGeom = lsst::afw::geom;
 namespace afwMath = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
+namespace nd = lsst::ndarray;
 
 afwMath::Kernel::Ptr afwMath::LanczosWarpingKernel::clone() const {
     return afwMath::Kernel::Ptr(new afwMath::LanczosWarpingKernel(this->getOrder()));
@@ -168,6 +179,212 @@ boost::shared_ptr<afwMath::SeparableKernel> afwMath::makeWarpingKernel(std::stri
     }
 }
 
+namespace {
+    /*
+     * Set srcPosXY[i] to the position on the source image of the pixel of the destination image at
+     * (destX[i], destY[i]), computed from the Wcs.  All the positions are converted together by the
+     * array versions of Wcs::pixelToSky and Wcs::skyToPixel, which are much faster than converting
+     * them one at a time.
+     *
+     * If pool is set, the temporary arrays are drawn from it
+     *
+     * \throw lsst::pex::exceptions::RuntimeErrorException if a position can't be converted
+     */
+    void computeSrcPositions(
+        afwImage::Wcs const &destWcs,           ///< WCS of remapped %image
+        afwImage::Wcs const &srcWcs,            ///< WCS of source %image
+        nd::Array<double,1,1> const &destX,     ///< x positions on remapped %image (parent pixels)
+        nd::Array<double,1,1> const &destY,     ///< y positions on remapped %image (parent pixels)
+        afwGeom::Point2D *srcPosXY,             ///< positions on source %image
+        nd::MemoryPool::Ptr const &pool=nd::MemoryPool::Ptr() ///< pool for temporary arrays; may be empty
+    ) {
+        int const n = destX.getSize<0>();
+        nd::Array<double,1,1> sky1 = nd::allocate(n, pool);
+        nd::Array<double,1,1> sky2 = nd::allocate(n, pool);
+        nd::Array<double,1,1> srcX = nd::allocate(n, pool);
+        nd::Array<double,1,1> srcY = nd::allocate(n, pool);
+        destWcs.pixelToSky(destX, destY, sky1, sky2);
+        srcWcs.skyToPixel(sky1, sky2, srcX, srcY);
+        for (int i = 0; i != n; ++i) {
+            if (lsst::utils::isnan(srcX[i]) || lsst::utils::isnan(srcY[i])) {
+                throw LSST_EXCEPT(pexExcept::RuntimeErrorException,
+                    (boost::format("Cannot compute the source position of remapped pixel (%g, %g)") %
+                     destX[i] % destY[i]).str());
+            }
+            srcPosXY[i] = afwGeom::Point2D(srcX[i], srcY[i]);
+        }
+    }
+}
+
+/**
+ * \brief Construct a SrcPositionGrid, computing the source position of each node from the Wcs.
+ *
+ * \throw lsst::pex::exceptions::InvalidParameterException if destBBox is empty,
+ * maxError <= 0 or maxSpacing < 1
+ */
+afwMath::SrcPositionGrid::SrcPositionGrid(
+    afwImage::Wcs const &destWcs,       ///< WCS of remapped %image
+    afwImage::Wcs const &srcWcs,        ///< WCS of source %image
+    afwGeom::Box2I const &destBBox,     ///< bounding box of remapped %image (parent pixels)
+    double maxError,                    ///< maximum error in source position (source pixels)
+    int maxSpacing                      ///< maximum spacing of the grid nodes (remapped pixels);
+                                        ///< rounded down to a power of 2
+) :
+    _destBBox(destBBox),
+    _maxError(maxError),
+    _x0(destBBox.getMinX() - 1),
+    _y0(destBBox.getMinY() - 1),
+    _spacing(1),
+    _nCellX(0),
+    _nCellY(0),
+    _nodes()
+{
+    if (destBBox.isEmpty()) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, "destBBox is empty");
+    }
+    if (maxError <= 0) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, "maxError must be > 0");
+    }
+    if (maxSpacing < 1) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, "maxSpacing must be >= 1");
+    }
+    // start with the largest spacing allowed, but no larger than needed to span destBBox with one cell
+    int const maxExtent = std::max(destBBox.getWidth(), destBBox.getHeight());
+    while (2*_spacing <= maxSpacing && _spacing < maxExtent) {
+        _spacing *= 2;
+    }
+    // the nodes span one more column and row than destBBox, and may extend past its top and right edges
+    _nCellX = (destBBox.getWidth() + _spacing - 1)/_spacing;
+    _nCellY = (destBBox.getHeight() + _spacing - 1)/_spacing;
+    {
+        int const nNodeX = _nCellX + 1;
+        int const nNodeY = _nCellY + 1;
+        nd::Array<double,1,1> destX = nd::allocate(nNodeX*nNodeY);
+        nd::Array<double,1,1> destY = nd::allocate(nNodeX*nNodeY);
+        for (int j = 0; j != nNodeY; ++j) {
+            for (int i = 0; i != nNodeX; ++i) {
+                destX[j*nNodeX + i] = afwImage::indexToPosition(_x0 + i*_spacing);
+                destY[j*nNodeX + i] = afwImage::indexToPosition(_y0 + j*_spacing);
+            }
+        }
+        _nodes.resize(nNodeX*nNodeY);
+        computeSrcPositions(destWcs, srcWcs, destX, destY, &_nodes[0]);
+    }
+    //
+    // Halve the spacing until the coarser grid predicts the nodes of the finer one well enough.
+    // The nodes of the coarser grid are also nodes of the finer one, so are not recomputed;
+    // the other nodes are the midpoints of the coarse cells or their sides, where bilinear interpolation
+    // is the mean of the two or four nearest coarse nodes.  The new nodes of each finer grid are
+    // computed together, which is much faster than computing them one at a time.
+    //
+    double const maxError2 = maxError*maxError;
+    while (_spacing > 1) {
+        int const nFineX = 2*_nCellX;
+        int const nFineY = 2*_nCellY;
+        int const fineSpacing = _spacing/2;
+        int const nNew = (nFineX + 1)*(nFineY + 1) - (_nCellX + 1)*(_nCellY + 1);
+        nd::Array<double,1,1> destX = nd::allocate(nNew);
+        nd::Array<double,1,1> destY = nd::allocate(nNew);
+        int n = 0;
+        for (int j = 0; j <= nFineY; ++j) {
+            for (int i = 0; i <= nFineX; ++i) {
+                if (i%2 != 0 || j%2 != 0) {
+                    destX[n] = afwImage::indexToPosition(_x0 + i*fineSpacing);
+                    destY[n] = afwImage::indexToPosition(_y0 + j*fineSpacing);
+                    ++n;
+                }
+            }
+        }
+        std::vector<afwGeom::Point2D> newNodes(nNew);
+        computeSrcPositions(destWcs, srcWcs, destX, destY, &newNodes[0]);
+
+        std::vector<afwGeom::Point2D> fineNodes;
+        fineNodes.reserve((nFineX + 1)*(nFineY + 1));
+        double fitError2 = 0;
+        n = 0;
+        for (int j = 0; j <= nFineY; ++j) {
+            afwGeom::Point2D const *coarseRow0 = &_nodes[(j/2)*(_nCellX + 1)];
+            afwGeom::Point2D const *coarseRow1 = &_nodes[((j + 1)/2)*(_nCellX + 1)];
+            for (int i = 0; i <= nFineX; ++i) {
+                int const i0 = i/2;
+                int const i1 = (i + 1)/2;
+                if (i0 == i1 && j%2 == 0) {
+                    fineNodes.push_back(coarseRow0[i0]);
+                    continue;
+                }
+                afwGeom::Point2D const srcPos = newNodes[n++];
+                fineNodes.push_back(srcPos);
+                double err2 = 0;
+                for (int k = 0; k != 2; ++k) {
+                    double const predicted = 0.25*(coarseRow0[i0][k] + coarseRow0[i1][k] +
+                                                   coarseRow1[i0][k] + coarseRow1[i1][k]);
+                    err2 += (srcPos[k] - predicted)*(srcPos[k] - predicted);
+                }
+                fitError2 = std::max(fitError2, err2);
+            }
+        }
+        _nodes.swap(fineNodes);
+        _spacing = fineSpacing;
+        _nCellX = nFineX;
+        _nCellY = nFineY;
+        if (fitError2 <= maxError2) {
+            break;
+        }
+    }
+    pexLog::TTrace<3>("lsst.afw.math.warp", "SrcPositionGrid: spacing=%d; %d x %d nodes",
+                      _spacing, _nCellX + 1, _nCellY + 1);
+}
+
+/**
+ * \brief Return the approximate position on the source %image of one pixel of the remapped %image
+ *
+ * \throw lsst::pex::exceptions::InvalidParameterException if the pixel is not on the grid
+ */
+afwGeom::Point2D afwMath::SrcPositionGrid::getSrcPosition(
+    int x,      ///< x index of pixel on remapped %image (parent pixels)
+    int y       ///< y index of pixel on remapped %image (parent pixels)
+) const {
+    afwGeom::Point2D srcPosXY;
+    getSrcPositions(x, y, 1, &srcPosXY);
+    return srcPosXY;
+}
+
+/**
+ * \brief Compute the approximate position on the source %image of n adjacent pixels of one row
+ * of the remapped %image
+ *
+ * The pixels may include the extra column and row of the grid, i.e. x0 and y may be one less than
+ * the minimum of the destination bounding box.
+ *
+ * \throw lsst::pex::exceptions::InvalidParameterException if any of the pixels is not on the grid
+ */
+void afwMath::SrcPositionGrid::getSrcPositions(
+    int x0,                     ///< x index of first pixel on remapped %image (parent pixels)
+    int y,                      ///< y index of the row on remapped %image (parent pixels)
+    int n,                      ///< number of pixels
+    afwGeom::Point2D *srcPosXY  ///< source position of each pixel; must have room for n positions
+) const {
+    if (n < 0 || x0 < _x0 || x0 + n - 1 > _destBBox.getMaxX() || y < _y0 || y > _destBBox.getMaxY()) {
+        std::ostringstream os;
+        os << "pixels [" << x0 << ", " << x0 + n << ") of row " << y << " are not on the grid";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, os.str());
+    }
+    int const dy = y - _y0;
+    int const j = std::min(dy/_spacing, _nCellY - 1);
+    double const wy = (dy - j*_spacing)/static_cast<double>(_spacing);
+    afwGeom::Point2D const *row0 = &_nodes[j*(_nCellX + 1)];
+    afwGeom::Point2D const *row1 = row0 + (_nCellX + 1);
+    for (int x = 0; x != n; ++x) {
+        int const dx = x0 + x - _x0;
+        int const i = std::min(dx/_spacing, _nCellX - 1);
+        double const wx = (dx - i*_spacing)/static_cast<double>(_spacing);
+        for (int k = 0; k != 2; ++k) {
+            srcPosXY[x].coeffRef(k) = (1 - wy)*((1 - wx)*row0[i][k] + wx*row0[i + 1][k]) +
+                                      wy*((1 - wx)*row1[i][k] + wx*row1[i + 1][k]);
+        }
+    }
+}
+
 /**
  * \brief Convenience wrapper around warpImage()
  */
@@ -176,7 +393,8 @@ int afwMath::warpExposure(
     DestExposureT &destExposure,        ///< remapped exposure
     SrcExposureT const &srcExposure,    ///< source exposure
     SeparableKernel &warpingKernel,     ///< warping kernel; determines warping algorithm
-    int const interpLength              ///< Distance over which WCS can be linearily interpolated    
+    int const interpLength,             ///< Distance over which WCS can be linearily interpolated    
+    int const nThread                   ///< number of threads to use; see warpImage()
     )
 {
     if (!destExposure.hasWcs()) {
@@ -187,36 +405,650 @@ int afwMath::warpExposure(
     }
     typename DestExposureT::MaskedImageT mi = destExposure.getMaskedImage();
     return warpImage(mi, *destExposure.getWcs(),
-                     srcExposure.getMaskedImage(), *srcExposure.getWcs(), warpingKernel, interpLength);
+                     srcExposure.getMaskedImage(), *srcExposure.getWcs(), warpingKernel, interpLength,
+                     nThread);
 }
 
 
 /************************************************************************************************************/
 namespace {
-    inline std::pair<afwGeom::Point2D, float>
-    getSrcPos(afwGeom::Point2D destPosXY,
-              afwImage::Wcs const &destWcs,   ///< WCS of remapped %image
-              afwImage::Wcs const &srcWcs,    ///< WCS of source %image
-              std::vector<afwGeom::Point2D>::iterator const prevSrcPosXY)
-    {
-        /*
-         * These two versions are equivalent, but the second is faster as it doesn't need to build a Coord
-         */
-#if 0
-        afwGeom::Point2D srcPosXY = srcWcs.skyToPixel(destWcs.pixelToSky(destPosXY));
-#else
-        double const x = destPosXY[0];
-        double const y = destPosXY[1];
-        afwGeom::Point2D sky = destWcs.pixelToSky(x, y, true);
-        afwGeom::Point2D srcPosXY = srcWcs.skyToPixel(sky[0], sky[1]);
-#endif
+    /*
+     * Return the area on the source image of a pixel of the remapped image, given its position on the
+     * source image and those of the pixels below it and below and to the left of it
+     */
+    inline float computeRelativeArea(
+        afwGeom::Point2D const &srcPosXY,                                   ///< source position of pixel
+        std::vector<afwGeom::Point2D>::const_iterator const prevSrcPosXY    ///< source position of the
+                                                                            ///< pixel below
+    ) {
         // Correct intensity due to relative pixel spatial scale and kernel sum.
         // The area computation is for a parallellogram.
         afwGeom::Point2D dSrcA = srcPosXY - afwGeom::Extent<double>(prevSrcPosXY[-1]);
         afwGeom::Point2D dSrcB = srcPosXY - afwGeom::Extent<double>(prevSrcPosXY[0]);
         
-        return std::make_pair(srcPosXY,
-                              std::abs(dSrcA.getX()*dSrcB.getY() - dSrcA.getY()*dSrcB.getX()));
+        return std::abs(dSrcA.getX()*dSrcB.getY() - dSrcA.getY()*dSrcB.getX());
+    }
+
+    int const WarpingTableResolution = 1024; // number of steps per pixel in a WarpingKernelTable
+    int const WarpingBandHeight = 64;   // number of rows whose source positions are computed at once
+
+    /*
+     * One of the 1-d functions of a warping kernel, tabulated for each position of the kernel at
+     * fractional positions 0, 1/n, 2/n, ... 1 (n = WarpingTableResolution); the kernel vector
+     * at other fractional positions is linearly interpolated between its neighbours.
+     */
+    class WarpingKernelTable {
+    public:
+        WarpingKernelTable(
+            afwMath::SeparableKernel::KernelFunctionPtr func,   ///< x or y function of the kernel
+            int size,                   ///< width (or height) of the kernel
+            int ctr                     ///< index of the kernel's centre along that axis
+        ) :
+            _size(size),
+            _table((WarpingTableResolution + 1)*size)
+        {
+            for (int i = 0; i <= WarpingTableResolution; ++i) {
+                func->setParameter(0, i/static_cast<double>(WarpingTableResolution));
+                for (int j = 0; j != size; ++j) {
+                    _table[i*size + j] = (*func)(j - ctr);
+                }
+            }
+        }
+
+        /*
+         * Set vec[0, size) to the kernel vector at a fractional position in [0, 1]; return its sum
+         */
+        double computeVector(double frac, double *vec) const {
+            double const pos = frac*WarpingTableResolution;
+            int const ind = std::min(static_cast<int>(pos), WarpingTableResolution - 1);
+            double const weight = pos - ind;
+            double const *lower = &_table[ind*_size];
+            double const *upper = lower + _size;
+            double sum = 0.0;
+            for (int j = 0; j != _size; ++j) {
+                vec[j] = lower[j] + (upper[j] - lower[j])*weight;
+                sum += vec[j];
+            }
+            return sum;
+        }
+
+    private:
+        int const _size;
+        std::vector<double> _table;     // kernel vector for fractional position i/n is [i*_size, (i+1)*_size)
+    };
+
+    /*
+     * Compute the x and y vectors of a warping kernel at a given fractional position
+     *
+     * LanczosWarpingKernel and BilinearWarpingKernel are tabulated (so the vectors may be computed
+     * by any number of threads at once).  Other kernels are evaluated directly, by setting the kernel's
+     * parameters, so may only be used by one thread.
+     */
+    class WarpingKernelVectors {
+    public:
+        explicit WarpingKernelVectors(afwMath::SeparableKernel &kernel) :
+            _kernel(kernel),
+            _xTable(),
+            _yTable(),
+            _xList(kernel.getWidth()),
+            _yList(kernel.getHeight())
+        {
+            if (!kernel.isSpatiallyVarying() &&
+                (dynamic_cast<afwMath::LanczosWarpingKernel const *>(&kernel) != NULL ||
+                 dynamic_cast<afwMath::BilinearWarpingKernel const *>(&kernel) != NULL)) {
+                _xTable.reset(new WarpingKernelTable(kernel.getKernelColFunction(),
+                                                     kernel.getWidth(), kernel.getCtrX()));
+                _yTable.reset(new WarpingKernelTable(kernel.getKernelRowFunction(),
+                                                     kernel.getHeight(), kernel.getCtrY()));
+            }
+        }
+
+        bool isTabulated() const { return _xTable.get() != NULL; }
+
+        /*
+         * Set xVec[0, width) and yVec[0, height) to the kernel vectors at fractional position
+         * (fracX, fracY); return the sum of the kernel
+         */
+        double compute(double fracX, double fracY, double *xVec, double *yVec) const {
+            if (_xTable) {
+                return _xTable->computeVector(fracX, xVec)*_yTable->computeVector(fracY, yVec);
+            }
+            _kernel.setKernelParameters(std::make_pair(fracX, fracY));
+            double const kSum = _kernel.computeVectors(_xList, _yList, false);
+            std::copy(_xList.begin(), _xList.end(), xVec);
+            std::copy(_yList.begin(), _yList.end(), yVec);
+            return kSum;
+        }
+
+    private:
+        afwMath::SeparableKernel &_kernel;
+        boost::scoped_ptr<WarpingKernelTable> _xTable;
+        boost::scoped_ptr<WarpingKernelTable> _yTable;
+        mutable std::vector<afwMath::Kernel::Pixel> _xList; // workspace for untabulated kernels
+        mutable std::vector<afwMath::Kernel::Pixel> _yList;
+    };
+
+    /*
+     * The source pixels and kernel needed to compute one row of a warped image
+     *
+     * For pixel x of the row the kernel's pixel (0, 0) lies on source pixel (srcX[x], srcY[x]),
+     * or srcX[x] is -1 if the kernel doesn't fit on the source (an edge pixel).  The kernel vectors
+     * are xVec[x*kernelWidth, (x+1)*kernelWidth) and yVec[x*kernelHeight, (x+1)*kernelHeight),
+     * and the kernel is to be scaled by scale[x] (the relative area of the pixels over the kernel sum).
+     */
+    struct WarpedRow {
+        WarpedRow(int width, int kernelWidth_, int kernelHeight_) :
+            kernelWidth(kernelWidth_), kernelHeight(kernelHeight_),
+            srcX(width), srcY(width), xVec(width*kernelWidth), yVec(width*kernelHeight), scale(width)
+        {}
+
+        int const kernelWidth;
+        int const kernelHeight;
+        std::vector<int> srcX;
+        std::vector<int> srcY;
+        std::vector<double> xVec;
+        std::vector<double> yVec;
+        std::vector<double> scale;
+    };
+
+    /*
+     * Fill in a WarpedRow, given the position on the source image of each pixel of the row
+     *
+     * @return the number of pixels in the row that aren't edge pixels
+     */
+    template <typename SrcImageT>
+    int computeWarpedRow(WarpedRow &row,                          // row to fill in
+                         SrcImageT const &srcImage,               // image being warped
+                         afwGeom::Point2D const *srcPosXY,        // position on srcImage of each pixel
+                         float const *relativeArea,               // relative area of each pixel
+                         WarpingKernelVectors const &kernelVectors, // kernel vectors at fractional positions
+                         int kernelCtrX, int kernelCtrY           // centre of warping kernel
+                        ) {
+        int const width = row.srcX.size();
+        int const srcWidth = srcImage.getWidth();
+        int const srcHeight = srcImage.getHeight();
+        int nGood = 0;
+        for (int x = 0; x != width; ++x) {
+            // Compute associated source pixel index as integer and nonnegative fractional parts;
+            // the latter is used to compute the remapping kernel.
+            std::pair<int, double> srcIndFracX = srcImage.positionToIndex(srcPosXY[x][0], afwImage::X);
+            std::pair<int, double> srcIndFracY = srcImage.positionToIndex(srcPosXY[x][1], afwImage::Y);
+            if (srcIndFracX.second < 0) {
+                ++srcIndFracX.second;
+                --srcIndFracX.first;
+            }
+            if (srcIndFracY.second < 0) {
+                ++srcIndFracY.second;
+                --srcIndFracY.first;
+            }
+
+            // Offset source pixel index from kernel center to kernel corner (0, 0)
+            int const srcX = srcIndFracX.first - kernelCtrX;
+            int const srcY = srcIndFracY.first - kernelCtrY;
+
+            // If location is too near the edge of the source, or off the source, mark the dest as edge
+            if ((srcX < 0) || (srcX + row.kernelWidth > srcWidth) ||
+                (srcY < 0) || (srcY + row.kernelHeight > srcHeight)) {
+                row.srcX[x] = -1;
+                continue;
+            }
+            ++nGood;
+
+            row.srcX[x] = srcX;
+            row.srcY[x] = srcY;
+            double const kSum = kernelVectors.compute(srcIndFracX.second, srcIndFracY.second,
+                                                      &row.xVec[x*row.kernelWidth],
+                                                      &row.yVec[x*row.kernelHeight]);
+            row.scale[x] = relativeArea[x]/kSum;
+        }
+        return nGood;
+    }
+
+    /*
+     * Set row y of a warped image plane from a WarpedRow
+     *
+     * Kernel pixels that are 0 are skipped (as in convolveAtAPoint), so non-finite source pixels
+     * only affect the warped pixels that they contribute to.
+     */
+    template <typename DestPixelT, typename SrcPixelT>
+    void warpPlaneRow(nd::Array<DestPixelT, 2, 1> const &dest,       // warped plane
+                      nd::Array<SrcPixelT const, 2, 1> const &src,   // source plane
+                      WarpedRow const &row,                         // how to compute the row
+                      int y,                                        // row of dest to set
+                      bool const isSquared,                         // use the square of the kernel?
+                      DestPixelT const edgeValue                    // value for edge pixels
+                     ) {
+        int const kWidth = row.kernelWidth;
+        int const kHeight = row.kernelHeight;
+        int const srcStride = src.template getStride<0>();
+        DestPixelT *destPtr = dest.getData() + y*dest.template getStride<0>();
+        for (int x = 0, width = row.srcX.size(); x != width; ++x) {
+            if (row.srcX[x] < 0) {
+                destPtr[x] = edgeValue;
+                continue;
+            }
+            double const *xVec = &row.xVec[x*kWidth];
+            double const *yVec = &row.yVec[x*kHeight];
+            SrcPixelT const *srcPtr = src.getData() + row.srcY[x]*srcStride + row.srcX[x];
+            double sum = 0.0;
+            for (int ky = 0; ky != kHeight; ++ky, srcPtr += srcStride) {
+                double const yVal = yVec[ky];
+                if (yVal == 0) {
+                    continue;
+                }
+                double rowSum = 0.0;
+                for (int kx = 0; kx != kWidth; ++kx) {
+                    double const xVal = xVec[kx];
+                    if (xVal != 0) {
+                        rowSum += srcPtr[kx]*(isSquared ? xVal*xVal : xVal);
+                    }
+                }
+                sum += rowSum*(isSquared ? yVal*yVal : yVal);
+            }
+            double const scale = row.scale[x];
+            destPtr[x] = static_cast<DestPixelT>(sum*(isSquared ? scale*scale : scale));
+        }
+    }
+
+    /*
+     * Set row y of a warped mask from a WarpedRow, to the OR of the source pixels under the nonzero
+     * kernel pixels
+     */
+    void warpMaskRow(nd::Array<afwImage::MaskPixel, 2, 1> const &dest,       // warped mask
+                     nd::Array<afwImage::MaskPixel const, 2, 1> const &src,   // source mask
+                     WarpedRow const &row,                                   // how to compute the row
+                     int y,                                                  // row of dest to set
+                     afwImage::MaskPixel const edgeValue                     // value for edge pixels
+                    ) {
+        int const kWidth = row.kernelWidth;
+        int const kHeight = row.kernelHeight;
+        int const srcStride = src.getStride<0>();
+        afwImage::MaskPixel *destPtr = dest.getData() + y*dest.getStride<0>();
+        for (int x = 0, width = row.srcX.size(); x != width; ++x) {
+            if (row.srcX[x] < 0) {
+                destPtr[x] = edgeValue;
+                continue;
+            }
+            double const *xVec = &row.xVec[x*kWidth];
+            double const *yVec = &row.yVec[x*kHeight];
+            afwImage::MaskPixel const *srcPtr = src.getData() + row.srcY[x]*srcStride + row.srcX[x];
+            afwImage::MaskPixel value = 0;
+            for (int ky = 0; ky != kHeight; ++ky, srcPtr += srcStride) {
+                if (yVec[ky] == 0) {
+                    continue;
+                }
+                for (int kx = 0; kx != kWidth; ++kx) {
+                    if (xVec[kx] != 0) {
+                        value |= srcPtr[kx];
+                    }
+                }
+            }
+            destPtr[x] = value;
+        }
+    }
+
+    /*
+     * Set row y of a warped Image from a WarpedRow
+     */
+    template <typename DestPixelT, typename SrcPixelT>
+    void warpRowByPlane(mathDetail::OutputPlanes<afwImage::Image<DestPixelT> > const &destPlanes,
+                        mathDetail::InputPlanes<afwImage::Image<SrcPixelT> > const &srcPlanes,
+                        WarpedRow const &row,
+                        int y,
+                        DestPixelT const edgePixel
+                       ) {
+        warpPlaneRow(destPlanes.image, srcPlanes.image, row, y, false, edgePixel);
+    }
+
+    /*
+     * Set row y of a warped MaskedImage from a WarpedRow; the variance is warped with the square
+     * of the kernel
+     */
+    template <typename DestPixelT, typename SrcPixelT>
+    void warpRowByPlane(mathDetail::OutputPlanes<afwImage::MaskedImage<DestPixelT> > const &destPlanes,
+                        mathDetail::InputPlanes<afwImage::MaskedImage<SrcPixelT> > const &srcPlanes,
+                        WarpedRow const &row,
+                        int y,
+                        typename afwImage::MaskedImage<DestPixelT>::SinglePixel const edgePixel
+                       ) {
+        warpPlaneRow(destPlanes.image, srcPlanes.image, row, y, false,
+                     static_cast<DestPixelT>(edgePixel.image()));
+        warpPlaneRow(destPlanes.variance, srcPlanes.variance, row, y, true,
+                     static_cast<afwImage::VariancePixel>(edgePixel.variance()));
+        warpMaskRow(destPlanes.mask, srcPlanes.mask, row, y, edgePixel.mask());
+    }
+
+    /*
+     * Warp one chunk of a band of rows of an image; called (possibly in parallel) for each chunk.
+     *
+     * The positions on the source image of the pixels of the band (and their relative areas)
+     * have already been computed, as the Wcs code isn't thread safe.
+     */
+    template <typename DestImageT, typename SrcImageT>
+    class WarpRows {
+    public:
+        WarpRows(
+            mathDetail::OutputPlanes<DestImageT> const &destPlanes, ///< views of the warped image
+            mathDetail::InputPlanes<SrcImageT> const &srcPlanes,    ///< views of the source image
+            SrcImageT const &srcImage,                  ///< source image
+            WarpingKernelVectors const &kernelVectors,  ///< kernel vectors at fractional positions
+            int kernelWidth,                            ///< width of kernel
+            int kernelHeight,                           ///< height of kernel
+            int kernelCtrX,                             ///< x index of kernel centre
+            int kernelCtrY,                             ///< y index of kernel centre
+            typename DestImageT::SinglePixel const &edgePixel, ///< value of edge pixels
+            std::vector<afwGeom::Point2D> const &srcPosXY, ///< position on source of each pixel of band
+            std::vector<float> const &relativeArea,     ///< relative area of each pixel of band
+            int y0,                                     ///< first row of the band
+            int nRow,                                   ///< number of rows in the band
+            int nChunk,                                 ///< number of chunks the rows are divided into
+            std::vector<int> &nGoodList                 ///< number of good pixels set by each chunk
+        ) :
+            _destPlanes(destPlanes),
+            _srcPlanes(srcPlanes),
+            _srcImage(srcImage),
+            _kernelVectors(kernelVectors),
+            _kernelWidth(kernelWidth),
+            _kernelHeight(kernelHeight),
+            _kernelCtrX(kernelCtrX),
+            _kernelCtrY(kernelCtrY),
+            _edgePixel(edgePixel),
+            _srcPosXY(srcPosXY),
+            _relativeArea(relativeArea),
+            _y0(y0),
+            _nRow(nRow),
+            _nChunk(nChunk),
+            _nGoodList(nGoodList)
+        { }
+
+        void operator()(int chunk) const {
+            int const width = _destPlanes.image.template getSize<1>();
+            int const rowBegin = (chunk*_nRow)/_nChunk;
+            int const rowEnd = ((chunk + 1)*_nRow)/_nChunk;
+
+            WarpedRow row(width, _kernelWidth, _kernelHeight);
+            int nGood = 0;
+            for (int i = rowBegin; i != rowEnd; ++i) {
+                nGood += computeWarpedRow(row, _srcImage, &_srcPosXY[i*width], &_relativeArea[i*width],
+                                          _kernelVectors, _kernelCtrX, _kernelCtrY);
+                warpRowByPlane(_destPlanes, _srcPlanes, row, _y0 + i, _edgePixel);
+            }
+            _nGoodList[chunk] = nGood;
+        }
+
+    private:
+        mathDetail::OutputPlanes<DestImageT> const &_destPlanes;
+        mathDetail::InputPlanes<SrcImageT> const &_srcPlanes;
+        SrcImageT const &_srcImage;
+        WarpingKernelVectors const &_kernelVectors;
+        int const _kernelWidth;
+        int const _kernelHeight;
+        int const _kernelCtrX;
+        int const _kernelCtrY;
+        typename DestImageT::SinglePixel const _edgePixel;
+        std::vector<afwGeom::Point2D> const &_srcPosXY;
+        std::vector<float> const &_relativeArea;
+        int const _y0;
+        int const _nRow;
+        int const _nChunk;
+        std::vector<int> &_nGoodList;
+    };
+}
+
+namespace {
+    /*
+     * Compute the position on the source image of each pixel of a row of the remapped image from the Wcs,
+     * every interpLength pixels with linear interpolation in between if interpLength > 0
+     *
+     * The rows all need temporary arrays of the same sizes, so they're recycled through a MemoryPool
+     */
+    class WcsSrcPositions {
+    public:
+        WcsSrcPositions(
+            afwImage::Wcs const &destWcs,   ///< WCS of remapped %image
+            afwImage::Wcs const &srcWcs,    ///< WCS of source %image
+            afwGeom::Point2I const &destXY0, ///< xy0 of remapped %image
+            int destWidth,                  ///< width of remapped %image
+            int interpLength                ///< distance over which WCS can be linearily interpolated
+        ) :
+            _destWcs(destWcs),
+            _srcWcs(srcWcs),
+            _destX0(destXY0.getX()),
+            _destY0(destXY0.getY()),
+            _destWidth(destWidth),
+            _interpLength(interpLength),
+            _pool(nd::MemoryPool::make())
+        {}
+
+        /*
+         * Set srcPosXY[-1, destWidth) for row -1 of the remapped image (the row below it)
+         */
+        void computeFirstRow(std::vector<afwGeom::Point2D>::iterator srcPosXY) const {
+            nd::Array<double,1,1> destX = nd::allocate(_destWidth + 1, _pool);
+            nd::Array<double,1,1> destY = nd::allocate(_destWidth + 1, _pool);
+            for (int x = -1; x != _destWidth; ++x) {
+                destX[x + 1] = afwImage::indexToPosition(_destX0 + x);
+                destY[x + 1] = afwImage::indexToPosition(_destY0 - 1);
+            }
+            computeSrcPositions(_destWcs, _srcWcs, destX, destY, &srcPosXY[-1], _pool);
+        }
+
+        /*
+         * Set srcPosXY[-1, destWidth) for row y of the remapped image, and the relative area of each pixel
+         */
+        void computeRow(
+            int y,                                              // row of remapped image
+            std::vector<afwGeom::Point2D>::iterator srcPosXY,   // source positions of this row
+            std::vector<afwGeom::Point2D>::iterator prevSrcPosXY, // source positions of the previous row
+            std::vector<float>::iterator relativeArea           // relative area of each pixel of this row
+        ) const {
+            //
+            // Choose the pixels whose transformations are computed from the Wcs:  the pixel just to the
+            // left of this row, and then either every pixel of the row or, rather than calculate the
+            // transformation for each pixel, the last pixel of each interval of interpLength pixels
+            //
+            std::vector<int> wcsX;
+            wcsX.push_back(-1);
+            if (_interpLength < 1) {
+                for (int x = 0; x < _destWidth; ++x) {
+                    wcsX.push_back(x);
+                }
+            } else {
+                for (int x = 0; x < _destWidth; x += _interpLength) {
+                    wcsX.push_back(std::min(x + _interpLength, _destWidth) - 1);
+                }
+            }
+            //
+            // Compute their transformations all at once
+            //
+            int const nWcs = wcsX.size();
+            nd::Array<double,1,1> destX = nd::allocate(nWcs, _pool);
+            nd::Array<double,1,1> destY = nd::allocate(nWcs, _pool);
+            for (int i = 0; i != nWcs; ++i) {
+                destX[i] = afwImage::indexToPosition(_destX0 + wcsX[i]);
+                destY[i] = afwImage::indexToPosition(_destY0 + y);
+            }
+            std::vector<afwGeom::Point2D> wcsSrcPosXY(nWcs);
+            computeSrcPositions(_destWcs, _srcWcs, destX, destY, &wcsSrcPosXY[0], _pool);
+            for (int i = 0; i != nWcs; ++i) {
+                int const x = wcsX[i];
+                srcPosXY[x] = wcsSrcPosXY[i];
+                // the pixel to the left of the row has no left neighbour in the previous row,
+                // so its area is computed from the same pixels as that of the row's first pixel
+                relativeArea[x] = computeRelativeArea(srcPosXY[x], prevSrcPosXY + std::max(x, 0));
+            }
+            //
+            // and linearly interpolate the others
+            //
+            if (_interpLength >= 1) {
+                for (int x = 0; x < _destWidth; x += _interpLength) {
+                    int const xend = std::min(x + _interpLength, _destWidth) - 1;
+                    int const interval = xend - x + 1;
+                    for (int i = 0; i < interval - 1; ++i) {
+                        for (int j = 0; j != 2; ++j) {
+                            srcPosXY[x + i].coeffRef(j) = srcPosXY[x - 1].coeffRef(j) +
+                                (i + 1)*(srcPosXY[xend].coeffRef(j) - srcPosXY[x - 1].coeffRef(j))/interval;
+                        }
+
+                        relativeArea[x + i] = relativeArea[x - 1] +
+                            (i + 1)*(relativeArea[xend] - relativeArea[x - 1])/interval;
+                    }
+                }
+            }
+        }
+
+    private:
+        afwImage::Wcs const &_destWcs;
+        afwImage::Wcs const &_srcWcs;
+        int const _destX0;
+        int const _destY0;
+        int const _destWidth;
+        int const _interpLength;
+        nd::MemoryPool::Ptr const _pool;  // recycles the temporary arrays of successive rows
+    };
+
+    /*
+     * Interpolate the position on the source image of each pixel of a row of the remapped image
+     * from a SrcPositionGrid
+     */
+    class GridSrcPositions {
+    public:
+        GridSrcPositions(
+            afwMath::SrcPositionGrid const &grid,   ///< source position grid
+            afwGeom::Point2I const &destXY0,        ///< xy0 of remapped %image
+            int destWidth                           ///< width of remapped %image
+        ) :
+            _grid(grid),
+            _destX0(destXY0.getX()),
+            _destY0(destXY0.getY()),
+            _destWidth(destWidth)
+        {}
+
+        void computeFirstRow(std::vector<afwGeom::Point2D>::iterator srcPosXY) const {
+            _grid.getSrcPositions(_destX0 - 1, _destY0 - 1, _destWidth + 1, &srcPosXY[-1]);
+        }
+
+        void computeRow(
+            int y,
+            std::vector<afwGeom::Point2D>::iterator srcPosXY,
+            std::vector<afwGeom::Point2D>::iterator prevSrcPosXY,
+            std::vector<float>::iterator relativeArea
+        ) const {
+            _grid.getSrcPositions(_destX0 - 1, _destY0 + y, _destWidth + 1, &srcPosXY[-1]);
+            for (int x = 0; x < _destWidth; ++x) {
+                // Correct intensity due to relative pixel spatial scale and kernel sum.
+                // The area computation is for a parallellogram.
+                afwGeom::Point2D dSrcA = srcPosXY[x] - afwGeom::Extent<double>(prevSrcPosXY[x - 1]);
+                afwGeom::Point2D dSrcB = srcPosXY[x] - afwGeom::Extent<double>(prevSrcPosXY[x]);
+                relativeArea[x] = std::abs(dSrcA.getX()*dSrcB.getY() - dSrcA.getY()*dSrcB.getX());
+            }
+        }
+
+    private:
+        afwMath::SrcPositionGrid const &_grid;
+        int const _destX0;
+        int const _destY0;
+        int const _destWidth;
+    };
+
+    /*
+     * Warp srcImage into destImage, given the position on srcImage of each pixel of destImage
+     *
+     * SrcPositionsT is WcsSrcPositions or GridSrcPositions
+     */
+    template<typename DestImageT, typename SrcImageT, typename SrcPositionsT>
+    int warpImageRows(
+        DestImageT &destImage,                  ///< remapped %image
+        SrcImageT const &srcImage,              ///< source %image
+        afwMath::SeparableKernel &warpingKernel, ///< warping kernel
+        SrcPositionsT const &srcPositions,      ///< computes the source position of each row's pixels
+        int const nThread                       ///< number of threads to use; <= 0 means one per core
+    ) {
+        int numGoodPixels = 0;
+
+        // Compute borders; use to prevent applying kernel outside of srcImage
+        const int kernelWidth = warpingKernel.getWidth();
+        const int kernelHeight = warpingKernel.getHeight();
+        const int kernelCtrX = warpingKernel.getCtrX();
+        const int kernelCtrY = warpingKernel.getCtrY();
+
+        // Get the source MaskedImage and a pixel accessor to it.
+        const int srcWidth = srcImage.getWidth();
+        const int srcHeight = srcImage.getHeight();
+
+        pexLog::TTrace<3>("lsst.afw.math.warp", "source image width=%d; height=%d", srcWidth, srcHeight);
+
+        const int destWidth = destImage.getWidth();
+        const int destHeight = destImage.getHeight();
+        pexLog::TTrace<3>("lsst.afw.math.warp", "remap image width=%d; height=%d", destWidth, destHeight);
+
+        const typename DestImageT::SinglePixel edgePixel = afwMath::edgePixel<DestImageT>(
+            typename afwImage::detail::image_traits<DestImageT>::image_category()
+        );
+
+        if (destWidth == 0 || destHeight == 0) {
+            return 0;
+        }
+
+        // Only tabulated kernels may be evaluated by several threads at once
+        WarpingKernelVectors const kernelVectors(warpingKernel);
+        int const nThreadMax = kernelVectors.isTabulated() ? mathDetail::getNumThreads(nThread) : 1;
+
+        mathDetail::OutputPlanes<DestImageT> const destPlanes(destImage);
+        mathDetail::InputPlanes<SrcImageT> const srcPlanes(srcImage);
+
+        // Set each pixel of destExposure's MaskedImage
+        pexLog::TTrace<4>("lsst.afw.math.warp", "Remapping masked image using up to %d threads", nThreadMax);
+
+        std::vector<afwGeom::Point2D> _srcPosXY(1 + destWidth);
+        std::vector<afwGeom::Point2D>::iterator srcPosXY = _srcPosXY.begin() + 1;
+        // compute source position X,Y corresponding to row -1 of the destination image;
+        // this is used for computing relative pixel scale
+        srcPositions.computeFirstRow(srcPosXY);
+        //
+        // We overallocate a pixel here, and make prevSrcPosXY point to second element (which will be
+        // pixel [0]) so that prevSrcPosXY[-1] is valid
+        //
+        std::vector<afwGeom::Point2D> _prevSrcPosXY(1 + destWidth); // previous row's srcPosXY vector
+        std::vector<afwGeom::Point2D>::iterator prevSrcPosXY = _prevSrcPosXY.begin() + 1;
+        std::vector<float> _relativeArea(1 + destWidth); // relative dest and src area for each pixel
+        std::vector<float>::iterator relativeArea = _relativeArea.begin() + 1;
+        //
+        // The source positions are computed a row at a time (the Wcs code isn't thread safe), and saved
+        // for a band of rows; each full band is then warped, possibly in parallel
+        //
+        int const bandHeight = std::min(destHeight, WarpingBandHeight);
+        std::vector<afwGeom::Point2D> bandSrcPosXY(bandHeight*destWidth);
+        std::vector<float> bandRelativeArea(bandHeight*destWidth);
+
+        for (int y = 0; y < destHeight; ++y) {
+            //
+            // Set prevSrcPosXY from last row's srcPosXY. Note that we overallocated a pixel,
+            // so it's safe to set the [-1] element
+            //
+            std::copy(srcPosXY - 1, srcPosXY + destWidth, prevSrcPosXY - 1);
+            srcPositions.computeRow(y, srcPosXY, prevSrcPosXY, relativeArea);
+
+            int const bandRow = y%bandHeight;
+            std::copy(srcPosXY, srcPosXY + destWidth, bandSrcPosXY.begin() + bandRow*destWidth);
+            std::copy(relativeArea, relativeArea + destWidth,
+                      bandRelativeArea.begin() + bandRow*destWidth);
+            if (bandRow == bandHeight - 1 || y == destHeight - 1) {
+                int const nRow = bandRow + 1;
+                int const nChunk = std::min(nThreadMax, nRow);
+                std::vector<int> nGoodList(nChunk, 0);
+                mathDetail::parallelFor(0, nChunk,
+                                        WarpRows<DestImageT, SrcImageT>(
+                                            destPlanes, srcPlanes, srcImage, kernelVectors,
+                                            kernelWidth, kernelHeight, kernelCtrX, kernelCtrY, edgePixel,
+                                            bandSrcPosXY, bandRelativeArea, y + 1 - nRow, nRow, nChunk,
+                                            nGoodList),
+                                        nChunk);
+                numGoodPixels += std::accumulate(nGoodList.begin(), nGoodList.end(), 0);
+            }
+        } // dest y pixels
+
+        return numGoodPixels;
     }
 }
 
@@ -248,6 +1080,20 @@ namespace {
  *   (width/2, /height/2). This is because the kernel is used to map source positions that range from
  *   centered on on pixel (width/2, height/2) to nearly centered on pixel (width/2 + 1, height/2 + 1).
  *
+ * The x and y functions of a LanczosWarpingKernel or BilinearWarpingKernel are tabulated at 1/1024 pixel
+ * resolution and linearly interpolated, rather than evaluated for each pixel.  The interpolated Lanczos
+ * functions are within 10^-6 of the true values (the bilinear functions are linear, so are reproduced to
+ * within rounding error).  Any cache set by SeparableKernel::computeCache is not used by these kernels;
+ * other kernels are evaluated for each pixel.
+ *
+ * \b Threads:
+ *
+ * If nThread is not 1, the rows are warped by up to nThread threads (or one per core, if nThread <= 0),
+ * in bands of 64 rows.  The pixel positions on srcImage are still computed by the calling thread,
+ * as the Wcs code is not thread safe.  Only tabulated kernels are used by several threads;
+ * images are warped with other kernels in the calling thread.  The result is the same for any
+ * number of threads.
+ *
  * \b Algorithm:
  *
  * For each integer pixel position in the remapped Exposure:
@@ -255,7 +1101,8 @@ namespace {
  * - The associated pixel position on srcImage is determined using the source WCS.
  * - A remapping kernel is computed based on the fractional part of the pixel position on srcImage
  * - The remapping kernel is applied to srcImage at the integer portion of the pixel position
- *   to compute the remapped pixel value
+ *   to compute the remapped pixel value; this is done for all pixels of a row before it is used
+ *   (a plane at a time, for a MaskedImage).
  * - The flux-conserving factor is determined from the source and new WCS.
  *   and is applied to the remapped pixel
  *
@@ -265,6 +1112,10 @@ namespace {
  * - The area varies slowly enough across the %image that we can get away with computing
  *   the source area shifted by half a pixel up and to the left of the true area.
  *
+ * Evaluating the Wcs often dominates the time taken to warp, unless interpLength is large.
+ * A SrcPositionGrid interpolates the positions in both x and y to a specified accuracy, and may be
+ * used for several images; see the version of warpImage() that takes one.
+ *
  * \throw lsst::pex::exceptions::InvalidParameterException if destImage is srcImage
  *
  * \todo Should support an additional color-based position correction in the remapping (differential chromatic
@@ -279,187 +1130,52 @@ int afwMath::warpImage(
     SrcImageT const &srcImage,          ///< source %image
     afwImage::Wcs const &srcWcs,        ///< WCS of source %image
     SeparableKernel &warpingKernel,     ///< warping kernel; determines warping algorithm
-    int const interpLength              ///< Distance over which WCS can be linearily interpolated
+    int const interpLength,             ///< Distance over which WCS can be linearily interpolated
+    int const nThread                   ///< number of threads to use; <= 0 means one per core
     )
 {
     if (afwMath::details::isSameObject(destImage, srcImage)) {
         throw LSST_EXCEPT(pexExcept::InvalidParameterException,
             "destImage is srcImage; cannot warp in place");
     }
-    int numGoodPixels = 0;
-
-    typedef afwImage::Image<afwMath::Kernel::Pixel> KernelImageT;
-    
-    // Compute borders; use to prevent applying kernel outside of srcImage
-    const int kernelWidth = warpingKernel.getWidth();
-    const int kernelHeight = warpingKernel.getHeight();
-    const int kernelCtrX = warpingKernel.getCtrX();
-    const int kernelCtrY = warpingKernel.getCtrY();
-
-    // Get the source MaskedImage and a pixel accessor to it.
-    const int srcWidth = srcImage.getWidth();
-    const int srcHeight = srcImage.getHeight();
-
-    pexLog::TTrace<3>("lsst.afw.math.warp", "source image width=%d; height=%d", srcWidth, srcHeight);
-
-    const int destWidth = destImage.getWidth();
-    const int destHeight = destImage.getHeight();
-    pexLog::TTrace<3>("lsst.afw.math.warp", "remap image width=%d; height=%d", destWidth, destHeight);
-
-    const typename DestImageT::SinglePixel edgePixel = afwMath::edgePixel<DestImageT>(
-        typename afwImage::detail::image_traits<DestImageT>::image_category()
-    );
-    
-    std::vector<double> kernelXList(kernelWidth);
-    std::vector<double> kernelYList(kernelHeight);
-
-    // Set each pixel of destExposure's MaskedImage
-    pexLog::TTrace<4>("lsst.afw.math.warp", "Remapping masked image");
-    
-    std::vector<afwGeom::Point2D> _srcPosXY(1 + destWidth);
-    std::vector<afwGeom::Point2D>::iterator srcPosXY = _srcPosXY.begin() + 1;
-    // compute source position X,Y corresponding to row -1 of the destination image;
-    // this is used for computing relative pixel scale
-    for (int x = -1; x != destWidth; ++x) {
-        afwGeom::Point2D destPosXY = afwGeom::Point2D(destImage.indexToPosition(x, afwImage::X),
-                                                         destImage.indexToPosition(-1, afwImage::Y));
-        srcPosXY[x] = srcWcs.skyToPixel(destWcs.pixelToSky(destPosXY));
-    }
-    //
-    // We overallocate a pixel here, and make prevSrcPosXY point to second element (which will be pixel [0])
-    // so that prevSrcPosXY[-1] is valid
-    //
-    std::vector<afwGeom::Point2D> _prevSrcPosXY(1 + destWidth); // previous row's srcPosXY vector
-    std::vector<afwGeom::Point2D>::iterator prevSrcPosXY = _prevSrcPosXY.begin() + 1;
-    std::vector<float> _relativeArea(1 + destWidth); // relative dest and src area for each pixel
-    std::vector<float>::iterator relativeArea = _relativeArea.begin() + 1;
-    
-    afwGeom::Point2D oneSrcPosXY;
-    for (int y = 0; y < destHeight; ++y) {
-        //
-        // Set prevSrcPosXY from last row's srcPosXY. Note that we overallocated a pixel,
-        // so it's safe to set the [-1] element
-        //
-        std::copy(srcPosXY - 1, srcPosXY + destWidth, prevSrcPosXY - 1);
-        //
-        // Calculate the transformation for the pixel just to the left of this row
-        //
-        afwGeom::Point2D destPosXY = afwGeom::Point2D(destImage.indexToPosition(-1, afwImage::X),
-                                                         destImage.indexToPosition(y, afwImage::Y));
-        {
-            std::pair<afwGeom::Point2D, float> res = getSrcPos(destPosXY, destWcs, srcWcs,
-                                                               prevSrcPosXY);
-            srcPosXY[-1] = res.first;
-            relativeArea[-1] = res.second;
-        }
-        //
-        // Compute the transformations for this row
-        //
-        // Rather than calculate the transformation for each pixel, we'll estimate it every interpLength
-        // pixels
-        //
-#if 1
-        if (interpLength < 1) {
-            for (int x = 0; x < destWidth; ++x) {
-                // compute sky position associated with this pixel of remapped MaskedImage
-                destPosXY[0] = destImage.indexToPosition(x, afwImage::X);
-                std::pair<afwGeom::Point2D, float> res =
-                    getSrcPos(destPosXY, destWcs, srcWcs, prevSrcPosXY + x);
-                srcPosXY[x] = res.first;
-                relativeArea[x] = res.second;
-            }
-        } else {
-            for (int x = 0; x < destWidth + interpLength; x += interpLength) {
-                int interval = interpLength;
-                int xend = x + interval - 1;
-                if (xend >= destWidth) {
-                    xend = destWidth - 1;
-                    interval = xend - x + 1;
-                }
-                // compute sky position associated with [xend] pixel of remapped MaskedImage
-                destPosXY[0] = destImage.indexToPosition(xend, afwImage::X);
-
-                std::pair<afwGeom::Point2D, float> res = getSrcPos(destPosXY, destWcs, srcWcs,
-                                                                   prevSrcPosXY + xend);
-                srcPosXY[xend] = res.first;
-                relativeArea[xend] = res.second;
-
-                for (int i = 0; i < interval - 1; ++i) {
-                    for (int j = 0; j != 2; ++j) {
-                        srcPosXY[x + i].coeffRef(j) = srcPosXY[x - 1].coeffRef(j) +
-                            (i + 1)*(srcPosXY[xend].coeffRef(j) - srcPosXY[x - 1].coeffRef(j))/interval;
-                    }
-
-                    relativeArea[x + i] = relativeArea[x - 1] +
-                        (i + 1)*(relativeArea[xend] - relativeArea[x - 1])/interval;
-                }
-            }
-        }
-#else
-        for (int x = 0; x < destWidth; ++x) {
-            // compute sky position associated with this pixel of remapped MaskedImage
-            destPosXY[0] = destImage.indexToPosition(x, afwImage::X);
-
-            // Compute associated pixel position on source MaskedImage
-            srcPosXY[x] = srcWcs.skyToPixel(destWcs.pixelToSky(destPosXY));
-            {
-                // Correct intensity due to relative pixel spatial scale and kernel sum.
-                // The area computation is for a parallellogram.
-                oneSrcPosXY = srcPosXY[x];
-                afwGeom::Point2D dSrcA = oneSrcPosXY - afwGeom::Extent<double>(prevSrcPosXY[x - 1]);
-                afwGeom::Point2D dSrcB = oneSrcPosXY - afwGeom::Extent<double>(prevSrcPosXY[x    ]);
-                relativeArea[x] = std::abs(dSrcA.getX()*dSrcB.getY() - dSrcA.getY()*dSrcB.getX());
-            }
-        }
-#endif
-        
-        typename DestImageT::x_iterator destXIter = destImage.row_begin(y);
-        for (int x = 0; x < destWidth; ++x, ++destXIter) {
-            oneSrcPosXY = srcPosXY[x];  // pixel position on source
-
-            // Compute associated source pixel index as integer and nonnegative fractional parts;
-            // the latter is used to compute the remapping kernel.
-            std::pair<int, double> srcIndFracX = srcImage.positionToIndex(oneSrcPosXY[0], afwImage::X);
-            std::pair<int, double> srcIndFracY = srcImage.positionToIndex(oneSrcPosXY[1], afwImage::Y);
-            if (srcIndFracX.second < 0) {
-                ++srcIndFracX.second;
-                --srcIndFracX.first;
-            }
-            if (srcIndFracY.second < 0) {
-                ++srcIndFracY.second;
-                --srcIndFracY.first;
-            }
-
-            // Offset source pixel index from kernel center to kernel corner (0, 0)
-            // so we can convolveAtAPoint the pixels that overlap between source and kernel
-            srcIndFracX.first -= kernelCtrX;
-            srcIndFracY.first -= kernelCtrY;
-          
-            // If location is too near the edge of the source, or off the source, mark the dest as edge
-            if ((srcIndFracX.first < 0) || (srcIndFracX.first + kernelWidth > srcWidth) ||
-                (srcIndFracY.first < 0) || (srcIndFracY.first + kernelHeight > srcHeight)) {
-                // skip this pixel
-                *destXIter = edgePixel;
-            } else {
-                ++numGoodPixels;
-                    
-                // Compute warped pixel
-                std::pair<double, double> srcFracInd(srcIndFracX.second, srcIndFracY.second);
-                warpingKernel.setKernelParameters(srcFracInd);
-                double kSum = warpingKernel.computeVectors(kernelXList, kernelYList, false);
-
-                typename SrcImageT::const_xy_locator srcLoc =
-                    srcImage.xy_at(srcIndFracX.first, srcIndFracY.first);
-                
-                *destXIter = afwMath::convolveAtAPoint<DestImageT,SrcImageT>(srcLoc, kernelXList, kernelYList);
-                *destXIter *= relativeArea[x]/kSum;
-            }
-        } // dest x pixels
-    } // dest y pixels
-
-    return numGoodPixels;
+    WcsSrcPositions const srcPositions(destWcs, srcWcs, destImage.getXY0(), destImage.getWidth(),
+                                       interpLength);
+    return warpImageRows(destImage, srcImage, warpingKernel, srcPositions, nThread);
 }
 
+/**
+ * \brief Remap an Image or MaskedImage, using a SrcPositionGrid for the position on srcImage
+ * of each pixel of destImage.
+ *
+ * This is otherwise the same as the version of warpImage() that takes two Wcs; building the grid once
+ * and using it for several images with the same pair of Wcs saves evaluating the Wcs for each %image.
+ *
+ * \return the number of valid pixels in destImage (those that are not edge pixels).
+ *
+ * \throw lsst::pex::exceptions::InvalidParameterException if destImage is srcImage
+ * \throw lsst::pex::exceptions::InvalidParameterException if the parent bounding box of destImage
+ *  is not contained in srcPositionGrid's destination bounding box
+ */
+template<typename DestImageT, typename SrcImageT>
+int afwMath::warpImage(
+    DestImageT &destImage,              ///< remapped %image
+    SrcImageT const &srcImage,          ///< source %image
+    SrcPositionGrid const &srcPositionGrid, ///< position on srcImage of each pixel of destImage
+    SeparableKernel &warpingKernel,     ///< warping kernel; determines warping algorithm
+    int const nThread                   ///< number of threads to use; <= 0 means one per core
+    )
+{
+    if (afwMath::details::isSameObject(destImage, srcImage)) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException,
+            "destImage is srcImage; cannot warp in place");
+    }
+    if (!srcPositionGrid.getDestBBox().contains(destImage.getBBox(afwImage::PARENT))) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException,
+            "destImage is not contained in the bounding box of srcPositionGrid");
+    }
+    GridSrcPositions const srcPositions(srcPositionGrid, destImage.getXY0(), destImage.getWidth());
+    return warpImageRows(destImage, srcImage, warpingKernel, srcPositions, nThread);
+}
 
 //
 // Explicit instantiations
@@ -477,17 +1193,27 @@ int afwMath::warpImage(
         afwImage::Wcs const &destWcs, \
         IMAGE(SRCIMAGEPIXELT) const &srcImage, \
         afwImage::Wcs const &srcWcs, \
-        SeparableKernel &warpingKernel, int const interpLength); NL    \
+        SeparableKernel &warpingKernel, int const interpLength, int const nThread); NL    \
     template int afwMath::warpImage( \
         MASKEDIMAGE(DESTIMAGEPIXELT) &destImage, \
         afwImage::Wcs const &destWcs, \
         MASKEDIMAGE(SRCIMAGEPIXELT) const &srcImage, \
         afwImage::Wcs const &srcWcs, \
-        SeparableKernel &warpingKernel, int const interpLength); NL    \
+        SeparableKernel &warpingKernel, int const interpLength, int const nThread); NL    \
+    template int afwMath::warpImage( \
+        IMAGE(DESTIMAGEPIXELT) &destImage, \
+        IMAGE(SRCIMAGEPIXELT) const &srcImage, \
+        SrcPositionGrid const &srcPositionGrid, \
+        SeparableKernel &warpingKernel, int const nThread); NL    \
+    template int afwMath::warpImage( \
+        MASKEDIMAGE(DESTIMAGEPIXELT) &destImage, \
+        MASKEDIMAGE(SRCIMAGEPIXELT) const &srcImage, \
+        SrcPositionGrid const &srcPositionGrid, \
+        SeparableKernel &warpingKernel, int const nThread); NL    \
     template int afwMath::warpExposure( \
         EXPOSURE(DESTIMAGEPIXELT) &destExposure, \
         EXPOSURE(SRCIMAGEPIXELT) const &srcExposure, \
-        SeparableKernel &warpingKernel, int const interpLength);
+        SeparableKernel &warpingKernel, int const interpLength, int const nThread);
 
 INSTANTIATE(double, double)
 INSTANTIATE(double, float)
@@ -24,6 +24,7 @@
  
 #include <iostream>
 #include <cmath>
+#include <limits>
 #include <vector>
 
 #define BOOST_TEST_DYN_LINK
@@ -32,6 +33,7 @@
 #include "boost/test/unit_test.hpp"
 #include "boost/test/floating_point_comparison.hpp"
 
+#include "lsst/utils/ieee.h"
 #include "lsst/afw/image/Image.h"
 #include "lsst/afw/math/Interpolate.h"
 #include "lsst/afw/math/Background.h"
@@ -227,3 +229,172 @@ BOOST_AUTO_TEST_CASE(BackgroundParabola) { /* parasoft-suppress  LsstDm-3-2a Lss
     }
 }
 
+
+BOOST_AUTO_TEST_CASE(BackgroundBulk) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const nX = 101;
+    int const nY = 77;
+    image::MaskedImage<float> mimg(geom::Extent2I(nX, nY));
+    for (int j = 0; j < nY; ++j) {
+        for (int i = 0; i < nX; ++i) {
+            mimg.at(i, j).image() = 1000.0 + 0.3*i - 0.2*j + 1.0e-3*i*j + ((i*7 + j*13)%17)/17.0;
+        }
+    }
+
+    math::Interpolate::Style const styles[] = {math::Interpolate::AKIMA_SPLINE, math::Interpolate::CONSTANT};
+    for (int s = 0; s != 2; ++s) {
+        math::BackgroundControl bctrl(styles[s]);
+        if (styles[s] == math::Interpolate::CONSTANT) {
+            bctrl.setNxSample(1);
+            bctrl.setNySample(1);
+        } else {
+            bctrl.setNxSample(6);
+            bctrl.setNySample(5);
+        }
+        math::Background backobj = math::makeBackground(mimg, bctrl);
+        image::Image<float>::Ptr bimg = backobj.getImage<float>();
+
+        // getPixels() agrees with getPixel() and getImage()
+        vector<int> xpix, ypix;
+        for (int j = 0; j < nY; j += 7) {
+            for (int i = nX - 1; i >= 0; i -= 5) {
+                xpix.push_back(i);
+                ypix.push_back((j*3)%nY);
+            }
+        }
+        vector<double> values = backobj.getPixels(xpix, ypix);
+        BOOST_REQUIRE_EQUAL(values.size(), xpix.size());
+        for (unsigned int i = 0; i != values.size(); ++i) {
+            BOOST_CHECK_EQUAL(values[i], backobj.getPixel(xpix[i], ypix[i]));
+            BOOST_CHECK_EQUAL(static_cast<float>(values[i]), (*bimg)(xpix[i], ypix[i]));
+        }
+
+        // a sub-region of the background image
+        geom::Box2I const bbox(geom::Point2I(13, 21), geom::Extent2I(40, 30));
+        image::Image<float>::Ptr subimg = backobj.getImage<float>(bbox);
+        BOOST_CHECK_EQUAL(subimg->getX0(), bbox.getMinX());
+        BOOST_CHECK_EQUAL(subimg->getY0(), bbox.getMinY());
+        for (int j = 0; j < bbox.getHeight(); ++j) {
+            for (int i = 0; i < bbox.getWidth(); ++i) {
+                BOOST_CHECK_EQUAL((*subimg)(i, j), (*bimg)(i + bbox.getMinX(), j + bbox.getMinY()));
+            }
+        }
+
+        // subtracting in place is the same as subtracting the background image
+        image::Image<float> diff(*mimg.getImage(), true);
+        diff -= *bimg;
+        image::MaskedImage<float> mdiff(mimg, true);
+        backobj.subtractFrom(mdiff);
+        for (int j = 0; j < nY; ++j) {
+            for (int i = 0; i < nX; ++i) {
+                BOOST_CHECK_EQUAL(mdiff.at(i, j).image(), diff(i, j));
+            }
+        }
+    }
+
+    math::Background backobj = math::makeBackground(mimg, math::BackgroundControl(math::Interpolate::LINEAR));
+    image::Image<float> small(geom::Extent2I(nX - 1, nY));
+    BOOST_CHECK_THROW(backobj.subtractFrom(small), lsst::pex::exceptions::LengthErrorException);
+    BOOST_CHECK_THROW(backobj.getImage<float>(geom::Box2I(geom::Point2I(-1, 0), geom::Extent2I(10, 10))),
+                      lsst::pex::exceptions::LengthErrorException);
+    BOOST_CHECK_THROW(backobj.getPixels(vector<int>(1, nX), vector<int>(1, 0)),
+                      lsst::pex::exceptions::LengthErrorException);
+    BOOST_CHECK_THROW(backobj.getPixels(vector<int>(2, 0), vector<int>(1, 0)),
+                      lsst::pex::exceptions::LengthErrorException);
+}
+
+BOOST_AUTO_TEST_CASE(BackgroundThreads) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const nX = 256;
+    int const nY = 200;
+    image::Image<float> img(geom::Extent2I(nX, nY));
+    for (int j = 0; j < nY; ++j) {
+        for (int i = 0; i < nX; ++i) {
+            img(i, j) = 100.0 + 0.01*i + 0.02*j + ((i*31 + j*17)%23)/23.0;
+        }
+    }
+
+    math::BackgroundControl bctrl(math::Interpolate::AKIMA_SPLINE);
+    bctrl.setNxSample(8);
+    bctrl.setNySample(7);
+    image::Image<float>::Ptr bimg1 = math::makeBackground(img, bctrl).getImage<float>();
+
+    int const nThreads[] = {3, 0};
+    for (int t = 0; t != 2; ++t) {
+        bctrl.setNumThreads(nThreads[t]);
+        BOOST_CHECK_EQUAL(bctrl.getNumThreads(), nThreads[t]);
+        image::Image<float>::Ptr bimg = math::makeBackground(img, bctrl).getImage<float>();
+        for (int j = 0; j < nY; ++j) {
+            for (int i = 0; i < nX; ++i) {
+                BOOST_CHECK_EQUAL((*bimg)(i, j), (*bimg1)(i, j));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BackgroundBadCells) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    // a ramp, which the splines reproduce; sub-images are 41x31, so their means are at their centres
+    int const nX = 246;
+    int const nY = 186;
+    double const dzdx = 0.1;
+    double const dzdy = 0.2;
+    double const z0 = 10000.0;
+    image::MaskedImage<double> mimg(geom::Extent2I(nX, nY));
+    *mimg.getMask() = 0x0;
+    *mimg.getVariance() = 1.0;
+    for (int j = 0; j < nY; ++j) {
+        for (int i = 0; i < nX; ++i) {
+            mimg.at(i, j).image() = dzdx*i + dzdy*j + z0;
+        }
+    }
+    image::MaskPixel const badBit = image::Mask<>::getPlaneBitMask("BAD");
+
+    math::BackgroundControl bctrl(math::Interpolate::AKIMA_SPLINE);
+    bctrl.setNxSample(6);
+    bctrl.setNySample(6);
+    bctrl.getStatisticsControl()->setNumSigmaClip(20.0);
+    bctrl.getStatisticsControl()->setNumIter(1);
+    bctrl.getStatisticsControl()->setAndMask(badBit);
+
+    // sub-image (2, 1) is entirely masked, (4, 4) is mostly masked, and (5, 3) is entirely NaN
+    for (int j = 31; j < 62; ++j) {
+        for (int i = 82; i < 123; ++i) {
+            mimg.at(i, j).mask() = badBit;
+        }
+    }
+    for (int j = 124; j < 155; ++j) {
+        for (int i = 164; i < 203; ++i) {
+            mimg.at(i, j).mask() = badBit;
+        }
+    }
+    for (int j = 93; j < 124; ++j) {
+        for (int i = 205; i < 246; ++i) {
+            mimg.at(i, j).image() = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    bctrl.setMinGoodFraction(0.5);
+    BOOST_CHECK_EQUAL(bctrl.getMinGoodFraction(), 0.5);
+    math::Background backobj = math::makeBackground(mimg, bctrl);
+
+    for (int j = 0; j < nY; j += 15) {
+        for (int i = 0; i < nX; i += 20) {
+            BOOST_CHECK_CLOSE(backobj.getPixel(i, j), dzdx*i + dzdy*j + z0, 1.0e-6);
+        }
+    }
+
+    // With the default (no minimum fraction) the mostly-masked sub-image is used, so only the wholly
+    // bad sub-images are interpolated over
+    bctrl.setMinGoodFraction(0.0);
+    backobj = math::makeBackground(mimg, bctrl);
+    for (int j = 0; j < nY; j += 15) {
+        for (int i = 0; i < nX; i += 20) {
+            BOOST_CHECK(!lsst::utils::isnan(backobj.getPixel(i, j)));
+        }
+    }
+
+    // If every sub-image is bad there's nothing to interpolate from
+    *mimg.getMask() = badBit;
+    BOOST_CHECK_THROW(math::makeBackground(mimg, bctrl), lsst::pex::exceptions::RuntimeErrorException);
+}
@@ -78,6 +78,13 @@ GarbageChars = string.punctuation + string.whitespace
 
 #-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
+def copyArrays(maskedImage):
+    """Return copies of the (image, mask, variance) arrays of a masked image
+
+    getArrays returns views, which would follow the masked image if it is convolved into again.
+    """
+    return tuple(arr.copy() for arr in maskedImage.getArrays())
+
 def refConvolve(imMaskVar, xy0, kernel, doNormalize, doCopyEdge):
     """Reference code to convolve a kernel with a masked image.
 
@@ -365,6 +372,11 @@ class ConvolveTestCase(unittest.TestCase):
         for maxInterpDist in (0, 1, 2, 10, 100):
             convControl.setMaxInterpolationDistance(maxInterpDist)
             self.assertEqual(convControl.getMaxInterpolationDistance(), maxInterpDist)
+
+        self.assertEqual(convControl.getNumThreads(), 1)
+        for nThread in (0, 1, 4):
+            convControl.setNumThreads(nThread)
+            self.assertEqual(convControl.getNumThreads(), nThread)
         
     def testUnityConvolution(self):
         """Verify that convolution with a centered delta function reproduces the original.
@@ -413,6 +425,108 @@ class ConvolveTestCase(unittest.TestCase):
         
         self.runStdTest(fixedKernel, kernelDescr="Gaussian FixedKernel")
 
+    def testFftConvolve(self):
+        """Test convolve with a kernel large enough to be convolved using FFTs
+        """
+        kWidth = 17
+        kHeight = 19
+
+        kFunc =  afwMath.GaussianFunction2D(4.5, 3.5, 0.5)
+        analyticKernel = afwMath.AnalyticKernel(kWidth, kHeight, kFunc)
+        kernelImage = afwImage.ImageD(afwGeom.Extent2I(kWidth, kHeight))
+        analyticKernel.computeImage(kernelImage, False)
+        fixedKernel = afwMath.FixedKernel(kernelImage)
+        self.assert_(mathDetail.isFftConvolutionPreferred(fixedKernel, afwMath.ConvolutionControl()))
+
+        self.runStdTest(fixedKernel, kernelDescr="Gaussian FixedKernel convolved using FFTs")
+        self.runStdTest(analyticKernel, kernelDescr="Gaussian AnalyticKernel convolved using FFTs")
+
+        # the FFT and direct results should agree to within rounding error
+        convControl = afwMath.ConvolutionControl()
+        afwMath.convolve(self.cnvMaskedImage, self.maskedImage, fixedKernel, convControl)
+        fftImMaskVarArr = copyArrays(self.cnvMaskedImage)
+        convControl.setMinFftKernelSize(0)
+        self.assert_(not mathDetail.isFftConvolutionPreferred(fixedKernel, convControl))
+        afwMath.convolve(self.cnvMaskedImage, self.maskedImage, fixedKernel, convControl)
+        directImMaskVarArr = copyArrays(self.cnvMaskedImage)
+        errStr = imTestUtils.maskedImagesDiffer(fftImMaskVarArr, directImMaskVarArr,
+            doVariance = True, rtol=1.0e-05, atol=1e-08)
+        self.assert_(not errStr, "FFT and direct convolution differ:\n%s" % (errStr,))
+
+        # clearing the cache of FFTW plans mustn't change the results
+        mathDetail.clearFftCache()
+        convControl.setMinFftKernelSize(15)
+        afwMath.convolve(self.cnvMaskedImage, self.maskedImage, fixedKernel, convControl)
+        errStr = imTestUtils.maskedImagesDiffer(fftImMaskVarArr, self.cnvMaskedImage.getArrays(),
+            doVariance = True, rtol=0, atol=0)
+        self.assert_(not errStr, "FFT convolution changed after clearing the cache:\n%s" % (errStr,))
+
+    def testThreadedConvolve(self):
+        """Test that convolving using several threads matches convolving using one
+        """
+        sFunc = afwMath.PolynomialFunction2D(1)
+        sParams = (
+            (1.5, 1.0 / self.width, 0.0),
+            (1.5, 0.0, 1.0 / self.height),
+            (0.0, 0.0, 0.0),
+        )
+        gaussFunc1 = afwMath.GaussianFunction1D(1.0)
+        gaussFunc2 = afwMath.GaussianFunction2D(1.0, 1.0, 0.0)
+
+        fixedKernel = afwMath.AnalyticKernel(7, 6, gaussFunc2)
+        separableKernel = afwMath.SeparableKernel(7, 6, gaussFunc1, gaussFunc1)
+        varyingKernel = afwMath.AnalyticKernel(7, 6, gaussFunc2, sFunc)
+        varyingKernel.setSpatialParameters(sParams)
+        varyingSeparableKernel = afwMath.SeparableKernel(7, 6, gaussFunc1, gaussFunc1, sFunc)
+        varyingSeparableKernel.setSpatialParameters(sParams[0:2])
+        fftKernel = afwMath.AnalyticKernel(17, 19, afwMath.GaussianFunction2D(4.5, 3.5, 0.5))
+
+        for kernel, maxInterpDist, rtol, kernelDescr in (
+            (fixedKernel,             10, 0.0,    "spatially invariant kernel"),
+            (separableKernel,         10, 0.0,    "separable kernel"),
+            (varyingKernel,            0, 0.0,    "spatially varying kernel using brute force"),
+            (varyingKernel,           10, 0.0,    "spatially varying kernel using interpolation"),
+            (varyingSeparableKernel,  10, 0.0,    "spatially varying separable kernel"),
+            (fftKernel,               10, 1e-10,  "kernel convolved using FFTs"),
+        ):
+            convControl = afwMath.ConvolutionControl()
+            convControl.setMaxInterpolationDistance(maxInterpDist)
+            afwMath.convolve(self.cnvMaskedImage, self.maskedImage, kernel, convControl)
+            serialImMaskVarArr = copyArrays(self.cnvMaskedImage)
+            for nThread in (2, 3, 0):
+                convControl.setNumThreads(nThread)
+                afwMath.convolve(self.cnvMaskedImage, self.maskedImage, kernel, convControl)
+                errStr = imTestUtils.maskedImagesDiffer(self.cnvMaskedImage.getArrays(), serialImMaskVarArr,
+                    doVariance = True, rtol=rtol, atol=0.0)
+                self.assert_(not errStr, "%s convolved using %d threads differs from using 1:\n%s" % \
+                    (kernelDescr, nThread, errStr))
+
+    def testSimdConvolve(self):
+        """Test that convolving using each available SIMD instruction set matches using scalar code
+        """
+        gaussFunc1 = afwMath.GaussianFunction1D(1.0)
+        gaussFunc2 = afwMath.GaussianFunction2D(1.0, 1.0, 0.0)
+        kernelList = (
+            (afwMath.AnalyticKernel(7, 6, gaussFunc2), "spatially invariant kernel"),
+            (afwMath.SeparableKernel(7, 6, gaussFunc1, gaussFunc1), "separable kernel"),
+        )
+        convControl = afwMath.ConvolutionControl()
+        try:
+            for kernel, kernelDescr in kernelList:
+                mathDetail.setSimdLevel(mathDetail.SIMD_NONE)
+                afwMath.convolve(self.cnvMaskedImage, self.maskedImage, kernel, convControl)
+                scalarImMaskVarArr = copyArrays(self.cnvMaskedImage)
+                for level in range(mathDetail.SIMD_NONE + 1, mathDetail.getMaxSimdLevel() + 1):
+                    mathDetail.setSimdLevel(level)
+                    self.assertEqual(mathDetail.getSimdLevel(), level)
+                    afwMath.convolve(self.cnvMaskedImage, self.maskedImage, kernel, convControl)
+                    errStr = imTestUtils.maskedImagesDiffer(self.cnvMaskedImage.getArrays(),
+                        scalarImMaskVarArr, doVariance = True, rtol=1.0e-06, atol=0.0)
+                    self.assert_(not errStr, "%s using SIMD level %d differs from scalar code:\n%s" % \
+                        (kernelDescr, level, errStr))
+        finally:
+            mathDetail.setSimdLevel(mathDetail.getMaxSimdLevel())
+
     def testSeparableConvolve(self):
         """Test convolve of a separable kernel with a spatially invariant Gaussian function
         """
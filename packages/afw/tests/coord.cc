@@ -28,6 +28,7 @@
  * @brief An example executible which calls the example sex2dec code
  *
  */
+#include <cmath>
 #include <iostream>
 #include <string>
 
@@ -82,3 +83,72 @@ BOOST_AUTO_TEST_CASE(eclipticConversion) {
 
     BOOST_CHECK_EQUAL(test->getLongitude(afwCoord::DEGREES), lamb0);
 }
+
+
+namespace {
+
+/// A reproducible pseudo-random fraction in [0, 1) for the i'th of n samples; as 7919 is prime,
+/// i = 0..n-1 give each of 0, 1/n, ..., (n - 1)/n once unless n is a multiple of 7919
+double getDeviate(int const i, int const n) {
+    return ((7919LL*i) % n)/static_cast<double>(n);
+}
+
+}
+
+// The bulk conversions should agree with converting one Coord at a time
+BOOST_AUTO_TEST_CASE(bulkConversion) {
+
+    int const n = 1000;
+    lsst::ndarray::Array<double,1,1> ra = lsst::ndarray::allocate(n);
+    lsst::ndarray::Array<double,1,1> dec = lsst::ndarray::allocate(n);
+    lsst::ndarray::Array<double,1,1> epoch = lsst::ndarray::allocate(n);
+    for (int i = 0; i != n; ++i) {
+        ra[i] = std::fmod(37.123*i, 360.0);
+        dec[i] = -85.0 + 170.0*getDeviate(i, n);
+        epoch[i] = (i < n/2) ? 1950.0 : 2010.0;
+    }
+
+    lsst::ndarray::Array<double,1,1> l = lsst::ndarray::allocate(n);
+    lsst::ndarray::Array<double,1,1> b = lsst::ndarray::allocate(n);
+    afwCoord::CoordTransform(afwCoord::FK5, afwCoord::GALACTIC).apply(ra, dec, l, b);
+
+    lsst::ndarray::Array<double,1,1> lambda = lsst::ndarray::allocate(n);
+    lsst::ndarray::Array<double,1,1> beta = lsst::ndarray::allocate(n);
+    afwCoord::CoordTransform(afwCoord::FK5, afwCoord::ECLIPTIC, 2000.0, 2010.0).apply(ra, dec, lambda, beta);
+
+    lsst::ndarray::Array<double,1,1> ra2000 = lsst::ndarray::allocate(n);
+    lsst::ndarray::Array<double,1,1> dec2000 = lsst::ndarray::allocate(n);
+    afwCoord::transformCoords(afwCoord::FK5, afwCoord::FK5, epoch, 2000.0, ra, dec, ra2000, dec2000);
+
+    lsst::ndarray::Array<double,1,1> sep = lsst::ndarray::allocate(n);
+    afwCoord::angularSeparation(ra, dec, l, b, sep);
+
+    double const tol = 1.0e-8;          // degrees
+    for (int i = 0; i != n; ++i) {
+        afwCoord::Fk5Coord const fk5(ra[i], dec[i]);
+
+        afwCoord::GalacticCoord const gal = fk5.toGalactic();
+        BOOST_CHECK_SMALL(std::fmod(gal.getL(afwCoord::DEGREES) - l[i] + 540.0, 360.0) - 180.0, tol);
+        BOOST_CHECK_SMALL(gal.getB(afwCoord::DEGREES) - b[i], tol);
+
+        afwCoord::EclipticCoord const ecl = fk5.toEcliptic(2010.0);
+        BOOST_CHECK_SMALL(std::fmod(ecl.getLambda(afwCoord::DEGREES) - lambda[i] + 540.0, 360.0) - 180.0,
+                          tol);
+        BOOST_CHECK_SMALL(ecl.getBeta(afwCoord::DEGREES) - beta[i], tol);
+
+        afwCoord::Fk5Coord const precessed = afwCoord::Fk5Coord(ra[i], dec[i], epoch[i]).precess(2000.0);
+        BOOST_CHECK_SMALL(std::fmod(precessed.getRa(afwCoord::DEGREES) - ra2000[i] + 540.0, 360.0) - 180.0,
+                          tol);
+        BOOST_CHECK_SMALL(precessed.getDec(afwCoord::DEGREES) - dec2000[i], tol);
+
+        afwCoord::Coord const lb(l[i], b[i]);
+        BOOST_CHECK_SMALL(fk5.angularSeparation(lb, afwCoord::DEGREES) - sep[i], tol);
+    }
+
+    // the conversions round trip, even in place
+    afwCoord::CoordTransform(afwCoord::GALACTIC, afwCoord::FK5).apply(l, b, l, b);
+    for (int i = 0; i != n; ++i) {
+        BOOST_CHECK_SMALL(std::fmod(l[i] - ra[i] + 540.0, 360.0) - 180.0, tol);
+        BOOST_CHECK_SMALL(b[i] - dec[i], tol);
+    }
+}
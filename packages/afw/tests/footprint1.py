@@ -36,6 +36,7 @@ or
 import sys
 import unittest
 import lsst.utils.tests as tests
+import lsst.pex.exceptions as pexExcept
 import lsst.pex.logging as logging
 import lsst.afw.geom as afwGeom
 import lsst.afw.geom.ellipses as afwGeomEllipses
@@ -639,6 +640,87 @@ class FootprintSetTestCase(unittest.TestCase):
             ds9.mtv(self.ms, frame=0)
             ds9.mtv(idImage, frame=1)
 
+    def testGrowFootprintSet(self):
+        """Check that growing a FootprintSet merges the Footprints that touch"""
+        ds = afwDetect.FootprintSetF(self.ms, afwDetect.Threshold(10))
+
+        for isotropic in (False, True):
+            gds = afwDetect.FootprintSetF(ds, 1, isotropic)
+            #
+            # The set of pixels in any of the grown Footprints
+            #
+            pixels = set()
+            for foot in ds.getFootprints():
+                for sp in afwDetect.growFootprint(foot, 1, isotropic).getSpans():
+                    if sp.getY() < 0 or sp.getY() >= self.ms.getHeight():
+                        continue
+                    for x in range(max(sp.getX0(), 0), min(sp.getX1(), self.ms.getWidth() - 1) + 1):
+                        pixels.add((x, sp.getY()))
+            #
+            # Objects 0 and 2 are now diagonally adjacent, so should have been merged
+            #
+            objects = gds.getFootprints()
+            self.assertEqual(len(objects), 2)
+
+            gpixels = set()
+            for foot in objects:
+                npix = 0
+                for sp in foot.getSpans():
+                    for x in range(sp.getX0(), sp.getX1() + 1):
+                        self.assertFalse((x, sp.getY()) in gpixels)
+                        gpixels.add((x, sp.getY()))
+                        npix += 1
+                self.assertEqual(foot.getNpix(), npix)
+            self.assertEqual(gpixels, pixels)
+
+    def testMergeFootprintSets(self):
+        """Check that we can merge FootprintSets"""
+        ds1 = afwDetect.FootprintSetF(self.ms, afwDetect.Threshold(10))
+        ds2 = afwDetect.FootprintSetF(self.ms, afwDetect.Threshold(15)) # objects 1 and 2
+
+        self.assertEqual(len(ds2.getFootprints()), 2)
+
+        for includePeaks in (False, True):
+            ds = afwDetect.FootprintSetF(ds1, ds2, includePeaks)
+
+            objects = ds.getFootprints()
+            self.assertEqual(len(objects), len(self.objects))
+            for i in range(len(objects)):
+                self.assertEqual(objects[i], self.objects[i])
+        #
+        # Merging with a grown FootprintSet gives the grown FootprintSet
+        #
+        gds = afwDetect.FootprintSetF(ds1, 1, False)
+        ds = afwDetect.FootprintSetF(ds1, gds, False)
+
+        objects = ds.getFootprints()
+        self.assertEqual(len(objects), len(gds.getFootprints()))
+        for foot, gfoot in zip(objects, gds.getFootprints()):
+            self.assertEqual([sp.toString() for sp in foot.getSpans()],
+                             [sp.toString() for sp in gfoot.getSpans()])
+
+    def testFootprintAtPoint(self):
+        """Check that we can find the Footprint containing a given pixel"""
+        for (x, y), obj in [((4, 2), self.objects[0]), ((10, 5), self.objects[1]), ((8, 6), self.objects[1])]:
+            ds = afwDetect.FootprintSetF(self.ms, afwDetect.Threshold(10), x, y)
+
+            objects = ds.getFootprints()
+            self.assertEqual(len(objects), 1)
+            self.assertEqual(objects[0], obj)
+            self.assertEqual(objects[0].getNpix(), sum([sp[2] - sp[1] + 1 for sp in obj.spans]))
+        #
+        # A pixel below threshold
+        #
+        ds = afwDetect.FootprintSetF(self.ms, afwDetect.Threshold(10), 0, 0)
+        self.assertEqual(len(ds.getFootprints()), 0)
+        #
+        # A pixel that isn't in the image
+        #
+        def outside():
+            afwDetect.FootprintSetF(self.ms, afwDetect.Threshold(10), self.ms.getWidth(), 0)
+
+        tests.assertRaisesLsstCpp(self, pexExcept.InvalidParameterException, outside)
+
 #-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
 class MaskFootprintSetTestCase(unittest.TestCase):
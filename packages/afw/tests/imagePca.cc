@@ -0,0 +1,234 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <cmath>
+#include <vector>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ImagePca
+
+#include "boost/test/unit_test.hpp"
+#include "boost/test/floating_point_comparison.hpp"
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/image/ImagePca.h"
+
+namespace image = lsst::afw::image;
+namespace geom = lsst::afw::geom;
+
+typedef image::Image<double> Image;
+typedef image::MaskedImage<double> MaskedImage;
+
+namespace {
+    int const nImage = 60;
+    int const width = 15;
+    int const height = 13;
+
+    /// A reproducible uniform deviate in [-0.5, 0.5)
+    double getDeviate(unsigned int& seed) {
+        seed = 1664525u*seed + 1013904223u;
+        return (seed & 0xffffffu)/16777216.0 - 0.5;
+    }
+
+    /*
+     * Images made of three patterns with random amplitudes, plus a little noise.  The patterns aren't
+     * symmetrical, so the sign chosen when normalising each eigen image is well defined
+     */
+    std::vector<Image::Ptr> makeImages() {
+        unsigned int seed = 1;
+        std::vector<Image::Ptr> images;
+        for (int j = 0; j != nImage; ++j) {
+            double const a0 = 10.0 + getDeviate(seed);
+            double const a1 = 4.0*getDeviate(seed);
+            double const a2 = 4.0*getDeviate(seed);
+
+            Image::Ptr im(new Image(geom::Extent2I(width, height)));
+            for (int y = 0; y != height; ++y) {
+                for (int x = 0; x != width; ++x) {
+                    double const dx = x - 5.0;
+                    double const dy = y - 4.0;
+                    (*im)(x, y) = a0*std::exp(-0.05*(dx*dx + dy*dy)) + a1*std::pow(x/double(width), 2) +
+                        a2*std::pow(y/double(height), 3) + 1e-3*getDeviate(seed);
+                }
+            }
+            images.push_back(im);
+        }
+        return images;
+    }
+
+    Image const& getImage(Image::Ptr const& im) { return *im; }
+    Image const& getImage(MaskedImage::Ptr const& mimg) { return *mimg->getImage(); }
+
+    /// Check that the first nComp eigen values and images of two ImagePcas agree
+    template<typename ImageT, typename RefImageT>
+    void checkEigenImages(image::ImagePca<ImageT> const& pca, image::ImagePca<RefImageT> const& ref,
+                          int const nComp) {
+        BOOST_REQUIRE(static_cast<int>(pca.getEigenImages().size()) >= nComp);
+        BOOST_REQUIRE(static_cast<int>(ref.getEigenImages().size()) >= nComp);
+        for (int k = 0; k != nComp; ++k) {
+            BOOST_CHECK_CLOSE(pca.getEigenValues()[k], ref.getEigenValues()[k], 1e-5);
+
+            Image const& eImage = getImage(pca.getEigenImages()[k]);
+            Image const& eRef = getImage(ref.getEigenImages()[k]);
+            for (int y = 0; y != height; ++y) {
+                for (int x = 0; x != width; ++x) {
+                    BOOST_CHECK_SMALL(eImage(x, y) - eRef(x, y), 1e-5);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ImagePcaNumComponents) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    image::ImagePca<Image> pca;
+    BOOST_CHECK_EQUAL(pca.getNumComponents(), 100);
+    pca.setNumComponents(3);
+    BOOST_CHECK_EQUAL(pca.getNumComponents(), 3);
+    BOOST_CHECK_THROW(pca.setNumComponents(0), lsst::pex::exceptions::InvalidParameterException);
+    BOOST_CHECK_EQUAL(pca.getNumComponents(), 3);
+
+    BOOST_CHECK_EQUAL(pca.getNumThreads(), 1);
+    pca.setNumThreads(4);
+    BOOST_CHECK_EQUAL(pca.getNumThreads(), 4);
+}
+
+/*
+ * Asking for a few components uses subspace iteration, which should find the same leading eigen values
+ * and images as the full eigen problem; it should also only return that many eigen values
+ */
+BOOST_AUTO_TEST_CASE(ImagePcaSubspace) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    std::vector<Image::Ptr> images = makeImages();
+    int const nComp = 3;
+
+    image::ImagePca<Image> dense;
+    image::ImagePca<Image> subspace;
+    subspace.setNumComponents(nComp);
+    for (int j = 0; j != nImage; ++j) {
+        dense.addImage(images[j], 1.0);
+        subspace.addImage(images[j], 1.0);
+    }
+    dense.analyze();
+    subspace.analyze();
+
+    BOOST_CHECK_EQUAL(static_cast<int>(dense.getEigenValues().size()), nImage);
+    BOOST_CHECK_EQUAL(static_cast<int>(dense.getEigenImages().size()), nImage);
+    BOOST_CHECK_EQUAL(static_cast<int>(subspace.getEigenValues().size()), nComp);
+    BOOST_CHECK_EQUAL(static_cast<int>(subspace.getEigenImages().size()), nComp);
+    checkEigenImages(subspace, dense, nComp);
+
+    // The same again, using several threads
+    image::ImagePca<Image> threaded;
+    threaded.setNumComponents(nComp);
+    threaded.setNumThreads(3);
+    for (int j = 0; j != nImage; ++j) {
+        threaded.addImage(images[j], 1.0);
+    }
+    threaded.analyze();
+    checkEigenImages(threaded, subspace, nComp);
+}
+
+/*
+ * Adding images after an analyze() only calculates their inner products; the results should be the
+ * same as analyzing all the images at once
+ */
+BOOST_AUTO_TEST_CASE(ImagePcaIncremental) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    std::vector<Image::Ptr> images = makeImages();
+    int const nComp = 3;
+
+    image::ImagePca<Image> all;
+    for (int j = 0; j != nImage; ++j) {
+        all.addImage(images[j], 1.0);
+    }
+    all.analyze();
+
+    image::ImagePca<Image> incremental;
+    for (int j = 0; j != nImage/2; ++j) {
+        incremental.addImage(images[j], 1.0);
+    }
+    incremental.analyze();
+    BOOST_CHECK_EQUAL(static_cast<int>(incremental.getEigenValues().size()), nImage/2);
+    for (int j = nImage/2; j != nImage; ++j) {
+        incremental.addImage(images[j], 1.0);
+    }
+    incremental.analyze();
+
+    BOOST_CHECK_EQUAL(static_cast<int>(incremental.getEigenValues().size()), nImage);
+    checkEigenImages(incremental, all, nComp);
+}
+
+/*
+ * The eigen images of MaskedImages have the same pixels as those of the Images; their masks are the OR
+ * of all the input masks, and their variances sum the input variances with the squares of the weights
+ */
+BOOST_AUTO_TEST_CASE(ImagePcaMaskedImage) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    std::vector<Image::Ptr> images = makeImages();
+    int const nComp = 3;
+
+    image::ImagePca<Image> pca;
+    image::ImagePca<MaskedImage> mpca;
+    for (int j = 0; j != nImage; ++j) {
+        MaskedImage::Ptr mimg(new MaskedImage(geom::Extent2I(width, height)));
+        *mimg->getImage() <<= *images[j];
+        *mimg->getMask() = 0x0;
+        (*mimg->getMask())(j%width, j%height) = 0x1 << (j%3);
+        for (int y = 0; y != height; ++y) {
+            for (int x = 0; x != width; ++x) {
+                (*mimg->getVariance())(x, y) = 1.0 + 0.1*x + 0.01*y; // the same for every image
+            }
+        }
+
+        pca.addImage(images[j], 1.0);
+        mpca.addImage(mimg, 1.0);
+    }
+    pca.setNumComponents(nComp);
+    mpca.setNumComponents(nComp);
+    pca.analyze();
+    mpca.analyze();
+
+    checkEigenImages(mpca, pca, nComp);
+
+    for (int k = 0; k != nComp; ++k) {
+        MaskedImage const& eImage = *mpca.getEigenImages()[k];
+        // As every input has the same variance plane, and the weights are a unit vector (scaled by the
+        // normalisation of the eigen image), each eigen image's variance is proportional to it
+        double const scale = (*eImage.getVariance())(0, 0);
+        BOOST_CHECK(scale > 0.0);
+        for (int y = 0; y != height; ++y) {
+            for (int x = 0; x != width; ++x) {
+                BOOST_CHECK_CLOSE(static_cast<double>((*eImage.getVariance())(x, y)),
+                                  scale*(1.0 + 0.1*x + 0.01*y), 1e-4);
+
+                image::MaskPixel expected = 0x0;
+                for (int j = 0; j != nImage; ++j) {
+                    if (x == j%width && y == j%height) {
+                        expected |= 0x1 << (j%3);
+                    }
+                }
+                BOOST_CHECK_EQUAL((*eImage.getMask())(x, y), expected);
+            }
+        }
+    }
+}
@@ -169,6 +169,66 @@ class MaskedImageTestCase(unittest.TestCase):
 
         utilsTests.assertRaisesLsstCpp(self, pexEx.IoErrorException, tst)
 
+    def testReadWriteCompressed(self):
+        """Test reading and writing tile-compressed MaskedImages, and parts of them"""
+        width, height = 60, 45
+        im = afwImage.MaskedImageF(afwGeom.Extent2I(width, height))
+        for y in range(height):
+            for x in range(width):
+                im.getImage().set(x, y, 100*x + y)
+                im.getMask().set(x, y, 0x1 if (x == 10 or y == 20) else 0x0)
+                im.getVariance().set(x, y, 1000 + 0.1*(x + y))
+        im.setXY0(3, 4)
+
+        imageCompression = afwImage.FitsCompression(afwImage.COMPRESS_GZIP, 0, 4, 0.0) # lossless
+        maskCompression = afwImage.FitsCompression(afwImage.COMPRESS_RICE, 0, 4)
+        varianceCompression = afwImage.FitsCompression(afwImage.COMPRESS_RICE, 16, 8, 16.0)
+        self.assertTrue(varianceCompression.isCompressed())
+        self.assertFalse(afwImage.FitsCompression().isCompressed())
+
+        bbox = afwGeom.Box2I(afwGeom.Point2I(7, 5), afwGeom.Extent2I(23, 17))
+        sub = im.Factory(im, bbox, afwImage.LOCAL) # not contiguous, so it's written a band at a time
+
+        tmpFile, tmpFile2 = "foo.fits", "foo2.fits"
+        try:
+            im.writeFits(tmpFile, None, "w", True, imageCompression, maskCompression, varianceCompression)
+            im.writeFits(tmpFile2)
+            self.assertTrue(os.path.getsize(tmpFile) < os.path.getsize(tmpFile2))
+
+            for fileName, subImage in [(tmpFile, None), (tmpFile, bbox), (tmpFile2, bbox)]:
+                if subImage:
+                    im2 = im.Factory(fileName, 0, None, bbox, afwImage.LOCAL)
+                    ref = sub
+                else:
+                    im2 = im.Factory(fileName)
+                    ref = im
+                self.assertEqual(im2.getDimensions(), ref.getDimensions())
+                self.assertEqual(im2.getXY0(), ref.getXY0())
+                for y in range(ref.getHeight()):
+                    for x in range(ref.getWidth()):
+                        self.assertEqual(im2.getImage().get(x, y), ref.getImage().get(x, y))
+                        self.assertEqual(im2.getMask().get(x, y), ref.getMask().get(x, y))
+                        self.assertAlmostEqual(im2.getVariance().get(x, y)/ref.getVariance().get(x, y),
+                                               1.0, 3)
+
+            sub.writeFits(tmpFile, None, "w", True, imageCompression, maskCompression, varianceCompression)
+            im2 = im.Factory(tmpFile)
+            self.assertEqual(im2.getXY0(), sub.getXY0())
+            for y in range(sub.getHeight()):
+                for x in range(sub.getWidth()):
+                    self.assertEqual(im2.getImage().get(x, y), sub.getImage().get(x, y))
+                    self.assertEqual(im2.getMask().get(x, y), sub.getMask().get(x, y))
+            #
+            # The compression keywords shouldn't appear in the metadata
+            #
+            metadata = afwImage.readMetadata(tmpFile, 2)
+            for key in ("ZIMAGE", "ZCMPTYPE", "ZTILE1", "TFIELDS", "TTYPE1"):
+                self.assertFalse(metadata.exists(key))
+        finally:
+            for f in (tmpFile, tmpFile2):
+                if os.path.exists(f):
+                    os.remove(f)
+
     def testReadWriteXY0(self):
         """Test that we read and write (X0, Y0) correctly"""
         im = afwImage.MaskedImageF(afwGeom.Extent2I(10, 20))
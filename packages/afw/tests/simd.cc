@@ -0,0 +1,122 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file simd.cc
+ * @brief Test that the vectorized row operations match the scalar versions for all supported SIMD levels
+ */
+#include <cstdlib>
+#include <vector>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE simd
+
+#include "boost/test/unit_test.hpp"
+
+#include "lsst/afw/math/detail/Simd.h"
+
+namespace afwImage = lsst::afw::image;
+namespace mathDetail = lsst::afw::math::detail;
+
+namespace {
+    /*
+     * Check addScaledRow for all lengths up to 40 and all offsets from a vector boundary
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void checkAddScaledRow() {
+        int const nMax = 40;
+        int const nOffset = 8;
+        double const scale = 0.3141592653589793;
+
+        std::vector<InPixelT> in(nMax + nOffset);
+        std::vector<OutPixelT> out0(nMax + nOffset);
+        for (int i = 0; i != nMax + nOffset; ++i) {
+            // compute in double and then convert, so that integer pixels aren't all zero
+            in[i] = static_cast<InPixelT>(1000.0*std::rand()/RAND_MAX - 500.0);
+            out0[i] = static_cast<OutPixelT>(1000.0*std::rand()/RAND_MAX);
+        }
+
+        for (int n = 0; n <= nMax; ++n) {
+            for (int offset = 0; offset != nOffset; ++offset) {
+                std::vector<OutPixelT> ref(out0);
+                mathDetail::setSimdLevel(mathDetail::SIMD_NONE);
+                mathDetail::addScaledRow(&ref[offset], &in[nOffset - 1 - offset], scale, n);
+
+                for (int level = mathDetail::SIMD_NONE; level <= mathDetail::getMaxSimdLevel(); ++level) {
+                    mathDetail::setSimdLevel(static_cast<mathDetail::SimdLevel>(level));
+                    std::vector<OutPixelT> out(out0);
+                    mathDetail::addScaledRow(&out[offset], &in[nOffset - 1 - offset], scale, n);
+                    for (int i = 0; i != nMax + nOffset; ++i) {
+                        BOOST_CHECK_EQUAL(out[i], ref[i]);
+                    }
+                }
+            }
+        }
+        mathDetail::setSimdLevel(mathDetail::getMaxSimdLevel());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SimdLevel) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    BOOST_CHECK_EQUAL(mathDetail::getSimdLevel(), mathDetail::getMaxSimdLevel());
+
+    mathDetail::setSimdLevel(mathDetail::SIMD_NONE);
+    BOOST_CHECK_EQUAL(mathDetail::getSimdLevel(), mathDetail::SIMD_NONE);
+
+    mathDetail::setSimdLevel(mathDetail::SIMD_AVX);     // may not be supported
+    BOOST_CHECK_EQUAL(mathDetail::getSimdLevel(), mathDetail::getMaxSimdLevel());
+}
+
+BOOST_AUTO_TEST_CASE(AddScaledRow) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    checkAddScaledRow<double, double>();
+    checkAddScaledRow<double, float>();
+    checkAddScaledRow<float, float>();
+    checkAddScaledRow<float, int>();            // generic version
+}
+
+BOOST_AUTO_TEST_CASE(OrRow) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const nMax = 40;
+    int const nOffset = 16;
+
+    std::vector<afwImage::MaskPixel> in(nMax + nOffset);
+    std::vector<afwImage::MaskPixel> out0(nMax + nOffset);
+    for (int i = 0; i != nMax + nOffset; ++i) {
+        in[i] = 1 << (std::rand()%16);
+        out0[i] = 1 << (std::rand()%16);
+    }
+
+    for (int n = 0; n <= nMax; ++n) {
+        for (int offset = 0; offset != nOffset; ++offset) {
+            for (int level = mathDetail::SIMD_NONE; level <= mathDetail::getMaxSimdLevel(); ++level) {
+                mathDetail::setSimdLevel(static_cast<mathDetail::SimdLevel>(level));
+                std::vector<afwImage::MaskPixel> out(out0);
+                mathDetail::orRow(&out[offset], &in[nOffset - 1 - offset], n);
+                for (int i = 0; i != nMax + nOffset; ++i) {
+                    bool const isSet = (i >= offset && i < offset + n);
+                    BOOST_CHECK_EQUAL(out[i], isSet ? (out0[i] | in[i + nOffset - 1 - 2*offset]) : out0[i]);
+                }
+            }
+        }
+    }
+    mathDetail::setSimdLevel(mathDetail::getMaxSimdLevel());
+}
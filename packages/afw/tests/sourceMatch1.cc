@@ -25,13 +25,16 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE SourceMatch
 
+#include <algorithm>
 #include <cmath>
 
 #include "boost/test/unit_test.hpp"
 #include "boost/test/floating_point_comparison.hpp"
 
+#include "lsst/pex/exceptions.h"
 #include "lsst/afw/detection/Source.h"
 #include "lsst/afw/detection/SourceMatch.h"
+#include "lsst/afw/detection/SourceIndex.h"
 #include "lsst/afw/math/Random.h"
 #include "lsst/afw/coord/Utils.h"
 
@@ -356,4 +359,78 @@ BOOST_AUTO_TEST_CASE(matchNearPole) {
 
 }
 
+BOOST_AUTO_TEST_CASE(sourceIndexRadii) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const N = 500;    // # of points to generate
+    double const M = 8.0; // avg. # of matches
+    double const radius = std::acos(1.0 - 2.0*M/N)*(180.0/PI)*3600.0;
 
+    det::SourceSet set1, set2;
+    makeSources(set1, N);
+    makeSources(set2, N);
+    // build the indices once, and query them with several radii and numbers of threads
+    det::SourceIndex index(set2, det::SourceIndex::RA_DEC);
+    det::SourceIndex selfIndex(set1, det::SourceIndex::RA_DEC);
+    BOOST_CHECK_EQUAL(index.size(), N);
+    for (double r = 0.5*radius; r <= 2.0*radius; r *= 2.0) {
+        std::vector<det::SourceMatch> matches = index.findMatches(set1, r, false, 4);
+        std::vector<det::SourceMatch> refMatches = bruteMatch(set1, set2, r, DistRaDec());
+        compareMatches(matches, refMatches, r);
+
+        matches = selfIndex.findSelfMatches(r, true, 4);
+        refMatches = bruteMatch(set1, r, DistRaDec());
+        compareMatches(matches, refMatches, r);
+    }
+}
+
+/*
+ * A source out of range is reported by the thread that queries it; the exception must reach the caller
+ * with its own type
+ */
+BOOST_AUTO_TEST_CASE(sourceIndexThreadedError) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const N = 100;
+
+    det::SourceSet set1, set2;
+    makeSources(set1, N);
+    makeSources(set2, N);
+    set1[N/2]->setRa(7.0);
+    det::SourceIndex index(set2, det::SourceIndex::RA_DEC);
+    BOOST_CHECK_THROW(index.findMatches(set1, 10.0, false, 4), lsst::pex::exceptions::RangeErrorException);
+    BOOST_CHECK_THROW(index.findMatches(set1, 10.0, false, 1), lsst::pex::exceptions::RangeErrorException);
+}
+
+BOOST_AUTO_TEST_CASE(sourceIndexNearest) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const N = 200;    // # of points to generate
+    int const K = 3;      // # of neighbours
+    double const tolerance = 1e-6;
+
+    det::SourceSet set1, set2;
+    makeSources(set1, N);
+    makeSources(set2, N);
+    det::SourceIndex index(set2, det::SourceIndex::XY);
+    std::vector<det::SourceMatch> allMatches = index.findNearestMatches(set1, K, 2.0, 4);
+    BOOST_REQUIRE_EQUAL(allMatches.size(), static_cast<size_t>(K*N));
+
+    DistXy distFun;
+    for (int i = 0; i < N; ++i) {
+        std::vector<double> dist;
+        for (int j = 0; j < N; ++j) {
+            dist.push_back(distFun(set1[i], set2[j]));
+        }
+        std::sort(dist.begin(), dist.end());
+
+        std::vector<det::SourceMatch> matches = index.findNearest(set1[i], K, 2.0);
+        BOOST_REQUIRE_EQUAL(matches.size(), static_cast<size_t>(K));
+        for (int k = 0; k < K; ++k) {
+            BOOST_CHECK(std::fabs(matches[k].distance - dist[k]) <= tolerance);
+            BOOST_CHECK(matches[k].first == set1[i]);
+            // the parallel match returns the same matches, in the order of the query set
+            BOOST_CHECK(allMatches[K*i + k].second == matches[k].second);
+        }
+    }
+    // the closest match is the nearest neighbour
+    std::vector<det::SourceMatch> closest = det::matchXy(set1, set2, 2.0, true);
+    BOOST_REQUIRE_EQUAL(closest.size(), static_cast<size_t>(N));
+    for (int i = 0; i < N; ++i) {
+        BOOST_CHECK(closest[i].second == allMatches[K*i].second);
+    }
+}
@@ -0,0 +1,192 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+//
+//##====----------------                                ----------------====##/
+//
+//! \file
+//! \brief  Tests of SourceTable, and of its IO via the persistence framework.
+//
+//##====----------------                                ----------------====##/
+
+#include <cstring>
+#include <limits>
+#include <unistd.h>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE SourceTable
+
+#include "boost/test/unit_test.hpp"
+
+#include "lsst/daf/base.h"
+#include "lsst/daf/persistence.h"
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceTable.h"
+#include "lsst/afw/image/Filter.h"
+
+using lsst::daf::base::PropertySet;
+using lsst::daf::base::Persistable;
+using lsst::daf::persistence::LogicalLocation;
+using lsst::daf::persistence::Persistence;
+using lsst::daf::persistence::Storage;
+using lsst::pex::policy::Policy;
+
+using namespace lsst::afw::detection;
+
+static SourceSet makeSources(int n) {
+    SourceSet sources;
+    for (int i = 0; i != n; ++i) {
+        Source::Ptr s(new Source);
+        s->setId(i + 1);
+        s->setRa(0.001*i);
+        s->setDec(-0.002*i);
+        s->setXAstrom(10.0 + i);
+        s->setYAstrom(20.0 + i);
+        s->setPsfFlux(1000.0*i);
+        s->setPsfFluxErr(0.5*i);
+        s->setShapeStatus(i % 3);
+        s->setFlagForDetection(static_cast<boost::int64_t>(1) << (i % 40));
+        // exercise a different null pattern in each Source
+        s->setNotNull();
+        s->setNull(i % NUM_SOURCE_NULLABLE_FIELDS);
+        sources.push_back(s);
+    }
+    return sources;
+}
+
+static bool equal(SourceSet const & a, SourceSet const & b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (SourceSet::size_type i = 0; i != a.size(); ++i) {
+        if (*a[i] != *b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BOOST_AUTO_TEST_CASE(SourceTableConversion) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    SourceSet sources = makeSources(100);
+    SourceTable table(sources);
+
+    BOOST_CHECK_EQUAL(table.size(), 100);
+    BOOST_CHECK(equal(table.makeSourceSet(), sources));
+
+    lsst::ndarray::Array<double,1,1> ra = table.getRaColumn();
+    lsst::ndarray::Array<bool,1,1> xFluxNull = table.getNullColumn(X_FLUX);
+    BOOST_CHECK_EQUAL(ra.getSize<0>(), 100);
+    for (int i = 0; i != table.size(); ++i) {
+        BOOST_CHECK_EQUAL(ra[i], sources[i]->getRa());
+        BOOST_CHECK_EQUAL(table[i].getRa(), sources[i]->getRa());
+        BOOST_CHECK_EQUAL(table[i].getShapeStatus(), sources[i]->getShapeStatus());
+        BOOST_CHECK_EQUAL(xFluxNull[i], sources[i]->isNull(X_FLUX));
+    }
+
+    // columns share memory with the table
+    ra[3] = 1.5;
+    BOOST_CHECK_EQUAL(table[3].getRa(), 1.5);
+    table[4].setRa(2.5);
+    BOOST_CHECK_EQUAL(ra[4], 2.5);
+
+    // setters clear null flags, as for Source
+    table[5].setNull(OBJECT_ID);
+    table[5].setObjectId(7);
+    BOOST_CHECK(!table[5].isNull(OBJECT_ID));
+
+    // a const table hands out read-only views of the same memory
+    SourceTable const & constTable = table;
+    lsst::ndarray::Array<double const,1,1> constRa = constTable.getRaColumn();
+    lsst::ndarray::Array<bool const,1,1> objectIdNull = constTable.getNullColumn(OBJECT_ID);
+    ConstSourceRecord const constRecord = constTable[4];
+    BOOST_CHECK(constRa.getData() == ra.getData());
+    BOOST_CHECK_EQUAL(constRecord.getRa(), 2.5);
+    BOOST_CHECK_EQUAL(constRecord.getObjectId(), table[4].getObjectId());
+    BOOST_CHECK_EQUAL(objectIdNull[5], false);
+    BOOST_CHECK(&constRecord.getTable() == &table);
+}
+
+BOOST_AUTO_TEST_CASE(SourceTableAppend) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    SourceSet sources = makeSources(50);
+    SourceTable table;
+    BOOST_CHECK(table.empty());
+
+    for (SourceSet::const_iterator i = sources.begin(); i != sources.end(); ++i) {
+        table.append(**i);
+    }
+    BOOST_CHECK_EQUAL(table.size(), 50);
+    BOOST_CHECK(table.getCapacity() >= 50);
+    BOOST_CHECK(equal(table.makeSourceSet(), sources));
+
+    // a new row looks like a default-constructed Source
+    SourceRecord record = table.append();
+    BOOST_CHECK(*record.makeSource() == Source());
+
+    // copies are deep
+    SourceTable copy(table);
+    copy[0].setId(1000);
+    BOOST_CHECK_EQUAL(table[0].getId(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(SourceTableIO) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    char name[32];
+    std::strncpy(name, "SourceTable_XXXXXX", 31);
+    name[31] = 0;
+    int const fd = ::mkstemp(name);
+    BOOST_REQUIRE(fd != -1);
+    ::close(fd);
+    LogicalLocation loc(name);
+
+    SourceSet sources = makeSources(100);
+    sources[7]->setPsfFlux(std::numeric_limits<double>::quiet_NaN());
+    sources[8]->setFilterId(3);
+    SourceTable table(sources);
+
+    Policy::Ptr policy(new Policy);
+    PropertySet::Ptr props(new PropertySet);
+    props->set("filterId", 2);
+    Persistence::Ptr pers = Persistence::getPersistence(policy);
+    {
+        Storage::List storageList;
+        storageList.push_back(pers->getPersistStorage("BoostStorage", loc));
+        pers->persist(table, storageList, props);
+    }
+    // the unknown filter ids are only set in what's persisted
+    BOOST_CHECK(equal(table.makeSourceSet(), sources));
+    for (SourceSet::const_iterator i = sources.begin(); i != sources.end(); ++i) {
+        if ((*i)->getFilterId() == lsst::afw::image::Filter::UNKNOWN) {
+            (*i)->setFilterId(2);
+        }
+    }
+    {
+        Storage::List storageList;
+        storageList.push_back(pers->getRetrieveStorage("BoostStorage", loc));
+        Persistable::Ptr p = pers->retrieve("SourceTable", storageList, props);
+        SourceTable::Ptr result = boost::dynamic_pointer_cast<SourceTable>(p);
+        BOOST_REQUIRE(result);
+        BOOST_CHECK(equal(result->makeSourceSet(), sources));
+    }
+    ::unlink(name);
+}
@@ -0,0 +1,151 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file srcPositionGrid.cc
+ * @brief Test that SrcPositionGrid approximates the source positions to the requested accuracy,
+ * and that warping with it matches warping with the Wcs
+ */
+#include <cmath>
+#include <vector>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE srcPositionGrid
+
+#include "boost/test/unit_test.hpp"
+
+#include "Eigen/Core.h"
+#include "lsst/utils/ieee.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/geom.h"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/TanWcs.h"
+#include "lsst/afw/math/warpExposure.h"
+
+namespace pexExcept = lsst::pex::exceptions;
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+
+namespace {
+    /*
+     * Make a Wcs with large pixels, so that the tangent plane projection is noticeably nonlinear
+     */
+    afwImage::TanWcs makeWcs(double ra, double dec, double scale, double rotation) {
+        Eigen::Matrix2d cd;
+        cd(0, 0) = scale*std::cos(rotation);
+        cd(0, 1) = -scale*std::sin(rotation);
+        cd(1, 0) = scale*std::sin(rotation);
+        cd(1, 1) = scale*std::cos(rotation);
+        return afwImage::TanWcs(afwGeom::Point2D(ra, dec), afwGeom::Point2D(100, 50), cd);
+    }
+
+    afwGeom::Point2D computeSrcPos(afwImage::Wcs const &destWcs, afwImage::Wcs const &srcWcs, int x, int y) {
+        afwGeom::Point2D sky = destWcs.pixelToSky(x, y, true);
+        return srcWcs.skyToPixel(sky[0], sky[1]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Accuracy) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    afwImage::TanWcs const destWcs = makeWcs(30.0, 60.0, 0.01, 0.0);
+    afwImage::TanWcs const srcWcs = makeWcs(30.5, 60.2, 0.011, 0.3);
+    afwGeom::Box2I const destBBox(afwGeom::Point2I(-20, 10), afwGeom::Extent2I(300, 200));
+
+    double const maxErrors[] = {0.1, 0.01, 0.0001};
+    int lastSpacing = 1000;
+    for (int i = 0; i != 3; ++i) {
+        afwMath::SrcPositionGrid const grid(destWcs, srcWcs, destBBox, maxErrors[i]);
+        BOOST_CHECK(grid.getSpacing() <= 256);
+        BOOST_CHECK(grid.getSpacing() <= lastSpacing);
+        lastSpacing = grid.getSpacing();
+
+        std::vector<afwGeom::Point2D> row(destBBox.getWidth() + 1);
+        for (int y = destBBox.getMinY() - 1; y <= destBBox.getMaxY(); ++y) {
+            grid.getSrcPositions(destBBox.getMinX() - 1, y, destBBox.getWidth() + 1, &row[0]);
+            for (int x = destBBox.getMinX() - 1; x <= destBBox.getMaxX(); ++x) {
+                afwGeom::Point2D const exact = computeSrcPos(destWcs, srcWcs, x, y);
+                afwGeom::Point2D const &approx = row[x + 1 - destBBox.getMinX()];
+                double const err = std::sqrt((exact[0] - approx[0])*(exact[0] - approx[0]) +
+                                             (exact[1] - approx[1])*(exact[1] - approx[1]));
+                BOOST_CHECK(err <= maxErrors[i]);
+            }
+        }
+        // row holds the last row of the grid
+        afwGeom::Point2D const pos = grid.getSrcPosition(destBBox.getMinX(), destBBox.getMaxY());
+        BOOST_CHECK_EQUAL(pos[0], row[1][0]);
+        BOOST_CHECK_EQUAL(pos[1], row[1][1]);
+    }
+    BOOST_CHECK(lastSpacing < 256);
+
+    afwMath::SrcPositionGrid const grid(destWcs, srcWcs, destBBox);
+    afwGeom::Point2D pos;
+    BOOST_CHECK_THROW(grid.getSrcPositions(destBBox.getMinX() - 2, destBBox.getMinY(), 1, &pos),
+                      pexExcept::InvalidParameterException);
+    BOOST_CHECK_THROW(grid.getSrcPositions(destBBox.getMaxX() + 1, destBBox.getMinY(), 1, &pos),
+                      pexExcept::InvalidParameterException);
+    BOOST_CHECK_THROW(grid.getSrcPosition(destBBox.getMinX(), destBBox.getMaxY() + 1),
+                      pexExcept::InvalidParameterException);
+    BOOST_CHECK_THROW(afwMath::SrcPositionGrid(destWcs, srcWcs, destBBox, 0.0),
+                      pexExcept::InvalidParameterException);
+}
+
+BOOST_AUTO_TEST_CASE(WarpImage) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    afwImage::TanWcs const destWcs = makeWcs(30.0, 60.0, 0.01, 0.0);
+    afwImage::TanWcs const srcWcs = makeWcs(30.2, 60.1, 0.009, 0.2);
+
+    afwImage::ImageF srcImage(afwGeom::Extent2I(250, 180));
+    for (int y = 0; y != srcImage.getHeight(); ++y) {
+        afwImage::ImageF::x_iterator ptr = srcImage.row_begin(y);
+        for (int x = 0; x != srcImage.getWidth(); ++x, ++ptr) {
+            *ptr = 100.0 + std::sin(x/10.0) + std::cos(y/15.0);
+        }
+    }
+    afwGeom::Box2I const destBBox(afwGeom::Point2I(5, -3), afwGeom::Extent2I(200, 150));
+    afwImage::ImageF wcsImage(destBBox);
+    afwImage::ImageF gridImage(destBBox);
+
+    afwMath::LanczosWarpingKernel warpingKernel(3);
+    afwMath::warpImage(wcsImage, destWcs, srcImage, srcWcs, warpingKernel, 0);
+    afwMath::SrcPositionGrid const grid(destWcs, srcWcs, destBBox, 1.0e-4);
+    afwMath::warpImage(gridImage, srcImage, grid, warpingKernel);
+
+    int nGood = 0;
+    for (int y = 0; y != destBBox.getHeight(); ++y) {
+        afwImage::ImageF::x_iterator wcsPtr = wcsImage.row_begin(y);
+        afwImage::ImageF::x_iterator gridPtr = gridImage.row_begin(y);
+        for (int x = 0; x != destBBox.getWidth(); ++x, ++wcsPtr, ++gridPtr) {
+            if (lsst::utils::isnan(*wcsPtr) || lsst::utils::isnan(*gridPtr)) {
+                continue;
+            }
+            ++nGood;
+            BOOST_CHECK_CLOSE(*wcsPtr, *gridPtr, 1.0e-2); // percent
+        }
+    }
+    BOOST_CHECK(nGood > destBBox.getArea()/4);
+
+    // the grid must cover the destination image
+    afwImage::ImageF bigImage(afwGeom::Box2I(afwGeom::Point2I(5, -3), afwGeom::Extent2I(201, 150)));
+    BOOST_CHECK_THROW(afwMath::warpImage(bigImage, srcImage, grid, warpingKernel),
+                      pexExcept::InvalidParameterException);
+}
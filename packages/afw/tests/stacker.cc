@@ -29,6 +29,8 @@
  *
  */
 #include <iostream>
+#include <cmath>
+#include <limits>
 
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE Stacker
@@ -38,6 +40,7 @@
 
 #include "lsst/afw/image/Image.h"
 #include "lsst/afw/math/Stack.h"
+#include "lsst/utils/ieee.h"
 
 namespace image = lsst::afw::image;
 namespace math = lsst::afw::math;
@@ -48,6 +51,13 @@ typedef image::MaskedImage<float> MImageF;
 typedef std::vector<float> VecF;
 typedef boost::shared_ptr<VecF> VecFPtr;
 
+namespace {
+    /// A reproducible pseudo-random number in [0, 1009) for pixel (x, y) of image iImg of an nX*nY stack
+    int getSeed(int const iImg, int const x, int const y, int const nX, int const nY) {
+        return (iImg*nX*nY + y*nX + x)*7919 % 1009;
+    }
+}
+
 BOOST_AUTO_TEST_CASE(MeanStack) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
     
     int const nImg = 10;
@@ -126,3 +136,199 @@ BOOST_AUTO_TEST_CASE(MeanStack) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a
     BOOST_CHECK_EQUAL((*wvecStack)[nX*nY/2], knownWeightMean);
 
 }
+
+/*
+ * Check that the stack agrees, pixel by pixel, with running makeStatistics on each column of the stack
+ */
+BOOST_AUTO_TEST_CASE(StackAgreesWithStatistics) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const nImg = 25;
+    int const nX = 16;
+    int const nY = 8;
+    image::MaskPixel const badBit = 0x2;
+
+    // Fill the images with a pseudo-random pattern, with some outliers, NaNs, and masked pixels
+    std::vector<MImageF::Ptr> mimgList;
+    for (int iImg = 0; iImg < nImg; ++iImg) {
+        MImageF::Ptr mimg = MImageF::Ptr(new MImageF(geom::Extent2I(nX, nY)));
+        for (int y = 0; y != nY; ++y) {
+            for (int x = 0; x != nX; ++x) {
+                int const seed = getSeed(iImg, x, y, nX, nY);
+                float val = 100.0 + (seed % 97)/10.0;
+                if (seed % 23 == 0) {
+                    val += 1000.0;
+                }
+                if (seed % 31 == 0) {
+                    val = std::numeric_limits<float>::quiet_NaN();
+                }
+                image::MaskPixel const msk = (seed % 11 == 0) ? badBit : 0x0;
+                (*mimg->getImage())(x, y) = val;
+                (*mimg->getMask())(x, y) = msk;
+                (*mimg->getVariance())(x, y) = 1.0 + (seed % 5);
+            }
+        }
+        mimgList.push_back(mimg);
+    }
+    // and mask an entire pixel in the stack
+    for (int iImg = 0; iImg < nImg; ++iImg) {
+        (*mimgList[iImg]->getMask())(1, 1) = badBit;
+    }
+
+    math::StatisticsControl sctrl;
+    sctrl.setAndMask(badBit);
+
+    math::Property const props[] = { math::MEAN, math::MEDIAN, math::MEANCLIP, math::STDEV, math::MAX };
+    for (unsigned int iProp = 0; iProp != sizeof(props)/sizeof(props[0]); ++iProp) {
+        math::Property const prop = props[iProp];
+        MImageF::Ptr mimgStack = math::statisticsStack<float>(mimgList, prop, sctrl);
+
+        for (int y = 0; y != nY; ++y) {
+            for (int x = 0; x != nX; ++x) {
+                math::MaskedVector<float> pixelSet(nImg);
+                math::MaskedVector<float>::iterator psPtr = pixelSet.begin();
+                for (int iImg = 0; iImg < nImg; ++iImg, ++psPtr) {
+                    psPtr.value() = (*mimgList[iImg]->getImage())(x, y);
+                    psPtr.mask() = (*mimgList[iImg]->getMask())(x, y);
+                    psPtr.variance() = (*mimgList[iImg]->getVariance())(x, y);
+                }
+                math::Statistics stat = math::makeStatistics(pixelSet, prop | math::NPOINT | math::ERRORS, sctrl);
+
+                float const value = (*mimgStack->getImage())(x, y);
+                if (stat.getValue(math::NPOINT) == 0) {
+                    BOOST_CHECK(lsst::utils::isnan(value));
+                    BOOST_CHECK_EQUAL((*mimgStack->getMask())(x, y), sctrl.getNoGoodPixelsMask());
+                } else {
+                    BOOST_CHECK_CLOSE(value, static_cast<float>(stat.getValue(prop)), 1.0e-4);
+                    BOOST_CHECK_CLOSE((*mimgStack->getVariance())(x, y),
+                                      static_cast<float>(::pow(stat.getError(prop), 2)), 1.0e-3);
+                    BOOST_CHECK_EQUAL((*mimgStack->getMask())(x, y), stat.getOrMask());
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Weighted clipped statistics must agree with makeStatistics too, as their variance is normalised by the
+ * sum of the weights rather than the number of points
+ */
+BOOST_AUTO_TEST_CASE(WeightedClippedStack) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const nImg = 21;
+    int const nX = 12;
+    int const nY = 6;
+
+    std::vector<MImageF::Ptr> mimgList;
+    for (int iImg = 0; iImg < nImg; ++iImg) {
+        MImageF::Ptr mimg = MImageF::Ptr(new MImageF(geom::Extent2I(nX, nY)));
+        for (int y = 0; y != nY; ++y) {
+            for (int x = 0; x != nX; ++x) {
+                int const seed = getSeed(iImg, x, y, nX, nY);
+                float val = 100.0 + (seed % 97)/10.0;
+                if (seed % 19 == 0) {
+                    val += 500.0;
+                }
+                (*mimg->getImage())(x, y) = val;
+                (*mimg->getMask())(x, y) = 0x0;
+                (*mimg->getVariance())(x, y) = 1.0 + (seed % 7);
+            }
+        }
+        mimgList.push_back(mimg);
+    }
+
+    math::StatisticsControl sctrl;
+    sctrl.setWeighted(true);
+
+    math::Property const props[] = { math::MEANCLIP, math::VARIANCECLIP };
+    for (unsigned int iProp = 0; iProp != sizeof(props)/sizeof(props[0]); ++iProp) {
+        math::Property const prop = props[iProp];
+        MImageF::Ptr mimgStack = math::statisticsStack<float>(mimgList, prop, sctrl);
+
+        for (int y = 0; y != nY; ++y) {
+            for (int x = 0; x != nX; ++x) {
+                math::MaskedVector<float> pixelSet(nImg);
+                math::MaskedVector<float>::iterator psPtr = pixelSet.begin();
+                for (int iImg = 0; iImg < nImg; ++iImg, ++psPtr) {
+                    psPtr.value() = (*mimgList[iImg]->getImage())(x, y);
+                    psPtr.mask() = (*mimgList[iImg]->getMask())(x, y);
+                    psPtr.variance() = (*mimgList[iImg]->getVariance())(x, y);
+                }
+                math::Statistics stat = math::makeStatistics(pixelSet, prop, sctrl);
+                BOOST_CHECK_CLOSE((*mimgStack->getImage())(x, y), static_cast<float>(stat.getValue(prop)),
+                                  1.0e-3);
+            }
+        }
+    }
+}
+
+namespace {
+/*
+ * A StackInput that returns bands of MaskedImages that are already in memory
+ */
+class InMemoryStackInput : public math::StackInput<float> {
+public:
+    explicit InMemoryStackInput(std::vector<MImageF::Ptr> const &images) : _images(images) {}
+
+    virtual int getSize() const { return _images.size(); }
+    virtual geom::Extent2I getDimensions() const { return _images[0]->getDimensions(); }
+    virtual MImageF::Ptr read(int i, geom::Box2I const &bbox) const {
+        return MImageF::Ptr(new MImageF(*_images[i], bbox, image::LOCAL, true));
+    }
+
+private:
+    std::vector<MImageF::Ptr> _images;
+};
+}
+
+BOOST_AUTO_TEST_CASE(ThreadedStack) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const nImg = 9;
+    int const nX = 13;
+    int const nY = 11;
+
+    std::vector<MImageF::Ptr> mimgList;
+    std::vector<ImageF::Ptr> imgList;
+    for (int iImg = 0; iImg < nImg; ++iImg) {
+        MImageF::Ptr mimg = MImageF::Ptr(new MImageF(geom::Extent2I(nX, nY)));
+        for (int y = 0; y != nY; ++y) {
+            for (int x = 0; x != nX; ++x) {
+                int const seed = getSeed(iImg, x, y, nX, nY);
+                (*mimg->getImage())(x, y) = 10.0 + (seed % 97)/10.0;
+                (*mimg->getMask())(x, y) = (seed % 7 == 0) ? 0x1 : 0x0;
+                (*mimg->getVariance())(x, y) = 1.0 + (seed % 3);
+            }
+        }
+        mimgList.push_back(mimg);
+        imgList.push_back(mimg->getImage());
+    }
+
+    math::StatisticsControl sctrl;
+    sctrl.setAndMask(0x1);
+    // Bands that don't divide the image evenly, and more threads than rows in the last band
+    math::StackControl stctrl(4, 3);
+
+    math::Property const props[] = { math::MEAN, math::MEDIAN, math::MEANCLIP };
+    for (unsigned int iProp = 0; iProp != sizeof(props)/sizeof(props[0]); ++iProp) {
+        math::Property const prop = props[iProp];
+
+        MImageF::Ptr mimgStack = math::statisticsStack<float>(mimgList, prop, sctrl);
+        MImageF::Ptr mimgStackThreaded = math::statisticsStack<float>(mimgList, prop, sctrl, VecF(), stctrl);
+        MImageF::Ptr mimgStackInput = math::statisticsStack<float>(InMemoryStackInput(mimgList),
+                                                                   prop, sctrl, VecF(), stctrl);
+        ImageF::Ptr imgStack = math::statisticsStack<float>(imgList, prop, sctrl);
+        ImageF::Ptr imgStackThreaded = math::statisticsStack<float>(imgList, prop, sctrl, VecF(), stctrl);
+
+        for (int y = 0; y != nY; ++y) {
+            for (int x = 0; x != nX; ++x) {
+                BOOST_CHECK_EQUAL((*mimgStackThreaded->getImage())(x, y), (*mimgStack->getImage())(x, y));
+                BOOST_CHECK_EQUAL((*mimgStackThreaded->getMask())(x, y), (*mimgStack->getMask())(x, y));
+                BOOST_CHECK_EQUAL((*mimgStackThreaded->getVariance())(x, y), (*mimgStack->getVariance())(x, y));
+
+                BOOST_CHECK_EQUAL((*mimgStackInput->getImage())(x, y), (*mimgStack->getImage())(x, y));
+                BOOST_CHECK_EQUAL((*mimgStackInput->getMask())(x, y), (*mimgStack->getMask())(x, y));
+
+                BOOST_CHECK_EQUAL((*imgStackThreaded)(x, y), (*imgStack)(x, y));
+            }
+        }
+    }
+}
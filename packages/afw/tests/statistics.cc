@@ -33,7 +33,9 @@
 #include "boost/test/floating_point_comparison.hpp"
 
 #include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/StatisticsAccumulator.h"
 #include "lsst/utils/ieee.h"
 
 using namespace std;
@@ -284,3 +286,343 @@ BOOST_AUTO_TEST_CASE(StatisticsTestImages) { /* parasoft-suppress  LsstDm-3-2a L
         }
     }
 }
+
+
+namespace {
+
+typedef image::MaskedImage<float> MaskedImage;
+
+/// A reproducible pseudo-random integer in [0, modulus) for the index'th pixel (or sample); modulus is prime
+int getSeed(long long const index, int const modulus) {
+    return index*7919 % modulus;
+}
+
+/*
+ * Straightforward (and slow) estimates of the statistics of the good pixels in [center - hwidth,
+ * center + hwidth], used to check the single-pass loops in Statistics
+ */
+struct ReferenceStats {
+    int n;
+    double mean, variance, min, max;
+};
+
+ReferenceStats computeReference(MaskedImage const &mimg, math::StatisticsControl const &sctrl,
+                                double const center, double const hwidth) {
+    ReferenceStats ref = { 0, 0.0, 0.0, 0.0, 0.0 };
+    double wsum = 0.0, wxsum = 0.0, wx2sum = 0.0;
+    for (int iY = 0; iY != mimg.getHeight(); ++iY) {
+        for (int iX = 0; iX != mimg.getWidth(); ++iX) {
+            double const val = (*mimg.getImage())(iX, iY);
+            if (lsst::utils::isnan(val) || ((*mimg.getMask())(iX, iY) & sctrl.getAndMask()) ||
+                !(std::fabs(val - center) <= hwidth)) {
+                continue;
+            }
+            double const w = sctrl.getWeighted() ? 1.0/(*mimg.getVariance())(iX, iY) : 1.0;
+            if (ref.n == 0 || val < ref.min) ref.min = val;
+            if (ref.n == 0 || val > ref.max) ref.max = val;
+            ++ref.n;
+            wsum += w;
+            wxsum += w*val;
+            wx2sum += w*val*val;
+        }
+    }
+    ref.mean = wxsum/wsum;
+    ref.variance = (wx2sum - wxsum*wxsum/wsum)/(wsum - wsum/ref.n);
+    return ref;
+}
+
+/*
+ * An image with outliers and masked pixels, and optionally some NaNs
+ */
+MaskedImage makeTestImage(bool withNans) {
+    int const nx = 37;
+    int const ny = 23;
+    MaskedImage mimg(geom::Extent2I(nx, ny));
+    for (int iY = 0; iY < ny; ++iY) {
+        for (int iX = 0; iX < nx; ++iX) {
+            int const seed = getSeed(iY*nx + iX, 1009);
+            double val = 100.0 + (seed % 97)/10.0 + 0.001*iX;
+            if (seed % 23 == 0) {
+                val += 1000.0;
+            }
+            if (withNans && seed % 31 == 0) {
+                val = std::numeric_limits<double>::quiet_NaN();
+            }
+            (*mimg.getImage())(iX, iY) = val;
+            (*mimg.getMask())(iX, iY) = (seed % 11 == 0) ? 0x2 : 0x0;
+            (*mimg.getVariance())(iX, iY) = 1.0 + (seed % 5);
+        }
+    }
+    return mimg;
+}
+
+bool equalOrBothNan(double a, double b) {
+    return a == b || (lsst::utils::isnan(a) && lsst::utils::isnan(b));
+}
+
+}
+
+/*
+ * Check the standard and clipped statistics against the reference, for all combinations of
+ * weighting, NaN-safety, masking and min/max finding
+ */
+BOOST_AUTO_TEST_CASE(StatisticsCombinations) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    double const IQ_TO_STDEV = 0.741301109252802;
+
+    for (int withNans = 0; withNans != 2; ++withNans) {
+        MaskedImage mimg = makeTestImage(withNans);
+        for (int weighted = 0; weighted != 2; ++weighted) {
+            for (int nanSafe = 0; nanSafe != 2; ++nanSafe) {
+                if (withNans && !nanSafe) {
+                    continue;           // the results aren't defined
+                }
+                for (int masked = 0; masked != 2; ++masked) {
+                    for (int minMax = 0; minMax != 2; ++minMax) {
+                        math::StatisticsControl sctrl;
+                        sctrl.setWeighted(weighted);
+                        sctrl.setNanSafe(nanSafe);
+                        sctrl.setAndMask(masked ? 0x2 : 0x0);
+                        sctrl.setNumSigmaClip(3.0);
+                        sctrl.setNumIter(3);
+
+                        int const flags = math::NPOINT | math::MEAN | math::VARIANCE | math::MEDIAN |
+                            math::IQRANGE | math::MEANCLIP | math::VARIANCECLIP |
+                            (minMax ? (math::MIN | math::MAX) : 0);
+                        math::Statistics stats = math::makeStatistics(mimg, flags, sctrl);
+
+                        ReferenceStats ref = computeReference(mimg, sctrl, 0.0,
+                                                              std::numeric_limits<double>::infinity());
+                        BOOST_CHECK_CLOSE(stats.getValue(math::MEAN), ref.mean, 1e-6);
+                        BOOST_CHECK_CLOSE(stats.getValue(math::VARIANCE), ref.variance, 1e-6);
+                        if (minMax) {
+                            BOOST_CHECK_EQUAL(stats.getValue(math::MIN), ref.min);
+                            BOOST_CHECK_EQUAL(stats.getValue(math::MAX), ref.max);
+                        }
+
+                        // the quantiles don't depend on the weighting, nor on finding the min and max
+                        math::StatisticsControl qctrl;
+                        qctrl.setAndMask(sctrl.getAndMask());
+                        math::Statistics quantiles =
+                            math::makeStatistics(mimg, math::MEDIAN | math::IQRANGE, qctrl);
+                        double const median = quantiles.getValue(math::MEDIAN);
+                        double const iqrange = quantiles.getValue(math::IQRANGE);
+                        BOOST_CHECK_EQUAL(stats.getValue(math::MEDIAN), median);
+                        BOOST_CHECK_EQUAL(stats.getValue(math::IQRANGE), iqrange);
+
+                        ReferenceStats clip = computeReference(mimg, sctrl, median,
+                                                               3.0*IQ_TO_STDEV*iqrange);
+                        for (int iter = 1; iter < sctrl.getNumIter(); ++iter) {
+                            clip = computeReference(mimg, sctrl, clip.mean, 3.0*std::sqrt(clip.variance));
+                        }
+                        BOOST_CHECK_CLOSE(stats.getValue(math::MEANCLIP), clip.mean, 1e-6);
+                        BOOST_CHECK_CLOSE(stats.getValue(math::VARIANCECLIP), clip.variance, 1e-5);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ * When we aren't NaN-safe, NaNs are kept in the copy used for the quantiles whether or not the
+ * min and max (whose loop always skips NaNs) were requested
+ */
+BOOST_AUTO_TEST_CASE(StatisticsNanUnsafeQuantiles) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    MaskedImage mimg = makeTestImage(true);
+    math::StatisticsControl sctrl;
+    sctrl.setNanSafe(false);
+
+    math::Statistics quantiles = math::makeStatistics(mimg, math::MEDIAN | math::IQRANGE, sctrl);
+    math::Statistics withMinMax =
+        math::makeStatistics(mimg, math::MEDIAN | math::IQRANGE | math::MIN | math::MAX, sctrl);
+
+    BOOST_CHECK(equalOrBothNan(withMinMax.getValue(math::MEDIAN), quantiles.getValue(math::MEDIAN)));
+    BOOST_CHECK(equalOrBothNan(withMinMax.getValue(math::IQRANGE), quantiles.getValue(math::IQRANGE)));
+    BOOST_CHECK(!lsst::utils::isnan(withMinMax.getValue(math::MIN)));
+    BOOST_CHECK(!lsst::utils::isnan(withMinMax.getValue(math::MAX)));
+}
+
+/*
+ * The weighted clipped variance should be normalised in the same way as the weighted variance, so
+ * they agree when the clipping doesn't reject anything
+ */
+BOOST_AUTO_TEST_CASE(StatisticsWeightedClip) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const nx = 40;
+    int const ny = 30;
+    image::MaskedImage<float> mimg(geom::Extent2I(nx, ny));
+    for (int iY = 0; iY < ny; ++iY) {
+        for (int iX = 0; iX < nx; ++iX) {
+            int const seed = (iX*37 + iY*11)%53;
+            // a skewed distribution, so the median (the first clipping centre) isn't the mean
+            (*mimg.getImage())(iX, iY) = 10.0 + 0.01*seed*seed;
+            (*mimg.getMask())(iX, iY) = 0x0;
+            (*mimg.getVariance())(iX, iY) = 1.0 + seed%4;
+        }
+    }
+
+    math::StatisticsControl sctrl;
+    sctrl.setWeighted(true);
+    sctrl.setNumSigmaClip(1000.0);
+    sctrl.setNumIter(1);
+
+    int const flags = math::NPOINT | math::MEAN | math::VARIANCE | math::MEANCLIP | math::VARIANCECLIP;
+    math::Statistics stats = math::makeStatistics(mimg, flags, sctrl);
+
+    BOOST_CHECK_EQUAL(stats.getValue(math::NPOINT), nx*ny);
+    BOOST_CHECK_CLOSE(stats.getValue(math::MEANCLIP), stats.getValue(math::MEAN), 1e-8);
+    BOOST_CHECK_CLOSE(stats.getValue(math::VARIANCECLIP), stats.getValue(math::VARIANCE), 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(StatisticsAccumulatorMerge) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const nx = 101;
+    int const ny = 64;
+    Image img(geom::Extent2I(nx, ny));
+    for (int iY = 0; iY < ny; ++iY) {
+        for (int iX = 0; iX < nx; ++iX) {
+            img(iX, iY) = 10.0 + (iX*37 + iY*11)%53 + ((iX + iY)%29 == 0 ? 1000.0 : 0.0);
+        }
+    }
+
+    int const flags = math::NPOINT | math::MEAN | math::STDEV | math::MEDIAN | math::IQRANGE |
+        math::MEANCLIP | math::STDEVCLIP | math::MIN | math::MAX | math::SUM;
+    math::Statistics stats = math::makeStatistics(img, flags);
+
+    // Accumulate the image in three horizontal strips, and merge them
+    math::StatisticsAccumulator total(flags);
+    int const nStrip = 3;
+    for (int i = 0; i != nStrip; ++i) {
+        int const y0 = i*ny/nStrip;
+        int const y1 = (i + 1)*ny/nStrip;
+        Image strip(img, geom::Box2I(geom::Point2I(0, y0), geom::Extent2I(nx, y1 - y0)), image::LOCAL);
+
+        math::StatisticsAccumulator acc(flags);
+        acc.add(strip);
+        total.merge(acc);
+    }
+    BOOST_CHECK(!total.isApproximate());
+
+    math::Statistics accStats = total.finalize();
+    math::Property const props[] = { math::NPOINT, math::MEAN, math::STDEV, math::MEDIAN, math::IQRANGE,
+                                     math::MEANCLIP, math::STDEVCLIP, math::MIN, math::MAX, math::SUM };
+    for (unsigned int i = 0; i != sizeof(props)/sizeof(props[0]); ++i) {
+        BOOST_CHECK_CLOSE(accStats.getValue(props[i]), stats.getValue(props[i]), 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(StatisticsAccumulatorApproximate) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const nx = 500;
+    int const ny = 400;
+    double const mean = 1000.0;
+    double const sigma = 10.0;
+    Image img(geom::Extent2I(nx, ny));
+    for (int iY = 0; iY < ny; ++iY) {
+        for (int iX = 0; iX < nx; ++iX) {
+            // a roughly Gaussian distribution (the sum of uniform deviates), with some outliers
+            double val = 0.0;
+            for (int k = 0; k != 12; ++k) {
+                val += getSeed((k*ny + iY)*nx + iX, 10007)/10007.0;
+            }
+            img(iX, iY) = mean + sigma*(val - 6.0) + ((iX*iY)%97 == 1 ? 1.0e5 : 0.0);
+        }
+    }
+
+    int const flags = math::NPOINT | math::MEAN | math::MEDIAN | math::MEANCLIP | math::STDEVCLIP;
+    math::Statistics stats = math::makeStatistics(img, flags);
+
+    int const maxValues = 1024;
+    math::StatisticsAccumulator total(flags, math::StatisticsControl(), maxValues);
+    int const nStrip = 4;
+    for (int i = 0; i != nStrip; ++i) {
+        int const y0 = i*ny/nStrip;
+        int const y1 = (i + 1)*ny/nStrip;
+        Image strip(img, geom::Box2I(geom::Point2I(0, y0), geom::Extent2I(nx, y1 - y0)), image::LOCAL);
+
+        math::StatisticsAccumulator acc(flags, math::StatisticsControl(), maxValues);
+        acc.add(strip);
+        total.merge(acc);
+    }
+    BOOST_CHECK(total.isApproximate());
+
+    math::Statistics accStats = total.finalize();
+    BOOST_CHECK_CLOSE(accStats.getValue(math::MEAN), stats.getValue(math::MEAN), 1e-8); // not approximate
+    BOOST_CHECK_SMALL(accStats.getValue(math::MEDIAN) - stats.getValue(math::MEDIAN), 0.1*sigma);
+    BOOST_CHECK_SMALL(accStats.getValue(math::MEANCLIP) - stats.getValue(math::MEANCLIP), 0.01*sigma);
+    BOOST_CHECK_CLOSE(accStats.getValue(math::STDEVCLIP), stats.getValue(math::STDEVCLIP), 5.0);
+}
+
+/*
+ * When we aren't NaN-safe, the accumulator follows makeStatistics:  NaNs are left out of the sums if
+ * MIN or MAX is requested, and poison them otherwise
+ */
+BOOST_AUTO_TEST_CASE(StatisticsAccumulatorNans) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    MaskedImage mimg = makeTestImage(true);
+    math::StatisticsControl sctrl;
+    sctrl.setNanSafe(false);
+
+    int const flagSets[] = { math::NPOINT | math::MIN | math::MEAN | math::VARIANCE,
+                             math::NPOINT | math::MEAN | math::VARIANCE };
+    for (unsigned int i = 0; i != sizeof(flagSets)/sizeof(flagSets[0]); ++i) {
+        int const flags = flagSets[i];
+        math::Statistics stats = math::makeStatistics(mimg, flags, sctrl);
+        math::StatisticsAccumulator acc(flags, sctrl);
+        acc.add(mimg);
+        math::Statistics accStats = acc.finalize();
+
+        BOOST_CHECK_EQUAL(accStats.getValue(math::NPOINT), stats.getValue(math::NPOINT));
+        if (flags & math::MIN) {
+            BOOST_CHECK(!lsst::utils::isnan(stats.getValue(math::MEAN)));
+            BOOST_CHECK_CLOSE(accStats.getValue(math::MIN), stats.getValue(math::MIN), 1e-8);
+            BOOST_CHECK_CLOSE(accStats.getValue(math::MEAN), stats.getValue(math::MEAN), 1e-8);
+            BOOST_CHECK_CLOSE(accStats.getValue(math::VARIANCE), stats.getValue(math::VARIANCE), 1e-8);
+        } else {
+            BOOST_CHECK(lsst::utils::isnan(stats.getValue(math::MEAN)));
+            BOOST_CHECK(lsst::utils::isnan(accStats.getValue(math::MEAN)));
+        }
+    }
+}
+
+/*
+ * Merging an accumulator with itself counts its pixels twice
+ */
+BOOST_AUTO_TEST_CASE(StatisticsAccumulatorSelfMerge) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    MaskedImage mimg = makeTestImage(false);
+    int const flags = math::NPOINT | math::MEAN | math::MEDIAN;
+    math::StatisticsAccumulator acc(flags);
+    acc.add(mimg);
+    math::Statistics stats = acc.finalize();
+
+    acc.merge(acc);
+    math::Statistics doubled = acc.finalize();
+    BOOST_CHECK_EQUAL(doubled.getValue(math::NPOINT), 2*stats.getValue(math::NPOINT));
+    BOOST_CHECK_CLOSE(doubled.getValue(math::MEAN), stats.getValue(math::MEAN), 1e-8);
+    BOOST_CHECK_CLOSE(doubled.getValue(math::MEDIAN), stats.getValue(math::MEDIAN), 1e-8);
+}
+
+/*
+ * Values spanning hundreds of decades mustn't overflow the histogram's bin indices
+ */
+BOOST_AUTO_TEST_CASE(StatisticsAccumulatorWideRange) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const flags = math::NPOINT | math::MIN | math::MAX | math::MEDIAN;
+    math::StatisticsAccumulator acc(flags, math::StatisticsControl(), 16);
+    for (int i = 0; i != 64; ++i) {
+        acc.add(1.0 + 1.0e-3*i);        // a narrow histogram...
+    }
+    acc.add(1.0e300);                   // ...which then has to cover these
+    acc.add(-1.0e300);
+    acc.add(1.0e-300);
+    BOOST_CHECK(acc.isApproximate());
+
+    math::Statistics stats = acc.finalize();
+    BOOST_CHECK_EQUAL(stats.getValue(math::NPOINT), 67);
+    BOOST_CHECK_EQUAL(stats.getValue(math::MIN), -1.0e300);
+    BOOST_CHECK_EQUAL(stats.getValue(math::MAX), 1.0e300);
+    BOOST_CHECK(lsst::utils::isfinite(stats.getValue(math::MEDIAN)));
+}
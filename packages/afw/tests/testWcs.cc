@@ -213,3 +213,78 @@ BOOST_AUTO_TEST_CASE(linearMatrix) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-
 }
 
 
+
+
+//The array versions of pixelToSky and skyToPixel should agree with the single position versions
+BOOST_AUTO_TEST_CASE(arrays) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    geom::Point2D crval = geom::Point2D(80.159679, 30.806568);
+    geom::Point2D crpix = geom::Point2D(890.500000, 892.500000);
+    matrixD CD(2,2);
+
+    CD(0,0) = -0.0002802350;
+    CD(0,1) = -0.0000021800;
+    CD(1,0) = -0.0000022507;
+    CD(1,1) = 0.0002796878;
+
+    //Small quadratic distortion, and (approximately) its inverse
+    Eigen::MatrixXd sipA = Eigen::MatrixXd::Zero(3,3);
+    Eigen::MatrixXd sipB = Eigen::MatrixXd::Zero(3,3);
+    sipA(2,0) = 1e-6;
+    sipA(1,1) = -2e-6;
+    sipB(0,2) = 3e-6;
+    sipB(1,1) = 1e-6;
+    Eigen::MatrixXd sipAp = -sipA;
+    Eigen::MatrixXd sipBp = -sipB;
+
+    image::Wcs wcs(crval, crpix, CD);
+    image::TanWcs tanWcs(crval, crpix, CD, sipA, sipB, sipAp, sipBp);
+
+    //More positions than are passed to wcslib at once
+    int const n = 2500;
+    lsst::ndarray::Array<double,1,1> x = lsst::ndarray::allocate(n);
+    lsst::ndarray::Array<double,1,1> y = lsst::ndarray::allocate(n);
+    for (int i = 0; i != n; ++i) {
+        x[i] = 10.0 + 0.7*i;
+        y[i] = 1800.0 - 0.6*i;
+    }
+
+    image::Wcs const *wcsList[] = { &wcs, &tanWcs };
+    for (int w = 0; w != 2; ++w) {
+        image::Wcs const &testWcs = *wcsList[w];
+
+        lsst::ndarray::Array<double,1,1> ra = lsst::ndarray::allocate(n);
+        lsst::ndarray::Array<double,1,1> dec = lsst::ndarray::allocate(n);
+        testWcs.pixelToSky(x, y, ra, dec);
+
+        lsst::ndarray::Array<double,1,1> x2 = lsst::ndarray::allocate(n);
+        lsst::ndarray::Array<double,1,1> y2 = lsst::ndarray::allocate(n);
+        testWcs.skyToPixel(ra, dec, x2, y2);
+
+        for (int i = 0; i != n; ++i) {
+            geom::Point2D const ad = testWcs.pixelToSky(x[i], y[i], true);
+            BOOST_CHECK_CLOSE(ra[i], ad.getX(), 1e-10);
+            BOOST_CHECK_CLOSE(dec[i], ad.getY(), 1e-10);
+
+            geom::Point2D const xy = testWcs.skyToPixel(ra[i], dec[i]);
+            BOOST_CHECK_CLOSE(x2[i], xy.getX(), 1e-10);
+            BOOST_CHECK_CLOSE(y2[i], xy.getY(), 1e-10);
+        }
+    }
+
+    //Closure (without distortion, as the SIP polynomials above are only approximate inverses)
+    lsst::ndarray::Array<double,1,1> ra = lsst::ndarray::allocate(n);
+    lsst::ndarray::Array<double,1,1> dec = lsst::ndarray::allocate(n);
+    lsst::ndarray::Array<double,1,1> x2 = lsst::ndarray::allocate(n);
+    lsst::ndarray::Array<double,1,1> y2 = lsst::ndarray::allocate(n);
+    wcs.pixelToSky(x, y, ra, dec);
+    wcs.skyToPixel(ra, dec, x2, y2);
+    for (int i = 0; i != n; ++i) {
+        BOOST_CHECK_CLOSE(x2[i], x[i], 1e-6);
+        BOOST_CHECK_CLOSE(y2[i], y[i], 1e-6);
+    }
+
+    //All the arrays must have the same length
+    lsst::ndarray::Array<double,1,1> shortArray = lsst::ndarray::allocate(n - 1);
+    BOOST_CHECK_THROW(wcs.pixelToSky(x, y, ra, shortArray), lsst::pex::exceptions::LengthErrorException);
+    BOOST_CHECK_THROW(wcs.skyToPixel(ra, shortArray, x2, y2), lsst::pex::exceptions::LengthErrorException);
+}
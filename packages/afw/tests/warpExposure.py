@@ -166,6 +166,56 @@ class WarpExposureTestCase(unittest.TestCase):
         except Exception:
             pass
 
+    def testTabulatedKernel(self, interpLength=10):
+        """Test that warping with a tabulated Lanczos kernel matches the same kernel evaluated at each pixel
+
+        makeWarpingKernel returns a LanczosWarpingKernel, which warpImage tabulates;
+        an equivalent plain SeparableKernel is evaluated at each pixel.
+        """
+        originalExposure = afwImage.ExposureF(originalExposurePath)
+        swarpedMetadata = afwImage.DecoratedImageF(os.path.join(dataDir, "medswarp1lanczos3.fits")).getMetadata()
+        warpedWcs = afwImage.makeWcs(swarpedMetadata)
+        dimensions = originalExposure.getMaskedImage().getDimensions()
+
+        tabulatedKernel = afwMath.makeWarpingKernel("lanczos3")
+        tabulatedExposure = afwImage.ExposureF(afwImage.MaskedImageF(dimensions), warpedWcs)
+        afwMath.warpExposure(tabulatedExposure, originalExposure, tabulatedKernel, interpLength)
+
+        lanczosFunc = afwMath.LanczosFunction1D(3)
+        exactKernel = afwMath.SeparableKernel(6, 6, lanczosFunc, lanczosFunc)
+        exactExposure = afwImage.ExposureF(afwImage.MaskedImageF(dimensions), warpedWcs)
+        afwMath.warpExposure(exactExposure, originalExposure, exactKernel, interpLength)
+
+        tabulatedArrSet = tabulatedExposure.getMaskedImage().getArrays()
+        exactArrSet = exactExposure.getMaskedImage().getArrays()
+        errStr = imageTestUtils.maskedImagesDiffer(tabulatedArrSet, exactArrSet,
+            skipMaskArr=numpy.isnan(exactArrSet[0]), rtol=1.0e-05, atol=1.0e-03)
+        if errStr:
+            self.fail("tabulated and exact lanczos3-warped exposures differ: %s" % (errStr,))
+
+    def testThreads(self, interpLength=10):
+        """Test that warping in parallel gives exactly the same result as warping in one thread
+        """
+        originalExposure = afwImage.ExposureF(originalExposurePath)
+        swarpedMetadata = afwImage.DecoratedImageF(os.path.join(dataDir, "medswarp1lanczos3.fits")).getMetadata()
+        warpedWcs = afwImage.makeWcs(swarpedMetadata)
+        dimensions = originalExposure.getMaskedImage().getDimensions()
+
+        for kernelName in ("bilinear", "lanczos3", "nearest"):
+            warpingKernel = afwMath.makeWarpingKernel(kernelName)
+            serialExposure = afwImage.ExposureF(afwImage.MaskedImageF(dimensions), warpedWcs)
+            numGoodPix = afwMath.warpExposure(serialExposure, originalExposure, warpingKernel, interpLength, 1)
+            serialArrSet = serialExposure.getMaskedImage().getArrays()
+            for nThread in (4, 0):
+                parallelExposure = afwImage.ExposureF(afwImage.MaskedImageF(dimensions), warpedWcs)
+                self.assertEqual(afwMath.warpExposure(parallelExposure, originalExposure, warpingKernel,
+                    interpLength, nThread), numGoodPix)
+                errStr = imageTestUtils.maskedImagesDiffer(parallelExposure.getMaskedImage().getArrays(),
+                    serialArrSet, skipMaskArr=numpy.isnan(serialArrSet[0]), rtol=0, atol=0)
+                if errStr:
+                    self.fail("%s-warped exposure with nThread=%d differs from nThread=1: %s" % \
+                        (kernelName, nThread, errStr))
+
     def testMatchSwarpBilinearImage(self):
         """Test that warpExposure matches swarp using a bilinear warping kernel
         """
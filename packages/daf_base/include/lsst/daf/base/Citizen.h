@@ -25,9 +25,11 @@
 #ifndef LSST_DAF_BASE_CITIZEN_H
 #define LSST_DAF_BASE_CITIZEN_H
 
+#include <cstddef>
 #include <map>
 #include <ostream>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 #include "boost/noncopyable.hpp"
@@ -50,6 +52,18 @@ namespace base {
  * a function of your choice be called when a specific
  * block ID is allocated or deleted, and check whether any
  * of the data blocks are known to be corrupted
+ *
+ * Citizens may be created and destroyed in any thread:  the
+ * registry of Citizens is split into shards (chosen by ID),
+ * each with its own lock, so threads rarely contend for it.
+ * The callbacks and their IDs should be set before any
+ * threads are started.
+ *
+ * Tracking may be turned off with setTracking(false) (or by
+ * default, by compiling daf_base with
+ * LSST_DAF_BASE_NO_CITIZEN_TRACKING defined), in which case
+ * Citizens created thereafter are given IDs but not entered
+ * in the registry, so they don't appear in any census.
  */
     class Citizen {
     public:
@@ -58,6 +72,16 @@ namespace base {
         //! A function used to register a callback
         typedef memId (*memCallback)(const Citizen *ptr);
 
+        //! The number of (and bytes used by) the active Citizens of a type
+        struct TypeCount {
+            TypeCount() : count(0), nBytes(0) {}
+
+            int count;                  //!< number of Citizens
+            std::size_t nBytes;         //!< total of their getByteCount()
+        };
+        //! A census of the active Citizens, by (demangled) type name
+        typedef std::map<std::string, TypeCount> TypeCensus;
+
         Citizen(const std::type_info &);
         Citizen(Citizen const &);
         ~Citizen();
@@ -70,13 +94,20 @@ namespace base {
         static int census(int, memId startingMemId = 0);
         static void census(std::ostream &stream, memId startingMemId = 0);
         static const std::vector<const Citizen *> *census();
+        static TypeCensus censusByType(memId startingMemId = 0);
+        static void censusByType(std::ostream &stream, memId startingMemId = 0);
 
         static bool hasBeenCorrupted();
         
         memId getId() const;
-        
+        //! Return the number of bytes that this Citizen has reported using (see setByteCount())
+        std::size_t getByteCount() const { return _nBytes; }
+
         static memId getNextMemId();
 
+        static bool setTracking(bool track);
+        static bool isTracking();
+
         static memId setNewCallbackId(memId id);
         static memId setDeleteCallbackId(memId id);
         static memCallback setNewCallback(memCallback func);
@@ -85,19 +116,26 @@ namespace base {
         //
         enum { magicSentinel = 0xdeadbeef }; //!< a magic known bit pattern
         static int init();
+    protected:
+        //! Report the number of bytes owned by this Citizen (e.g. its pixels), for censusByType()
+        void setByteCount(std::size_t nBytes) { _nBytes = nBytes; }
     private:
         typedef std::map<memId, const Citizen *> table;
+        struct Shard;                   // a part of the registry of Citizens, with its own lock
 
         int _sentinel;                  // Initialised to _magicSentinel to detect overwritten memory
         memId _CitizenId;               // unique identifier for this pointer
         const char *_typeName;          // typeid()->name
+        bool _isTracked;                // is this Citizen in the registry?
+        std::size_t _nBytes;            // bytes owned by this Citizen, as reported by setByteCount()
         //
         // Book-keeping for _CitizenId
         //
         static memId& _nextMemId(void);
-        static table& _activeCitizens();
-        static table& _persistentCitizens();
-        static bool _shouldPersistCitizens;
+        static Shard& _getShard(memId id);
+        static std::vector<const Citizen *> _getActive(memId startingMemId);
+        static bool _shouldTrackCitizens;
+        void _register();
         //
         // Callbacks
         //
@@ -109,8 +147,6 @@ namespace base {
         static memCallback _corruptionCallback;        
         //
         bool _hasBeenCorrupted() const;
-
-        friend class PersistentCitizenScope;
     };
 
 #ifndef SWIG
@@ -118,7 +154,7 @@ namespace base {
      * A PersistentCitizenScope object causes all Citizen objects created during its lifetime
      * to be marked as persistent. This is useful when constructing static objects that contain
      * a heirarchy of other Citizens which would otherwise need to be marked persistent on an
-     * individual basis.
+     * individual basis.  It only affects the thread that created it.
      *
      * @sa Citizen::markPersistent()
      */
@@ -25,9 +25,11 @@
 //! \file
 //! \brief Implementation of Citizen
 
+#include <algorithm>
 #include <iostream>
 #include <boost/shared_ptr.hpp>
 #include <boost/format.hpp>
+#include <boost/thread/mutex.hpp>
 #include <ctype.h>
 #include "lsst/daf/base/Citizen.h"
 #include "lsst/pex/exceptions.h"
@@ -52,31 +54,57 @@ private:
 };
  
 CitizenInit one;
+
+namespace {
+    //
+    // The registry is split into numShards shards, chosen by memId;  as consecutive IDs go to different
+    // shards, threads creating Citizens at the same time rarely need the same lock
+    //
+    int const numShards = 64;
+    //
+    // Should Citizens created by this thread be marked persistent?  (see PersistentCitizenScope)
+    //
+    __thread bool shouldPersistCitizens = false;
+
+    bool compareIds(Citizen const* a, Citizen const* b) {
+        return a->getId() < b->getId();
+    }
+}
+
+struct Citizen::Shard {
+    boost::mutex mutex;                 // protects active and persistent
+    table active;                       // Citizens that should be destroyed before the process ends
+    table persistent;                   // Citizens that may live until the process ends
+};
 //
 // Con/Destructors
 //
 Citizen::Citizen(std::type_info const& type) :
     _sentinel(magicSentinel),
-    _typeName(type.name()) {
-    _CitizenId = _nextMemId()++;
-    if (_shouldPersistCitizens) {
-        _persistentCitizens()[_CitizenId] = this;
-    } else {
-        _activeCitizens()[_CitizenId] = this;
-    }
-    if (_CitizenId == _newId) {
-        _newId += _newCallback(this);
-    }
+    _typeName(type.name()),
+    _nBytes(0) {
+    _register();
 }
 
 Citizen::Citizen(Citizen const& citizen) :
     _sentinel(magicSentinel),
-    _typeName(citizen._typeName) {
-    _CitizenId = _nextMemId()++;
-    if (_shouldPersistCitizens) {
-        _persistentCitizens()[_CitizenId] = this;
-    } else {
-        _activeCitizens()[_CitizenId] = this;
+    _typeName(citizen._typeName),
+    _nBytes(0) {
+    _register();
+}
+
+//! Give a newly-constructed Citizen its ID, and enter it in the registry
+void Citizen::_register() {
+    _CitizenId = __sync_fetch_and_add(&_nextMemId(), 1); // atomic, so IDs are unique across threads
+    _isTracked = _shouldTrackCitizens;
+    if (_isTracked) {
+        Shard &shard = _getShard(_CitizenId);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        if (shouldPersistCitizens) {
+            shard.persistent[_CitizenId] = this;
+        } else {
+            shard.active[_CitizenId] = this;
+        }
     }
 
     if (_CitizenId == _newId) {
@@ -91,9 +119,19 @@ Citizen::~Citizen() {
 
     (void)_hasBeenCorrupted();  // may execute callback
     _sentinel = 0x0000dead;     // In case we have a dangling pointer
-    size_t nActive = _activeCitizens().erase(_CitizenId);
-    if (nActive > 1 || (nActive == 0 && _persistentCitizens().erase(_CitizenId) != 1)) {
-        (void)_corruptionCallback(this);
+    if (_isTracked) {
+        Shard &shard = _getShard(_CitizenId);
+        size_t nActive, nPersistent = 0;
+        {
+            boost::mutex::scoped_lock lock(shard.mutex);
+            nActive = shard.active.erase(_CitizenId);
+            if (nActive == 0) {
+                nPersistent = shard.persistent.erase(_CitizenId);
+            }
+        }
+        if (nActive > 1 || (nActive == 0 && nPersistent != 1)) {
+            (void)_corruptionCallback(this);
+        }
     }
 }
 
@@ -139,8 +177,32 @@ std::string Citizen::repr() const {
 
 //! Mark a Citizen as persistent and not destroyed until process end.
 void Citizen::markPersistent(void) {
-    _activeCitizens().erase(_CitizenId);
-    _persistentCitizens()[_CitizenId] = this;
+    if (!_isTracked) {
+        return;
+    }
+    Shard &shard = _getShard(_CitizenId);
+    boost::mutex::scoped_lock lock(shard.mutex);
+    shard.active.erase(_CitizenId);
+    shard.persistent[_CitizenId] = this;
+}
+
+//! Turn on (or off) the tracking of the Citizens created from now on; return the previous setting
+//
+// Untracked Citizens cost an ID, but aren't entered in the registry; they
+// don't appear in any census, and aren't checked by hasBeenCorrupted()
+//
+bool Citizen::setTracking(
+    bool track                          //!< track new Citizens?
+    ) {
+    bool const old = _shouldTrackCitizens;
+    _shouldTrackCitizens = track;
+
+    return old;
+}
+
+//! Are new Citizens being tracked?
+bool Citizen::isTracking() {
+    return _shouldTrackCitizens;
 }
 
 //! \name Census
@@ -154,15 +216,17 @@ int Citizen::census(
     int,                                //<! the int argument allows overloading
     memId startingMemId                 //!< Don't print Citizens with lower IDs
     ) {
-    if (startingMemId == 0) {              // easy
-        return _activeCitizens().size();
-    }
-
     int n = 0;
-    for (table::iterator cur = _activeCitizens().begin();
-         cur != _activeCitizens().end(); cur++) {
-        if (cur->second->_CitizenId >= startingMemId) {
-            n++;
+    for (int i = 0; i != numShards; ++i) {
+        Shard &shard = _getShard(i);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        if (startingMemId == 0) {          // easy
+            n += shard.active.size();
+        } else {
+            for (table::iterator cur = shard.active.lower_bound(startingMemId);
+                 cur != shard.active.end(); cur++) {
+                n++;
+            }
         }
     }
 
@@ -175,11 +239,9 @@ void Citizen::census(
     std::ostream &stream,               //!< stream to print to
     memId startingMemId                 //!< Don't print Citizens with lower IDs
     ) {
-    for (table::iterator cur = _activeCitizens().begin();
-         cur != _activeCitizens().end(); cur++) {
-        if (cur->second->_CitizenId >= startingMemId) {
-            stream << cur->second->repr() << "\n";
-        }
+    std::vector<Citizen const*> const active = _getActive(startingMemId);
+    for (std::vector<Citizen const*>::const_iterator cur = active.begin(); cur != active.end(); cur++) {
+        stream << (*cur)->repr() << "\n";
     }
 }
 //
@@ -191,16 +253,47 @@ void Citizen::census(
 //! and not bother
 //
 std::vector<Citizen const*> const* Citizen::census() {
-    std::vector<Citizen const*>* vec =
-        new std::vector<Citizen const*>(0);
-    vec->reserve(_activeCitizens().size());
+    return new std::vector<Citizen const*>(_getActive(0));
+}
+//
+//! Return the number of active Citizens of each type, and the bytes that they've reported using
+//
+Citizen::TypeCensus Citizen::censusByType(
+    memId startingMemId                 //!< Don't count Citizens with lower IDs
+    ) {
+    // count by typeid().name(), which is cheap to compare;  a type may have several copies of its
+    // name (e.g. one per shared library), so merge the counts by demangled name afterwards
+    std::map<char const*, TypeCount> counts;
+    for (int i = 0; i != numShards; ++i) {
+        Shard &shard = _getShard(i);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        for (table::iterator cur = shard.active.lower_bound(startingMemId);
+             cur != shard.active.end(); cur++) {
+            TypeCount &count = counts[cur->second->_typeName];
+            count.count++;
+            count.nBytes += cur->second->_nBytes;
+        }
+    }
 
-    for (table::iterator cur = _activeCitizens().begin();
-         cur != _activeCitizens().end(); cur++) {
-        vec->push_back(dynamic_cast<Citizen const*>(cur->second));
+    TypeCensus census;
+    for (std::map<char const*, TypeCount>::const_iterator cur = counts.begin(); cur != counts.end(); cur++) {
+        TypeCount &count = census[lsst::utils::demangleType(cur->first)];
+        count.count += cur->second.count;
+        count.nBytes += cur->second.nBytes;
+    }
+    return census;
+}
+//
+//! Print the number of active Citizens of each type, and the bytes that they've reported using
+//
+void Citizen::censusByType(
+    std::ostream &stream,               //!< stream to print to
+    memId startingMemId                 //!< Don't count Citizens with lower IDs
+    ) {
+    TypeCensus const census = censusByType(startingMemId);
+    for (TypeCensus::const_iterator cur = census.begin(); cur != census.end(); cur++) {
+        stream << boost::format("%8d %12d %s\n") % cur->second.count % cur->second.nBytes % cur->first;
     }
-        
-    return vec;
 }
 //@}
 
@@ -218,16 +311,18 @@ bool Citizen::_hasBeenCorrupted() const {
 
 //! Check all allocated blocks for corruption
 bool Citizen::hasBeenCorrupted() {
-    for (table::iterator cur = _activeCitizens().begin();
-         cur != _activeCitizens().end(); cur++) {
-        if (cur->second->_hasBeenCorrupted()) {
-            return true;
+    for (int i = 0; i != numShards; ++i) {
+        Shard &shard = _getShard(i);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        for (table::iterator cur = shard.active.begin(); cur != shard.active.end(); cur++) {
+            if (cur->second->_hasBeenCorrupted()) {
+                return true;
+            }
         }
-    }
-    for (table::iterator cur = _persistentCitizens().begin();
-         cur != _persistentCitizens().end(); cur++) {
-        if (cur->second->_hasBeenCorrupted()) {
-            return true;
+        for (table::iterator cur = shard.persistent.begin(); cur != shard.persistent.end(); cur++) {
+            if (cur->second->_hasBeenCorrupted()) {
+                return true;
+            }
         }
     }
 
@@ -334,21 +429,37 @@ Citizen::memId defaultCorruptionCallback(Citizen const* ptr //!< About-to-be del
     return ptr->getId();                // NOTREACHED
 }
 
-Citizen::table& Citizen::_activeCitizens(void) {
-    static Citizen::table* activeCitizensTable = new Citizen::table; /* parasoft-suppress BD-RES-LEAKS "Needs to stay for the life of the process" */
-    return *activeCitizensTable;
+//! Return the shard of the registry that holds the Citizen with ID id
+Citizen::Shard& Citizen::_getShard(memId id) {
+    static Citizen::Shard* shards = new Citizen::Shard[numShards]; /* parasoft-suppress BD-RES-LEAKS "Needs to stay for the life of the process" */
+    return shards[id%numShards];
 }
 
-Citizen::table& Citizen::_persistentCitizens(void) {
-    static Citizen::table* persistentCitizensTable = new Citizen::table; /* parasoft-suppress BD-RES-LEAKS "Needs to stay for the life of the process" */
-    return *persistentCitizensTable;
+//! Return the active Citizens with IDs of at least startingMemId, sorted by ID
+std::vector<Citizen const*> Citizen::_getActive(memId startingMemId) {
+    std::vector<Citizen const*> active;
+    for (int i = 0; i != numShards; ++i) {
+        Shard &shard = _getShard(i);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        for (table::iterator cur = shard.active.lower_bound(startingMemId);
+             cur != shard.active.end(); cur++) {
+            active.push_back(cur->second);
+        }
+    }
+    std::sort(active.begin(), active.end(), compareIds);
+
+    return active;
 }
 
 //@}
 //
 // Initialise static members
 //
-bool Citizen::_shouldPersistCitizens = false;
+#if defined(LSST_DAF_BASE_NO_CITIZEN_TRACKING)
+bool Citizen::_shouldTrackCitizens = false;
+#else
+bool Citizen::_shouldTrackCitizens = true;
+#endif
 
 Citizen::memId Citizen::_newId = 0;
 Citizen::memId Citizen::_deleteId = 0;
@@ -359,11 +470,11 @@ Citizen::memCallback Citizen::_corruptionCallback = defaultCorruptionCallback;
 
 
 PersistentCitizenScope::PersistentCitizenScope() {
-    Citizen::_shouldPersistCitizens = true;
+    shouldPersistCitizens = true;
 }
 
 PersistentCitizenScope::~PersistentCitizenScope() {
-    Citizen::_shouldPersistCitizens = false;
+    shouldPersistCitizens = false;
 }
 
 }}} // namespace lsst::daf::base
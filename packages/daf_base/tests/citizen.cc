@@ -26,6 +26,7 @@
 #include <boost/format.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
 #include "lsst/pex/exceptions.h"
 #include "lsst/daf/base/Citizen.h"
 
@@ -37,6 +38,11 @@ private:
     int _i;
 };
 
+class Sock : public lsst::daf::base::Citizen {
+public:
+    Sock(std::size_t nBytes = 0) : Citizen(typeid(this)) { setByteCount(nBytes); }
+};
+
 class MyClass : public lsst::daf::base::Citizen {
   public:
     MyClass(const char * = 0) :
@@ -98,5 +104,66 @@ BOOST_AUTO_TEST_CASE(all) {
     BOOST_CHECK_EQUAL(Citizen::census(0, firstId), 0);
 }
 
+// Create and destroy Citizens, as a thread
+struct MakeShoes {
+    void operator()() const {
+        std::vector<boost::shared_ptr<Shoe> > shoes;
+        for (int i = 0; i != 10000; ++i) {
+            shoes.push_back(boost::shared_ptr<Shoe>(new Shoe(i)));
+            if (i%3 == 0) {
+                shoes.pop_back();
+            }
+        }
+    }
+};
+
+BOOST_AUTO_TEST_CASE(threads) {
+    const Citizen::memId firstId = Citizen::getNextMemId();
+    const int nThread = 8;
+
+    boost::thread_group threads;
+    for (int i = 0; i != nThread; ++i) {
+        threads.create_thread(MakeShoes());
+    }
+    threads.join_all();
+
+    BOOST_CHECK_EQUAL(Citizen::census(0, firstId), 0);
+    BOOST_CHECK_EQUAL(Citizen::getNextMemId() - firstId, static_cast<Citizen::memId>(nThread*10000));
+    BOOST_CHECK(!Citizen::hasBeenCorrupted());
+}
+
+BOOST_AUTO_TEST_CASE(censusByType) {
+    const Citizen::memId firstId = Citizen::getNextMemId();
+
+    Shoe shoe;
+    Sock sock1(100);
+    Sock sock2(23);
+    Citizen::TypeCensus census = Citizen::censusByType(firstId);
+    BOOST_CHECK_EQUAL(census.size(), 2U);
+    for (Citizen::TypeCensus::const_iterator i = census.begin(); i != census.end(); ++i) {
+        if (i->first.find("Sock") != std::string::npos) {
+            BOOST_CHECK_EQUAL(i->second.count, 2);
+            BOOST_CHECK_EQUAL(i->second.nBytes, 123U);
+        } else {
+            BOOST_CHECK_EQUAL(i->second.count, 1);
+            BOOST_CHECK_EQUAL(i->second.nBytes, 0U);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tracking) {
+    const Citizen::memId firstId = Citizen::getNextMemId();
+
+    bool const wasTracking = Citizen::setTracking(false);
+    boost::scoped_ptr<Shoe> untracked(new Shoe);
+    Citizen::setTracking(true);
+    Shoe tracked;
+    BOOST_CHECK_EQUAL(Citizen::census(0, firstId), 1);
+
+    untracked.reset();                  // mustn't be reported as corrupt
+    BOOST_CHECK_EQUAL(Citizen::census(0, firstId), 1);
+    Citizen::setTracking(wasTracking);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
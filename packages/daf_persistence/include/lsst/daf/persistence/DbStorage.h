@@ -87,6 +87,8 @@ public:
     void setColumn(std::string const& columnName, T const& value);
     virtual void setColumnToNull(std::string const& columnName);
     virtual void insertRow(void);
+    virtual void setInsertBatchSize(int maxRows, int maxBytes = 512 * 1024);
+    virtual void flushInserts(void);
 
     virtual void setTableForQuery(std::string const& tableName,
                                   bool isExpr = false);
@@ -108,6 +108,8 @@ private:
     void setColumn(std::string const& columnName, T const& value);
     virtual void setColumnToNull(std::string const& columnName);
     virtual void insertRow(void);
+    virtual void setInsertBatchSize(int maxRows, int maxBytes);
+    virtual void flushInserts(void);
 
     virtual void setTableForQuery(std::string const& tableName, bool isExpr);
     virtual void setTableListForQuery(
@@ -129,10 +131,13 @@ private:
     // MySQL-specific functions for implementation.
     void executeQuery(std::string const& query);
     std::string quote(std::string const& name);
-    void stError(std::string const& text);
+    void stError(std::string const& text, MYSQL_STMT* statement = 0);
     void error(std::string const& text, bool mysqlCaused = true);
 
     void* allocateMemory(size_t size);
+    MYSQL_STMT* prepareInsert(int numRows, int numColumns, bool& isCached);
+    int maxInsertRows(int numColumns) const;
+    void closeInsertStatements(void);
 
     bool _readonly;
         ///< Remember if we are supposed to be read-only.
@@ -143,6 +148,10 @@ private:
 
     std::string _insertTable;
         ///< Name of table into which to insert.
+    std::string _insertColumns;
+        ///< Quoted, comma-separated list of the columns being inserted.
+    bool _insertColumnsChanged;
+        ///< Have the table or the columns to insert changed since the last row?
     std::vector<std::string> _queryTables;
         ///< Names of tables to select from.
 
@@ -170,6 +179,29 @@ private:
         ///< Space for lengths of result fields.
     boost::shared_array<my_bool> _fieldNulls;
         ///< Space for null flags of result fields.
+
+    typedef std::tr1::unordered_map<std::string, MYSQL_STMT*> StatementMap;
+    StatementMap _insertStatements;
+        ///< Prepared INSERT statements, keyed by their SQL.
+
+    /// A copy of a column value in a row waiting to be inserted.
+    struct PendingValue {
+        size_t _offset;                 ///< Offset of the value in _pendingData.
+        unsigned long _length;          ///< Length of the value in bytes.
+        enum_field_types _type;         ///< MySQL type of the value.
+        bool _isNull;                   ///< Is the value NULL?
+        bool _isUnsigned;               ///< Is the value an unsigned integer?
+    };
+    std::vector<char> _pendingData;
+        ///< Values of the rows waiting to be inserted.
+    std::vector<PendingValue> _pendingValues;
+        ///< Descriptions of the values waiting to be inserted, row by row.
+    int _numPendingRows;
+        ///< Number of rows waiting to be inserted.
+    int _maxBatchRows;
+        ///< Maximum number of rows to insert with a single statement.
+    int _maxBatchBytes;
+        ///< Flush the pending rows when their values exceed this many bytes.
 };
 
 template <>
@@ -44,6 +44,12 @@
   * performance.  Provides methods for writing rows to a table and retrieving
   * rows from a query.
   *
+  * Rows are formatted into a large buffer that's written to the TSV file a
+  * block at a time.  If the LoadChunkRows policy value is positive, the file
+  * is loaded into the database every LoadChunkRows rows by a separate thread,
+  * while the following rows are written to a new file.  All the files loaded
+  * in a transaction are committed together by endTransaction().
+  *
   * @ingroup daf_persistence
   */
 
@@ -51,7 +57,7 @@
 #include "lsst/daf/persistence/DbStorage.h"
 
 #include <boost/scoped_ptr.hpp>
-#include <fstream>
+#include <boost/thread.hpp>
 #include <map>
 #include <sstream>
 #include <string>
@@ -59,6 +65,8 @@
 
 #include "lsst/daf/persistence/LogicalLocation.h"
 
+struct st_mysql;                // MYSQL, from <mysql/mysql.h>
+
 namespace lsst {
 namespace daf {
 namespace persistence {
@@ -100,15 +108,29 @@ private:
     bool _persisting;
     bool _saveTemp;         ///< Do not delete temporary TSV file if true.
     std::string _tempPath;  ///< Directory pathname for temporary TSV file.
-    char* _fileName;        ///< Full pathname for temporary TSV file.
+    std::string _fileName;  ///< Full pathname for temporary TSV file.
+    int _fd;                ///< Descriptor of the TSV file, or -1.
     std::string _location;  ///< Database location URL.
     std::string _tableName;
     std::map<std::string, int> _colMap; ///< Map from column names to positions.
-    std::ostringstream _convertStream;  ///< Stream to convert to text.
-    std::vector<std::string> _rowBuffer;
-    boost::scoped_ptr<std::ofstream> _osp;  ///< Output TSV stream.
+    std::vector<std::string> _rowBuffer; ///< Text of each column in the row.
+    std::string _outBuffer; ///< Rows waiting to be written to the TSV file.
+    size_t _bufferSize;     ///< Write _outBuffer when it's this large.
+    int _rowsInFile;        ///< Number of rows written to the current file.
+    int _loadChunkRows;     ///< Load the file every this many rows, or 0.
+    boost::scoped_ptr<boost::thread> _loader; ///< Thread loading a file.
+    std::string _loadError; ///< Error message from _loader.
+    st_mysql* _loadDb;      ///< Connection used for loading, or 0.
 
     int _getColumnIndex(std::string const& columnName);
+    void _setColumnText(std::string const& columnName,
+                        char const* text, size_t length);
+    void _openFile(void);
+    void _writeBuffer(void);
+    void _connect(void);
+    void _disconnect(void);
+    void _loadFile(bool inBackground);
+    void _waitForLoad(void);
 };
 
 }}} // namespace lsst::daf::persistence
@@ -162,11 +162,32 @@ void DbStorage::setColumnToNull(std::string const& columnName) {
 
 /** Insert the row.
  * Row values must have been set with setColumn() calls.
+ *
+ * Rows are inserted in batches, so errors may not be reported until a later
+ * call; see setInsertBatchSize().
  */
 void DbStorage::insertRow(void) {
     _impl->insertRow();
 }
 
+/** Set the maximum size of the batches of rows inserted by a single
+ * statement.  The batch is inserted when it has maxRows rows or its data
+ * exceed maxBytes bytes, when the insert table or columns change, or when any
+ * other database operation (including ending the transaction) is requested.
+ * May also be set via the InsertBatchRows and InsertBatchBytes policy values.
+ * \param[in] maxRows Maximum number of rows in a batch; 1 disables batching
+ * \param[in] maxBytes Maximum number of bytes of data in a batch
+ */
+void DbStorage::setInsertBatchSize(int maxRows, int maxBytes) {
+    _impl->setInsertBatchSize(maxRows, maxBytes);
+}
+
+/** Insert any rows that are waiting to be inserted.
+ */
+void DbStorage::flushInserts(void) {
+    _impl->flushInserts();
+}
+
 
 /** Set the table to query (single-table queries only).
  * \param[in] tableName Name of the table
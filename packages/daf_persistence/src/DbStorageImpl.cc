@@ -44,8 +44,8 @@ static char const* SVNid __attribute__((unused)) = "$Id$";
 
 #include "lsst/daf/persistence/DbStorageImpl.h"
 #include "boost/regex.hpp"
+#include <algorithm>
 #include <ctime>
-#include <iostream>
 #include <stdlib.h>
 #include <unistd.h>
 #include <vector>
@@ -158,14 +158,24 @@ dafPer::BoundVar::BoundVar(BoundVar const& src) :
 /** Default constructor.
  */
 dafPer::DbStorageImpl::DbStorageImpl(void) :
-    lsst::daf::base::Citizen(typeid(*this)), _db(0) {
+    lsst::daf::base::Citizen(typeid(*this)), _db(0),
+    _insertColumnsChanged(true), _numPendingRows(0),
+    _maxBatchRows(1000), _maxBatchBytes(512 * 1024) {
 }
 
 /** Destructor.
- * End session if present.
+ * Insert any pending rows and end session if present.
  */
 dafPer::DbStorageImpl::~DbStorageImpl(void) {
     if (_db) {
+        try {
+            flushInserts();
+        } catch (pexExcept::Exception& e) {
+            // We can't throw from a destructor
+            lsst::pex::logging::TTrace<1>("daf.persistence.DbStorage",
+                "Unable to insert pending rows: %s", e.what());
+        }
+        closeInsertStatements();
         mysql_close(_db);
         _db = 0;
     }
@@ -173,8 +183,23 @@ dafPer::DbStorageImpl::~DbStorageImpl(void) {
 
 /** Allow a Policy to be used to configure the DbStorage.
  * @param[in] policy
+ *
+ * Rows are inserted in batches of up to InsertBatchRows (default 1000) rows
+ * or (about) InsertBatchBytes (default 512 kB) of data, whichever is
+ * smaller; an InsertBatchRows of 1 inserts each row as soon as insertRow()
+ * is called.  InsertBatchBytes should be well below the server's
+ * max_allowed_packet.
  */
 void dafPer::DbStorageImpl::setPolicy(pexPolicy::Policy::Ptr policy) {
+    int maxRows = _maxBatchRows;
+    int maxBytes = _maxBatchBytes;
+    if (policy && policy->exists("InsertBatchRows")) {
+        maxRows = policy->getInt("InsertBatchRows");
+    }
+    if (policy && policy->exists("InsertBatchBytes")) {
+        maxBytes = policy->getInt("InsertBatchBytes");
+    }
+    setInsertBatchSize(maxRows, maxBytes);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -192,6 +217,8 @@ void dafPer::DbStorageImpl::startSession(std::string const& location) {
     DbStorageLocation dbloc(location);
 
     if (_db) {
+        flushInserts();
+        closeInsertStatements();
         mysql_close(_db);
     }
     _db = mysql_init(0);
@@ -228,6 +255,7 @@ void dafPer::DbStorageImpl::setRetrieveLocation(LogicalLocation const& location)
 void dafPer::DbStorageImpl::startTransaction(void) {
     if (_db == 0) error("Database session not initialized "
                         "in DbStorage::startTransaction()", false);
+    flushInserts();
     if (mysql_autocommit(_db, false)) error("Unable to turn off autocommit");
 }
 
@@ -236,6 +264,7 @@ void dafPer::DbStorageImpl::startTransaction(void) {
 void dafPer::DbStorageImpl::endTransaction(void) {
     if (_db == 0) error("Database session not initialized "
                         "in DbStorage::endTransaction()", false);
+    flushInserts();
     if (mysql_commit(_db)) error("Unable to commit transaction");
     if (mysql_autocommit(_db, true)) error("Unable to turn on autocommit");
 }
@@ -250,6 +279,7 @@ void dafPer::DbStorageImpl::executeQuery(std::string const& query) {
     if (_db == 0) {
         error("No DB connection for query: " + query, false);
     }
+    flushInserts();                     // keep the statements in order
     lsst::pex::logging::TTrace<5>("daf.persistence.DbStorage",
                                   "Query: " + query);
     if (mysql_query(_db, query.c_str()) != 0) {
@@ -266,8 +296,10 @@ std::string dafPer::DbStorageImpl::quote(std::string const& name) {
         std::string(name, pos + 1) + '`';
 }
 
-void dafPer::DbStorageImpl::stError(std::string const& text) {
-    error(text + " - * " + mysql_stmt_error(_statement), false);
+void dafPer::DbStorageImpl::stError(std::string const& text,
+                                    MYSQL_STMT* statement) {
+    error(text + " - * " + mysql_stmt_error(statement ? statement : _statement),
+          false);
 }
 
 void dafPer::DbStorageImpl::error(std::string const& text, bool mysqlCause) {
@@ -285,6 +317,74 @@ void* dafPer::DbStorageImpl::allocateMemory(size_t size) {
     return mem.get();
 }
 
+/** Return a prepared statement inserting numRows rows of the current insert
+ * columns into the current insert table.
+ * @param[in] numRows Number of rows to insert
+ * @param[in] numColumns Number of columns in each row
+ * @param[out] isCached Set true if the statement is cached (and must not be
+ * closed by the caller)
+ *
+ * Statements for single rows and for full batches are cached until the
+ * session ends, as they're reused for every row or batch; the caller must
+ * close any other statement.
+ */
+MYSQL_STMT* dafPer::DbStorageImpl::prepareInsert(int numRows, int numColumns,
+                                                 bool& isCached) {
+    std::string row = "(?";
+    for (int i = 1; i < numColumns; ++i) {
+        row += ", ?";
+    }
+    row += ")";
+
+    std::string query = "INSERT INTO " + quote(_insertTable) + " (" +
+        _insertColumns + ") VALUES " + row;
+    query.reserve(query.size() + (numRows - 1) * (row.size() + 2));
+    for (int i = 1; i < numRows; ++i) {
+        query += ", " + row;
+    }
+
+    isCached = (numRows == 1 || numRows == maxInsertRows(numColumns));
+    if (isCached) {
+        StatementMap::const_iterator it = _insertStatements.find(query);
+        if (it != _insertStatements.end()) {
+            return it->second;
+        }
+    }
+
+    MYSQL_STMT* statement = mysql_stmt_init(_db);
+    if (statement == 0) {
+        error("Unable to initialize statement: " + query);
+    }
+    lsst::pex::logging::TTrace<5>("daf.persistence.DbStorage",
+                                  "Prepare: " + query);
+    if (mysql_stmt_prepare(statement, query.c_str(), query.length()) != 0) {
+        std::string const msg = mysql_stmt_error(statement);
+        mysql_stmt_close(statement);
+        error("Unable to prepare statement: " + query + " - * " + msg, false);
+    }
+    if (isCached) {
+        _insertStatements[query] = statement;
+    }
+    return statement;
+}
+
+/** Return the number of rows of numColumns columns in a full batch.
+ */
+int dafPer::DbStorageImpl::maxInsertRows(int numColumns) const {
+    // MySQL allows at most 65535 placeholders in a statement
+    return std::max(1, std::min(_maxBatchRows, 65535 / numColumns));
+}
+
+/** Close all the cached INSERT statements.
+ */
+void dafPer::DbStorageImpl::closeInsertStatements(void) {
+    for (StatementMap::iterator it = _insertStatements.begin();
+         it != _insertStatements.end(); ++it) {
+        mysql_stmt_close(it->second);
+    }
+    _insertStatements.clear();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // TABLE OPERATIONS
 ///////////////////////////////////////////////////////////////////////////////
@@ -336,8 +436,10 @@ void dafPer::DbStorageImpl::setTableForInsert(std::string const& tableName) {
     if (_readonly) {
         error("Attempt to insert into read-only database", false);
     }
+    flushInserts();
     _insertTable = tableName;
     _inputVars.clear();
+    _insertColumnsChanged = true;
 }
 
 /** Set the value to insert in a given column.
@@ -353,6 +455,7 @@ void dafPer::DbStorageImpl::setColumn(std::string const& columnName,
        bv = _inputVars.insert(
             BoundVarMap::value_type(columnName,
                                     BoundVar(allocateMemory(size)))).first;
+       _insertColumnsChanged = true;
     }
     else if (bv->second._length != size) {
         bv->second._data = allocateMemory(size);
@@ -373,6 +476,7 @@ void dafPer::DbStorageImpl::setColumn(std::string const& columnName,
        bv = _inputVars.insert(
             BoundVarMap::value_type(columnName,
                                     BoundVar(allocateMemory(size)))).first;
+       _insertColumnsChanged = true;
     }
     else if (bv->second._length != size) {
         bv->second._data = allocateMemory(size);
@@ -393,6 +497,7 @@ void dafPer::DbStorageImpl::setColumn(std::string const& columnName,
        bv = _inputVars.insert(
             BoundVarMap::value_type(columnName,
                                     BoundVar(allocateMemory(size)))).first;
+       _insertColumnsChanged = true;
     }
     else if (bv->second._length != size) {
         bv->second._data = allocateMemory(size);
@@ -423,6 +528,7 @@ void dafPer::DbStorageImpl::setColumnToNull(std::string const& columnName) {
        bv = _inputVars.insert(
             BoundVarMap::value_type(columnName,
                                     BoundVar(allocateMemory(1)))).first;
+       _insertColumnsChanged = true;
     }
     bv->second._isNull = true;
     bv->second._length = 1;
@@ -430,6 +536,11 @@ void dafPer::DbStorageImpl::setColumnToNull(std::string const& columnName) {
 
 /** Insert the row.
  * Row values must have been set with setColumn() calls.
+ *
+ * The values are copied, and the row is inserted (with any other pending
+ * rows) when a batch is full, the table or the set of columns changes, or
+ * any other database operation is requested; call flushInserts() to insert
+ * it immediately.  Errors in pending rows are thus reported later.
  */
 void dafPer::DbStorageImpl::insertRow(void) {
     if (_readonly) {
@@ -438,62 +549,108 @@ void dafPer::DbStorageImpl::insertRow(void) {
     if (_insertTable.empty()) error("Insert table not initialized in DbStorage::insertRow()", false);
     if (_inputVars.empty()) error("No values to insert", false);
 
-    std::string query = "INSERT INTO " + quote(_insertTable) + " (";
-
-    boost::scoped_array<MYSQL_BIND> binder(new MYSQL_BIND[_inputVars.size()]);
-    memset(binder.get(), 0, _inputVars.size() * sizeof(MYSQL_BIND));
+    if (_insertColumnsChanged) {        // we need a different statement
+        flushInserts();
+        _insertColumns.clear();
+        for (BoundVarMap::const_iterator it = _inputVars.begin();
+             it != _inputVars.end(); ++it) {
+            if (it != _inputVars.begin()) {
+                _insertColumns += ", ";
+            }
+            _insertColumns += quote(it->first);
+        }
+        _insertColumnsChanged = false;
+    }
 
-    int i = 0;
-    for (BoundVarMap::iterator it = _inputVars.begin();
+    // Copy the values, aligning each one for any type we might bind
+    for (BoundVarMap::const_iterator it = _inputVars.begin();
          it != _inputVars.end(); ++it) {
-        if (it != _inputVars.begin()) {
-            query += ", ";
+        BoundVar const& bv(it->second);
+        PendingValue value;
+        value._offset = (_pendingData.size() + 7) & ~static_cast<size_t>(7);
+        value._length = bv._isNull ? 0 : bv._length;
+        value._type = bv._type;
+        value._isNull = bv._isNull;
+        value._isUnsigned = bv._isUnsigned;
+        _pendingData.resize(value._offset + value._length);
+        if (value._length > 0) {
+            memcpy(&_pendingData[value._offset], bv._data, value._length);
         }
-        query += quote(it->first);
+        _pendingValues.push_back(value);
+    }
+    ++_numPendingRows;
 
-        // Bind variables
+    if (_numPendingRows >= maxInsertRows(_inputVars.size()) ||
+        _pendingData.size() >= static_cast<size_t>(_maxBatchBytes)) {
+        flushInserts();
+    }
+}
+
+/** Set the maximum size of the batches of rows inserted by a single
+ * statement.
+ * @param[in] maxRows Maximum number of rows; 1 disables batching
+ * @param[in] maxBytes Insert the batch when its values exceed this many bytes
+ */
+void dafPer::DbStorageImpl::setInsertBatchSize(int maxRows, int maxBytes) {
+    if (maxRows < 1 || maxBytes < 1) {
+        error("Insert batches must contain at least one row and byte", false);
+    }
+    flushInserts();
+    _maxBatchRows = maxRows;
+    _maxBatchBytes = maxBytes;
+}
+
+/** Insert any rows that are waiting to be inserted.
+ */
+void dafPer::DbStorageImpl::flushInserts(void) {
+    if (_numPendingRows == 0) {
+        return;
+    }
+    // Forget the pending rows even if we fail, so they aren't inserted twice
+    std::vector<char> data;
+    std::vector<PendingValue> values;
+    data.swap(_pendingData);
+    values.swap(_pendingValues);
+    int const numRows = _numPendingRows;
+    _numPendingRows = 0;
+
+    std::vector<MYSQL_BIND> binder(values.size());
+    memset(&binder[0], 0, values.size() * sizeof(MYSQL_BIND));
+    for (size_t i = 0; i < values.size(); ++i) {
         MYSQL_BIND& bind(binder[i]);
-        BoundVar& bv(it->second);
-        if (bv._isNull) {
+        PendingValue& value(values[i]);
+        if (value._isNull) {
             bind.buffer_type = MYSQL_TYPE_NULL;
         }
         else {
-            bind.buffer_type = bv._type;
-            bind.buffer = bv._data;
-            bind.buffer_length = bv._length;
-            bind.length = &(bv._length);
+            bind.buffer_type = value._type;
+            bind.buffer = value._length > 0 ? &data[value._offset] : 0;
+            bind.buffer_length = value._length;
+            bind.length = &value._length;
             bind.is_null = 0;
-            bind.is_unsigned = bv._isUnsigned;
+            bind.is_unsigned = value._isUnsigned;
             bind.error = 0;
         }
-        ++i;
-    }
-    query += ") VALUES (";
-    for (size_t i = 0; i < _inputVars.size(); ++i) {
-        if (i != 0) {
-            query += ", ";
-        }
-        query += "?";
     }
-    query += ")";
 
-    // Execute statement
-    // Guard statement with mysql_stmt_close()
-    _statement = mysql_stmt_init(_db);
-    if (_statement == 0) {
-        error("Unable to initialize statement: " + query);
+    bool isCached = false;
+    MYSQL_STMT* statement =
+        prepareInsert(numRows, values.size() / numRows, isCached);
+    bool const failed = mysql_stmt_bind_param(statement, &binder[0]) ||
+        mysql_stmt_execute(statement) != 0;
+    std::string const msg = failed ? mysql_stmt_error(statement) : "";
+    if (!isCached) {
+        mysql_stmt_close(statement);
     }
-    if (mysql_stmt_prepare(_statement, query.c_str(), query.length()) != 0) {
-        stError("Unable to prepare statement: " + query);
+    if (failed) {
+        error("Unable to insert rows into " + _insertTable + " - * " + msg,
+              false);
     }
-    if (mysql_stmt_bind_param(_statement, binder.get())) {
-        stError("Unable to bind variables in: " + query);
-    }
-    if (mysql_stmt_execute(_statement) != 0) {
-        stError("Unable to execute statement: " + query);
-    }
-    mysql_stmt_close(_statement);
-    _statement = 0;
+    // Reuse the buffers for the next batch
+    data.clear();
+    values.clear();
+    _pendingData.swap(data);
+    _pendingValues.swap(values);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -507,9 +664,11 @@ void dafPer::DbStorageImpl::insertRow(void) {
 void dafPer::DbStorageImpl::setTableForQuery(std::string const& tableName,
                                              bool isExpr) {
     if (_db == 0) error("Database session not initialized in DbStorage::setTableForQuery()", false);
+    flushInserts();                     // the query may need them
     _queryTables.clear();
     _queryTables.push_back(isExpr ? tableName : quote(tableName));
     _inputVars.clear();
+    _insertColumnsChanged = true;
     _outputVars.clear();
     _outColumns.clear();
     _whereClause.clear();
@@ -524,11 +683,13 @@ void dafPer::DbStorageImpl::setTableForQuery(std::string const& tableName,
 void dafPer::DbStorageImpl::setTableListForQuery(
     std::vector<std::string> const& tableNameList) {
     if (_db == 0) error("Database session not initialized in DbStorage::setTableListForQuery()", false);
+    flushInserts();                     // the query may need them
     for (std::vector<std::string>::const_iterator it = tableNameList.begin();
          it != tableNameList.end(); ++it) {
         _queryTables.push_back(quote(*it));
     }
     _inputVars.clear();
+    _insertColumnsChanged = true;
     _outputVars.clear();
     _outColumns.clear();
     _whereClause.clear();
@@ -44,14 +44,17 @@ static char const* SVNid __attribute__((unused)) = "$Id$";
 
 #include "lsst/daf/persistence/DbTsvStorage.h"
 
-#include <iomanip>
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <boost/bind.hpp>
 #include <mysql/mysql.h>
 
 #include "lsst/pex/exceptions.h"
+#include "lsst/pex/logging/Trace.h"
 #include "lsst/daf/base/DateTime.h"
 #include "lsst/daf/persistence/DbStorageLocation.h"
 #include "lsst/daf/persistence/LogicalLocation.h"
@@ -62,18 +65,112 @@ namespace lsst {
 namespace daf {
 namespace persistence {
 
+namespace {
+
+/** Load a TSV file into a table.
+ * Removes the file afterwards unless saveTemp is true.
+ * \param[in] db Connection to the database
+ * \param[in] tableName Name of the table being loaded
+ * \param[in] query LOAD DATA statement to execute
+ * \param[in] fileName Pathname of the TSV file
+ * \param[in] saveTemp Do not remove the file if true
+ * \return Empty string on success, else a description of the error
+ *
+ * Does not throw, so that it can be run in a separate thread.
+ */
+std::string loadTsvFile(MYSQL* db,
+                        std::string const& tableName,
+                        std::string const& query,
+                        std::string const& fileName,
+                        bool saveTemp) {
+    std::string error;
+    if (mysql_query(db, query.c_str()) != 0) {
+        error = "Unable to load data into database table: " + tableName +
+            "- * " + mysql_error(db);
+    }
+
+    if (!saveTemp) {
+        unlink(fileName.c_str());
+    }
+    return error;
+}
+
+/** Thread entry point for loadTsvFile().
+ * \param[out] error Set to the result of loadTsvFile()
+ *
+ * The connection is only used by one thread at a time.
+ */
+void loadTsvFileInThread(MYSQL* db, std::string tableName,
+                         std::string query, std::string fileName,
+                         bool saveTemp, std::string* error) {
+    mysql_thread_init();
+    *error = loadTsvFile(db, tableName, query, fileName, saveTemp);
+    mysql_thread_end();
+}
+
+/** Format an integer as decimal text ending just before the given position.
+ * \param[in] value Value to format
+ * \param[in] end One past the last character of the output buffer, which
+ * must have room for at least 21 characters
+ * \return Pointer to the first character of the text
+ */
+char* formatInteger(long long value, char* end) {
+    unsigned long long v = value < 0 ?
+        0ULL - static_cast<unsigned long long>(value) :
+        static_cast<unsigned long long>(value);
+    char* p = end;
+    do {
+        *--p = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    if (value < 0) *--p = '-';
+    return p;
+}
+
+} // anonymous namespace
+
 /** Constructor.
 */
-DbTsvStorage::DbTsvStorage(void) : _saveTemp(false) {
+DbTsvStorage::DbTsvStorage(void) :
+    _persisting(false), _saveTemp(false), _fd(-1), _bufferSize(1024 * 1024),
+    _rowsInFile(0), _loadChunkRows(0), _loadDb(0) {
 }
 
-/** Minimal destructor.
+/** Destructor.  Waits for any load in progress, rolls back any rows loaded
+ * since the last endTransaction(), and removes any TSV file that was never
+ * loaded.
  */
 DbTsvStorage::~DbTsvStorage(void) {
+    if (_loader) {
+        _loader->join();
+        if (!_loadError.empty()) {
+            // We can't throw from a destructor
+            lsst::pex::logging::TTrace<1>("daf.persistence.DbTsvStorage",
+                "%s", _loadError.c_str());
+        }
+    }
+    _disconnect();
+    if (_fd >= 0) {
+        close(_fd);
+        if (!_saveTemp) {
+            unlink(_fileName.c_str());
+        }
+    }
 }
 
 /** Allow a policy to be used to configure the DbTsvStorage.
  * \param[in] policy
+ *
+ * Recognized keys are TempPath (directory for the TSV files, default /tmp),
+ * SaveTemp (keep the TSV files), BufferSize (bytes of rows to accumulate
+ * before writing to the file, default 1 MiB) and LoadChunkRows (if positive,
+ * load the file in the background after this many rows, default 0).
+ *
+ * All the files loaded before endTransaction() share one connection with
+ * autocommit off, and are committed by endTransaction(); if any load fails,
+ * or the DbTsvStorage is destroyed first, none of them is committed.  N.b.
+ * this relies on the table supporting transactions (e.g. InnoDB); rows
+ * loaded into a MyISAM table cannot be rolled back.
  */
 void DbTsvStorage::setPolicy(lsst::pex::policy::Policy::Ptr policy) {
     _tempPath = "/tmp";
@@ -83,6 +180,14 @@ void DbTsvStorage::setPolicy(lsst::pex::policy::Policy::Ptr policy) {
     if (policy && policy->exists("SaveTemp") && policy->getBool("SaveTemp")) {
         _saveTemp = true;
     }
+    if (policy && policy->exists("BufferSize")) {
+        int bufferSize = policy->getInt("BufferSize");
+        _bufferSize = bufferSize > 0 ? bufferSize : 0;
+    }
+    if (policy && policy->exists("LoadChunkRows")) {
+        int loadChunkRows = policy->getInt("LoadChunkRows");
+        _loadChunkRows = loadChunkRows > 0 ? loadChunkRows : 0;
+    }
 }
 
 /** Set the database location to persist to.
@@ -110,69 +215,28 @@ void DbTsvStorage::startTransaction(void) {
 }
 
 /** End a transaction.
+ * Loads any rows not yet loaded, waits for any load in progress, and commits
+ * all the rows loaded since the last endTransaction().  If any load failed,
+ * none of the rows is committed.
  */
 void DbTsvStorage::endTransaction(void) {
     if (!_persisting) {
         DbStorage::endTransaction();
         return;
     }
-
-    // close stream
-    _osp->close();
-
-    MYSQL* db = mysql_init(0);
-    if (db == 0) {
-        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, "Unable to allocate MySQL connection");
+    try {
+        _loadFile(false);
+        if (mysql_commit(_loadDb) != 0) {
+            throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
+                std::string("Unable to commit transaction - * ") +
+                mysql_error(_loadDb));
+        }
     }
-    DbStorageLocation dbLoc(_location);
-    unsigned int port = strtoul(dbLoc.getPort().c_str(), 0, 10);
-    if (mysql_real_connect(db,
-                           dbLoc.getHostname().c_str(),
-                           dbLoc.getUsername().c_str(),
-                           dbLoc.getPassword().c_str(),
-                           dbLoc.getDbName().c_str(),
-                           port, 0,
-                           CLIENT_COMPRESS | CLIENT_LOCAL_FILES) == 0) {
-        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
-            "Unable to connect to MySQL database: " + _location);
+    catch (...) {
+        _disconnect();          // rolls back any rows already loaded
+        throw;
     }
-    if (mysql_options(db, MYSQL_OPT_LOCAL_INFILE, 0) != 0) {
-        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
-            std::string("Unable to set LOCAL INFILE option - * ") +
-            mysql_error(db));
-    }
-
-    std::string query = "LOAD DATA LOCAL INFILE";
-    query += " '";
-    query += _fileName;
-    query += "'";
-    query += " REPLACE";
-    query += " INTO TABLE `" + _tableName;
-    query += "` (";
-    for (std::map<std::string, int>::const_iterator it = _colMap.begin();
-         it != _colMap.end(); ++it) {
-        _rowBuffer[it->second] = it->first;
-    }
-    for (std::vector<std::string>::const_iterator it = _rowBuffer.begin();
-         it != _rowBuffer.end(); ++it) {
-        if (it != _rowBuffer.begin()) query += " ,";
-        query += *it;
-    }
-    query += ")";
-
-    if (mysql_query(db, query.c_str()) != 0) {
-        mysql_close(db);
-        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
-            "Unable to load data into database table: " + _tableName +
-            "- * " + mysql_error(db));
-    }
-    mysql_close(db);
-
-    // unlink file
-    if (!_saveTemp) {
-        unlink(_fileName);
-    }
-    delete[] _fileName;
+    _disconnect();
 }
 
 /** Create a new table from an existing template table.
@@ -233,14 +297,169 @@ void DbTsvStorage::truncateTable(std::string const& tableName) {
  */
 void DbTsvStorage::setTableForInsert(std::string const& tableName) {
     _tableName = tableName;
-    std::string templ = _tempPath + "/" + tableName + ".XXXXXX";
-    _fileName = new char[templ.size() + 1];
-    strncpy(_fileName, templ.c_str(), templ.size());
-    _fileName[templ.size()] = '\0';
-    int fd = mkstemp(_fileName);
-    // \todo check for errors
-    close(fd);
-    _osp.reset(new std::ofstream(_fileName));
+    _openFile();
+}
+
+/** Create a new temporary TSV file for the current table.
+ */
+void DbTsvStorage::_openFile(void) {
+    std::vector<char> templ(_tempPath.begin(), _tempPath.end());
+    templ.push_back('/');
+    templ.insert(templ.end(), _tableName.begin(), _tableName.end());
+    char const suffix[] = ".XXXXXX";
+    templ.insert(templ.end(), suffix, suffix + sizeof(suffix));
+    _fd = mkstemp(&templ[0]);
+    if (_fd < 0) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
+            "Unable to create temporary TSV file in " + _tempPath + " - * " +
+            strerror(errno));
+    }
+    _fileName = &templ[0];
+    _outBuffer.clear();
+    _rowsInFile = 0;
+}
+
+/** Write the accumulated rows to the TSV file.
+ */
+void DbTsvStorage::_writeBuffer(void) {
+    char const* p = _outBuffer.data();
+    size_t remaining = _outBuffer.size();
+    while (remaining > 0) {
+        ssize_t n = write(_fd, p, remaining);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
+                "Unable to write to TSV file " + _fileName + " - * " +
+                strerror(errno));
+        }
+        p += n;
+        remaining -= n;
+    }
+    _outBuffer.clear();
+}
+
+/** Load the current TSV file into the table.
+ * \param[in] inBackground If true, load the file in a separate thread and
+ * start a new file for subsequent rows; otherwise wait for the load
+ */
+void DbTsvStorage::_loadFile(bool inBackground) {
+    // Only one load at a time, so that rows are loaded in order.
+    _waitForLoad();
+
+    if (_fd < 0) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
+            "No table set for insert");
+    }
+    _writeBuffer();
+    _connect();
+    if (close(_fd) != 0) {
+        _fd = -1;
+        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
+            "Unable to close TSV file " + _fileName + " - * " +
+            strerror(errno));
+    }
+    _fd = -1;
+
+    std::vector<std::string> columns(_colMap.size());
+    for (std::map<std::string, int>::const_iterator it = _colMap.begin();
+         it != _colMap.end(); ++it) {
+        columns[it->second] = it->first;
+    }
+    std::string query = "LOAD DATA LOCAL INFILE";
+    query += " '";
+    query += _fileName;
+    query += "'";
+    query += " REPLACE";
+    query += " INTO TABLE `" + _tableName;
+    query += "` (";
+    for (std::vector<std::string>::const_iterator it = columns.begin();
+         it != columns.end(); ++it) {
+        if (it != columns.begin()) query += " ,";
+        query += *it;
+    }
+    query += ")";
+
+    if (inBackground) {
+        _loader.reset(new boost::thread(boost::bind(&loadTsvFileInThread,
+            _loadDb, _tableName, query, _fileName, _saveTemp,
+            &_loadError)));
+        _openFile();
+    }
+    else {
+        std::string error =
+            loadTsvFile(_loadDb, _tableName, query, _fileName, _saveTemp);
+        if (!error.empty()) {
+            throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
+                              error);
+        }
+    }
+}
+
+/** Connect to the database for loading, unless already connected.
+ * Autocommit is turned off, so that all the files loaded in a transaction
+ * are committed together by endTransaction().
+ */
+void DbTsvStorage::_connect(void) {
+    if (_loadDb != 0) return;
+
+    // The client library must be initialized before any thread uses it.
+    if (mysql_library_init(0, 0, 0) != 0) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
+            "Unable to initialize MySQL library");
+    }
+    MYSQL* db = mysql_init(0);
+    if (db == 0) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException,
+            "Unable to allocate MySQL connection");
+    }
+    std::string error;
+    DbStorageLocation dbLoc(_location);
+    unsigned int port = strtoul(dbLoc.getPort().c_str(), 0, 10);
+    if (mysql_real_connect(db,
+                           dbLoc.getHostname().c_str(),
+                           dbLoc.getUsername().c_str(),
+                           dbLoc.getPassword().c_str(),
+                           dbLoc.getDbName().c_str(),
+                           port, 0,
+                           CLIENT_COMPRESS | CLIENT_LOCAL_FILES) == 0) {
+        error = "Unable to connect to MySQL database: " + _location;
+    }
+    else if (mysql_options(db, MYSQL_OPT_LOCAL_INFILE, 0) != 0) {
+        error = std::string("Unable to set LOCAL INFILE option - * ") +
+            mysql_error(db);
+    }
+    else if (mysql_autocommit(db, 0) != 0) {
+        error = std::string("Unable to turn off autocommit - * ") +
+            mysql_error(db);
+    }
+    if (!error.empty()) {
+        mysql_close(db);
+        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, error);
+    }
+    _loadDb = db;
+}
+
+/** Close the connection used for loading, if any.  Rows loaded since the
+ * last commit are rolled back.  Must not be called while a load is running.
+ */
+void DbTsvStorage::_disconnect(void) {
+    if (_loadDb == 0) return;
+    mysql_close(_loadDb);
+    _loadDb = 0;
+}
+
+/** Wait for any load running in the background to finish.
+ * Throws if that load failed.
+ */
+void DbTsvStorage::_waitForLoad(void) {
+    if (!_loader) return;
+    _loader->join();
+    _loader.reset();
+    if (!_loadError.empty()) {
+        std::string error;
+        error.swap(_loadError);
+        throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, error);
+    }
 }
 
 /** Get the index of a given column.  Create a new entry in the row buffer if
@@ -262,84 +481,107 @@ int DbTsvStorage::_getColumnIndex(std::string const& columnName) {
     }
 }
 
+/** Set the text to insert in a given column.
+ * \param[in] columnName Name of the column
+ * \param[in] text Text of the value, already escaped for LOAD DATA
+ * \param[in] length Number of characters in text
+ */
+void DbTsvStorage::_setColumnText(std::string const& columnName,
+                                  char const* text, size_t length) {
+    int colIndex = _getColumnIndex(columnName);
+    // Reuse the existing string's storage.
+    _rowBuffer[colIndex].assign(text, length);
+}
+
 /** Set the value to insert in a given column.
  * \param[in] columnName Name of the column
  * \param[in] value Value to set in the column
+ *
+ * The generic version handles integral types (including char, which is
+ * persisted as TINYINT instead of [VAR]CHAR(1), and bool).
  */
 template <typename T>
 void DbTsvStorage::setColumn(std::string const& columnName, T const& value) {
-    int colIndex = _getColumnIndex(columnName);
-
-    // set value in row buffer
-    // \todo quote value as appropriate
-    _convertStream.str(std::string());
-    _convertStream << value;
-    _rowBuffer[colIndex] = _convertStream.str();
-
-    // \todo Optimization: if next column, output now, plus any others saved
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* begin = formatInteger(static_cast<long long>(value), end);
+    _setColumnText(columnName, begin, end - begin);
 }
 
-// Specialization for char to persist as TINYINT instead of [VAR]CHAR(1).
+// Specializations for float and double to set precision correctly.
 template<>
 void DbTsvStorage::setColumn(std::string const& columnName,
-                             char const& value) {
-    int colIndex = _getColumnIndex(columnName);
-    _convertStream.str(std::string());
-    _convertStream << static_cast<int>(value);
-    _rowBuffer[colIndex] = _convertStream.str();
+                             double const& value) {
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.17g", value);
+    _setColumnText(columnName, buf, n);
 }
 
-// Specializations for float and double to set precision correctly.
 template<>
 void DbTsvStorage::setColumn(std::string const& columnName,
-                             double const& value) {
-    int colIndex = _getColumnIndex(columnName);
-    _convertStream.str(std::string());
-    _convertStream << std::setprecision(17) << value;
-    _rowBuffer[colIndex] = _convertStream.str();
+                             float const& value) {
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(value));
+    _setColumnText(columnName, buf, n);
 }
 
+// Specialization for strings to escape characters special to LOAD DATA.
 template<>
 void DbTsvStorage::setColumn(std::string const& columnName,
-                             float const& value) {
+                             std::string const& value) {
+    static std::string const special("\\\t\n\0", 4);
     int colIndex = _getColumnIndex(columnName);
-    _convertStream.str(std::string());
-    _convertStream << std::setprecision(9) << value;
-    _rowBuffer[colIndex] = _convertStream.str();
+    std::string& field = _rowBuffer[colIndex];
+    if (value.find_first_of(special) == std::string::npos) {
+        field.assign(value);
+        return;
+    }
+    field.clear();
+    for (std::string::const_iterator i = value.begin(); i != value.end(); ++i) {
+        switch (*i) {
+        case '\\': field += "\\\\"; break;
+        case '\t': field += "\\t"; break;
+        case '\n': field += "\\n"; break;
+        case '\0': field += "\\0"; break;
+        default: field += *i; break;
+        }
+    }
 }
 
 // Specialization for DateTime.
 template<>
 void DbTsvStorage::setColumn(std::string const& columnName,
                              DateTime const& value) {
-    int colIndex = _getColumnIndex(columnName);
-    _convertStream.str(std::string());
     struct tm t = value.gmtime();
     char buf[20];
-    strftime(buf, sizeof(buf), "%F %T", &t);
-    _rowBuffer[colIndex] = std::string(buf);
+    size_t n = strftime(buf, sizeof(buf), "%F %T", &t);
+    _setColumnText(columnName, buf, n);
 }
 
 /** Set a given column to NULL.
  * \param[in] columnName Name of the column
  */
 void DbTsvStorage::setColumnToNull(std::string const& columnName) {
-    int colIndex = _getColumnIndex(columnName);
-    _rowBuffer[colIndex] = "\\N";
+    _setColumnText(columnName, "\\N", 2);
 }
 
 /** Insert the row.
  * Row values must have been set with setColumn() calls.
  */
 void DbTsvStorage::insertRow(void) {
-    // Output row to stream
+    // Append row to buffer; it is written when full or at endTransaction().
     for (std::vector<std::string>::const_iterator i = _rowBuffer.begin();
          i != _rowBuffer.end(); ++i) {
-        if (i != _rowBuffer.begin()) *_osp << '\t';
-        *_osp << *i;
+        if (i != _rowBuffer.begin()) _outBuffer += '\t';
+        _outBuffer += *i;
+    }
+    _outBuffer += '\n';
+    if (_outBuffer.size() >= _bufferSize) {
+        _writeBuffer();
+    }
+    if (_loadChunkRows > 0 && ++_rowsInFile >= _loadChunkRows) {
+        _loadFile(true);
     }
-    // \todo Optimization: if columns all outputted, just put out endl
-    *_osp << std::endl;
 }
 
 
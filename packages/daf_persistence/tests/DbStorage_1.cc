@@ -132,6 +132,71 @@ BOOST_AUTO_TEST_CASE(DbStorage) {
     dbs.endTransaction();
 }
 
+BOOST_AUTO_TEST_CASE(DbStorageBatch) {
+    lsst::pex::policy::Policy::Ptr policy(new lsst::pex::policy::Policy);
+    policy->set("InsertBatchRows", 4);
+
+    struct timeval tv;
+    gettimeofday(&tv, 0); 
+    long long testId = tv.tv_sec * 1000000LL + tv.tv_usec;
+    std::ostringstream os;
+    os << "DbStorage_Test_B_" << testId;
+    std::string tempTableName = os.str();
+
+    dafPersist::DbStorage dbs;
+
+    dbs.setPolicy(policy);
+    dafPersist::LogicalLocation loc("mysql://lsst10.ncsa.uiuc.edu:3306/test");
+    dbs.setPersistLocation(loc);
+
+    dbs.startTransaction();
+    dbs.createTableFromTemplate(tempTableName, "DbStorage_Test_1");
+    dbs.endTransaction();
+
+    // Insert 10 rows (two full batches and a partial one), changing the
+    // columns part way through
+    int const numRows = 10;
+    dbs.startTransaction();
+    dbs.setTableForInsert(tempTableName);
+    for (int i = 0; i < numRows; ++i) {
+        dbs.setColumn<long long>("id", i);
+        dbs.setColumn<double>("ra", 0.5 * i);
+        if (i < 6) {
+            dbs.setColumn<double>("decl", -0.5 * i);
+        } else {
+            dbs.setColumnToNull("decl");
+            dbs.setColumn<int>("something", i);
+        }
+        dbs.insertRow();
+    }
+    dbs.endTransaction();
+
+    dbs.setRetrieveLocation(loc);
+    dbs.startTransaction();
+    dbs.setTableForQuery(tempTableName);
+    long long id;
+    double ra;
+    dbs.outParam("id", &id);
+    dbs.outParam("ra", &ra);
+    dbs.orderBy("id");
+    dbs.query();
+
+    for (int i = 0; i < numRows; ++i) {
+        BOOST_CHECK_MESSAGE(dbs.next() == true, "Failed to get row");
+        BOOST_CHECK_MESSAGE(id == i, "Id is incorrect");
+        BOOST_CHECK_MESSAGE(ra == 0.5 * i, "RA is incorrect");
+    }
+    BOOST_CHECK_MESSAGE(dbs.next() == false, "Got too many rows");
+
+    dbs.finishQuery();
+    dbs.endTransaction();
+
+    dbs.setPersistLocation(loc);
+    dbs.startTransaction();
+    dbs.dropTable(tempTableName);
+    dbs.endTransaction();
+}
+
 BOOST_AUTO_TEST_CASE(DbStorageExprs) {
     lsst::pex::policy::Policy::Ptr policy(new lsst::pex::policy::Policy);
 
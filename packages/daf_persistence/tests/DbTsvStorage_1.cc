@@ -0,0 +1,197 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * \file DbTsvStorage_1.cc
+ *
+ * This test tests the TSV files written by the DbTsvStorage class.  It
+ * doesn't need a database: the storage is pointed at a port that refuses
+ * connections, and told to keep its TSV files, so loading them fails but
+ * they can be checked afterwards.
+ */
+#include <dirent.h>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "lsst/daf/persistence/DbAuth.h"
+#include "lsst/daf/persistence/DbTsvStorage.h"
+#include "lsst/daf/persistence/LogicalLocation.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/pex/policy/Policy.h"
+
+#define BOOST_TEST_MODULE DbTsvStorage_1
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+namespace dafPersist = lsst::daf::persistence;
+namespace pexPolicy = lsst::pex::policy;
+
+namespace {
+
+/** A temporary directory for the TSV files, removed (with its contents) when
+ * the test is done.
+ */
+class TempDir {
+public:
+    TempDir(void) {
+        char templ[] = "/tmp/DbTsvStorage_1.XXXXXX";
+        BOOST_REQUIRE(mkdtemp(templ) != 0);
+        _path = templ;
+    }
+    ~TempDir(void) {
+        std::vector<std::string> files = getFiles();
+        for (std::vector<std::string>::const_iterator i = files.begin();
+             i != files.end(); ++i) {
+            unlink(i->c_str());
+        }
+        rmdir(_path.c_str());
+    }
+    std::string const& getPath(void) const { return _path; }
+    /// Return the pathnames of the files in the directory.
+    std::vector<std::string> getFiles(void) const {
+        std::vector<std::string> files;
+        DIR* dir = opendir(_path.c_str());
+        if (dir == 0) return files;
+        for (struct dirent* entry = readdir(dir); entry != 0;
+             entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                files.push_back(_path + "/" + name);
+            }
+        }
+        closedir(dir);
+        return files;
+    }
+private:
+    std::string _path;
+};
+
+/** Return the contents of a file.
+ */
+std::string readFile(std::string const& fileName) {
+    std::ifstream in(fileName.c_str());
+    std::ostringstream os;
+    os << in.rdbuf();
+    return os.str();
+}
+
+/** Make a DbTsvStorage that keeps its TSV files in dir, and whose database
+ * refuses connections.
+ */
+dafPersist::DbTsvStorage::Ptr makeStorage(TempDir const& dir,
+                                          int loadChunkRows = 0) {
+    pexPolicy::Policy::Ptr authInfo(new pexPolicy::Policy);
+    authInfo->set("host", "127.0.0.1");
+    authInfo->set("port", 1);
+    authInfo->set("user", "test");
+    authInfo->set("password", "test");
+    pexPolicy::Policy::Ptr authPolicy(new pexPolicy::Policy);
+    authPolicy->add("database.authInfo", authInfo);
+    dafPersist::DbAuth::setPolicy(authPolicy);
+
+    pexPolicy::Policy::Ptr policy(new pexPolicy::Policy);
+    policy->set("TempPath", dir.getPath());
+    policy->set("SaveTemp", true);
+    policy->set("BufferSize", 16);      // write (almost) every row
+    policy->set("LoadChunkRows", loadChunkRows);
+
+    dafPersist::DbTsvStorage::Ptr tsv(new dafPersist::DbTsvStorage);
+    tsv->setPolicy(policy);
+    tsv->setPersistLocation(
+        dafPersist::LogicalLocation("mysql://127.0.0.1:1/test"));
+    return tsv;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(DbTsvStorageSuite)
+
+BOOST_AUTO_TEST_CASE(Formatting) {
+    TempDir dir;
+    {
+        dafPersist::DbTsvStorage::Ptr tsv = makeStorage(dir);
+        tsv->startTransaction();
+        tsv->setTableForInsert("DbTsvStorage_Test_1");
+
+        tsv->setColumn<long long>("ll", std::numeric_limits<long long>::min());
+        tsv->setColumn<int>("i", -42);
+        tsv->setColumn<short>("s", 0);
+        tsv->setColumn<char>("c", 7);
+        tsv->setColumn<bool>("b", true);
+        tsv->setColumn<double>("d", 0.1);
+        tsv->setColumn<float>("f", 0.1f);
+        tsv->setColumn<std::string>("str", "plain");
+        tsv->insertRow();
+
+        tsv->setColumn<long long>("ll", std::numeric_limits<long long>::max());
+        tsv->setColumn<int>("i", std::numeric_limits<int>::min());
+        tsv->setColumn<short>("s", -1);
+        tsv->setColumn<char>("c", -7);
+        tsv->setColumn<bool>("b", false);
+        tsv->setColumn<double>("d", -1.5);
+        tsv->setColumn<float>("f", 3.4e38f);
+        tsv->setColumn<std::string>("str", std::string("a\\b\tc\nd\0e", 9));
+        tsv->insertRow();
+
+        tsv->setColumn<long long>("ll", 0);
+        tsv->setColumnToNull("i");
+        tsv->insertRow();
+
+        BOOST_CHECK_THROW(tsv->endTransaction(),
+                          lsst::pex::exceptions::RuntimeErrorException);
+    }
+
+    std::vector<std::string> files = dir.getFiles();
+    BOOST_REQUIRE_EQUAL(files.size(), 1U);
+    BOOST_CHECK_EQUAL(readFile(files[0]),
+        "-9223372036854775808\t-42\t0\t7\t1\t0.10000000000000001\t"
+        "0.100000001\tplain\n"
+        "9223372036854775807\t-2147483648\t-1\t-7\t0\t-1.5\t"
+        "3.39999995e+38\ta\\\\b\\tc\\nd\\0e\n"
+        "0\t\\N\t-1\t-7\t0\t-1.5\t3.39999995e+38\ta\\\\b\\tc\\nd\\0e\n");
+}
+
+BOOST_AUTO_TEST_CASE(LoadChunkRows) {
+    TempDir dir;
+    {
+        dafPersist::DbTsvStorage::Ptr tsv = makeStorage(dir, 2);
+        tsv->startTransaction();
+        tsv->setTableForInsert("DbTsvStorage_Test_1");
+
+        tsv->setColumn<int>("i", 1);
+        tsv->insertRow();
+        // The second row fills the chunk, which can't be loaded
+        tsv->setColumn<int>("i", 2);
+        BOOST_CHECK_THROW(tsv->insertRow(),
+                          lsst::pex::exceptions::RuntimeErrorException);
+    }
+
+    std::vector<std::string> files = dir.getFiles();
+    BOOST_REQUIRE_EQUAL(files.size(), 1U);
+    BOOST_CHECK_EQUAL(readFile(files[0]), "1\n2\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
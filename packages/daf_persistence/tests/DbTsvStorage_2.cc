@@ -0,0 +1,175 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * \file DbTsvStorage_2.cc
+ *
+ * This test tests loading TSV files in chunks with the DbTsvStorage class.
+ */
+#include <sstream>
+#include <string>
+#include <sys/time.h>
+#include "lsst/daf/persistence/DbStorage.h"
+#include "lsst/daf/persistence/DbTsvStorage.h"
+#include "lsst/daf/persistence/LogicalLocation.h"
+#include "lsst/pex/exceptions.h"
+
+#define BOOST_TEST_MODULE DbTsvStorage_2
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+namespace dafPersist = lsst::daf::persistence;
+
+namespace {
+
+dafPersist::LogicalLocation const loc("mysql://lsst10.ncsa.uiuc.edu:3306/test");
+
+/** Return a table name that no other test run will use.
+ */
+std::string makeTableName(std::string const& prefix) {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    std::ostringstream os;
+    os << prefix << tv.tv_sec * 1000000LL + tv.tv_usec;
+    return os.str();
+}
+
+/** Return a DbTsvStorage that loads its files every loadChunkRows rows.
+ */
+dafPersist::DbTsvStorage::Ptr makeStorage(int loadChunkRows) {
+    lsst::pex::policy::Policy::Ptr policy(new lsst::pex::policy::Policy);
+    policy->set("LoadChunkRows", loadChunkRows);
+    dafPersist::DbTsvStorage::Ptr tsv(new dafPersist::DbTsvStorage);
+    tsv->setPolicy(policy);
+    tsv->setPersistLocation(loc);
+    return tsv;
+}
+
+/** Return the number of rows in a table.
+ */
+long long countRows(std::string const& tableName) {
+    dafPersist::DbStorage dbs;
+    dbs.setRetrieveLocation(loc);
+    dbs.startTransaction();
+    dbs.setTableForQuery(tableName);
+    long long count;
+    dbs.outParam("COUNT(*)", &count, true);
+    dbs.query();
+    BOOST_CHECK_MESSAGE(dbs.next() == true, "Failed to get row");
+    dbs.finishQuery();
+    dbs.endTransaction();
+    return count;
+}
+
+std::string makeString(int i) {
+    std::ostringstream os;
+    os << "row\t" << i << "\\\n";
+    return os.str();
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(DbTsvStorageSuite)
+
+BOOST_AUTO_TEST_CASE(LoadInChunks) {
+    std::string tableName = makeTableName("DbTsvStorage_Test_C_");
+    dafPersist::DbTsvStorage::Ptr tsv = makeStorage(3);
+    tsv->createTableFromTemplate(tableName, "DbTsvStorage_Test_1");
+
+    // Insert 10 rows: three chunks loaded in the background, and a final one
+    int const numRows = 10;
+    tsv->startTransaction();
+    tsv->setTableForInsert(tableName);
+    for (int i = 0; i < numRows; ++i) {
+        tsv->setColumn<long long>("id", i);
+        tsv->setColumn<double>("ra", 0.1 * i);
+        tsv->setColumn<std::string>("final", makeString(i));
+        tsv->insertRow();
+    }
+    tsv->endTransaction();
+
+    dafPersist::DbStorage dbs;
+    dbs.setRetrieveLocation(loc);
+    dbs.startTransaction();
+    dbs.setTableForQuery(tableName);
+    long long id;
+    double ra;
+    std::string final;
+    dbs.outParam("id", &id);
+    dbs.outParam("ra", &ra);
+    dbs.outParam("final", &final);
+    dbs.orderBy("id");
+    dbs.query();
+
+    for (int i = 0; i < numRows; ++i) {
+        BOOST_CHECK_MESSAGE(dbs.next() == true, "Failed to get row");
+        BOOST_CHECK_MESSAGE(id == i, "Id is incorrect");
+        BOOST_CHECK_MESSAGE(ra == 0.1 * i, "RA is incorrect");
+        BOOST_CHECK_MESSAGE(final == makeString(i), "String is incorrect");
+    }
+    BOOST_CHECK_MESSAGE(dbs.next() == false, "Got too many rows");
+
+    dbs.finishQuery();
+    dbs.endTransaction();
+
+    tsv->dropTable(tableName);
+}
+
+BOOST_AUTO_TEST_CASE(BackgroundLoadError) {
+    // The first chunk's load fails in the background; the error is reported
+    // by endTransaction()
+    dafPersist::DbTsvStorage::Ptr tsv = makeStorage(2);
+    tsv->startTransaction();
+    tsv->setTableForInsert(makeTableName("DbTsvStorage_Test_Missing_"));
+    for (int i = 0; i < 3; ++i) {
+        tsv->setColumn<long long>("id", i);
+        tsv->insertRow();
+    }
+    BOOST_CHECK_THROW(tsv->endTransaction(),
+                      lsst::pex::exceptions::RuntimeErrorException);
+}
+
+BOOST_AUTO_TEST_CASE(ChunksShareTransaction) {
+    // The first chunk loads, but the second fails (it names a column that
+    // doesn't exist); the first chunk's rows mustn't be committed.  This
+    // needs a transactional (e.g. InnoDB) table
+    std::string tableName = makeTableName("DbTsvStorage_Test_R_");
+    dafPersist::DbTsvStorage::Ptr tsv = makeStorage(2);
+    tsv->createTableFromTemplate(tableName, "DbTsvStorage_Test_1");
+
+    tsv->startTransaction();
+    tsv->setTableForInsert(tableName);
+    for (int i = 0; i < 4; ++i) {
+        tsv->setColumn<long long>("id", i);
+        if (i >= 2) {
+            tsv->setColumn<int>("noSuchColumn", i);
+        }
+        tsv->insertRow();
+    }
+    BOOST_CHECK_THROW(tsv->endTransaction(),
+                      lsst::pex::exceptions::RuntimeErrorException);
+    BOOST_CHECK_EQUAL(countRows(tableName), 0);
+
+    tsv->dropTable(tableName);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -166,8 +166,8 @@ public:
      *  @brief Return true if the Array is definitely unique.
      *
      *  This will only return true if the manager overrides Manager::isUnique();
-     *  this is true for the SimpleManager used by lsst::ndarray::allocate, but it is
-     *  not true for ExternalManager.
+     *  this is true for the SimpleManager and PoolManager used by lsst::ndarray::allocate,
+     *  but it is not true for ExternalManager.
      */
     bool isUnique() const { return this->_core->isUnique(); }
 
@@ -35,6 +35,7 @@
 #include "lsst/ndarray/detail/ArrayAccess.h"
 #include "lsst/ndarray/Vector.h"
 #include "lsst/ndarray/detail/Core.h"
+#include "lsst/ndarray/detail/FlatAccess.h"
 #include "lsst/ndarray/views.h"
 
 namespace lsst { namespace ndarray {
@@ -99,7 +100,9 @@ public:
     operator =(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        std::copy(expr.begin(),expr.end(),this->begin());
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::AssignOp())) {
+            std::copy(expr.begin(),expr.end(),this->begin());
+        }
         return *this;
     }
 
@@ -111,7 +114,9 @@ public:
     ArrayRef const &
 #endif
     operator =(Scalar const & scalar) const {
-        std::fill(this->begin(),this->end(),scalar);
+        if (!detail::assignFlatScalar(*this, scalar, detail::AssignOp())) {
+            std::fill(this->begin(),this->end(),scalar);
+        }
         return *this;
     }
 
@@ -121,9 +126,11 @@ public:
     operator +=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) += (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::PlusAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) += (*j);
+        }
         return *this;
     }
 
@@ -135,8 +142,10 @@ public:
     ArrayRef const &
 #endif
     operator +=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) += scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::PlusAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) += scalar;
+        }
         return *this;
     }
 
@@ -146,9 +155,11 @@ public:
     operator -=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) -= (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::MinusAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) -= (*j);
+        }
         return *this;
     }
 
@@ -160,8 +171,10 @@ public:
     ArrayRef const &
 #endif
     operator -=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) -= scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::MinusAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) -= scalar;
+        }
         return *this;
     }
 
@@ -171,9 +184,11 @@ public:
     operator *=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) *= (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::MultipliesAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) *= (*j);
+        }
         return *this;
     }
 
@@ -185,8 +200,10 @@ public:
     ArrayRef const &
 #endif
     operator *=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) *= scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::MultipliesAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) *= scalar;
+        }
         return *this;
     }
 
@@ -196,9 +213,11 @@ public:
     operator /=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) /= (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::DividesAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) /= (*j);
+        }
         return *this;
     }
 
@@ -210,8 +229,10 @@ public:
     ArrayRef const &
 #endif
     operator /=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) /= scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::DividesAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) /= scalar;
+        }
         return *this;
     }
 
@@ -221,9 +242,11 @@ public:
     operator %=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) %= (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::ModulusAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) %= (*j);
+        }
         return *this;
     }
 
@@ -235,8 +258,10 @@ public:
     ArrayRef const &
 #endif
     operator %=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) %= scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::ModulusAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) %= scalar;
+        }
         return *this;
     }
 
@@ -246,9 +271,11 @@ public:
     operator ^=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) ^= (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::BitwiseXorAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) ^= (*j);
+        }
         return *this;
     }
 
@@ -260,8 +287,10 @@ public:
     ArrayRef const &
 #endif
     operator ^=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) ^= scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::BitwiseXorAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) ^= scalar;
+        }
         return *this;
     }
 
@@ -271,9 +300,11 @@ public:
     operator &=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) &= (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::BitwiseAndAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) &= (*j);
+        }
         return *this;
     }
 
@@ -285,8 +316,10 @@ public:
     ArrayRef const &
 #endif
     operator &=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) &= scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::BitwiseAndAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) &= scalar;
+        }
         return *this;
     }
 
@@ -296,9 +329,11 @@ public:
     operator |=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) |= (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::BitwiseOrAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) |= (*j);
+        }
         return *this;
     }
 
@@ -310,8 +345,10 @@ public:
     ArrayRef const &
 #endif
     operator |=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) |= scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::BitwiseOrAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) |= scalar;
+        }
         return *this;
     }
 
@@ -321,9 +358,11 @@ public:
     operator <<=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) <<= (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::LeftShiftAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) <<= (*j);
+        }
         return *this;
     }
 
@@ -335,8 +374,10 @@ public:
     ArrayRef const &
 #endif
     operator <<=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) <<= scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::LeftShiftAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) <<= scalar;
+        }
         return *this;
     }
 
@@ -346,9 +387,11 @@ public:
     operator >>=(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) >>= (*j);
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::RightShiftAssignOp())) {
+            Iterator const i_end = this->end();
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) >>= (*j);
+        }
         return *this;
     }
 
@@ -360,8 +403,10 @@ public:
     ArrayRef const &
 #endif
     operator >>=(Scalar const & scalar) const {
-        Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) >>= scalar;
+        if (!detail::assignFlatScalar(*this, scalar, detail::RightShiftAssignOp())) {
+            Iterator const i_end = this->end();
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) >>= scalar;
+        }
         return *this;
     }
     ///@}
@@ -29,7 +29,9 @@ define(`GENERAL_ASSIGN',
     operator $1(ExpressionBase<Other> const & expr) const {
         LSST_NDARRAY_ASSERT(expr.getShape() 
                          == this->getShape().template first<ExpressionBase<Other>::ND::value>());
-        indir(`$3',$1)
+        if (!detail::assignFlat(*this, static_cast<Other const &>(expr), detail::$4())) {
+            indir(`$3',$1)
+        }
         return *this;
     }
 
@@ -41,20 +43,22 @@ define(`GENERAL_ASSIGN',
     ArrayRef const &
 #endif
     operator $1(Scalar const & scalar) const {
-        indir(`$2',$1)
+        if (!detail::assignFlatScalar(*this, scalar, detail::$4())) {
+            indir(`$2',$1)
+        }
         return *this;
     }')dnl
 define(`BASIC_ASSIGN_SCALAR',`std::fill(this->begin(),this->end(),scalar);')dnl
 define(`BASIC_ASSIGN_EXPR',`std::copy(expr.begin(),expr.end(),this->begin());')dnl
 define(`AUGMENTED_ASSIGN_SCALAR',
 `Iterator const i_end = this->end();
-        for (Iterator i = this->begin(); i != i_end; ++i) (*i) $1 scalar;')dnl
+            for (Iterator i = this->begin(); i != i_end; ++i) (*i) $1 scalar;')dnl
 define(`AUGMENTED_ASSIGN_EXPR',
 `Iterator const i_end = this->end();
-        typename Other::Iterator j = expr.begin();
-        for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) $1 (*j);')dnl
-define(`BASIC_ASSIGN',`GENERAL_ASSIGN(`=',`BASIC_ASSIGN_SCALAR',`BASIC_ASSIGN_EXPR')')dnl
-define(`AUGMENTED_ASSIGN',`GENERAL_ASSIGN($1,`AUGMENTED_ASSIGN_SCALAR',`AUGMENTED_ASSIGN_EXPR')')dnl
+            typename Other::Iterator j = expr.begin();
+            for (Iterator i = this->begin(); i != i_end; ++i, ++j) (*i) $1 (*j);')dnl
+define(`BASIC_ASSIGN',`GENERAL_ASSIGN(`=',`BASIC_ASSIGN_SCALAR',`BASIC_ASSIGN_EXPR',`AssignOp')')dnl
+define(`AUGMENTED_ASSIGN',`GENERAL_ASSIGN($1,`AUGMENTED_ASSIGN_SCALAR',`AUGMENTED_ASSIGN_EXPR',$2)')dnl
 #ifndef LSST_NDARRAY_ArrayRef_h_INCLUDED
 #define LSST_NDARRAY_ArrayRef_h_INCLUDED
 
@@ -70,6 +74,7 @@ define(`AUGMENTED_ASSIGN',`GENERAL_ASSIGN($1,`AUGMENTED_ASSIGN_SCALAR',`AUGMENTE
 #include "lsst/ndarray/detail/ArrayAccess.h"
 #include "lsst/ndarray/Vector.h"
 #include "lsst/ndarray/detail/Core.h"
+#include "lsst/ndarray/detail/FlatAccess.h"
 #include "lsst/ndarray/views.h"
 
 namespace lsst { namespace ndarray {
@@ -128,16 +133,16 @@ public:
      */
     /// @{
 BASIC_ASSIGN
-AUGMENTED_ASSIGN(+=)
-AUGMENTED_ASSIGN(-=)
-AUGMENTED_ASSIGN(*=)
-AUGMENTED_ASSIGN(/=)
-AUGMENTED_ASSIGN(%=)
-AUGMENTED_ASSIGN(^=)
-AUGMENTED_ASSIGN(&=)
-AUGMENTED_ASSIGN(|=)
-AUGMENTED_ASSIGN(<<=)
-AUGMENTED_ASSIGN(>>=)
+AUGMENTED_ASSIGN(+=,PlusAssignOp)
+AUGMENTED_ASSIGN(-=,MinusAssignOp)
+AUGMENTED_ASSIGN(*=,MultipliesAssignOp)
+AUGMENTED_ASSIGN(/=,DividesAssignOp)
+AUGMENTED_ASSIGN(%=,ModulusAssignOp)
+AUGMENTED_ASSIGN(^=,BitwiseXorAssignOp)
+AUGMENTED_ASSIGN(&=,BitwiseAndAssignOp)
+AUGMENTED_ASSIGN(|=,BitwiseOrAssignOp)
+AUGMENTED_ASSIGN(<<=,LeftShiftAssignOp)
+AUGMENTED_ASSIGN(>>=,RightShiftAssignOp)
     ///@}
 
 private:
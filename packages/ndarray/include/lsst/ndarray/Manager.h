@@ -32,10 +32,88 @@
 #include "lsst/ndarray_fwd.h"
 #include <boost/noncopyable.hpp>
 #include <boost/intrusive_ptr.hpp>
-#include <boost/scoped_array.hpp>
+#include <boost/type_traits/has_trivial_constructor.hpp>
+#include <boost/type_traits/has_trivial_destructor.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <utility>
 
 namespace lsst { namespace ndarray {
 
+/// @brief The alignment, in bytes, of the first element of memory allocated by ndarray.
+enum { DATA_ALIGNMENT = 64 };
+
+namespace detail {
+
+/**
+ *  @internal @brief Allocate n elements of the given size, aligned to DATA_ALIGNMENT bytes.
+ *
+ *  The returned pointer is the aligned data; block is set to the pointer that must be passed
+ *  to freeAligned when the memory is no longer needed.  Throws std::bad_alloc if the total
+ *  size overflows std::size_t.
+ */
+inline void * allocateAligned(std::size_t n, std::size_t elementSize, void * & block) {
+    std::size_t const maxSize = std::numeric_limits<std::size_t>::max() - DATA_ALIGNMENT;
+    if (elementSize != 0 && n > maxSize / elementSize) {
+        throw std::bad_alloc();
+    }
+    block = ::operator new(n * elementSize + DATA_ALIGNMENT);
+    std::size_t address = reinterpret_cast<std::size_t>(block);
+    address = (address + DATA_ALIGNMENT - 1) & ~static_cast<std::size_t>(DATA_ALIGNMENT - 1);
+    return reinterpret_cast<void*>(address);
+}
+
+/// @internal @brief Free a block returned by allocateAligned.
+inline void freeAligned(void * block) {
+    ::operator delete(block);
+}
+
+template <typename U>
+inline void destroyElements(U *, std::size_t, boost::true_type) {}
+
+template <typename U>
+inline void destroyElements(U * p, std::size_t n, boost::false_type) {
+    for (std::size_t i = 0; i < n; ++i) {
+        p[i].~U();
+    }
+}
+
+/// @internal @brief Run the destructors of n elements, if they have any.
+template <typename U>
+inline void destroyElements(U * p, std::size_t n) {
+    destroyElements(p, n, boost::has_trivial_destructor<U>());
+}
+
+template <typename U>
+inline void constructElements(U *, std::size_t, boost::true_type) {}
+
+template <typename U>
+inline void constructElements(U * p, std::size_t n, boost::false_type) {
+    std::size_t i = 0;
+    try {
+        for (; i < n; ++i) {
+            new (p + i) U();
+        }
+    } catch (...) {
+        destroyElements(p, i);
+        throw;
+    }
+}
+
+/**
+ *  @internal @brief Run the default constructors of n elements in raw memory.
+ *
+ *  Like new U[n], this leaves elements with trivial constructors uninitialized.
+ */
+template <typename U>
+inline void constructElements(U * p, std::size_t n) {
+    constructElements(p, n, boost::has_trivial_constructor<U>());
+}
+
+} // namespace detail
+
 class Manager : private boost::noncopyable {
 public:
 
@@ -63,21 +141,43 @@ private:
     mutable int _rc;
 };
 
+/**
+ *  @brief A Manager that owns a freshly allocated block of memory.
+ *
+ *  The first element is aligned to DATA_ALIGNMENT bytes, so rows of contiguous arrays start on
+ *  a cache line and may be loaded with aligned SIMD instructions.
+ */
 template <typename T>
 class SimpleManager : public Manager {
     typedef typename boost::remove_const<T>::type U;
 public:
     
-    static std::pair<Manager::Ptr,T*> allocate(int size) {
+    static std::pair<Manager::Ptr,T*> allocate(std::size_t size) {
         boost::intrusive_ptr<SimpleManager> r(new SimpleManager(size), false);
-        return std::pair<Manager::Ptr,T*>(r, r->_p.get());
+        return std::pair<Manager::Ptr,T*>(r, r->_p);
     }
 
     virtual bool isUnique() const { return true; }
 
 private:
-    explicit SimpleManager(int size) : _p(new U[size]) {}
-    boost::scoped_array<U> _p;
+    explicit SimpleManager(std::size_t size) : _block(0), _p(0), _size(size) {
+        _p = static_cast<U*>(detail::allocateAligned(size, sizeof(U), _block));
+        try {
+            detail::constructElements(_p, _size);
+        } catch (...) {
+            detail::freeAligned(_block);
+            throw;
+        }
+    }
+
+    virtual ~SimpleManager() {
+        detail::destroyElements(_p, _size);
+        detail::freeAligned(_block);
+    }
+
+    void * _block;
+    U * _p;
+    std::size_t _size;
 };
 
 template <typename U>
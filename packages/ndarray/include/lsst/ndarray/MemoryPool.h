@@ -0,0 +1,306 @@
+// -*- lsst-c++ -*-
+/* 
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_NDARRAY_MemoryPool_h_INCLUDED
+#define LSST_NDARRAY_MemoryPool_h_INCLUDED
+
+/** 
+ *  @file lsst/ndarray/MemoryPool.h
+ *
+ *  @brief Definition of MemoryPool and PoolManager, which recycle the memory of temporary arrays.
+ *
+ *  This header isn't included by lsst/ndarray.h:  MemoryPool locks its free lists with a
+ *  boost::mutex, so code that includes it must also be built against boost_thread.
+ */
+
+#include "lsst/ndarray/initialization.h"
+#include "lsst/ndarray/Manager.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <vector>
+
+namespace lsst { namespace ndarray {
+
+/**
+ *  @brief A cache of aligned memory blocks, sorted into size classes.
+ *
+ *  Arrays allocated from a pool (see allocate(Vector<int,N> const &, MemoryPool::Ptr const &))
+ *  return their memory to it when the last reference goes away, and a later allocation of
+ *  a similar size reuses that memory instead of going back to the system allocator.  This
+ *  avoids most of the malloc and page-fault cost of temporaries that are created over and over
+ *  again in a loop.
+ *
+ *  Requests are rounded up to the next size class; there are four classes per power of two,
+ *  so at most 25% of a block is wasted.  Once the pool caches maxCachedBytes, blocks that are
+ *  released are freed rather than cached.  All blocks are aligned to DATA_ALIGNMENT bytes.
+ *
+ *  A pool may be shared between threads (its free lists are protected by a mutex), but
+ *  contention is avoided entirely by giving each worker thread its own pool.
+ */
+class MemoryPool : private boost::noncopyable {
+public:
+
+    typedef boost::shared_ptr<MemoryPool> Ptr;
+
+    /// @brief The default limit on the number of bytes a pool caches.
+    enum { DEFAULT_MAX_CACHED_BYTES = 1 << 30 };
+
+    /// @internal @brief A block of memory handed out by a pool.
+    struct Block {
+        void * raw;                     ///< the pointer returned by detail::allocateAligned
+        void * data;                    ///< the aligned start of the block
+        int sizeClass;                  ///< index of the size class the block belongs to
+
+        Block() : raw(0), data(0), sizeClass(-1) {}
+    };
+
+    /// @brief Create a new pool that caches at most maxCachedBytes of free memory.
+    static Ptr make(std::size_t maxCachedBytes = DEFAULT_MAX_CACHED_BYTES) {
+        return Ptr(new MemoryPool(maxCachedBytes));
+    }
+
+    explicit MemoryPool(std::size_t maxCachedBytes = DEFAULT_MAX_CACHED_BYTES) :
+        _maxCachedBytes(maxCachedBytes), _cachedBytes(0)
+    {}
+
+    ~MemoryPool() { clear(); }
+
+    /**
+     *  @brief Return a block with room for n elements of the given size.
+     *
+     *  The block's contents are uninitialized; they may hold the values of a released array.
+     */
+    Block acquire(std::size_t n, std::size_t elementSize) {
+        std::size_t const maxSize = std::numeric_limits<std::size_t>::max() / 2;
+        if (elementSize != 0 && n > maxSize / elementSize) {
+            throw std::bad_alloc();
+        }
+        std::size_t classBytes = 0;
+        Block block;
+        block.sizeClass = getSizeClass(n * elementSize, classBytes);
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            if (static_cast<std::size_t>(block.sizeClass) < _free.size()
+                && !_free[block.sizeClass].empty()) {
+                block = _free[block.sizeClass].back();
+                _free[block.sizeClass].pop_back();
+                _cachedBytes -= classBytes;
+                return block;
+            }
+        }
+        block.data = detail::allocateAligned(classBytes, 1, block.raw);
+        return block;
+    }
+
+    /// @brief Return a block obtained from acquire to the pool.
+    void release(Block const & block) {
+        std::size_t const classBytes = getClassBytes(block.sizeClass);
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            if (_cachedBytes + classBytes <= _maxCachedBytes) {
+                if (static_cast<std::size_t>(block.sizeClass) >= _free.size()) {
+                    _free.resize(block.sizeClass + 1);
+                }
+                _free[block.sizeClass].push_back(block);
+                _cachedBytes += classBytes;
+                return;
+            }
+        }
+        detail::freeAligned(block.raw);
+    }
+
+    /// @brief Free all cached blocks.
+    void clear() {
+        boost::mutex::scoped_lock lock(_mutex);
+        for (std::size_t i = 0; i < _free.size(); ++i) {
+            for (std::size_t j = 0; j < _free[i].size(); ++j) {
+                detail::freeAligned(_free[i][j].raw);
+            }
+            _free[i].clear();
+        }
+        _cachedBytes = 0;
+    }
+
+    /// @brief Return the number of bytes held in free blocks.
+    std::size_t getCachedBytes() const {
+        boost::mutex::scoped_lock lock(_mutex);
+        return _cachedBytes;
+    }
+
+    /// @brief Return the largest number of bytes the pool will hold in free blocks.
+    std::size_t getMaxCachedBytes() const { return _maxCachedBytes; }
+
+    /**
+     *  @brief Return the index of the size class used for a request of the given size.
+     *
+     *  classBytes is set to the size of the blocks in the class.
+     */
+    static int getSizeClass(std::size_t bytes, std::size_t & classBytes) {
+        if (bytes < MIN_BLOCK_BYTES) bytes = MIN_BLOCK_BYTES;
+        int k = 0;
+        while ((bytes >> (k + 1)) != 0) ++k;
+        std::size_t granule = static_cast<std::size_t>(1) << (k - 2);
+        std::size_t n = (bytes + granule - 1) / granule;
+        if (n == 8) {
+            ++k;
+            n = 4;
+            granule <<= 1;
+        }
+        classBytes = n * granule;
+        return (k - MIN_BLOCK_LOG2) * 4 + static_cast<int>(n - 4);
+    }
+
+    /// @brief Return the size of the blocks in a size class.
+    static std::size_t getClassBytes(int sizeClass) {
+        int const k = sizeClass / 4 + MIN_BLOCK_LOG2;
+        return static_cast<std::size_t>(4 + sizeClass % 4) << (k - 2);
+    }
+
+private:
+
+    enum { MIN_BLOCK_LOG2 = 6, MIN_BLOCK_BYTES = 1 << MIN_BLOCK_LOG2 };
+
+    std::size_t _maxCachedBytes;
+    std::size_t _cachedBytes;
+    std::vector< std::vector<Block> > _free;
+    mutable boost::mutex _mutex;
+};
+
+/**
+ *  @brief A Manager that owns a block drawn from a MemoryPool, and returns it when destroyed.
+ *
+ *  The manager holds a reference to the pool, so the pool outlives every array allocated from it.
+ */
+template <typename T>
+class PoolManager : public Manager {
+    typedef typename boost::remove_const<T>::type U;
+public:
+
+    static std::pair<Manager::Ptr,T*> allocate(std::size_t size, MemoryPool::Ptr const & pool) {
+        boost::intrusive_ptr<PoolManager> r(new PoolManager(size, pool), false);
+        return std::pair<Manager::Ptr,T*>(r, static_cast<U*>(r->_block.data));
+    }
+
+    MemoryPool::Ptr getPool() const { return _pool; }
+
+    virtual bool isUnique() const { return true; }
+
+private:
+    PoolManager(std::size_t size, MemoryPool::Ptr const & pool) :
+        _pool(pool), _block(pool->acquire(size, sizeof(U))), _size(size)
+    {
+        try {
+            detail::constructElements(static_cast<U*>(_block.data), _size);
+        } catch (...) {
+            _pool->release(_block);
+            throw;
+        }
+    }
+
+    virtual ~PoolManager() {
+        detail::destroyElements(static_cast<U*>(_block.data), _size);
+        _pool->release(_block);
+    }
+
+    MemoryPool::Ptr _pool;
+    MemoryPool::Block _block;
+    std::size_t _size;
+};
+
+namespace detail {
+
+template <int N>
+class PoolInitializer : public Initializer< N, PoolInitializer<N> > {
+public:
+
+    template <typename Target>
+    Target apply() const {
+        typedef detail::ArrayAccess< Target > Access;
+        typedef typename Access::Core Core;
+        typedef typename Access::Element Element;
+        std::size_t total = 1;
+        for (int n = 0; n < N; ++n) {
+            total *= static_cast<std::size_t>(_shape[n]);
+        }
+        std::pair<Manager::Ptr,Element*> p = _pool ?
+            PoolManager<Element>::allocate(total, _pool) : SimpleManager<Element>::allocate(total);
+        return Access::construct(p.second, Core::create(_shape, p.first));
+    }
+
+    PoolInitializer(Vector<int,N> const & shape, MemoryPool::Ptr const & pool) :
+        _shape(shape), _pool(pool) {}
+
+private:
+    Vector<int,N> _shape;
+    MemoryPool::Ptr _pool;
+};
+
+} // namespace detail
+
+/// @addtogroup MainGroup
+/// @{
+
+/** 
+ *  @brief Create an expression that allocates uninitialized memory for an array from a MemoryPool.
+ *
+ *  The memory is returned to the pool when the last array referencing it is destroyed; see MemoryPool.
+ *  If pool is empty the memory is allocated as by allocate(Vector<int,N> const &).
+ *
+ *  @returns A temporary object convertible to an Array with fully contiguous row-major strides.
+ */
+template <int N>
+inline detail::PoolInitializer<N> allocate(Vector<int,N> const & shape, MemoryPool::Ptr const & pool) {
+    return detail::PoolInitializer<N>(shape, pool); 
+}
+
+/** 
+ *  @brief Create an expression that allocates uninitialized memory for a 1-d array from a MemoryPool.
+ *
+ *  @returns A temporary object convertible to an Array with fully contiguous row-major strides.
+ */
+inline detail::PoolInitializer<1> allocate(int n, MemoryPool::Ptr const & pool) {
+    return detail::PoolInitializer<1>(lsst::ndarray::makeVector(n), pool); 
+}
+
+/** 
+ *  @brief Create an expression that allocates uninitialized memory for a 2-d array from a MemoryPool.
+ *
+ *  @returns A temporary object convertible to an Array with fully contiguous row-major strides.
+ */
+inline detail::PoolInitializer<2> allocate(int n1, int n2, MemoryPool::Ptr const & pool) {
+    return detail::PoolInitializer<2>(lsst::ndarray::makeVector(n1, n2), pool); 
+}
+
+/** 
+ *  @brief Create an expression that allocates uninitialized memory for a 3-d array from a MemoryPool.
+ *
+ *  @returns A temporary object convertible to an Array with fully contiguous row-major strides.
+ */
+inline detail::PoolInitializer<3> allocate(int n1, int n2, int n3, MemoryPool::Ptr const & pool) {
+    return detail::PoolInitializer<3>(lsst::ndarray::makeVector(n1, n2, n3), pool); 
+}
+
+/// @}
+
+}} // namespace lsst::ndarray
+
+#endif // !LSST_NDARRAY_MemoryPool_h_INCLUDED
@@ -31,6 +31,7 @@
 
 #include "lsst/ndarray/ExpressionBase.h"
 #include "lsst/ndarray/vectorize.h"
+#include "lsst/ndarray/detail/FlatAccess.h"
 #include <boost/iterator/iterator_adaptor.hpp>
 #include <boost/iterator/zip_iterator.hpp>
 #include <boost/tuple/tuple.hpp>
@@ -144,6 +145,61 @@ public:
     BinaryFunction _functor;
 };
 
+/**
+ *  @internal @brief Flat element access for a contiguous binary expression.
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Operand1, typename Operand2, typename BinaryFunction>
+class BinaryOpFlatAccessor {
+public:
+    typedef typename FlatAccess<Operand1>::Accessor BaseAccessor1;
+    typedef typename FlatAccess<Operand2>::Accessor BaseAccessor2;
+
+    BinaryOpFlatAccessor(
+        BaseAccessor1 const & operand1,
+        BaseAccessor2 const & operand2,
+        BinaryFunction const & functor
+    ) : _operand1(operand1), _operand2(operand2), _functor(functor) {}
+
+    typename BinaryFunction::result_type operator[](std::ptrdiff_t n) const {
+        return _functor(_operand1[n], _operand2[n]);
+    }
+
+private:
+    BaseAccessor1 _operand1;
+    BaseAccessor2 _operand2;
+    BinaryFunction _functor;
+};
+
+/**
+ *  @internal @brief FlatAccess specialization for BinaryOpExpression.
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Operand1, typename Operand2, typename BinaryFunction, int N>
+struct FlatAccess< BinaryOpExpression<Operand1,Operand2,BinaryFunction,N> > {
+    typedef BinaryOpExpression<Operand1,Operand2,BinaryFunction,N> Expression;
+    typedef typename boost::mpl::and_<
+        typename FlatAccess<Operand1>::IsSupported,
+        typename FlatAccess<Operand2>::IsSupported
+        >::type IsSupported;
+    typedef BinaryOpFlatAccessor<Operand1,Operand2,BinaryFunction> Accessor;
+
+    static bool isContiguous(Expression const & expr) {
+        return FlatAccess<Operand1>::isContiguous(expr._operand1)
+            && FlatAccess<Operand2>::isContiguous(expr._operand2);
+    }
+
+    static Accessor getAccessor(Expression const & expr) {
+        return Accessor(
+            FlatAccess<Operand1>::getAccessor(expr._operand1),
+            FlatAccess<Operand2>::getAccessor(expr._operand2),
+            expr._functor
+        );
+    }
+};
+
 } // namespace detail
 }} // namespace lsst::ndarray
 
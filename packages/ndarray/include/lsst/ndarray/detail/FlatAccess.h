@@ -0,0 +1,237 @@
+// -*- lsst-c++ -*-
+/* 
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_NDARRAY_DETAIL_FlatAccess_h_INCLUDED
+#define LSST_NDARRAY_DETAIL_FlatAccess_h_INCLUDED
+
+/** 
+ *  @file lsst/ndarray/detail/FlatAccess.h
+ *
+ *  @brief Evaluation of row-major contiguous expressions as flat loops.
+ */
+
+#include "lsst/ndarray/ExpressionTraits.h"
+#include "lsst/ndarray/Vector.h"
+#include <boost/mpl/and.hpp>
+#include <boost/mpl/bool.hpp>
+#include <cstddef>
+
+namespace lsst { namespace ndarray {
+namespace detail {
+
+/**
+ *  @internal @brief Return true if an array with the given shape and strides is row-major contiguous.
+ *
+ *  Dimensions with unit size may have any stride, and an empty array is always contiguous.
+ *
+ *  @ingroup InternalGroup
+ */
+template <int N>
+inline bool isRowMajorContiguous(Vector<int,N> const & shape, Vector<int,N> const & strides) {
+    int expected = 1;
+    for (int n = N - 1; n >= 0; --n) {
+        if (shape[n] == 0) return true;
+        if (shape[n] != 1 && strides[n] != expected) return false;
+        expected *= shape[n];
+    }
+    return true;
+}
+
+/// @internal @brief Return the total number of elements in an array or expression with the given shape.
+template <int N>
+inline std::ptrdiff_t countElements(Vector<int,N> const & shape) {
+    std::ptrdiff_t n = 1;
+    for (int i = 0; i < N; ++i) n *= shape[i];
+    return n;
+}
+
+/**
+ *  @internal @brief Traits that allow an expression to be evaluated with a single flat loop.
+ *
+ *  When IsSupported is true, the specialization also provides:
+ *   - isContiguous(expr), which returns true if every array in the expression is
+ *     row-major contiguous (and hence can be traversed by a single index);
+ *   - Accessor, a lightweight type with an operator[] that returns the element at a
+ *     flat index, in row-major order;
+ *   - getAccessor(expr), which returns an Accessor for a contiguous expression.
+ *
+ *  Arrays and unary and binary expressions built from them are supported; the specializations
+ *  for the expressions live with their definitions.
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Expression>
+struct FlatAccess {
+    typedef boost::mpl::false_ IsSupported;
+};
+
+/**
+ *  @internal @brief Implementation of FlatAccess for Array and ArrayRef.
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Array_>
+struct ArrayFlatAccess {
+    typedef ExpressionTraits<Array_> Traits;
+    typedef boost::mpl::true_ IsSupported;
+    typedef typename Traits::Element * Accessor;
+
+    static bool isContiguous(Array_ const & array) {
+        if (Traits::RMC::value == Traits::ND::value) return true;
+        return isRowMajorContiguous(array.getShape(), array.getStrides());
+    }
+
+    static Accessor getAccessor(Array_ const & array) { return array.getData(); }
+};
+
+template <typename T, int N, int C>
+struct FlatAccess< Array<T,N,C> > : public ArrayFlatAccess< Array<T,N,C> > {};
+
+template <typename T, int N, int C>
+struct FlatAccess< ArrayRef<T,N,C> > : public ArrayFlatAccess< ArrayRef<T,N,C> > {};
+
+/**
+ *  @internal @brief True if an expression can be assigned to an array with a flat loop.
+ *
+ *  Both must support FlatAccess and have the same number of dimensions (assignment
+ *  of an expression with fewer dimensions broadcasts it, which needs nested iteration).
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Target, typename Source>
+struct CanAssignFlat : public boost::mpl::and_<
+    typename FlatAccess<Target>::IsSupported,
+    typename FlatAccess<Source>::IsSupported,
+    boost::mpl::bool_<(ExpressionTraits<Target>::ND::value == ExpressionTraits<Source>::ND::value)>
+    > {};
+
+template <typename Target, typename Source, typename Op>
+inline bool assignFlat(Target const &, Source const &, Op const &, boost::mpl::false_) {
+    return false;
+}
+
+template <typename Target, typename Source, typename Op>
+inline bool assignFlat(Target const & target, Source const & source, Op const & op, boost::mpl::true_) {
+    if (!FlatAccess<Target>::isContiguous(target) || !FlatAccess<Source>::isContiguous(source)) {
+        return false;
+    }
+    std::ptrdiff_t const n = countElements(target.getShape());
+    typename FlatAccess<Target>::Accessor const out = FlatAccess<Target>::getAccessor(target);
+    typename FlatAccess<Source>::Accessor const in = FlatAccess<Source>::getAccessor(source);
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        op(out[i], in[i]);
+    }
+    return true;
+}
+
+/**
+ *  @internal @brief Apply op(target[i], source[i]) to every element with a single flat loop.
+ *
+ *  Returns false, having done nothing, if either expression is not row-major contiguous,
+ *  in which case the caller must fall back to nested iteration.
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Target, typename Source, typename Op>
+inline bool assignFlat(Target const & target, Source const & source, Op const & op) {
+    return assignFlat(target, source, op, typename CanAssignFlat<Target,Source>::type());
+}
+
+/**
+ *  @internal @brief Apply op(target[i], scalar) to every element with a single flat loop.
+ *
+ *  Returns false, having done nothing, if the target is not row-major contiguous.
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Target, typename Scalar, typename Op>
+inline bool assignFlatScalar(Target const & target, Scalar const & scalar, Op const & op) {
+    if (!FlatAccess<Target>::isContiguous(target)) {
+        return false;
+    }
+    std::ptrdiff_t const n = countElements(target.getShape());
+    typename FlatAccess<Target>::Accessor const out = FlatAccess<Target>::getAccessor(target);
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        op(out[i], scalar);
+    }
+    return true;
+}
+
+template <typename Expression, typename Reducer>
+inline bool reduceFlat(Expression const &, Reducer &, boost::mpl::false_) {
+    return false;
+}
+
+template <typename Expression, typename Reducer>
+inline bool reduceFlat(Expression const & expr, Reducer & reducer, boost::mpl::true_) {
+    if (!FlatAccess<Expression>::isContiguous(expr)) {
+        return false;
+    }
+    std::ptrdiff_t const n = countElements(expr.getShape());
+    if (n == 0) return true;
+    typename FlatAccess<Expression>::Accessor const in = FlatAccess<Expression>::getAccessor(expr);
+    reducer.start(in[0]);
+    for (std::ptrdiff_t i = 1; i < n; ++i) {
+        reducer(in[i]);
+    }
+    return true;
+}
+
+/**
+ *  @internal @brief Feed every element of a contiguous expression to a reducer with a single flat loop.
+ *
+ *  The first element is passed to reducer.start(), and the rest to reducer(); nothing is
+ *  passed for an empty expression.  Returns false, having done nothing, if the expression is
+ *  not row-major contiguous.
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Expression, typename Reducer>
+inline bool reduceFlat(Expression const & expr, Reducer & reducer) {
+    return reduceFlat(expr, reducer, typename FlatAccess<Expression>::IsSupported());
+}
+
+#define LSST_NDARRAY_FLAT_ASSIGN_OP(NAME, OP)                           \
+    struct NAME {                                                       \
+        template <typename A, typename B>                               \
+        void operator()(A & a, B const & b) const { a OP b; }           \
+    }
+
+/// @internal @brief Element-wise assignment functors, used by ArrayRef's assignment operators.
+LSST_NDARRAY_FLAT_ASSIGN_OP(AssignOp, =);
+LSST_NDARRAY_FLAT_ASSIGN_OP(PlusAssignOp, +=);
+LSST_NDARRAY_FLAT_ASSIGN_OP(MinusAssignOp, -=);
+LSST_NDARRAY_FLAT_ASSIGN_OP(MultipliesAssignOp, *=);
+LSST_NDARRAY_FLAT_ASSIGN_OP(DividesAssignOp, /=);
+LSST_NDARRAY_FLAT_ASSIGN_OP(ModulusAssignOp, %=);
+LSST_NDARRAY_FLAT_ASSIGN_OP(BitwiseXorAssignOp, ^=);
+LSST_NDARRAY_FLAT_ASSIGN_OP(BitwiseAndAssignOp, &=);
+LSST_NDARRAY_FLAT_ASSIGN_OP(BitwiseOrAssignOp, |=);
+LSST_NDARRAY_FLAT_ASSIGN_OP(LeftShiftAssignOp, <<=);
+LSST_NDARRAY_FLAT_ASSIGN_OP(RightShiftAssignOp, >>=);
+
+#undef LSST_NDARRAY_FLAT_ASSIGN_OP
+
+} // namespace detail
+}} // namespace lsst::ndarray
+
+#endif // !LSST_NDARRAY_DETAIL_FlatAccess_h_INCLUDED
@@ -31,6 +31,7 @@
 
 #include "lsst/ndarray/ExpressionBase.h"
 #include "lsst/ndarray/vectorize.h"
+#include "lsst/ndarray/detail/FlatAccess.h"
 #include <boost/iterator/iterator_adaptor.hpp>
 
 namespace lsst { namespace ndarray {
@@ -120,6 +121,48 @@ public:
     UnaryFunction _functor;
 };
 
+/**
+ *  @internal @brief Flat element access for a contiguous unary expression.
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Operand, typename UnaryFunction>
+class UnaryOpFlatAccessor {
+public:
+    typedef typename FlatAccess<Operand>::Accessor BaseAccessor;
+
+    UnaryOpFlatAccessor(BaseAccessor const & operand, UnaryFunction const & functor) :
+        _operand(operand), _functor(functor) {}
+
+    typename UnaryFunction::result_type operator[](std::ptrdiff_t n) const {
+        return _functor(_operand[n]);
+    }
+
+private:
+    BaseAccessor _operand;
+    UnaryFunction _functor;
+};
+
+/**
+ *  @internal @brief FlatAccess specialization for UnaryOpExpression.
+ *
+ *  @ingroup InternalGroup
+ */
+template <typename Operand, typename UnaryFunction, int N>
+struct FlatAccess< UnaryOpExpression<Operand,UnaryFunction,N> > {
+    typedef UnaryOpExpression<Operand,UnaryFunction,N> Expression;
+    typedef typename FlatAccess<Operand>::IsSupported IsSupported;
+    typedef UnaryOpFlatAccessor<Operand,UnaryFunction> Accessor;
+
+    static bool isContiguous(Expression const & expr) {
+        return FlatAccess<Operand>::isContiguous(expr._operand);
+    }
+
+    static Accessor getAccessor(Expression const & expr) {
+        return Accessor(FlatAccess<Operand>::getAccessor(expr._operand), expr._functor);
+    }
+};
+
 } // namespace detail
 }} // namespace lsst::ndarray
 
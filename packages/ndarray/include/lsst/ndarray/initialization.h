@@ -60,7 +60,10 @@ public:
         typedef detail::ArrayAccess< Target > Access;
         typedef typename Access::Core Core;
         typedef typename Access::Element Element;
-        int total = _shape.product();
+        std::size_t total = 1;
+        for (int n = 0; n < N; ++n) {
+            total *= static_cast<std::size_t>(_shape[n]);
+        }
         std::pair<Manager::Ptr,Element*> p = SimpleManager<Element>::allocate(total);
         return Access::construct(p.second, Core::create(_shape, p.first));
     }
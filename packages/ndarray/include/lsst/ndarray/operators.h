@@ -1244,6 +1244,53 @@ allclose(ExpressionBase<Derived1> const & expr1, ExpressionBase<Derived2> const
 }
 
 
+/// \cond INTERNAL
+namespace detail {
+
+/**
+ *  \internal @class SumReducer
+ *  \ingroup InternalGroup
+ *  \brief Reducer for sum(); see reduceFlat.
+ */
+template <typename T>
+struct SumReducer {
+    T result;
+
+    SumReducer() : result(static_cast<T>(0)) {}
+
+    template <typename U> void start(U const & x) { result += x; }
+    template <typename U> void operator()(U const & x) { result += x; }
+};
+
+/**
+ *  \internal @class MinReducer
+ *  \ingroup InternalGroup
+ *  \brief Reducer for min(); see reduceFlat.
+ */
+template <typename T>
+struct MinReducer {
+    T result;
+
+    template <typename U> void start(U const & x) { result = x; }
+    template <typename U> void operator()(U const & x) { if (x < result) result = x; }
+};
+
+/**
+ *  \internal @class MaxReducer
+ *  \ingroup InternalGroup
+ *  \brief Reducer for max(); see reduceFlat.
+ */
+template <typename T>
+struct MaxReducer {
+    T result;
+
+    template <typename U> void start(U const & x) { result = x; }
+    template <typename U> void operator()(U const & x) { if (result < x) result = x; }
+};
+
+} // namespace detail
+/// \endcond
+
 template <typename Scalar>
 inline typename boost::enable_if<typename ExpressionTraits<Scalar>::IsScalar, Scalar>::type
 sum(Scalar const & scalar) { return scalar; }
@@ -1252,19 +1299,87 @@ sum(Scalar const & scalar) { return scalar; }
 /**
  *  \brief Return the sum of all elements of the given expression.
  *
+ *  Contiguous expressions are summed with a single flat loop, without evaluating any temporaries.
+ *
  *  \ingroup MainGroup
  */
 template <typename Derived>
-inline typename Derived::Element
+inline typename boost::remove_const<typename Derived::Element>::type
 sum(ExpressionBase<Derived> const & expr) {
-    typename Derived::Iterator const i_end = expr.end();
-    typename Derived::Element total = static_cast<typename Derived::Element>(0);
-    for (typename Derived::Iterator i = expr.begin(); i != i_end; ++i) {
-        total += sum(*i);
+    detail::SumReducer<typename boost::remove_const<typename Derived::Element>::type> reducer;
+    if (!detail::reduceFlat(static_cast<Derived const &>(expr), reducer)) {
+        typename Derived::Iterator const i_end = expr.end();
+        for (typename Derived::Iterator i = expr.begin(); i != i_end; ++i) {
+            reducer.result += sum(*i);
+        }
     }
-    return total;
+    return reducer.result;
 }
 
+template <typename Scalar>
+inline typename boost::enable_if<typename ExpressionTraits<Scalar>::IsScalar, Scalar>::type
+min(Scalar const & scalar) { return scalar; }
+
+/**
+ *  \brief Return the smallest element of the given expression, which must not be empty.
+ *
+ *  \ingroup MainGroup
+ */
+template <typename Derived>
+inline typename boost::remove_const<typename Derived::Element>::type
+min(ExpressionBase<Derived> const & expr) {
+    LSST_NDARRAY_ASSERT(detail::countElements(expr.getShape()) > 0);
+    detail::MinReducer<typename boost::remove_const<typename Derived::Element>::type> reducer;
+    if (!detail::reduceFlat(static_cast<Derived const &>(expr), reducer)) {
+        typename Derived::Iterator const i_end = expr.end();
+        typename Derived::Iterator i = expr.begin();
+        reducer.start(min(*i));
+        for (++i; i != i_end; ++i) {
+            reducer(min(*i));
+        }
+    }
+    return reducer.result;
+}
+
+template <typename Scalar>
+inline typename boost::enable_if<typename ExpressionTraits<Scalar>::IsScalar, Scalar>::type
+max(Scalar const & scalar) { return scalar; }
+
+/**
+ *  \brief Return the largest element of the given expression, which must not be empty.
+ *
+ *  \ingroup MainGroup
+ */
+template <typename Derived>
+inline typename boost::remove_const<typename Derived::Element>::type
+max(ExpressionBase<Derived> const & expr) {
+    LSST_NDARRAY_ASSERT(detail::countElements(expr.getShape()) > 0);
+    detail::MaxReducer<typename boost::remove_const<typename Derived::Element>::type> reducer;
+    if (!detail::reduceFlat(static_cast<Derived const &>(expr), reducer)) {
+        typename Derived::Iterator const i_end = expr.end();
+        typename Derived::Iterator i = expr.begin();
+        reducer.start(max(*i));
+        for (++i; i != i_end; ++i) {
+            reducer(max(*i));
+        }
+    }
+    return reducer.result;
+}
+
+/**
+ *  \brief Return the sum of the element-wise products of two expressions with the same shape.
+ *
+ *  This is equivalent to sum(expr1 * expr2), and like it does not create a temporary array.
+ *
+ *  \ingroup MainGroup
+ */
+template <typename Derived1, typename Derived2>
+inline typename boost::remove_const<
+    typename detail::MultipliesTag::template ExprExpr<Derived1,Derived2>::BinaryFunction::result_type
+>::type
+dot(ExpressionBase<Derived1> const & expr1, ExpressionBase<Derived2> const & expr2) {
+    return sum(expr1 * expr2);
+}
 
 }} // namespace lsst::ndarray
 
@@ -56,6 +56,7 @@ namespace lsst { namespace ndarray {
 template <typename T, int N, int C> struct ArrayTraits;
 template <typename Expression_> struct ExpressionTraits;
 class Manager;
+class MemoryPool;
 
 /** @internal @namespace lsst::ndarray::detail @brief Internal namespace */
 namespace detail {
@@ -21,6 +21,7 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 #include "lsst/ndarray.h"
+#include "lsst/ndarray/MemoryPool.h"
 
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE ndarray
@@ -88,6 +89,53 @@ BOOST_AUTO_TEST_CASE(allocation) {
     
 }
 
+BOOST_AUTO_TEST_CASE(alignment) {
+    for (int n = 1; n < 20; ++n) {
+        lsst::ndarray::Array<char,1,1> a = lsst::ndarray::allocate(n);
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(a.getData()) % lsst::ndarray::DATA_ALIGNMENT, 0u);
+        lsst::ndarray::Array<double,2,2> b = lsst::ndarray::allocate(n, 3);
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(b.getData()) % lsst::ndarray::DATA_ALIGNMENT, 0u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pools) {
+    lsst::ndarray::MemoryPool::Ptr pool = lsst::ndarray::MemoryPool::make(1 << 20);
+    double * data = 0;
+    {
+        lsst::ndarray::Array<double,2,2> a = lsst::ndarray::allocate(30, 20, pool);
+        BOOST_CHECK_EQUAL(a.getShape(), lsst::ndarray::makeVector(30, 20));
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(a.getData()) % lsst::ndarray::DATA_ALIGNMENT, 0u);
+        BOOST_CHECK(a.isUnique());
+        data = a.getData();
+        BOOST_CHECK_EQUAL(pool->getCachedBytes(), 0u);
+    }
+    BOOST_CHECK(pool->getCachedBytes() >= 30 * 20 * sizeof(double));
+    // a slightly smaller request falls in the same size class, and reuses the block
+    lsst::ndarray::Array<double,1,1> b = lsst::ndarray::allocate(590, pool);
+    BOOST_CHECK_EQUAL(b.getData(), data);
+    BOOST_CHECK_EQUAL(pool->getCachedBytes(), 0u);
+    // blocks that would exceed the cache limit are freed instead
+    {
+        lsst::ndarray::Array<char,1,1> c = lsst::ndarray::allocate(1 << 21, pool);
+    }
+    BOOST_CHECK_EQUAL(pool->getCachedBytes(), 0u);
+    b = lsst::ndarray::Array<double,1,1>();
+    BOOST_CHECK(pool->getCachedBytes() > 0u);
+    pool->clear();
+    BOOST_CHECK_EQUAL(pool->getCachedBytes(), 0u);
+    // size classes are increasing, and waste at most a quarter of a block
+    int lastClass = -1;
+    for (std::size_t bytes = 1; bytes < (1 << 20); bytes += 1 + bytes / 8) {
+        std::size_t classBytes = 0;
+        int sizeClass = lsst::ndarray::MemoryPool::getSizeClass(bytes, classBytes);
+        BOOST_CHECK(sizeClass >= lastClass);
+        BOOST_CHECK(classBytes >= bytes);
+        BOOST_CHECK(bytes < 64 || classBytes <= bytes + bytes / 4);
+        BOOST_CHECK_EQUAL(lsst::ndarray::MemoryPool::getClassBytes(sizeClass), classBytes);
+        lastClass = sizeClass;
+    }
+}
+
 BOOST_AUTO_TEST_CASE(external) {
     double data[3*4*2] = {0};
     lsst::ndarray::Vector<int,3> shape = lsst::ndarray::makeVector(3,4,2);
@@ -343,6 +391,60 @@ BOOST_AUTO_TEST_CASE(binary_ops) {
     BOOST_CHECK(lsst::ndarray::allclose(b, a + q));
 }
 
+BOOST_AUTO_TEST_CASE(flat_evaluation) {
+    lsst::ndarray::Vector<int,2> shape = lsst::ndarray::makeVector(5,4);
+    lsst::ndarray::Array<double,2,2> a = lsst::ndarray::allocate(shape);
+    lsst::ndarray::Array<double,2,2> b = lsst::ndarray::allocate(shape);
+    for (int i=0; i<shape[0]; ++i) {
+        for (int j=0; j<shape[1]; ++j) {
+            a[i][j] = i * shape[1] + j - 7;
+            b[i][j] = 0.5 * (i - j);
+        }
+    }
+    // contiguous operands are evaluated with a flat loop; transposes and strided views aren't
+    lsst::ndarray::Array<double,2,2> c = lsst::ndarray::allocate(shape);
+    c.deep() = a * 2.0 + b;
+    lsst::ndarray::Array<double,2,2> d = lsst::ndarray::allocate(shape[1], shape[0]);
+    d.deep() = a.transpose() * 2.0 + b.transpose();
+    lsst::ndarray::Array<double,2,0> e = lsst::ndarray::copy(a)[lsst::ndarray::view()(0,4,2)];
+    e.deep() += b[lsst::ndarray::view()(1,4,2)];
+    for (int i=0; i<shape[0]; ++i) {
+        for (int j=0; j<shape[1]; ++j) {
+            BOOST_CHECK_EQUAL(c[i][j], a[i][j] * 2.0 + b[i][j]);
+            BOOST_CHECK_EQUAL(d[j][i], c[i][j]);
+        }
+        for (int j=0; j<2; ++j) {
+            BOOST_CHECK_EQUAL(e[i][j], a[i][2*j] + b[i][2*j+1]);
+        }
+    }
+    c.deep() -= a;
+    c.deep() *= 2.0;
+    BOOST_CHECK(lsst::ndarray::allclose(c, 2.0 * (a + b)));
+
+    BOOST_CHECK_EQUAL(lsst::ndarray::sum(a), 50.0);
+    BOOST_CHECK_EQUAL(lsst::ndarray::sum(a.transpose()), 50.0);
+    BOOST_CHECK_EQUAL(lsst::ndarray::sum(a + b), 50.0 + lsst::ndarray::sum(b));
+    BOOST_CHECK_EQUAL(lsst::ndarray::min(a), -7.0);
+    BOOST_CHECK_EQUAL(lsst::ndarray::max(a), 12.0);
+    BOOST_CHECK_EQUAL(lsst::ndarray::min(-a.transpose()), -12.0);
+    BOOST_CHECK_EQUAL(lsst::ndarray::max(e), a[4][2] + b[4][3]);
+    lsst::ndarray::Array<double const,2,2> f(a);
+    double product = 0.0;
+    for (int i=0; i<shape[0]; ++i) {
+        for (int j=0; j<shape[1]; ++j) {
+            product += a[i][j] * b[i][j];
+        }
+    }
+    BOOST_CHECK_EQUAL(lsst::ndarray::dot(f, b), product);
+    BOOST_CHECK_EQUAL(lsst::ndarray::dot(f.transpose(), b.transpose()), product);
+    lsst::ndarray::Array<int,1,1> g = lsst::ndarray::allocate(6);
+    g.deep() = 3;
+    g[4] = 10;
+    g.deep() <<= 1;
+    BOOST_CHECK_EQUAL(lsst::ndarray::sum(g), 50);
+    BOOST_CHECK_EQUAL(lsst::ndarray::max(g), 20);
+}
+
 BOOST_AUTO_TEST_CASE(broadcasting) {
     double data3[3*4*2] = { 
          0, 1, 2, 3, 4, 5, 6, 7,
@@ -72,6 +72,7 @@ namespace exceptions {
         virtual lsst::pex::exceptions::Exception* clone(void) const { \
             return new t(*this); \
         }; \
+        virtual void raise(void) const { throw *this; }; \
     };
 
 struct Tracepoint {
@@ -104,6 +105,7 @@ public:
     virtual char const* what(void) const throw();
     virtual char const* getType(void) const throw();
     virtual Exception* clone(void) const;
+    virtual void raise(void) const;
 
 private:
     Traceback _traceback;
@@ -159,6 +159,15 @@ pexExcept::Exception* pexExcept::Exception::clone(void) const {
     return new pexExcept::Exception(*this);
 }
 
+/** Throw a copy of the exception as its most derived type, so that an
+  * exception held through an Exception* (e.g. from clone()) can be rethrown
+  * and caught by its own type.  Overridden by derived classes (automatically
+  * if the LSST_EXCEPTION_TYPE macro is used).
+  */
+void pexExcept::Exception::raise(void) const {
+    throw *this;
+}
+
 /** Push the text representation of an exception onto a stream.
   * \param[in] stream Reference to an output stream.
   * \param[in] e Exception to output.
@@ -365,4 +365,18 @@ BOOST_AUTO_TEST_CASE(detailed_what_boobytrap) {
     BOOST_CHECK(o.is_equal("DetailedException *"));
 }
 
+BOOST_AUTO_TEST_CASE(raise_clone) {
+    pexExcept::Exception* e = 0;
+    try {
+        f2();
+    }
+    catch (pexExcept::Exception const& err) {
+        e = err.clone();
+    }
+    BOOST_REQUIRE(e != 0);
+    BOOST_CHECK_THROW(e->raise(), ChildException);
+    BOOST_CHECK_THROW(pexExcept::Exception(*e).raise(), pexExcept::Exception);
+    delete e;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
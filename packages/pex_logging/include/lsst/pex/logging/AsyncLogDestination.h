@@ -0,0 +1,136 @@
+// -*- lsst-c++ -*-
+
+/* 
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+ 
+/**
+ * @file AsyncLogDestination.h
+ * @brief definition of the AsyncLogDestination class
+ */
+#ifndef LSST_PEX_ASYNCLOGDESTINATION_H
+#define LSST_PEX_ASYNCLOGDESTINATION_H
+
+#include "lsst/pex/logging/LogDestination.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a LogDestination that writes to its stream from a background 
+ * thread.  
+ *
+ * Each record that passes the destination's threshold is formatted in the 
+ * thread that logged it, and the text is put into a fixed-size ring buffer;
+ * a background thread takes the text out of the buffer and writes it to the
+ * stream, so logging threads don't wait for the stream (e.g. a file on a 
+ * slow disk), and records from different threads are never interleaved.  
+ * If the ring buffer is full, logging threads wait for the background thread
+ * to make room, so no records are lost.  
+ * 
+ * Records are written in the order in which they were logged.  Call flush() 
+ * to wait until all the records logged so far have been written; the 
+ * destructor flushes all remaining records before it returns.  
+ * 
+ * For example, to log asynchronously to a file:
+ * @code
+ *    std::ofstream logfile("pipeline.log");
+ *    boost::shared_ptr<LogFormatter> brief(new BriefFormatter());
+ *    log.addDestination(boost::shared_ptr<LogDestination>(
+ *                           new AsyncLogDestination(&logfile, brief)));
+ * @endcode
+ */
+class AsyncLogDestination : public LogDestination {
+public:
+
+    /**
+     * @brief create an asynchronous destination, and start its background 
+     * thread.  
+     * @param strm       the output stream to send messages to.  If the pointer
+     *                       is null, this AsyncLogDestination will act as a 
+     *                       null-op destination.  The stream must outlive 
+     *                       this destination.
+     * @param formatter  the LogFormatter to use to format the messages 
+     * @param threshold  the minimum volume level required to pass a message
+     *                       to the stream.  
+     * @param capacity   the maximum number of records waiting to be written
+     */
+    AsyncLogDestination(std::ostream *strm, 
+                        const boost::shared_ptr<LogFormatter>& formatter, 
+                        int threshold=threshold::PASS_ALL,
+                        int capacity=4096);
+
+    /**
+     * write all remaining records, then stop the background thread
+     */
+    virtual ~AsyncLogDestination();
+
+    /**
+     * queue a given log record to be written to this destination's output 
+     * stream, if (a) there is actually an attached stream, (b) there is an
+     * attached formatter, and (c) the importance level associated with the
+     * record is equal to or greater than the threshold associated with this
+     * destination.  The record is formatted before this function returns.
+     * @return  true if the record was queued to be written.
+     */
+    virtual bool write(const LogRecord& rec);
+
+    /**
+     * wait until all the records queued so far have been written to the 
+     * stream (and the stream has been flushed).
+     */
+    void flush();
+
+    /**
+     * return the maximum number of records waiting to be written
+     */
+    int getCapacity() const { return static_cast<int>(_ring.size()); }
+
+private:
+    // the background thread's thread is not copied with the destination
+    AsyncLogDestination(const AsyncLogDestination&);
+    AsyncLogDestination& operator=(const AsyncLogDestination&);
+
+    void _writeRecords();
+
+    std::vector<std::string> _ring;  // formatted records waiting to be written
+    int _first;                      // index of the oldest record in _ring
+    int _count;                      // number of records in _ring
+    unsigned long _nQueued;          // total number of records queued
+    unsigned long _nWritten;         // total number of records written
+    bool _stopping;                  // should the background thread stop?
+    boost::mutex _ringMutex;         // protects all of the above
+    boost::condition_variable _notEmpty;  // signalled when a record is queued
+    boost::condition_variable _notFull;   // signalled when records are taken
+    boost::condition_variable _written;   // signalled when records are written
+    boost::scoped_ptr<boost::thread> _writer;  // the background thread
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_ASYNCLOGDESTINATION_H
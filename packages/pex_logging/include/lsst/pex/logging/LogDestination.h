@@ -36,6 +36,7 @@
 #include <string>
 #include <ostream>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace lsst {
 namespace pex {
@@ -50,10 +51,12 @@ class LogRecord;
  *
  * Multiple destinations can be added to a Log either at its
  * contruction time or later using one of its addDestination()
- * methods.  A LogDestination can be added to multiple Logs; however,
- * actual writing to streams is not synchronized, so the output will
- * get garbled if multiple threads or processes write to the same
- * stream simultaneously.
+ * methods.  A LogDestination can be added to multiple Logs, and may be
+ * written to from several threads at once:  each record is written to 
+ * the stream whole.  However, writes are not synchronized with other 
+ * LogDestinations (or processes) sharing the same stream.  To take the 
+ * writing out of the logging threads altogether, use an 
+ * AsyncLogDestination.
  * 
  * A LogDestination has its own importance threshold associated with it that 
  * is in addition to a Log's threshold.  If the threshold of a destination
@@ -117,12 +120,13 @@ public:
      * @return  true if the record was actually passed to the
      *          associated stream. 
      */
-    bool write(const LogRecord& rec);
+    virtual bool write(const LogRecord& rec);
 
 protected:
     int _threshold;   // the stream's threshold
     std::ostream *_strm;   // the output stream
     boost::shared_ptr<LogFormatter> _frmtr;    // the formatter to use
+    boost::shared_ptr<boost::mutex> _mutex;    // serializes writes; shared by copies
 };
 
 }}}     // end lsst::pex::logging
@@ -35,6 +35,7 @@
 #include <ostream>
 #include <boost/shared_ptr.hpp>
 #include <boost/tokenizer.hpp>
+#include <boost/thread/shared_mutex.hpp>
 
 #include "lsst/pex/logging/threshold/enum.h"
 
@@ -167,6 +168,11 @@ private:
  * stored internally (privately) as a Family instance.  One Memory instance 
  * shared by all the Log instances in a Log hierarchy, created first by the 
  * root log and passed (by shared pointer) to child logs as they are created.
+ *
+ * The effective threshold for each name that has been looked up is cached,
+ * so that checking whether a (e.g. Trace) message would be recorded doesn't
+ * require walking the tree of names; the cache is cleared whenever any
+ * threshold is set.  A Memory may be used from several threads at once.
  */
 class Memory {
 public:
@@ -176,41 +182,29 @@ public:
     /**
      * return the threshold value associated with a given name
      */
-    int getThresholdFor(const std::string& name) {
-        if (name.length() == 0) return getRootThreshold();
-        tokenizer fields(name, _sep);
-        return _tree.getThresholdFor(fields.begin(), fields.end());
-    }
+    int getThresholdFor(const std::string& name);
 
     /**
      * set the threshold value associated with a given name
      */
-    void setThresholdFor(const std::string& name, int threshold) {
-        if (name.length() == 0) {
-            setRootThreshold(threshold);
-        }
-        else {
-            tokenizer fields(name, _sep);
-            _tree.setThresholdFor(fields.begin(), fields.end(), threshold);
-        }
-    }
+    void setThresholdFor(const std::string& name, int threshold);
 
     /**
      * return the default threshold value associated with the root
      * of the hierarchy.
      */
-    int getRootThreshold() { return _tree.getThreshold(); }
+    int getRootThreshold();
 
     /**
      * return the default threshold value associated with the root
      * of the hierarchy.
      */
-    void setRootThreshold(int threshold) { _tree.setThreshold(threshold); }
+    void setRootThreshold(int threshold);
 
     /**
      * reset the memory
      */
-    void forgetAllNames() { _tree.deleteDescendants(); }
+    void forgetAllNames();
 
     /**
      * print the thresholds stored in this Memory that are not set to INHERIT.
@@ -219,8 +213,15 @@ public:
 
 
 private:
+    typedef std::map<std::string, int> ThresholdCache;
+
+    Memory(const Memory&);
+    Memory& operator=(const Memory&);
+
     Family _tree;
     boost::char_separator<char> _sep;
+    ThresholdCache _cache;       // effective thresholds already looked up
+    boost::shared_mutex _mutex;  // protects _tree and _cache; lookups share it
 };
 
 }}}} // end lsst::pex::logging::threshold
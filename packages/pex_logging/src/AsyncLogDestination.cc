@@ -0,0 +1,151 @@
+/* 
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+ 
+ 
+/**
+ * @file AsyncLogDestination.cc
+ */
+#include "lsst/pex/logging/AsyncLogDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+#include <sstream>
+#include <boost/bind.hpp>
+
+using namespace std;
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+using boost::shared_ptr;
+
+/*
+ * @brief create an asynchronous destination, and start its background 
+ * thread.  
+ */
+AsyncLogDestination::AsyncLogDestination(
+                                    ostream *strm, 
+                                    const shared_ptr<LogFormatter>& formatter,
+                                    int threshold, int capacity) 
+    : LogDestination(strm, formatter, threshold), 
+      _ring((capacity > 0) ? capacity : 1), _first(0), _count(0), 
+      _nQueued(0), _nWritten(0), _stopping(false)
+{ 
+    _writer.reset(new boost::thread(
+                      boost::bind(&AsyncLogDestination::_writeRecords, this)));
+}
+
+/*
+ * write all remaining records, then stop the background thread
+ */
+AsyncLogDestination::~AsyncLogDestination() { 
+    {
+        boost::mutex::scoped_lock lock(_ringMutex);
+        _stopping = true;
+    }
+    _notEmpty.notify_all();
+    _writer->join();
+}
+
+/*
+ * queue a given log record to be written to this destination's output 
+ * stream.
+ */
+bool AsyncLogDestination::write(const LogRecord& rec) {
+    if (_strm == 0 || _frmtr.get() == 0 || 
+        rec.getImportance() < _threshold)
+    {
+        return false;
+    }
+
+    // format the record here, so that the background thread doesn't 
+    // need access to it (or to the formatter)
+    ostringstream text;
+    _frmtr->write(&text, rec);
+    string formatted(text.str());
+
+    boost::mutex::scoped_lock lock(_ringMutex);
+    while (_count == getCapacity()) 
+        _notFull.wait(lock);
+    _ring[(_first + _count) % getCapacity()].swap(formatted);
+    ++_count;
+    ++_nQueued;
+    lock.unlock();
+
+    _notEmpty.notify_one();
+    return true;
+}
+
+/*
+ * wait until all the records queued so far have been written to the 
+ * stream.
+ */
+void AsyncLogDestination::flush() {
+    boost::mutex::scoped_lock lock(_ringMutex);
+    const unsigned long target = _nQueued;
+    while (_nWritten < target) 
+        _written.wait(lock);
+}
+
+/*
+ * the body of the background thread:  repeatedly take all the queued 
+ * records out of the ring buffer and write them to the stream, until
+ * the destination is destroyed.
+ */
+void AsyncLogDestination::_writeRecords() {
+    vector<string> batch;
+    batch.reserve(_ring.size());
+
+    boost::mutex::scoped_lock lock(_ringMutex);
+    while (true) {
+        while (_count == 0 && ! _stopping) 
+            _notEmpty.wait(lock);
+        if (_count == 0) 
+            break;                  // stopping, and everything's written
+
+        // take the records (without copying the text), and make room 
+        // before writing them out
+        batch.resize(_count);
+        for(int i = 0; i < _count; ++i) 
+            batch[i].swap(_ring[(_first + i) % getCapacity()]);
+        _first = (_first + _count) % getCapacity();
+        _count = 0;
+        lock.unlock();
+        _notFull.notify_all();
+
+        for(vector<string>::iterator it = batch.begin(); 
+            it != batch.end(); 
+            ++it)
+        {
+            _strm->write(it->data(), it->size());
+        }
+        _strm->flush();
+
+        lock.lock();
+        _nWritten += batch.size();
+        _written.notify_all();
+    }
+}
+
+//@endcond
+}}} // end lsst::pex::logging
@@ -52,14 +52,16 @@ using boost::shared_ptr;
 LogDestination::LogDestination(ostream *strm, 
                                const shared_ptr<LogFormatter>& formatter,
                                int threshold) 
-    : _threshold(threshold), _strm(strm), _frmtr(formatter)
+    : _threshold(threshold), _strm(strm), _frmtr(formatter), 
+      _mutex(new boost::mutex())
 { }
 
 /*
  * create a copy
  */
 LogDestination::LogDestination(const LogDestination& that)
-    : _threshold(that._threshold), _strm(that._strm), _frmtr(that._frmtr)
+    : _threshold(that._threshold), _strm(that._strm), _frmtr(that._frmtr),
+      _mutex(that._mutex)
 { }
 
 /*
@@ -74,6 +76,7 @@ LogDestination& LogDestination::operator=(const LogDestination& that) {
     _threshold = that._threshold;
     _strm = that._strm; 
     _frmtr = that._frmtr;
+    _mutex = that._mutex;
     return *this;
 }
 
@@ -91,6 +94,7 @@ bool LogDestination::write(const LogRecord& rec) {
     if (_strm != 0 && _frmtr.get() != 0 && 
         rec.getImportance() >= _threshold)
     {
+        boost::mutex::scoped_lock lock(*_mutex);
         _frmtr->write(_strm, rec);
         return true;
     }
@@ -168,14 +168,88 @@ void Family::printDescThresholds(std::ostream& out,
 
 /* ******************************************************************* */
 
+// the most names to cache the thresholds for; beyond this, the cache is
+// cleared and refilled (names are normally a fixed set of components, so
+// this only guards against names being generated on the fly)
+static const std::size_t MAX_CACHED = 10000;
+
 Memory::Memory(const std::string& delims) 
-    : _tree(), _sep(delims.c_str())
+    : _tree(), _sep(delims.c_str()), _cache(), _mutex()
 { }
 
+/**
+ * return the threshold value associated with a given name
+ */
+int Memory::getThresholdFor(const std::string& name) {
+    if (name.length() == 0) return getRootThreshold();
+
+    {
+        // names are normally looked up many times, so concurrent lookups
+        // of cached names only share the lock
+        boost::shared_lock<boost::shared_mutex> lock(_mutex);
+        ThresholdCache::const_iterator cached = _cache.find(name);
+        if (cached != _cache.end()) return cached->second;
+    }
+
+    boost::unique_lock<boost::shared_mutex> lock(_mutex);
+    ThresholdCache::const_iterator cached = _cache.find(name);
+    if (cached != _cache.end()) return cached->second;  // cached meanwhile
+
+    tokenizer fields(name, _sep);
+    int threshold = _tree.getThresholdFor(fields.begin(), fields.end());
+    if (_cache.size() >= MAX_CACHED) _cache.clear();
+    _cache.insert(ThresholdCache::value_type(name, threshold));
+    return threshold;
+}
+
+/**
+ * set the threshold value associated with a given name
+ */
+void Memory::setThresholdFor(const std::string& name, int threshold) {
+    if (name.length() == 0) {
+        setRootThreshold(threshold);
+    }
+    else {
+        boost::unique_lock<boost::shared_mutex> lock(_mutex);
+        tokenizer fields(name, _sep);
+        _tree.setThresholdFor(fields.begin(), fields.end(), threshold);
+        _cache.clear();       // descendants of name may inherit threshold
+    }
+}
+
+/**
+ * return the default threshold value associated with the root
+ * of the hierarchy.
+ */
+int Memory::getRootThreshold() {
+    boost::shared_lock<boost::shared_mutex> lock(_mutex);
+    return _tree.getThreshold();
+}
+
+/**
+ * set the default threshold value associated with the root
+ * of the hierarchy.
+ */
+void Memory::setRootThreshold(int threshold) {
+    boost::unique_lock<boost::shared_mutex> lock(_mutex);
+    _tree.setThreshold(threshold);
+    _cache.clear();
+}
+
+/**
+ * reset the memory
+ */
+void Memory::forgetAllNames() {
+    boost::unique_lock<boost::shared_mutex> lock(_mutex);
+    _tree.deleteDescendants();
+    _cache.clear();
+}
+
 /**
  * print the thresholds stored in this Memory that are not set to INHERIT.
  */
 void Memory::printThresholds(std::ostream& out) {
+    boost::shared_lock<boost::shared_mutex> lock(_mutex);
     out << "(root)              ";
     int top = _tree.getThreshold();
     if (top < 10 && top >= 0) out << ' ';
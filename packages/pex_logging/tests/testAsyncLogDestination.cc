@@ -0,0 +1,115 @@
+/* 
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+ 
+ 
+/**
+ * @file testAsyncLogDestination.cc
+ * @brief  test that records logged from several threads to an 
+ *         AsyncLogDestination are all written, whole and in order.
+ */
+#include "lsst/pex/logging/AsyncLogDestination.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/Log.h"
+#include <cstdio>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <boost/format.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::AsyncLogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::BriefFormatter;
+using lsst::daf::base::PropertySet;
+using boost::shared_ptr;
+using namespace std;
+
+void assure(bool mustBeTrue, const string& failureMsg) {
+    if (! mustBeTrue)
+        throw runtime_error(failureMsg);
+}
+
+const int nThreads = 4;
+const int nMessages = 2000;
+
+// log nMessages messages to a child of a given log
+class Chatter {
+public:
+    Chatter(const Log& log, int id) : _log(&log), _id(id) { }
+    void operator()() const {
+        Log mylog(*_log, (boost::format("thread%d") % _id).str());
+        for(int i = 0; i < nMessages; ++i) 
+            mylog.format(Log::INFO, "message %d", i);
+    }
+private:
+    const Log *_log;
+    int _id;
+};
+
+int main() {
+
+    ostringstream out;
+    shared_ptr<LogFormatter> brief(new BriefFormatter());
+    shared_ptr<AsyncLogDestination> 
+        async(new AsyncLogDestination(&out, brief, Log::INFO, 16));
+    assure(async->getCapacity() == 16, "wrong capacity");
+
+    list<shared_ptr<LogDestination> > dests;
+    dests.push_back(async);
+    Log log(dests, PropertySet(), "async");
+
+    // a small ring buffer makes the loggers wait for the writer
+    boost::thread_group threads;
+    for(int t = 0; t < nThreads; ++t) 
+        threads.create_thread(Chatter(log, t));
+    threads.join_all();
+    log.log(Log::DEBUG, "not written");
+    log.log(Log::INFO, "done");
+    async->flush();
+
+    // every record should be whole, and each thread's records in order
+    vector<int> next(nThreads, 0);
+    istringstream in(out.str());
+    string line;
+    int nLines = 0;
+    while (getline(in, line)) {
+        ++nLines;
+        if (line == "async: done") {
+            assure(nLines == nThreads*nMessages + 1, "records out of order");
+            continue;
+        }
+        int t, i;
+        assure(sscanf(line.c_str(), "async.thread%d: message %d", &t, &i) == 2,
+               "garbled record: " + line);
+        assure(t >= 0 && t < nThreads && i == next[t], 
+               "record missing or out of order: " + line);
+        ++next[t];
+    }
+    assure(nLines == nThreads*nMessages + 1, "wrong number of records");
+
+    return 0;
+}
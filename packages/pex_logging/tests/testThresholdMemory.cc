@@ -28,6 +28,7 @@
 #include "lsst/pex/logging/LogRecord.h"
 #include <iostream>
 #include <sstream>
+#include <boost/thread.hpp>
 
 using lsst::pex::logging::threshold::Memory;
 using namespace std;
@@ -46,6 +47,24 @@ void tattle(bool mustBeTrue, const string& failureMsg, int line) {
 using lsst::pex::logging::LogRecord;
 namespace Threshold = lsst::pex::logging::threshold;
 
+/*
+ * look up names while another thread changes their threshold; every
+ * lookup must see either the old threshold or the new one
+ */
+class Reader {
+public:
+    Reader(Threshold::Memory& mem, int& bad) : _mem(mem), _bad(bad) { }
+    void operator()() {
+        for(int i=0; i < 20000; ++i) {
+            int t = _mem.getThresholdFor((i%2) ? "mount.doom" : "mount.doom.fire");
+            if (t != 3 && t != -3) ++_bad;
+        }
+    }
+private:
+    Threshold::Memory& _mem;
+    int& _bad;
+};
+
 int main() {
 
     Threshold::Memory mem;
@@ -71,4 +90,15 @@ int main() {
            "wrong new inherited threshold");
 
     mem.printThresholds(cout);
+
+    mem.setThresholdFor("mount", 3);
+    int bad[4] = { 0, 0, 0, 0 };
+    boost::thread_group readers;
+    for(int i=0; i < 4; ++i) 
+        readers.create_thread(Reader(mem, bad[i]));
+    for(int i=0; i < 1000; ++i) 
+        mem.setThresholdFor("mount", (i%2) ? 3 : -3);
+    readers.join_all();
+    Assert(bad[0]+bad[1]+bad[2]+bad[3] == 0, 
+           "lookup saw a threshold that was never set");
 }
@@ -160,6 +160,7 @@ public:
     { }
 
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
     virtual char const *getType(void) const throw();
 
     /**
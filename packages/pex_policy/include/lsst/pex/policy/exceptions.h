@@ -40,7 +40,8 @@
 char const *etn::getType(void) const throw() { return #etn " *"; } \
 lsst::pex::exceptions::Exception *etn::clone(void) const { \
     return new etn(*this); \
-}
+} \
+void etn::raise(void) const { throw *this; }
 
 namespace lsst {
 namespace pex {
@@ -66,6 +67,7 @@ public:
     { }
     virtual char const *getType(void) const throw();
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
 };
 
 /**
@@ -83,6 +85,7 @@ public:
     { }
     virtual char const *getType(void) const throw();
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
 };
 
 /**
@@ -101,6 +104,7 @@ public:
     { }
     virtual char const *getType(void) const throw();
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
 };
 
 /**
@@ -121,6 +125,7 @@ public:
     { }
     virtual char const *getType(void) const throw();
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
 };
 
 }}}  // end namespace lsst::pex::policy
@@ -82,6 +82,7 @@ public:
 
     virtual char const *getType() const throw();
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
 };
 
 /**
@@ -128,6 +129,7 @@ public:
 
     virtual char const *getType() const throw();
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
 };
 
 /**
@@ -161,6 +163,7 @@ public:
 
     virtual char const *getType() const throw();
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
 };
 
 /**
@@ -195,6 +198,7 @@ public:
 
     virtual char const *getType() const throw();
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
 };
 
 /**
@@ -229,6 +233,7 @@ public:
 
     virtual char const *getType() const throw();
     virtual pexExcept::Exception *clone() const;
+    virtual void raise() const;
 };
 
 